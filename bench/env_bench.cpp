@@ -0,0 +1,627 @@
+#include "../cpp-envlib/libenv.h"
+#include "../tests/alloc_counter.h"
+#include <benchmark/benchmark.h>
+
+using namespace env_cfg;
+
+// Reports the heap allocations of the measured loop as "allocs/op".
+class AllocScope {
+public:
+    explicit AllocScope(benchmark::State& state) : m_state(state), m_start(g_allocations.load()) {}
+
+    ~AllocScope()
+    {
+        m_state.counters["allocs/op"] = benchmark::Counter(
+            static_cast<double>(g_allocations.load() - m_start), benchmark::Counter::kAvgIterations);
+    }
+
+private:
+    benchmark::State& m_state;
+    std::size_t m_start;
+};
+
+// Adds `count` unrelated variables to the process environment for the lifetime of the object.
+class EnvironPadding {
+public:
+    explicit EnvironPadding(std::size_t count) : m_count(count)
+    {
+        for (std::size_t i = 0; i < m_count; ++i)
+        {
+            setenv(Name(i).c_str(), "padding", 1);
+        }
+    }
+
+    ~EnvironPadding()
+    {
+        for (std::size_t i = 0; i < m_count; ++i)
+        {
+            unsetenv(Name(i).c_str());
+        }
+    }
+
+private:
+    static std::string Name(std::size_t i)
+    {
+        return "BENCH_PAD_" + std::to_string(i);
+    }
+
+    std::size_t m_count;
+};
+
+static EnvMap MakeMap(std::size_t keys)
+{
+    EnvMap map;
+    for (std::size_t i = 0; i < keys; ++i)
+    {
+        const std::string name = "BENCH_KEY_" + std::to_string(i);
+        switch (i % 4)
+        {
+        case 0:
+            map.insert_or_assign(name, EnvCfg::EnvValue(static_cast<int>(i)));
+            break;
+        case 1:
+            map.insert_or_assign(name, EnvCfg::EnvValue(EnvCfgTypes::double_));
+            break;
+        case 2:
+            map.insert_or_assign(name, EnvCfg::EnvValue(std::string("default")));
+            break;
+        default:
+            map.insert_or_assign(name, EnvCfg::EnvValue(true));
+            break;
+        }
+    }
+    return map;
+}
+
+static void SetKeys(std::size_t keys)
+{
+    // Every second key is present in the environment.
+    for (std::size_t i = 0; i < keys; i += 2)
+    {
+        const std::string name = "BENCH_KEY_" + std::to_string(i);
+        switch (i % 4)
+        {
+        case 0:
+            setenv(name.c_str(), "123", 1);
+            break;
+        default:
+            setenv(name.c_str(), "default", 1);
+            break;
+        }
+    }
+}
+
+static void UnsetKeys(std::size_t keys)
+{
+    for (std::size_t i = 0; i < keys; ++i)
+    {
+        unsetenv(("BENCH_KEY_" + std::to_string(i)).c_str());
+    }
+}
+
+static void BM_InitEnv(benchmark::State& state)
+{
+    const std::size_t keys = static_cast<std::size_t>(state.range(0));
+    EnvironPadding padding(static_cast<std::size_t>(state.range(1)));
+    EnvMap map = MakeMap(keys);
+    SetKeys(keys);
+    {
+        AllocScope allocs(state);
+        for (auto _ : state)
+        {
+            EnvCfg env;
+            env.InitEnv(map);
+            benchmark::DoNotOptimize(env);
+        }
+    }
+    UnsetKeys(keys);
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(keys));
+}
+BENCHMARK(BM_InitEnv)->ArgsProduct({{10, 100, 10000}, {0, 1000}})->Unit(benchmark::kMicrosecond);
+
+// `range(0)` tenant keys (every second one set, see SetKeys) read through an explicit EnvMap (`range(1)` = 0)
+// or discovered by the pattern "BENCH_KEY_*" (`range(1)` = 1).
+static void BM_InitEnvPattern(benchmark::State& state)
+{
+    const std::size_t keys = static_cast<std::size_t>(state.range(0));
+    EnvMap map;
+    if (state.range(1))
+    {
+        map.emplace("BENCH_KEY_*", EnvCfgTypes::int_);
+    }
+    else
+    {
+        for (std::size_t i = 0; i < keys; i += 2)
+        {
+            map.emplace("BENCH_KEY_" + std::to_string(i), EnvCfgTypes::int_);
+        }
+    }
+    for (std::size_t i = 0; i < keys; i += 2)
+    {
+        setenv(("BENCH_KEY_" + std::to_string(i)).c_str(), "123", 1);
+    }
+    {
+        AllocScope allocs(state);
+        for (auto _ : state)
+        {
+            EnvCfg env;
+            env.InitEnv(map);
+            benchmark::DoNotOptimize(env);
+        }
+    }
+    UnsetKeys(keys);
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(keys / 2));
+}
+BENCHMARK(BM_InitEnvPattern)->ArgsProduct({{100, 2000}, {0, 1}})->Unit(benchmark::kMicrosecond);
+
+// Lazy InitEnv followed by reads of a single key.
+static void BM_InitEnvLazy(benchmark::State& state)
+{
+    const std::size_t keys = static_cast<std::size_t>(state.range(0));
+    EnvMap map = MakeMap(keys);
+    SetKeys(keys);
+    EnvInitOptions options;
+    options.lazy = true;
+    {
+        AllocScope allocs(state);
+        for (auto _ : state)
+        {
+            EnvCfg env;
+            env.InitEnv(map, options);
+            benchmark::DoNotOptimize(env.GetN<int>("BENCH_KEY_0"));
+        }
+    }
+    UnsetKeys(keys);
+}
+BENCHMARK(BM_InitEnvLazy)->Arg(10)->Arg(100)->Arg(10000)->Unit(benchmark::kMicrosecond);
+
+// Refresh of an initialized EnvCfg with one changed key out of `keys`.
+static void BM_Refresh(benchmark::State& state)
+{
+    const std::size_t keys = static_cast<std::size_t>(state.range(0));
+    EnvMap map = MakeMap(keys);
+    SetKeys(keys);
+    EnvCfg env;
+    env.InitEnv(map);
+    int value = 0;
+    {
+        AllocScope allocs(state);
+        for (auto _ : state)
+        {
+            setenv("BENCH_KEY_0", std::to_string(++value % 2).c_str(), 1);
+            benchmark::DoNotOptimize(env.Refresh());
+        }
+    }
+    UnsetKeys(keys);
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(keys));
+}
+BENCHMARK(BM_Refresh)->Arg(10)->Arg(100)->Arg(10000)->Unit(benchmark::kMicrosecond);
+
+// EnvLayeredCfg of `keys` with a file layer (an EnvSnapshot), the environment and one changing override.
+static void BM_LayeredOverride(benchmark::State& state)
+{
+    const std::size_t keys = static_cast<std::size_t>(state.range(0));
+    EnvMap map = MakeMap(keys);
+    SetKeys(keys);
+    EnvLayeredCfg layered(map);
+    layered.SetLayer(EnvLayer::file_, std::make_shared<EnvSnapshot>());
+    UnsetKeys(keys);
+    int value = 0;
+    {
+        AllocScope allocs(state);
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(layered.SetOverride("BENCH_KEY_0", std::to_string(++value % 2)));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(keys));
+}
+BENCHMARK(BM_LayeredOverride)->Arg(10)->Arg(100)->Arg(10000)->Unit(benchmark::kMicrosecond);
+
+// Reads of an EnvLayeredCfg stay a single lookup in the resolved table, whatever the number of layers.
+static void BM_LayeredGet(benchmark::State& state)
+{
+    EnvMap map = MakeMap(100);
+    SetKeys(100);
+    EnvLayeredCfg layered(map);
+    layered.SetLayer(EnvLayer::file_, std::make_shared<EnvSnapshot>());
+    layered.SetOverride("BENCH_KEY_4", "7");
+    UnsetKeys(100);
+    AllocScope allocs(state);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(layered.Get<int>("BENCH_KEY_40"));
+    }
+}
+BENCHMARK(BM_LayeredGet);
+
+// envp of a child: the current environment plus 200 job variables, in a fresh block (`range(0)` = 0)
+// or in one reused across spawns (`range(0)` = 1).
+static void BM_BuildEnvBlock(benchmark::State& state)
+{
+    std::vector<std::pair<std::string, std::string>> job;
+    for (int i = 0; i < 200; ++i)
+    {
+        job.emplace_back("BENCH_JOB_" + std::to_string(i), "value_" + std::to_string(i));
+    }
+    EnvBlock reused;
+    AllocScope allocs(state);
+    for (auto _ : state)
+    {
+        if (state.range(0))
+        {
+            EnvCfg::MaterializeEnv(reused);
+            reused.SetAll(job);
+            benchmark::DoNotOptimize(reused.envp());
+        }
+        else
+        {
+            EnvBlock block = EnvCfg::MaterializeEnv();
+            block.SetAll(job);
+            benchmark::DoNotOptimize(block.envp());
+        }
+    }
+}
+BENCHMARK(BM_BuildEnvBlock)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+// LoadSnapshot of a configuration saved from the same environment, with and without validation.
+static void BM_LoadSnapshot(benchmark::State& state)
+{
+    const std::size_t keys = static_cast<std::size_t>(state.range(0));
+    const bool validate = state.range(1) != 0;
+    const std::string path = "/tmp/libenv_bench.snapshot";
+    EnvMap map = MakeMap(keys);
+    SetKeys(keys);
+    {
+        EnvCfg env;
+        env.InitEnv(map);
+        env.SaveSnapshot(path);
+    }
+    {
+        AllocScope allocs(state);
+        for (auto _ : state)
+        {
+            EnvCfg env = EnvCfg::LoadSnapshot(path, validate);
+            benchmark::DoNotOptimize(env);
+        }
+    }
+    UnsetKeys(keys);
+    std::remove(path.c_str());
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(keys));
+}
+BENCHMARK(BM_LoadSnapshot)->ArgsProduct({{10, 100, 10000}, {0, 1}})->Unit(benchmark::kMicrosecond);
+
+// Fixture with an initialized EnvCfg of 100 keys.
+class ReadBench : public benchmark::Fixture {
+public:
+    void SetUp(const benchmark::State&) override
+    {
+        SetKeys(100);
+        env = std::make_unique<EnvCfg>();
+        EnvMap map = MakeMap(100);
+        env->InitEnv(map);
+        UnsetKeys(100);
+    }
+
+    void TearDown(const benchmark::State&) override
+    {
+        env.reset();
+    }
+
+    std::unique_ptr<EnvCfg> env;
+    const std::string hit = "BENCH_KEY_40";
+    const std::string miss = "BENCH_KEY_MISSING";
+    const std::string text = "BENCH_KEY_42";
+};
+
+BENCHMARK_F(ReadBench, Get_Hit)(benchmark::State& state)
+{
+    AllocScope allocs(state);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(env->Get<int>(hit));
+    }
+}
+
+BENCHMARK_F(ReadBench, Get_Miss)(benchmark::State& state)
+{
+    AllocScope allocs(state);
+    for (auto _ : state)
+    {
+        try
+        {
+            benchmark::DoNotOptimize(env->Get<int>(miss));
+        }
+        catch (const EnvBadGet& e)
+        {
+            benchmark::DoNotOptimize(e);
+        }
+    }
+}
+
+BENCHMARK_F(ReadBench, Get_String)(benchmark::State& state)
+{
+    AllocScope allocs(state);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(env->Get<std::string>(text));
+    }
+}
+
+BENCHMARK_F(ReadBench, GetView_String)(benchmark::State& state)
+{
+    AllocScope allocs(state);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(env->GetView(text));
+    }
+}
+
+BENCHMARK_F(ReadBench, GetN_Hit)(benchmark::State& state)
+{
+    AllocScope allocs(state);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(env->GetN<int>(hit));
+    }
+}
+
+BENCHMARK_F(ReadBench, GetN_Miss)(benchmark::State& state)
+{
+    AllocScope allocs(state);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(env->GetN<int>(miss));
+    }
+}
+
+BENCHMARK_F(ReadBench, Get_Handle)(benchmark::State& state)
+{
+    const EnvKey<int> key = env->Key<int>(hit);
+    AllocScope allocs(state);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(env->Get(key));
+    }
+}
+
+BENCHMARK_F(ReadBench, IsType_Hit)(benchmark::State& state)
+{
+    AllocScope allocs(state);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(env->IsType<int>(hit));
+    }
+}
+
+BENCHMARK_F(ReadBench, IsType_Miss)(benchmark::State& state)
+{
+    AllocScope allocs(state);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(env->IsType<int>(miss));
+    }
+}
+
+BENCHMARK_F(ReadBench, HasValue_Hit)(benchmark::State& state)
+{
+    AllocScope allocs(state);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(env->HasValue(hit));
+    }
+}
+
+BENCHMARK_F(ReadBench, HasValue_Miss)(benchmark::State& state)
+{
+    AllocScope allocs(state);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(env->HasValue(miss));
+    }
+}
+
+BENCHMARK_F(ReadBench, Scope_Get)(benchmark::State& state)
+{
+    const EnvCfgView scope = env->Scope("BENCH_KEY_");
+    AllocScope allocs(state);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(scope.Get<int>("40"));
+    }
+}
+
+// Enumerates the 11 keys BENCH_KEY_4, BENCH_KEY_40 ... BENCH_KEY_49 out of 100.
+BENCHMARK_F(ReadBench, Scope_Iterate)(benchmark::State& state)
+{
+    AllocScope allocs(state);
+    for (auto _ : state)
+    {
+        for (const auto& [key, value] : env->Scope("BENCH_KEY_4"))
+        {
+            benchmark::DoNotOptimize(key);
+            benchmark::DoNotOptimize(value.has_value());
+        }
+    }
+}
+
+BENCHMARK_F(ReadBench, Iterate)(benchmark::State& state)
+{
+    AllocScope allocs(state);
+    for (auto _ : state)
+    {
+        for (const auto& entry : *env)
+        {
+            benchmark::DoNotOptimize(entry);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * 100);
+}
+
+BENCHMARK_F(ReadBench, IterateEntries)(benchmark::State& state)
+{
+    char buffer[64];
+    AllocScope allocs(state);
+    for (auto _ : state)
+    {
+        for (const auto& [key, value] : env->Entries())
+        {
+            benchmark::DoNotOptimize(key);
+            benchmark::DoNotOptimize(value.ToChars(buffer, buffer + sizeof(buffer)));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * 100);
+}
+
+template <typename T>
+struct GetWValues;
+
+template <>
+struct GetWValues<int>
+{
+    static constexpr const char* ok = "12345";
+    static constexpr const char* bad = "x12345";
+};
+
+template <>
+struct GetWValues<long long>
+{
+    static constexpr const char* ok = "1234567890123";
+    static constexpr const char* bad = "99999999999999999999999";
+};
+
+template <>
+struct GetWValues<double>
+{
+    static constexpr const char* ok = "3.14159";
+    static constexpr const char* bad = "abc3.14";
+};
+
+template <>
+struct GetWValues<bool>
+{
+    static constexpr const char* ok = "true";
+    static constexpr const char* bad = "maybe";
+};
+
+template <>
+struct GetWValues<std::string>
+{
+    static constexpr const char* ok = "some string value";
+    // Every non-empty value parses as a string, the empty value takes the default path.
+    static constexpr const char* bad = "";
+};
+
+// range(0): 0 - the value parses, 1 - the parse fails.
+template <typename T>
+static void BM_GetW(benchmark::State& state)
+{
+    const bool fail = state.range(0) != 0;
+    setenv("BENCH_GETW", fail ? GetWValues<T>::bad : GetWValues<T>::ok, 1);
+    const std::string name = "BENCH_GETW";
+    {
+        AllocScope allocs(state);
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(EnvCfg::GetW<T>(name).default_value(T()));
+        }
+    }
+    unsetenv("BENCH_GETW");
+}
+BENCHMARK_TEMPLATE(BM_GetW, int)->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(BM_GetW, long long)->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(BM_GetW, double)->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(BM_GetW, bool)->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(BM_GetW, std::string)->Arg(0)->Arg(1);
+
+template <typename T>
+static void BM_TryGetEnv(benchmark::State& state)
+{
+    setenv("BENCH_GETW", GetWValues<T>::ok, 1);
+    const std::string name = "BENCH_GETW";
+    {
+        AllocScope allocs(state);
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(EnvCfg::TryGetEnv<T>(name));
+        }
+    }
+    unsetenv("BENCH_GETW");
+}
+BENCHMARK_TEMPLATE(BM_TryGetEnv, int);
+BENCHMARK_TEMPLATE(BM_TryGetEnv, double);
+
+template <typename T>
+static void BM_ParseBatch(benchmark::State& state)
+{
+    static const char* const samples[] = {"12345", "-42", "987654321", "TRUE", "no", "1", "0", "False"};
+    std::vector<std::string_view> raw(4096);
+    for (std::size_t i = 0; i < raw.size(); ++i)
+    {
+        raw[i] = samples[std::is_same_v<T, bool> ? 3 + i % 5 : i % 3];
+    }
+    std::unique_ptr<T[]> values(new T[raw.size()]());
+    std::vector<EnvErrc> errors(raw.size());
+    AllocScope allocs(state);
+    for (auto _ : state)
+    {
+        EnvCfg::ParseBatch<T>(raw.data(), raw.size(), values.get(), errors.data());
+        benchmark::DoNotOptimize(values.get());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(raw.size()));
+}
+BENCHMARK_TEMPLATE(BM_ParseBatch, int);
+BENCHMARK_TEMPLATE(BM_ParseBatch, long long);
+BENCHMARK_TEMPLATE(BM_ParseBatch, bool);
+
+// range(0): 0 - the libc environment, 1 - the overlay environment.
+static void BM_SetEnv(benchmark::State& state)
+{
+    if (state.range(0))
+    {
+        EnvCfg::EnableOverlay();
+    }
+    const std::string name = "BENCH_SET";
+    const std::string values[] = {"first value", "second value"};
+    std::size_t i = 0;
+    {
+        AllocScope allocs(state);
+        for (auto _ : state)
+        {
+            EnvCfg::SetEnv(name, values[i++ & 1]);
+        }
+    }
+    EnvCfg::DisableOverlay();
+    unsetenv("BENCH_SET");
+}
+BENCHMARK(BM_SetEnv)->Arg(0)->Arg(1);
+
+// Fills a fresh overlay with range(0) variables; range(1): 0 - one SetEnv per variable, 1 - one SetEnvs batch.
+static void BM_SetEnvsOverlay(benchmark::State& state)
+{
+    std::vector<std::pair<std::string, std::string>> values;
+    for (std::int64_t i = 0; i < state.range(0); ++i)
+    {
+        values.emplace_back("BENCH_BATCH_" + std::to_string(i), "value");
+    }
+    for (auto _ : state)
+    {
+        EnvCfg::EnableOverlay();
+        if (state.range(1))
+        {
+            EnvCfg::SetEnvs(values);
+        }
+        else
+        {
+            for (const auto& entry : values)
+            {
+                EnvCfg::SetEnv(entry.first, entry.second);
+            }
+        }
+        EnvCfg::DisableOverlay();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SetEnvsOverlay)->ArgsProduct({ {64, 1024}, {0, 1} });
+
+BENCHMARK_MAIN();
@@ -0,0 +1,25 @@
+//
+//  libenv.cpp
+//
+//  Copyright (c) 2025 Daniil Aleev. All rights reserved.
+//  MIT License
+//
+//  Compiled mode of libenv.h: build this file once and define CPPLIBENV_COMPILED for every translation
+//  unit that includes the header, e.g. `g++ -std=c++17 -DCPPLIBENV_COMPILED -c libenv.cpp`.
+//
+
+#if !defined(CPPLIBENV_COMPILED)
+#define CPPLIBENV_COMPILED
+#endif
+#define CPPLIBENV_IMPLEMENTATION
+#include "libenv.h"
+
+namespace env_cfg
+{
+#define CPPLIBENV_DEFINE_TYPE(T) CPPLIBENV_INSTANTIATE_TYPE(template, T)
+#define CPPLIBENV_DEFINE_INTEGER(T) CPPLIBENV_INSTANTIATE_INTEGER(template, T)
+#define CPPLIBENV_DEFINE_FLOATING(T) CPPLIBENV_INSTANTIATE_FLOATING(template, T)
+	CPPLIBENV_FOR_EACH_TYPE(CPPLIBENV_DEFINE_TYPE)
+	CPPLIBENV_FOR_EACH_INTEGER(CPPLIBENV_DEFINE_INTEGER)
+	CPPLIBENV_FOR_EACH_FLOATING(CPPLIBENV_DEFINE_FLOATING)
+} // namespace env_cfg
@@ -0,0 +1,59 @@
+//
+//  libenv.cppm
+//
+//  Copyright (c) 2025 Daniil Aleev. All rights reserved.
+//  MIT License
+//
+//  C++20 module interface of libenv.h in the compiled mode: `import libenv;` instead of including the header.
+//  Build it together with libenv.cpp, e.g.
+//  `clang++ -std=c++20 -DCPPLIBENV_COMPILED --precompile -x c++-module libenv.cppm -o libenv.pcm`, then link
+//  `libenv.pcm` compiled with `-c` and libenv.cpp into the program (see tests/module_tests.cpp in CI).
+//  GCC 12 builds the interface but does not export the using declarations to importers.
+//
+
+module;
+
+#if !defined(CPPLIBENV_COMPILED)
+#define CPPLIBENV_COMPILED
+#endif
+#include "libenv.h"
+
+export module libenv;
+
+export namespace env_cfg
+{
+	using env_cfg::EnvCfgTypes;
+	using env_cfg::EnvException;
+	using env_cfg::EnvBadGet;
+	using env_cfg::EnvSetError;
+	using env_cfg::EnvErrc;
+	using env_cfg::EnvResult;
+	using env_cfg::EnvBytes;
+	using env_cfg::EnvSnapshot;
+#if defined(CPPLIBENV_INSTRUMENT)
+	using env_cfg::EnvLatencyHistogram;
+#endif
+	using env_cfg::EnvSource;
+	using env_cfg::EnvFileSource;
+	using env_cfg::EnvAsyncSource;
+	using env_cfg::EnvPrecedence;
+	using env_cfg::EnvBlock;
+	using env_cfg::EnvBlockPool;
+	using env_cfg::EnvInitOptions;
+	using env_cfg::EnvList;
+	using env_cfg::EnvListView;
+	using env_cfg::EnvKey;
+	using env_cfg::EnvCfg;
+	using env_cfg::EnvCfgView;
+	using env_cfg::EnvMap;
+	using env_cfg::EnvFieldDefault;
+	using env_cfg::EnvField;
+	using env_cfg::EnvSchema;
+	using env_cfg::MakeEnvSchema;
+	using env_cfg::EnvBinding;
+	using env_cfg::EnvMatch;
+	using env_cfg::EnvChange;
+	using env_cfg::EnvCfgHolder;
+	using env_cfg::EnvLayer;
+	using env_cfg::EnvLayeredCfg;
+}
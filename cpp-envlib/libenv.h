@@ -9,15 +9,67 @@
 
 #define CPPLIBENV_VERSION "1.1"
 
+// With CPPLIBENV_COMPILED (defined for every translation unit of the program) the header only declares the
+// non-template functions and the parsing templates of the supported types; they are compiled once by
+// libenv.cpp, which defines CPPLIBENV_IMPLEMENTATION.
+#if defined(CPPLIBENV_COMPILED)
+#define CPPLIBENV_INLINE
+#define CPPLIBENV_TEMPLATE
+#else
+#define CPPLIBENV_INLINE inline
+#define CPPLIBENV_TEMPLATE inline
+#endif
+#if !defined(CPPLIBENV_COMPILED) || defined(CPPLIBENV_IMPLEMENTATION)
+#define CPPLIBENV_DEFINITIONS 1
+#else
+#define CPPLIBENV_DEFINITIONS 0
+#endif
+
 #include <string>
+#include <string_view>
 #include <optional>
 #include <variant>
 #include <unordered_map>
+#include <vector>
+#include <array>
+#include <memory>
+#include <functional>
+#include <cstring>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <system_error>
+#include <cstdint>
+#include <chrono>
 #include <type_traits>
 #include <algorithm>
 #include <stdexcept>
 #include <limits>
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
+#include <exception>
+#include <utility>
+#if CPPLIBENV_DEFINITIONS
+// Only the parallel InitEnv starts threads.
+#include <thread>
+#endif
+#if !defined(CPPLIBENV_COMPILED)
+// Not used by the library, kept for code that relies on the header including them.
 #include <iostream>
+#include <cfloat>
+#include <typeinfo>
+#endif
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+extern "C" char** environ;
 
 namespace env_cfg
 {
@@ -27,7 +79,18 @@ namespace env_cfg
 		int_,
 		double_,
 		longlong_,
-		bool_
+		bool_,
+		int16_,
+		uint16_,
+		uint32_,
+		uint64_,
+		float_,
+		/// `std::chrono` durations, e.g. `250ms`, `1.5s`, `1h30m`.
+		duration_,
+		/// Sizes in bytes (`EnvBytes`), e.g. `4096`, `64MiB`, `1.5GB`.
+		bytes_,
+		/// Separated lists declared with `EnvList`, read with `EnvCfg::GetList`.
+		list_
 	};
 	class EnvException : public std::runtime_error
 	{
@@ -57,662 +120,7826 @@ namespace env_cfg
 		EnvSetError(const std::string& message) : EnvException(message, 1) {}
 	};
 
-	class EnvCfg
+	/**
+	* @brief Error codes reported by the non-throwing parsing path (`EnvCfg::ParseValue`, `EnvCfg::TryGetEnv`).
+	*/
+	enum class EnvErrc
+	{
+		ok,
+		empty,             ///< Variable is not set or has an empty value.
+		invalid_format,    ///< Value can not be parsed as the requested type.
+		out_of_range,      ///< Value does not fit into the requested type.
+		fractional,        ///< Integer was requested, but the value contains '.'.
+		unhandled_type,    ///< Requested type is not supported by the parser.
+		source_unavailable ///< The attached source (see `EnvCfg::AttachSource`) failed to fetch its variables.
+	};
+
+	/**
+	* @brief Result of the non-throwing parsing path: either a value of type `T` or an `EnvErrc` code.
+	*
+	* Nothing is formatted or thrown on failure; use `EnvCfg::GetW` or `EnvCfg::Get` when an exception is wanted.
+	*/
+	template <typename T>
+	class EnvResult
 	{
+	public:
+		EnvResult(T value) noexcept(std::is_nothrow_move_constructible_v<T>) : m_value(std::move(value)), m_error(EnvErrc::ok) {}
+		EnvResult(EnvErrc error) noexcept : m_value(), m_error(error) {}
+
+		inline bool has_value() const noexcept
+		{
+			return m_error == EnvErrc::ok;
+		}
+
+		inline explicit operator bool() const noexcept
+		{
+			return has_value();
+		}
+
+		/**
+		* @brief Returns the parsed value. Must only be called if `has_value()` is `true`.
+		*/
+		inline const T& value() const& noexcept
+		{
+			return m_value;
+		}
+
+		inline T&& value() && noexcept
+		{
+			return std::move(m_value);
+		}
+
+		inline EnvErrc error() const noexcept
+		{
+			return m_error;
+		}
 	private:
-		template <typename T, typename = std::enable_if_t <std::disjunction_v <std::is_same<T, int>, std::is_same<T, double>, std::is_same<T, std::string>, std::is_same<T, long long>, std::is_same<T, bool>>>>
-		class EnvDefaultValue
+		T m_value;
+		EnvErrc m_error;
+	};
+
+	/**
+	* @brief Size in bytes, the value type of `EnvCfgTypes::bytes_`.
+	*
+	* Parsed from a number with an optional SI (`KB`, `MB`, ... powers of 1000) or IEC (`KiB`, `MiB`, ... powers
+	* of 1024) unit, letters in any case: `4096`, `512B`, `64MiB`, `1.5GB`.
+	*/
+	class EnvBytes
+	{
+	public:
+		constexpr EnvBytes() noexcept = default;
+		constexpr explicit EnvBytes(std::uint64_t bytes) noexcept : m_bytes(bytes) {}
+
+		inline constexpr std::uint64_t count() const noexcept
+		{
+			return m_bytes;
+		}
+
+		inline constexpr bool operator==(EnvBytes other) const noexcept
+		{
+			return m_bytes == other.m_bytes;
+		}
+
+		inline constexpr bool operator!=(EnvBytes other) const noexcept
+		{
+			return m_bytes != other.m_bytes;
+		}
+	private:
+		std::uint64_t m_bytes = 0;
+	};
+
+	namespace detail
+	{
+		template <typename T>
+		struct TypeIdentity
+		{
+			using type = T;
+		};
+
+		// Keys of an EnvMap holding a '*' are patterns matched against the environment names.
+		inline bool IsEnvPattern(std::string_view env_name) noexcept
+		{
+			return env_name.find('*') != std::string_view::npos;
+		}
+
+		// Trait table of the value types. Every supported type maps to an EnvCfgTypes tag with a `canonical` type
+		// (the one held by EnvValue and produced by parsing) and a `storage` type (the member of a value cell);
+		// `Store`/`Load` convert between the two, `From`/`To` between the canonical type and T.
+		template <typename T, typename = void>
+		struct EnvTypeTraits
+		{
+			static constexpr bool supported = false;
+		};
+
+		template <EnvCfgTypes Type, typename Canonical, typename Storage = Canonical>
+		struct EnvTypeEntry
+		{
+			static constexpr bool supported = true;
+			static constexpr EnvCfgTypes type = Type;
+			using canonical = Canonical;
+			using storage = Storage;
+
+			static constexpr Storage Store(const Canonical& value) noexcept
+			{
+				return value;
+			}
+
+			static constexpr Canonical Load(Storage value) noexcept
+			{
+				return value;
+			}
+		};
+
+		template <typename T, typename Entry>
+		struct EnvSameTraits : Entry
+		{
+			static constexpr T From(const typename Entry::canonical& value) noexcept
+			{
+				return static_cast<T>(value);
+			}
+
+			static constexpr typename Entry::canonical To(const T& value) noexcept
+			{
+				return static_cast<typename Entry::canonical>(value);
+			}
+		};
+
+		// Strings are kept in the arena of the EnvCfg, there is no storage member.
+		template <>
+		struct EnvTypeTraits<std::string>
+		{
+			static constexpr bool supported = true;
+			static constexpr EnvCfgTypes type = EnvCfgTypes::string_;
+			static constexpr const char* name = "string";
+			using canonical = std::string;
+		};
+
+		template <>
+		struct EnvTypeTraits<bool> : EnvSameTraits<bool, EnvTypeEntry<EnvCfgTypes::bool_, bool>>
+		{
+			static constexpr const char* name = "bool";
+		};
+
+		template <>
+		struct EnvTypeTraits<double> : EnvSameTraits<double, EnvTypeEntry<EnvCfgTypes::double_, double>>
+		{
+			static constexpr const char* name = "double";
+		};
+
+		template <>
+		struct EnvTypeTraits<float> : EnvSameTraits<float, EnvTypeEntry<EnvCfgTypes::float_, float>>
+		{
+			static constexpr const char* name = "float";
+		};
+
+		// Integers map to a tag by signedness and width, so e.g. `long`, `std::int64_t` and `long long` share
+		// `longlong_` and `std::size_t` is `uint64_` (or `uint32_`) on every platform.
+		template <bool Signed, std::size_t Size>
+		struct EnvIntegerEntry;
+		template <>
+		struct EnvIntegerEntry<true, 2> : EnvTypeEntry<EnvCfgTypes::int16_, std::int16_t>
+		{
+			static constexpr const char* name = "int16";
+		};
+		template <>
+		struct EnvIntegerEntry<true, 4> : EnvTypeEntry<EnvCfgTypes::int_, int>
+		{
+			static constexpr const char* name = "int";
+		};
+		template <>
+		struct EnvIntegerEntry<true, 8> : EnvTypeEntry<EnvCfgTypes::longlong_, long long>
+		{
+			static constexpr const char* name = "long long";
+		};
+		template <>
+		struct EnvIntegerEntry<false, 2> : EnvTypeEntry<EnvCfgTypes::uint16_, std::uint16_t>
+		{
+			static constexpr const char* name = "uint16";
+		};
+		template <>
+		struct EnvIntegerEntry<false, 4> : EnvTypeEntry<EnvCfgTypes::uint32_, std::uint32_t>
+		{
+			static constexpr const char* name = "uint32";
+		};
+		template <>
+		struct EnvIntegerEntry<false, 8> : EnvTypeEntry<EnvCfgTypes::uint64_, std::uint64_t>
+		{
+			static constexpr const char* name = "uint64";
+		};
+
+		template <typename T>
+		inline constexpr bool is_env_integer_v = std::is_integral_v<T> && sizeof(T) >= 2 && sizeof(T) <= 8
+			&& !std::is_same_v<T, bool> && !std::is_same_v<T, wchar_t> && !std::is_same_v<T, char16_t> && !std::is_same_v<T, char32_t>;
+
+		template <typename T>
+		struct EnvTypeTraits<T, std::enable_if_t<is_env_integer_v<T>>> : EnvSameTraits<T, EnvIntegerEntry<std::is_signed_v<T>, sizeof(T)>>
+		{
+		};
+
+		// Durations are kept in nanoseconds, a read converts them with duration_cast (truncating).
+		template <typename Rep, typename Period>
+		struct EnvTypeTraits<std::chrono::duration<Rep, Period>> : EnvTypeEntry<EnvCfgTypes::duration_, std::chrono::nanoseconds, long long>
+		{
+			static constexpr const char* name = "duration";
+
+			static constexpr long long Store(std::chrono::nanoseconds value) noexcept
+			{
+				return value.count();
+			}
+
+			static constexpr std::chrono::nanoseconds Load(long long value) noexcept
+			{
+				return std::chrono::nanoseconds(value);
+			}
+
+			static constexpr std::chrono::duration<Rep, Period> From(std::chrono::nanoseconds value) noexcept
+			{
+				return std::chrono::duration_cast<std::chrono::duration<Rep, Period>>(value);
+			}
+
+			static constexpr std::chrono::nanoseconds To(std::chrono::duration<Rep, Period> value) noexcept
+			{
+				return std::chrono::duration_cast<std::chrono::nanoseconds>(value);
+			}
+		};
+
+		template <>
+		struct EnvTypeTraits<EnvBytes> : EnvTypeEntry<EnvCfgTypes::bytes_, EnvBytes, std::uint64_t>
+		{
+			static constexpr const char* name = "byte size";
+
+			static constexpr std::uint64_t Store(EnvBytes value) noexcept
+			{
+				return value.count();
+			}
+
+			static constexpr EnvBytes Load(std::uint64_t value) noexcept
+			{
+				return EnvBytes(value);
+			}
+
+			static constexpr EnvBytes From(EnvBytes value) noexcept
+			{
+				return value;
+			}
+
+			static constexpr EnvBytes To(EnvBytes value) noexcept
+			{
+				return value;
+			}
+		};
+
+		template <typename T>
+		inline constexpr bool is_env_type_v = EnvTypeTraits<T>::supported;
+
+		template <typename T>
+		inline constexpr EnvCfgTypes TypeTag() noexcept
+		{
+			return EnvTypeTraits<T>::type;
+		}
+
+		// Number of the scalar types; `list_` follows them and has no canonical type of its own.
+		inline constexpr std::size_t type_count = static_cast<std::size_t>(EnvCfgTypes::bytes_) + 1;
+
+		// Calls `f` with TypeIdentity<T> of the canonical type of `type`, the only switch over the tags.
+		template <class F>
+		inline decltype(auto) DispatchType(EnvCfgTypes type, F&& f)
+		{
+			switch (type)
+			{
+			case EnvCfgTypes::string_:
+				return f(TypeIdentity<std::string>());
+			case EnvCfgTypes::int_:
+				return f(TypeIdentity<int>());
+			case EnvCfgTypes::double_:
+				return f(TypeIdentity<double>());
+			case EnvCfgTypes::longlong_:
+				return f(TypeIdentity<long long>());
+			case EnvCfgTypes::bool_:
+				return f(TypeIdentity<bool>());
+			case EnvCfgTypes::int16_:
+				return f(TypeIdentity<std::int16_t>());
+			case EnvCfgTypes::uint16_:
+				return f(TypeIdentity<std::uint16_t>());
+			case EnvCfgTypes::uint32_:
+				return f(TypeIdentity<std::uint32_t>());
+			case EnvCfgTypes::uint64_:
+				return f(TypeIdentity<std::uint64_t>());
+			case EnvCfgTypes::float_:
+				return f(TypeIdentity<float>());
+			case EnvCfgTypes::duration_:
+				return f(TypeIdentity<std::chrono::nanoseconds>());
+			case EnvCfgTypes::bytes_:
+				return f(TypeIdentity<EnvBytes>());
+			default:
+				throw EnvException("unknown enum type");
+			}
+		}
+	} // namespace detail
+
+	template <std::size_t N>
+	class EnvSchema;
+	struct EnvField;
+	template <class S>
+	class EnvBinding;
+
+	/**
+	* @brief Source of variables that `EnvCfg` resolves keys against besides the process environment, see `EnvCfg::AttachSource`.
+	*
+	* `Find` and `ForEach` are called concurrently by readers and must not modify the source; the views they
+	* return stay valid for the lifetime of the source.
+	*/
+	class EnvSource
+	{
+	public:
+		virtual ~EnvSource() = default;
+		/**
+		* @brief Returns the value of `env_name`, or a view with a null `data()` if the source does not define it.
+		*/
+		virtual std::string_view Find(std::string_view env_name) const noexcept = 0;
+		/**
+		* @brief Calls `f(name, value)` for every variable of the source, in no particular order.
+		*/
+		virtual void ForEach(const std::function<void(std::string_view, std::string_view)>& f) const = 0;
+		/**
+		* @brief Blocks until the source is able to answer `Find`, called by `InitEnv` before it reads any key.
+		*
+		* @throw Whatever made the source unable to provide its variables.
+		*/
+		virtual void Wait() const {}
+	};
+
+	/**
+	* @brief Index over the process environment block, built with a single pass over `environ`.
+	*
+	* Names and values are views into the original environment strings, nothing is copied.
+	* The index does not observe changes made with `setenv`/`unsetenv` after it was built,
+	* except for changes made through `EnvCfg::SetEnv`/`EnvCfg::SetEnvN` while the snapshot mode is enabled.
+	* As an `EnvSource` it freezes the environment of a point in time.
+	*/
+	class EnvSnapshot final : public EnvSource
+	{
+	public:
+		/**
+		* @brief Walks `environ` once and indexes every `NAME=value` entry.
+		*/
+		EnvSnapshot();
+		/**
+		* @brief Returns the value of `env_name`, or a view with a null `data()` if the variable is not set.
+		*/
+		std::string_view Find(std::string_view env_name) const noexcept override;
+		void ForEach(const std::function<void(std::string_view, std::string_view)>& f) const override;
+		/**
+		* @brief Re-reads `env_name` from the live environment and updates the index entry.
+		*/
+		void Update(const std::string& env_name);
+		/**
+		* @brief Calls `f(name, value)` for every indexed variable, in no particular order.
+		*/
+		template <class F>
+		void ForEach(F&& f) const
+		{
+			for (const Entry& entry : m_entries)
+			{
+				if (entry.value)
+				{
+					f(entry.name, std::string_view(entry.value));
+				}
+			}
+		}
+
+		inline std::size_t size() const noexcept
+		{
+			return m_size;
+		}
+	private:
+		struct Entry
+		{
+			std::size_t hash;
+			std::string_view name;
+			const char* value;
+		};
+		void Insert(std::string_view name, const char* value);
+		std::size_t Position(std::string_view env_name, std::size_t hash) const noexcept;
+		void Grow();
+		std::vector<Entry> m_entries;
+		std::size_t m_size = 0;
+	};
+
+	namespace detail
+	{
+		/**
+		* @brief Process wide epoch based reclamation domain for lock-free readers.
+		*
+		* Every reader thread owns a cache line sized record. Entering a read section publishes the current
+		* global epoch in that record, leaving it clears the record. `Retire()` advances the epoch and never
+		* waits: the object is destroyed by a later `Retire()` call once every reader which could have seen it
+		* has left its read section.
+		*/
+		class EpochDomain
 		{
 		public:
-			explicit EnvDefaultValue(const std::optional<T>& value) : EnvDefaultValue(std::string(), value) {}
-			EnvDefaultValue(const std::string& env_name, const std::optional<T>& value) : m_env_name(env_name), m_value(value) {}
-			EnvDefaultValue(const std::string& env_name, const std::optional<T>& value, const EnvBadGet& error) : m_env_name(env_name), m_value(value)
+			struct alignas(64) Record
 			{
-				m_exception = std::make_exception_ptr(error);
+				std::atomic<std::uint64_t> epoch{ 0 };
+				std::atomic<bool> in_use{ false };
+				Record* next = nullptr;
+				std::size_t depth = 0;
+			};
+
+			static EpochDomain& Instance()
+			{
+				static EpochDomain domain;
+				return domain;
 			}
-			EnvDefaultValue(const std::string& env_name, const std::optional<T>& value, const EnvException& error) : m_env_name(env_name), m_value(value)
+
+			inline Record& ThreadRecord()
 			{
-				m_exception = std::make_exception_ptr(error);
+				thread_local RecordOwner owner(*this);
+				return *owner.record;
 			}
-			inline T default_value(T default_value) const noexcept
+
+			inline void Enter(Record& record) noexcept
 			{
-				return m_value.value_or(default_value);
+				if (record.depth++ == 0)
+				{
+					record.epoch.store(m_epoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+				}
 			}
 
-			operator T() const
+			inline void Leave(Record& record) noexcept
 			{
-				if (m_exception)
+				if (--record.depth == 0)
 				{
-					std::rethrow_exception(m_exception);
+					record.epoch.store(0, std::memory_order_release);
 				}
-				if (!m_value)
+			}
+
+			/**
+			* @brief Defers `deleter(ptr)` until no reader section entered before this call is active.
+			*
+			* The object must already be unreachable for new readers. Objects retired earlier whose
+			* readers are gone are destroyed on the calling thread.
+			*/
+			void Retire(void* ptr, void (*deleter)(void*)) noexcept
+			{
+				std::vector<Retired> ready;
 				{
-					if (!m_env_name.empty())
+					std::lock_guard<std::mutex> lock(m_retired_mutex);
+					const std::uint64_t epoch = m_epoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+					try
 					{
-						throw EnvBadGet("no value for " + m_env_name);
+						m_retired.push_back(Retired{ ptr, deleter, epoch });
+						ready.reserve(m_retired.size());
 					}
-					throw EnvBadGet("no value for unknow environment");
+					catch (...)
+					{
+						// Out of memory: the object can not be tracked, leaking it is the only safe option.
+						return;
+					}
+					const std::uint64_t active = OldestActiveEpoch();
+					auto keep = std::partition(m_retired.begin(), m_retired.end(), [active](const Retired& retired) {
+						return retired.epoch > active;
+					});
+					ready.assign(keep, m_retired.end());
+					m_retired.erase(keep, m_retired.end());
+				}
+				for (const Retired& retired : ready)
+				{
+					retired.deleter(retired.ptr);
 				}
-				return m_value.value();
 			}
 		private:
-			std::exception_ptr m_exception;
-			std::optional<T> m_value;
-			std::string m_env_name;
-		};
+			struct RecordOwner
+			{
+				explicit RecordOwner(EpochDomain& domain) : record(domain.Acquire()) {}
+				~RecordOwner()
+				{
+					record->in_use.store(false, std::memory_order_release);
+				}
+				Record* record;
+			};
 
-	public:
-		struct EnvValue {
-			using VariantType = std::variant<int, double, long long, std::string, bool, EnvCfgTypes>;
-			std::optional<VariantType> data;
-	
-			template <typename T>
-			EnvValue(T&& value) {
-				using DecayedT = std::decay_t<T>;
-				static_assert(
-					(std::is_integral_v<DecayedT> && !std::is_same_v<DecayedT, char>) ||
-					std::is_same_v<DecayedT, double> ||
-					std::is_same_v<DecayedT, std::string> ||
-					std::is_same_v<DecayedT, bool> ||
-					std::is_same_v<DecayedT, const char*> ||
-					std::is_same_v<DecayedT, EnvCfgTypes> ||
-					!std::is_same_v<DecayedT, char>, 
-					"Invalid type for EnvValue"
-				);
-				if constexpr (std::is_same_v<DecayedT, const char*>) 
-				{
-					data.emplace(static_cast<std::string>(value));
-				}
-				if constexpr (std::is_integral_v<DecayedT> && !std::is_same_v<DecayedT, bool>) 
-				{
-					static_assert(std::numeric_limits<DecayedT>::max() <= std::numeric_limits<long long>::max(), "integer is larger than long long");
-					if constexpr (std::numeric_limits<DecayedT>::max() <= std::numeric_limits<int>::max())
-					{
-						data.emplace(static_cast<int>(value));
-					}
-					else
+			Record* Acquire()
+			{
+				for (Record* record = m_head.load(std::memory_order_acquire); record; record = record->next)
+				{
+					bool expected = false;
+					if (!record->in_use.load(std::memory_order_relaxed) && record->in_use.compare_exchange_strong(expected, true))
 					{
-						data.emplace(static_cast<long long>(value));
+						return record;
 					}
 				}
-				else 
+				// Records are never freed, threads exiting hand them over to new threads.
+				Record* record = new Record();
+				record->in_use.store(true, std::memory_order_relaxed);
+				Record* head = m_head.load(std::memory_order_relaxed);
+				do
 				{
-					data.emplace(std::forward<T>(value));
+					record->next = head;
+				} while (!m_head.compare_exchange_weak(head, record, std::memory_order_release, std::memory_order_relaxed));
+				return record;
+			}
+
+			struct Retired
+			{
+				void* ptr;
+				void (*deleter)(void*);
+				std::uint64_t epoch;
+			};
+
+			~EpochDomain()
+			{
+				// Runs at exit, no reader sections are active anymore.
+				for (const Retired& retired : m_retired)
+				{
+					retired.deleter(retired.ptr);
 				}
 			}
-				EnvValue(std::nullopt_t) : data(std::nullopt) {}
+
+			std::uint64_t OldestActiveEpoch() const noexcept
+			{
+				std::uint64_t oldest = std::numeric_limits<std::uint64_t>::max();
+				for (Record* record = m_head.load(std::memory_order_acquire); record; record = record->next)
+				{
+					const std::uint64_t reader_epoch = record->epoch.load(std::memory_order_seq_cst);
+					if (reader_epoch != 0 && reader_epoch < oldest)
+					{
+						oldest = reader_epoch;
+					}
+				}
+				return oldest;
+			}
+
+			std::atomic<std::uint64_t> m_epoch{ 1 };
+			std::atomic<Record*> m_head{ nullptr };
+			std::mutex m_retired_mutex;
+			std::vector<Retired> m_retired;
 		};
+
 		/**
-		* @brief Retrieves a pre-initialized environment value by key or returns a default value.
-		*
-		* This method attempts to fetch the value of the environment variable `env_name` initialized via `InitEnv`.
-		* If the value is unavailable (not found, empty, or type mismatch), it returns default value it it was
-		* provided during `InitEnv` initialization.
-		*
-		* @tparam T Supported types: `int`, `double`, `std::string`, `long long`, `bool`.
-		*           Unsupported types will be blocked at compile time.
-		*
-		* @param env_name Key name initialized via `InitEnv`.
-		*
-		* @return T
-		*         - Returns a copy of the initialized value if:
-		*             * Key exists in pre-initialized data
-		*             * Value type matches `T`
-		*             * Value is non-empty
-		*		  - On failure: Throw EnvBadGet exception in cases:
-		*             * Key not found in initialization data
-		*             * Value is empty
-		*             * Type mismatch with stored value
-		* @note This method throw EnvBadGet exception on errors.
-		*/
-		template <typename T, typename = std::enable_if_t <std::disjunction_v <std::is_same<T, int>, std::is_same<T, double>, std::is_same<T, std::string>, std::is_same<T, long long>, std::is_same<T, bool>>>>
-		T Get(const std::string& env_name) const;
-		/**
-		* @brief Checks if the environment configuration data is empty.
-		*
-		* This method verifies whether any environment variables were successfully
-		* initialized and stored during the `InitEnv` call.
-		*
-		* @return bool
-		*         - `true`: No environment data was loaded (container is empty).
-		*         - `false`: Environment data exists (at least one key-value pair is present).
-		*
-		* @note This check is performed on the initialized data, not the system environment.
+		* @brief Read section of the calling thread in `EpochDomain::Instance()`, sections may nest.
 		*/
-		inline bool Empty() const
+		class EpochSection
 		{
-			return m_env_result.empty();
-		}
-		/**
-		* @brief Retrieves a pre-initialized environment value by key or returns a default value.
-		*
-		* This method attempts to fetch the value of the environment variable `env_name` initialized via `InitEnv`.
-		* If the value is unavailable (not found, empty, or type mismatch), it returns default value it it was
-		* provided during `InitEnv` initialization.
-		* @tparam T Supported types: `int`, `double`, `std::string`, `long long`, `bool`.
-		*           Unsupported types will be blocked at compile time.
-		*
-		* @param env_name Environment name used during `InitEnv` initialization.
-		*
-		* @return std::optional<T>
-		*         - Contains a copy of the initialized value if:
-		*             * Key exists in pre-initialized data
-		*             * Value type matches `T`
-		*             * Value is non-empty
-		*         - Returns `std::nullopt` if:
-		*             * Key not found in initialization data
-		*             * Value is empty
-		*             * Type mismatch with stored value
-		*
-		* @note Noexcept guarantee: This method never throws exceptions.
-		**/
-		template <typename T, typename = std::enable_if_t <std::disjunction_v <std::is_same<T, int>, std::is_same<T, double>, std::is_same<T, std::string>, std::is_same<T, long long>, std::is_same<T, bool>>>>
-		std::optional<T> GetN(const std::string& env_name) const noexcept;
-		/**
-		* @brief Checks if a specific environment key has a valid initialized value.
-		*
-		* This method verifies whether the key `env_name` exists in the pre-initialized data via `InitEnv`
-		* and contains a non-empty value of any supported type.
-		*
-		* @param env_name Key name to check in the initialized environment data.
-		*
-		* @return bool
-		*         - `true`: Key exists **and** has a valid value (not `std::nullopt`).
-		*         - `false`: Key does not exist **or** value is empty.
-		*
-		* @note This check is performed only on the data initialized via `InitEnv`,
-		*       not the live system environment.
-		* @note Does not validate the value's type. Use `IsType<T>()` for type-specific checks.
-		*/
-		bool HasValue(const std::string& env_name) const noexcept;
-		/**
-		* @brief Initializes environment configuration from a provided key-value map(EnvCfg::EnvMap).
-		*
-		* This method populates the internal environment store using a map of expected keys
-		* and their type hints or default values. Each entry is processed as follows:
-		* - If the entry contains a value of `EnvCfgTypes`, it attempts to fetch and parse
-		*   the corresponding environment variable to the specified type.
-		* - If the entry contains a direct value (e.g., `int`, `std::string`), it uses it
-		*   as a default if the environment variable is not set.
-		* - If neither the environment variable nor a default value is provided,
-		*   the entry is stored as `std::nullopt`.
-		*
-		* @param env_map A map where:
-		*   - **Key**: Environment variable name (e.g., "PORT")
-		*   - **Value**: Either:
-		*     * A type tag from `EnvCfgTypes` (e.g., `EnvCfgTypes::int_`) to enforce parsing.
-		*
-		* @note This method throw EnvCfgException exception on errors.
-		*/
-		void InitEnv(std::unordered_map<std::string, EnvValue>& env_map);
-		/**
-		* @brief Checks if the initialized environment value for a key matches the specified type.
-		*
-		* This method verifies whether the value stored for the key `env_name` initialized via `InitEnv`
-		* is of type `T` and is non-empty.
-		*
-		* @tparam T Supported types: `int`, `double`, `std::string`, `long long`, `bool`.
-		*           Unsupported types will be blocked at compile time.
-		*
-		* @param env_name Key name to check in the initialized environment data.
-		*
-		* @return bool
-		*         - `true`: If all conditions are met:
-		*             * Key exists in initialized data
-		*             * Value is non-empty
-		*             * Value's type **exactly matches** `T`
-		*         - `false`: If any condition fails:
-		*             * Key does not exist
-		*             * Value is empty
-		*             * Type mismatch
-		*
-		* @note This check is performed only on data initialized via `InitEnv`.
-		* @note For existence check without type validation, use `HasValue()`
-		*/
-		template <typename T, typename = std::enable_if_t <std::disjunction_v <std::is_same<T, int>, std::is_same<T, double>, std::is_same<T, std::string>, std::is_same<T, long long>, std::is_same<T, bool>>>>
-		bool IsType(const std::string& env_name) const noexcept;
-		/**
-		* @brief Retrieves an environment variable and parses it into the specified type.
-		*
-		* This static method fetches the value of the environment variable `env_name`,
-		* converts it to the requested type `T`, and returns a wrapper object `EnvDefaultValue<T>`.
-		* The wrapper provides two ways to access the value:
-		*   1. **Implicit conversion to `T`**: Throws an exception if the value is missing or parsing fails.
-		*   2. **`.default_value(T)`**: Returns a fallback value if the environment variable is missing or empty,
-		*      without throwing exceptions.
-		*
-		* @tparam T Supported types: `int`, `double`, `std::string`, `long long`, `bool`.
-		*           Unsupported types will result in a compile-time error.
-		*
-		* @param env_name Name of the environment variable to retrieve (case-sensitive).
-		*
-		* @return EnvDefaultValue<T>
-		*         - Contains the parsed value, a fallback state, or an exception (if parsing failed).
-		*
-		* @note
-		*   - If parsing fails (e.g., invalid format), the exception is stored in the wrapper
-		*     and will be thrown during implicit conversion to `T`.
-		*   - `.default_value()` does not throw and always returns either the parsed value or the fallback.
-		*/
-		template <typename T, typename = std::enable_if_t <std::disjunction_v <std::is_same<T, int>, std::is_same<T, double>, std::is_same<T, std::string>, std::is_same<T, long long>, std::is_same<T, bool>>>>
-		static const EnvDefaultValue<T> GetW(const std::string& env_name)
+		public:
+			EpochSection() : m_record(EpochDomain::Instance().ThreadRecord())
+			{
+				EpochDomain::Instance().Enter(m_record);
+			}
+			EpochSection(const EpochSection&) = delete;
+			EpochSection& operator=(const EpochSection&) = delete;
+			~EpochSection()
+			{
+				EpochDomain::Instance().Leave(m_record);
+			}
+		private:
+			EpochDomain::Record& m_record;
+		};
+
+		// Read-only private mapping of a whole file, empty files are not mapped.
+		class MappedFile
 		{
-			try
+		public:
+			// `what` names the file in the exception messages, e.g. "env file".
+			MappedFile(const std::string& path, const char* what);
+			MappedFile(const MappedFile&) = delete;
+			MappedFile& operator=(const MappedFile&) = delete;
+			~MappedFile();
+
+			inline const char* data() const noexcept
 			{
-				auto value = GetEnvByType<T>(env_name);
-				if (value)
-				{
-					return EnvDefaultValue<T>(value);
-				}
+				return m_data;
 			}
-			catch (const EnvBadGet& e)
+
+			inline std::size_t size() const noexcept
 			{
-				return EnvDefaultValue<T>(env_name, std::nullopt, e);
+				return m_length;
 			}
-			catch (const EnvException& e)
+		private:
+			const char* m_data = nullptr;
+			std::size_t m_length = 0;
+		};
+
+		// Little-endian encoding of the `bytes` low bytes of `value`, independent of the host byte order.
+		inline void StoreLE(std::string& out, std::uint64_t value, std::size_t bytes)
+		{
+			for (std::size_t i = 0; i < bytes; ++i)
 			{
-				return EnvDefaultValue<T>(env_name, std::nullopt, e);
+				out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
 			}
-			return EnvDefaultValue<T>(env_name, std::nullopt);
 		}
-		/**
-		* @brief Sets an environment variable with the specified name and value.
-		*
-		* @param env_name The name of the environment variable. Must not be empty or contain the '=' character.
-		* @param value The value to assign to the environment variable.
-		* @param overwrite If `true` (default), overwrites an existing variable. If `false`, preserves the existing variable (if present).
-		*
-		* @throw EnvSetError In the following cases:
-		*   - Invalid variable name (empty or contains '=').
-		*   - Failure of the system function `setenv` (e.g., memory allocation error).
-		*
-		* @note
-		*   - Environment variable names cannot contain the '=' character.
-		*   - If `overwrite = false` and the variable already exists, its value remains unchanged.
-		*   - To modify an existing variable, use `overwrite = true`.
-		*   - This method affects the environment of the current process.
-		*/
-		static void SetEnv(const std::string& env_name, const std::string& value, bool overwrite = true);
-		/**
-		* @brief Sets an environment variable (no-throw version) with the specified name and value.
-		*
-		* @param env_name The name of the environment variable.
-		* @param value The value to assign to the environment variable.
-		* @param overwrite If `true`, overwrites an existing variable. If `false`, preserves the existing variable (if present).
-		*
-		* @return `true` if the environment variable was successfully set/updated.
-		* @return `false` if the operation failed (e.g., invalid name, memory error).
-		*
-		* @note
-		*   - Unlike `SetEnv`, this method does not validate the `env_name` format (e.g., empty name or '=' character).
-		*   - This method is `noexcept` and never throws exceptions. Errors are reported via the return value.
-		*/
-		static bool SetEnvN(const std::string& env_name, const std::string& value, bool overwrite = true) noexcept;
-	private:
-		using EnvValueMember = std::optional<std::variant<int, double, long long, std::string, bool>>;
-		class EnvCfgIterator {
-		public:
-			struct VariantToStringVisitor
+
+		inline std::uint64_t LoadLE(const char* data, std::size_t bytes) noexcept
+		{
+			std::uint64_t value = 0;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+			std::memcpy(&value, data, bytes);
+#else
+			for (std::size_t i = 0; i < bytes; ++i)
 			{
-				std::string operator()(int value) const { return std::to_string(value); }
-				std::string operator()(double value) const { return std::to_string(value); }
-				std::string operator()(long long value) const { return std::to_string(value); }
-				std::string operator()(const std::string& value) { return value; }
-				std::string operator()(bool value) const { return value ? "true" : "false"; }
-			};
+				value |= static_cast<std::uint64_t>(static_cast<unsigned char>(data[i])) << (8 * i);
+			}
+#endif
+			return value;
+		}
 
-			using MapIterator = std::unordered_map<std::string, EnvCfg::EnvValueMember>::const_iterator;
+		// Snapshot word of a value cell member: integers sign or zero extended, floating point values as their bits.
+		template <typename S>
+		inline std::uint64_t StorageWord(S value) noexcept
+		{
+			if constexpr (std::is_same_v<S, double>)
+			{
+				std::uint64_t bits;
+				std::memcpy(&bits, &value, sizeof(bits));
+				return bits;
+			}
+			else if constexpr (std::is_same_v<S, float>)
+			{
+				std::uint32_t bits;
+				std::memcpy(&bits, &value, sizeof(bits));
+				return bits;
+			}
+			else if constexpr (std::is_signed_v<S>)
+			{
+				return static_cast<std::uint64_t>(static_cast<long long>(value));
+			}
+			else
+			{
+				return static_cast<std::uint64_t>(value);
+			}
+		}
 
-			EnvCfgIterator(MapIterator  it) : m_it(it) {}
+		// Inverse of StorageWord, false if `word` is not a value of S.
+		template <typename S>
+		inline bool WordStorage(std::uint64_t word, S& out) noexcept
+		{
+			if constexpr (std::is_same_v<S, double>)
+			{
+				std::memcpy(&out, &word, sizeof(word));
+				return true;
+			}
+			else if constexpr (std::is_same_v<S, float>)
+			{
+				const std::uint32_t bits = static_cast<std::uint32_t>(word);
+				std::memcpy(&out, &bits, sizeof(bits));
+				return word == bits;
+			}
+			else if constexpr (std::is_same_v<S, bool>)
+			{
+				out = word != 0;
+				return word <= 1;
+			}
+			else if constexpr (std::is_signed_v<S>)
+			{
+				out = static_cast<S>(static_cast<long long>(word));
+				return static_cast<long long>(out) == static_cast<long long>(word);
+			}
+			else
+			{
+				out = static_cast<S>(word);
+				return out == word;
+			}
+		}
 
-			inline std::string EnvValueToString(const EnvCfg::EnvValueMember& value) const
+		// Stable 64-bit hash of a byte range, the same on every platform and build.
+		inline std::uint64_t Hash64(const char* data, std::size_t size) noexcept
+		{
+			auto mix = [](std::uint64_t h, std::uint64_t word) noexcept {
+				h ^= word * 0xFF51AFD7ED558CCDull;
+				return ((h << 31) | (h >> 33)) * 0x9E3779B97F4A7C15ull;
+			};
+			std::uint64_t h = 0xCBF29CE484222325ull ^ size;
+			for (; size >= 8; data += 8, size -= 8)
 			{
-				if (!value) return "nullopt";
-				return std::visit(VariantToStringVisitor{}, (value.value()));
+				h = mix(h, LoadLE(data, 8));
 			}
+			if (size > 0)
+			{
+				h = mix(h, LoadLE(data, size));
+			}
+			h ^= h >> 33;
+			h *= 0xC4CEB9FE1A85EC53ull;
+			return h ^ (h >> 29);
+		}
 
-			auto operator*() const
+		// Hash identifying the raw value of a variable: 0 if it is not set, never 0 otherwise.
+		inline std::uint64_t RawHash(std::string_view raw) noexcept
+		{
+			if (!raw.data())
 			{
-				return std::make_pair(m_it->first, EnvValueToString(m_it->second));
+				return 0;
 			}
+			const std::uint64_t hash = Hash64(raw.data(), raw.size());
+			return hash ? hash : 1;
+		}
 
-			EnvCfgIterator& operator++()
+		// Copy of a text stored inline up to N characters, longer texts are owned by a std::string.
+		template <std::size_t N>
+		class InlineText
+		{
+		public:
+			InlineText() noexcept = default;
+			explicit InlineText(std::string_view text)
 			{
-				++m_it;
-				return *this;
+				if (text.size() > N)
+				{
+					m_long.assign(text.data(), text.size());
+					return;
+				}
+				m_size = static_cast<std::uint8_t>(text.size());
+				if (m_size > 0)
+				{
+					std::memcpy(m_data, text.data(), m_size);
+				}
 			}
 
-			bool operator!=(const EnvCfgIterator& other) const
+			inline bool empty() const noexcept
 			{
-				return m_it != other.m_it;
+				return m_size == 0 && m_long.empty();
 			}
 
+			std::string str() const
+			{
+				return m_long.empty() ? std::string(m_data, m_size) : m_long;
+			}
 		private:
-			MapIterator m_it;
+			static_assert(N <= 255, "InlineText capacity must fit into one byte");
+			char m_data[N];
+			std::uint8_t m_size = 0;
+			std::string m_long;
 		};
 
-		template <class T>
-		static std::optional<T> GetEnvByType(const std::string& env_name);
-		static std::string GetEnv(const std::string& env_name) noexcept;
-		void ProcessEntry(const std::pair<std::string, EnvValue>& entry);
-		template <typename T>
-		void HandleType(const EnvValue& value, const std::string& env_name);
-		void HandleEnumType(const EnvValue& value, const std::string& env_name);
-		template<typename T>
-		bool TryHandleType(const EnvValue& value, const std::string& env_name);
-		std::unordered_map<std::string, EnvValueMember> m_env_result;
+		// Layout of the files written by EnvCfg::SaveSnapshot: a header, `slot_count` slot records,
+		// `index_size` index buckets and the arena, all integers little-endian.
+		//   header: magic[8] version:u32 header_size:u32 slot_count:u64 index_size:u64 arena_size:u64
+		//           index_seed:u64 checksum:u64 reserved:u64
+		//   slot:   key(offset:u32 length:u32) type:u8 flags:u8 reserved[6] value:u64 fallback:u64 raw_hash:u64
+		//   bucket: hash:u64 slot:u64 (all bits set if empty)
+		// String values are stored as (offset:u32 length:u32) into the arena, doubles as their bit pattern.
+		// `checksum` is Hash64 of everything past the header; `index_seed` is the key hash of a fixed string,
+		// the buckets are only used by a build hashing keys the same way.
+		inline constexpr char snapshot_magic[8] = { 'L', 'I', 'B', 'E', 'N', 'V', 'S', '\x1A' };
+		inline constexpr std::uint32_t snapshot_version = 1;
+		inline constexpr std::size_t snapshot_header_size = 64;
+		inline constexpr std::size_t snapshot_slot_size = 40;
+		inline constexpr std::size_t snapshot_bucket_size = 16;
+		inline constexpr std::string_view snapshot_seed_key = "CPPLIBENV_SNAPSHOT";
+	} // namespace detail
 
-	public:
-		EnvCfgIterator begin() const
+#if defined(CPPLIBENV_INSTRUMENT)
+	/**
+	* @brief Latency histogram collected when the library is compiled with `CPPLIBENV_INSTRUMENT`.
+	*
+	* Bucket `i` counts the durations in [2^i, 2^(i+1)) nanoseconds, the last bucket also counts all longer ones.
+	*/
+	struct EnvLatencyHistogram
+	{
+		static constexpr std::size_t bucket_count = 32;
+		std::array<std::uint64_t, bucket_count> buckets{};
+
+		inline std::uint64_t count() const noexcept
 		{
-			return EnvCfgIterator(m_env_result.begin());
+			std::uint64_t total = 0;
+			for (std::uint64_t bucket : buckets)
+			{
+				total += bucket;
+			}
+			return total;
 		}
 
-		EnvCfgIterator end() const
+		/**
+		* @brief Returns the upper bound in nanoseconds of the bucket holding the quantile `q` in [0, 1], `0` if empty.
+		*/
+		inline std::uint64_t quantile(double q) const noexcept
 		{
-			return EnvCfgIterator(m_env_result.end());
+			const std::uint64_t total = count();
+			if (total == 0)
+			{
+				return 0;
+			}
+			const double rank = std::clamp(q, 0.0, 1.0) * static_cast<double>(total);
+			std::uint64_t seen = 0;
+			for (std::size_t i = 0; i < bucket_count; ++i)
+			{
+				seen += buckets[i];
+				if (seen != 0 && static_cast<double>(seen) >= rank)
+				{
+					return std::uint64_t(2) << i;
+				}
+			}
+			return std::uint64_t(2) << (bucket_count - 1);
 		}
 	};
+#endif
 
-	using EnvMap = std::unordered_map<std::string, EnvCfg::EnvValue>;
+	namespace detail
+	{
+		// Histograms of the parse latency of every EnvCfgTypes value, then the one of InitEnv.
+		inline constexpr std::size_t stat_init_kind = static_cast<std::size_t>(EnvCfgTypes::list_) + 1;
+#if defined(CPPLIBENV_INSTRUMENT)
+		inline constexpr std::size_t stat_kinds = stat_init_kind + 1;
+		// Counters are spread over shards by thread, so that threads of different shards never write the same cache line.
+		inline constexpr std::size_t stat_shards = 16;
 
-	template <typename T, typename>
-	inline T EnvCfg::Get(const std::string& env_name) const
+		inline std::size_t StatShard() noexcept
+		{
+			static std::atomic<std::size_t> next{ 0 };
+			thread_local const std::size_t shard = next.fetch_add(1, std::memory_order_relaxed) % stat_shards;
+			return shard;
+		}
+
+		class EnvLatencyStats
+		{
+		public:
+			static EnvLatencyStats& Instance() noexcept
+			{
+				static EnvLatencyStats stats;
+				return stats;
+			}
+
+			void Record(std::size_t kind, std::uint64_t nanoseconds) noexcept
+			{
+				std::size_t bucket = 0;
+				while (nanoseconds > 1 && bucket + 1 < EnvLatencyHistogram::bucket_count)
+				{
+					nanoseconds >>= 1;
+					++bucket;
+				}
+				m_shards[StatShard()].buckets[kind][bucket].fetch_add(1, std::memory_order_relaxed);
+			}
+
+			EnvLatencyHistogram Histogram(std::size_t kind) const noexcept
+			{
+				EnvLatencyHistogram histogram;
+				for (const Shard& shard : m_shards)
+				{
+					for (std::size_t i = 0; i < EnvLatencyHistogram::bucket_count; ++i)
+					{
+						histogram.buckets[i] += shard.buckets[kind][i].load(std::memory_order_relaxed);
+					}
+				}
+				return histogram;
+			}
+
+			void Reset() noexcept
+			{
+				for (Shard& shard : m_shards)
+				{
+					for (auto& buckets : shard.buckets)
+					{
+						for (auto& bucket : buckets)
+						{
+							bucket.store(0, std::memory_order_relaxed);
+						}
+					}
+				}
+			}
+		private:
+			struct alignas(64) Shard
+			{
+				std::atomic<std::uint64_t> buckets[stat_kinds][EnvLatencyHistogram::bucket_count] = {};
+			};
+			Shard m_shards[stat_shards];
+		};
+
+		// Records the time from its construction to its destruction into the histogram `kind`; nested timers
+		// of the same kind on a thread (InitEnv calling another overload) only record the outermost one.
+		class EnvStatTimer
+		{
+		public:
+			explicit EnvStatTimer(std::size_t kind) noexcept : m_kind(kind), m_outer(Depth()[kind]++ == 0), m_start(std::chrono::steady_clock::now()) {}
+			EnvStatTimer(const EnvStatTimer&) = delete;
+			EnvStatTimer& operator=(const EnvStatTimer&) = delete;
+			~EnvStatTimer()
+			{
+				--Depth()[m_kind];
+				if (m_outer)
+				{
+					const auto elapsed = std::chrono::steady_clock::now() - m_start;
+					EnvLatencyStats::Instance().Record(m_kind, static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+				}
+			}
+		private:
+			static std::array<unsigned, stat_kinds>& Depth() noexcept
+			{
+				thread_local std::array<unsigned, stat_kinds> depth{};
+				return depth;
+			}
+
+			std::size_t m_kind;
+			bool m_outer;
+			std::chrono::steady_clock::time_point m_start;
+		};
+
+		// Read counters of the slots of an EnvCfg, one array per shard. Not copyable: a copied configuration
+		// starts counting from zero.
+		class EnvReadCounters
+		{
+		public:
+			EnvReadCounters() = default;
+			EnvReadCounters(EnvReadCounters&& other) noexcept : m_lines(std::move(other.m_lines)), m_capacity(std::exchange(other.m_capacity, 0)) {}
+			EnvReadCounters& operator=(EnvReadCounters&& other) noexcept
+			{
+				m_lines = std::move(other.m_lines);
+				m_capacity = std::exchange(other.m_capacity, 0);
+				return *this;
+			}
+
+			inline void Count(std::size_t slot) const noexcept
+			{
+				if (slot < m_capacity)
+				{
+					Counter(StatShard(), slot).fetch_add(1, std::memory_order_relaxed);
+				}
+			}
+
+			std::uint64_t Total(std::size_t slot) const noexcept
+			{
+				std::uint64_t total = 0;
+				if (slot < m_capacity)
+				{
+					for (std::size_t shard = 0; shard < stat_shards; ++shard)
+					{
+						total += Counter(shard, slot).load(std::memory_order_relaxed);
+					}
+				}
+				return total;
+			}
+
+			// Makes room for `slots` counters, keeping the counts. Must not run concurrently with Count().
+			void Resize(std::size_t slots)
+			{
+				if (slots <= m_capacity)
+				{
+					return;
+				}
+				const std::size_t capacity = (std::max(slots, m_capacity * 2) + per_line - 1) / per_line * per_line;
+				EnvReadCounters grown;
+				grown.m_lines = std::make_unique<Line[]>(stat_shards * (capacity / per_line));
+				grown.m_capacity = capacity;
+				for (std::size_t shard = 0; shard < stat_shards; ++shard)
+				{
+					for (std::size_t slot = 0; slot < m_capacity; ++slot)
+					{
+						grown.Counter(shard, slot).store(Counter(shard, slot).load(std::memory_order_relaxed), std::memory_order_relaxed);
+					}
+				}
+				*this = std::move(grown);
+			}
+
+			void Reset() noexcept
+			{
+				for (std::size_t shard = 0; shard < stat_shards; ++shard)
+				{
+					for (std::size_t slot = 0; slot < m_capacity; ++slot)
+					{
+						Counter(shard, slot).store(0, std::memory_order_relaxed);
+					}
+				}
+			}
+		private:
+			static constexpr std::size_t per_line = 8;
+			struct alignas(64) Line
+			{
+				std::atomic<std::uint64_t> counters[per_line] = {};
+			};
+
+			inline std::atomic<std::uint64_t>& Counter(std::size_t shard, std::size_t slot) const noexcept
+			{
+				return m_lines[shard * (m_capacity / per_line) + slot / per_line].counters[slot % per_line];
+			}
+
+			std::unique_ptr<Line[]> m_lines;
+			std::size_t m_capacity = 0;
+		};
+#else
+		// Stand-in of the timer of CPPLIBENV_INSTRUMENT builds, compiles to nothing.
+		class EnvStatTimer
+		{
+		public:
+			explicit constexpr EnvStatTimer(std::size_t) noexcept {}
+		};
+#endif
+	} // namespace detail
+
+	/**
+	* @brief Read-only `.env` file mapped into memory and indexed with one pass over its lines.
+	*
+	* Every `KEY=VALUE` line is indexed; blank lines, `#` comments and an `export ` prefix are skipped. Values may
+	* be enclosed in single or double quotes and followed by a `#` comment; unquoted values end at a ` #` comment
+	* and are trimmed. Quoted values are taken verbatim: escapes such as `\"` are not interpreted (`"a\"b"` is
+	* `a\"b`) and a value can not span lines, an unterminated quote is kept as a part of the value. A key repeated
+	* later in the file overrides the earlier line. Names and values are views into the mapping, nothing is copied.
+	* Attach it with `EnvCfg::AttachFile` to resolve `InitEnv`/`GetW` against it.
+	*/
+	class EnvFileSource final : public EnvSource
+	{
+	public:
+		/**
+		* @brief Maps and indexes the file at `path`.
+		*
+		* @throw EnvException if the file can not be opened or mapped.
+		*/
+		explicit EnvFileSource(const std::string& path);
+		EnvFileSource(const EnvFileSource&) = delete;
+		EnvFileSource& operator=(const EnvFileSource&) = delete;
+		~EnvFileSource();
+		/**
+		* @brief Returns the value of `env_name`, or a view with a null `data()` if the file does not define it.
+		*/
+		std::string_view Find(std::string_view env_name) const noexcept override;
+		void ForEach(const std::function<void(std::string_view, std::string_view)>& f) const override;
+		/**
+		* @brief Calls `f(name, value)` for every key, in no particular order.
+		*/
+		template <class F>
+		void ForEach(F&& f) const
+		{
+			for (const Entry& entry : m_entries)
+			{
+				if (entry.name.data())
+				{
+					f(entry.name, entry.value);
+				}
+			}
+		}
+
+		inline std::size_t size() const noexcept
+		{
+			return m_size;
+		}
+	private:
+		struct Entry
+		{
+			std::size_t hash;
+			std::string_view name;
+			std::string_view value;
+		};
+		void Index();
+		void IndexLine(std::string_view line);
+		void Insert(std::string_view name, std::string_view value);
+		std::size_t Position(std::string_view env_name, std::size_t hash) const noexcept;
+		void Grow();
+		detail::MappedFile m_file;
+		std::vector<Entry> m_entries;
+		std::size_t m_size = 0;
+	};
+
+	/**
+	* @brief Source filled by one asynchronous, batched fetch of a set of keys, e.g. from a remote configuration store.
+	*
+	* The constructor hands all keys to `fetcher` in a single call and returns. The fetcher must not block: it
+	* starts the request and completes the `Completion` it was given later, from any thread (an I/O thread, a
+	* completion handler, the continuation of a coroutine), so the startup work overlaps with the network.
+	* `Wait` (called by `InitEnv`), `Find` and `ForEach` wait for the completion. A completion which is destroyed
+	* without having been called fails the fetch.
+	*
+	* @code
+	* auto remote = std::make_shared<env_cfg::EnvAsyncSource>(env_cfg::EnvAsyncSource::Keys(config),
+	*     [&client](std::vector<std::string> keys, env_cfg::EnvAsyncSource::Completion done) {
+	*         client.BatchGet(std::move(keys), [done](Response response) { done(std::move(response.values)); });
+	*     });
+	* // ... other startup work while the request is in flight ...
+	* env_cfg::EnvCfg::AttachSource(remote, env_cfg::EnvPrecedence::source_);
+	* env.InitEnv(config);  // waits for the response, throws if the fetch failed
+	* @endcode
+	*/
+	class EnvAsyncSource final : public EnvSource
+	{
+		struct State;
+	public:
+		using Values = std::vector<std::pair<std::string, std::string>>;
+		/**
+		* @brief Completes the fetch of an `EnvAsyncSource`; copies share the completion and only the first call counts.
+		*/
+		class Completion
+		{
+		public:
+			/**
+			* @brief Completes the fetch with the variables found; keys missing from `values` are not defined by the source.
+			*/
+			void operator()(Values values) const;
+			/**
+			* @brief Fails the fetch, `Wait` re-throws `error` and the source defines no variable.
+			*/
+			void Fail(std::exception_ptr error) const;
+		private:
+			friend class EnvAsyncSource;
+			struct Token;
+			explicit Completion(std::shared_ptr<Token> token) noexcept : m_token(std::move(token)) {}
+			std::shared_ptr<Token> m_token;
+		};
+		using Fetcher = std::function<void(std::vector<std::string> keys, Completion done)>;
+
+		/**
+		* @brief Starts fetching `keys` with one call of `fetcher`.
+		*
+		* @throw Whatever `fetcher` throws, the fetch is failed then.
+		*/
+		EnvAsyncSource(std::vector<std::string> keys, const Fetcher& fetcher);
+		/**
+		* @brief Returns the keys of an `EnvMap` (patterns excluded) to request them in a batch.
+		*/
+		template <class Map>
+		static std::vector<std::string> Keys(const Map& env_map)
+		{
+			std::vector<std::string> keys;
+			keys.reserve(env_map.size());
+			for (const auto& entry : env_map)
+			{
+				if (!detail::IsEnvPattern(entry.first))
+				{
+					keys.push_back(entry.first);
+				}
+			}
+			return keys;
+		}
+		/**
+		* @brief Returns `true` once the fetch completed or failed.
+		*/
+		bool Ready() const noexcept;
+		/**
+		* @brief Waits at most `timeout` for the fetch, returns `Ready()`.
+		*/
+		template <class Rep, class Period>
+		bool WaitFor(const std::chrono::duration<Rep, Period>& timeout) const
+		{
+			std::unique_lock<std::mutex> lock(Mutex());
+			return Completed().wait_for(lock, timeout, [this]() {
+				return Ready();
+			});
+		}
+		/**
+		* @brief Waits for the fetch and re-throws its error, if any.
+		*/
+		void Wait() const override;
+		/**
+		* @brief Waits for the fetch, returns a view with a null `data()` if the key was not fetched or the fetch failed.
+		*/
+		std::string_view Find(std::string_view env_name) const noexcept override;
+		void ForEach(const std::function<void(std::string_view, std::string_view)>& f) const override;
+	private:
+		std::mutex& Mutex() const noexcept;
+		std::condition_variable& Completed() const noexcept;
+		void Await() const noexcept;
+		std::shared_ptr<State> m_state;
+	};
+
+	/**
+	* @brief Which source wins when a key is defined both in the environment and in an attached source (file).
+	*/
+	enum class EnvPrecedence
+	{
+		environment_,
+		file_,
+		source_ = file_
+	};
+
+	class EnvCfg;
+
+	/**
+	* @brief Owning `envp` block, the environment handed to a child process.
+	*
+	* All `NAME=value` strings are stored in one contiguous buffer; `envp()` returns the null-terminated
+	* pointer array expected by `execve`/`posix_spawn`. The pointers stay valid until the next change.
+	* Building a block never touches the environment of the calling process, and `Clear()` keeps the
+	* allocated memory, so a block (or an `EnvBlockPool`) reused across spawns stops allocating once warm.
+	*
+	* @code
+	* env_cfg::EnvCfg::MaterializeEnv(block); // clears the block, then copies the current environment
+	* block.SetAll(job_variables);            // validated, replaces the inherited values
+	* posix_spawn(&pid, path, nullptr, nullptr, argv, block.envp());
+	* @endcode
+	*/
+	class EnvBlock
+	{
+	public:
+		/**
+		* @brief Appends a `NAME=value` entry, names are neither validated nor checked for duplicates.
+		*/
+		void Append(std::string_view env_name, std::string_view value);
+		/**
+		* @brief Sets `env_name` to `value`, replacing the entry of that name (the last one appended) in place.
+		*
+		* @throw EnvSetError If the name is empty or contains `=`, like `EnvCfg::SetEnv`.
+		*/
+		void Set(std::string_view env_name, std::string_view value);
+		/**
+		* @brief Sets every `(name, value)` pair of `values` (e.g. a `std::map` or a vector of pairs).
+		*
+		* All names are validated first, an invalid one leaves the block unchanged.
+		*
+		* @throw EnvSetError If a name is empty or contains `=`.
+		*/
+		template <class Range>
+		void SetAll(const Range& values)
+		{
+			for (const auto& [env_name, value] : values)
+			{
+				CheckName(env_name);
+			}
+			for (const auto& [env_name, value] : values)
+			{
+				Replace(env_name, value);
+			}
+		}
+		/**
+		* @brief Sets the keys of `cfg` which have a value, formatted like `EnvValueRef::ToChars`.
+		*/
+		void SetAll(const EnvCfg& cfg);
+		/**
+		* @brief Returns the value of `env_name`, or a view with a null `data()` if the block does not set it.
+		*/
+		std::string_view Find(std::string_view env_name) const noexcept;
+		/**
+		* @brief Removes all entries and keeps the allocated memory.
+		*/
+		void Clear() noexcept;
+		/**
+		* @brief Reserves room for `entries` entries holding `bytes` characters in total.
+		*/
+		void Reserve(std::size_t entries, std::size_t bytes);
+		/**
+		* @brief Returns the null-terminated `envp` array.
+		*/
+		char* const* envp();
+
+		inline std::size_t size() const noexcept
+		{
+			return m_offsets.size();
+		}
+	private:
+		static void CheckName(std::string_view env_name);
+		void Replace(std::string_view env_name, std::string_view value);
+		std::string_view Name(std::size_t entry) const noexcept;
+		// Bucket of `env_name` in m_index: the one holding its entry, or the empty one it would go to.
+		std::size_t Bucket(std::string_view env_name) const noexcept;
+		void GrowIndex();
+		std::vector<char> m_buffer;
+		std::vector<std::size_t> m_offsets;
+		std::vector<char*> m_envp;
+		// Open addressing table of entry positions + 1, `0` marks an empty bucket; power of two sized.
+		std::vector<std::size_t> m_index;
+	};
+
+	/**
+	* @brief Thread-safe pool of `EnvBlock`s, one buffer per concurrent spawn instead of one per spawn.
+	*
+	* @code
+	* env_cfg::EnvBlockPool pool;
+	* auto block = pool.Acquire();
+	* env_cfg::EnvCfg::MaterializeEnv(*block);
+	* block->SetAll(job_variables);
+	* posix_spawn(&pid, path, nullptr, nullptr, argv, block->envp());
+	* @endcode
+	*
+	* @note The pool must outlive its leases.
+	*/
+	class EnvBlockPool
+	{
+	public:
+		/**
+		* @brief Exclusive use of a pooled block, which is cleared and handed back when the lease is destroyed.
+		*/
+		class Lease
+		{
+		public:
+			Lease(const Lease&) = delete;
+			Lease& operator=(const Lease&) = delete;
+			Lease(Lease&& other) noexcept = default;
+			Lease& operator=(Lease&&) = delete;
+			~Lease()
+			{
+				if (m_block)
+				{
+					m_pool->Release(std::move(m_block));
+				}
+			}
+
+			inline EnvBlock& operator*() const noexcept
+			{
+				return *m_block;
+			}
+
+			inline EnvBlock* operator->() const noexcept
+			{
+				return m_block.get();
+			}
+		private:
+			friend class EnvBlockPool;
+			Lease(EnvBlockPool& pool, std::unique_ptr<EnvBlock> block) noexcept : m_pool(&pool), m_block(std::move(block)) {}
+			EnvBlockPool* m_pool;
+			std::unique_ptr<EnvBlock> m_block;
+		};
+
+		/**
+		* @brief Returns an empty block, reusing a released one if there is any.
+		*/
+		Lease Acquire();
+
+		inline std::size_t idle() const
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_idle.size();
+		}
+	private:
+		void Release(std::unique_ptr<EnvBlock> block) noexcept;
+		mutable std::mutex m_mutex;
+		std::vector<std::unique_ptr<EnvBlock>> m_idle;
+	};
+
+	namespace detail
+	{
+		/**
+		* @brief Process local environment layered over the startup `environ`.
+		*
+		* Values set in the process live in an immutable table which is replaced (copy on write) for every
+		* change and published through an atomic pointer, so readers take no locks. Replaced tables are
+		* reclaimed through `EpochDomain`; `Find()` and `Materialize()` must run inside an `EpochSection`
+		* and the returned views are only valid while the section is active.
+		*/
+		class EnvOverlay
+		{
+		public:
+			EnvOverlay();
+			EnvOverlay(const EnvOverlay&) = delete;
+			EnvOverlay& operator=(const EnvOverlay&) = delete;
+			~EnvOverlay();
+
+			std::string_view Find(std::string_view env_name) const noexcept;
+			/**
+			* @brief Sets `env_name`, returns `false` if the name is empty or contains '='.
+			*/
+			bool Set(std::string_view env_name, std::string_view value, bool overwrite);
+			/**
+			* @brief Sets all `values` with one copy of the table, returns `false` and changes nothing if a name is invalid.
+			*/
+			bool SetAll(const std::vector<std::pair<std::string, std::string>>& values, bool overwrite);
+			void Materialize(EnvBlock& block) const;
+			/**
+			* @brief Calls `f(name, value)` for every variable, the values set in the process shadow the base ones.
+			*/
+			template <class F>
+			void ForEach(F&& f) const
+			{
+				const State* state = m_state.load(std::memory_order_seq_cst);
+				m_base.ForEach([&](std::string_view env_name, std::string_view value) {
+					if (!state->Find(env_name))
+					{
+						f(env_name, value);
+					}
+				});
+				for (const auto& entry : state->entries)
+				{
+					f(std::string_view(entry.first), std::string_view(entry.second));
+				}
+			}
+		private:
+			struct State
+			{
+				std::vector<std::pair<std::string, std::string>> entries;
+				// Open addressing table of entry positions + 1, `0` marks an empty bucket.
+				std::vector<std::size_t> index;
+
+				const std::pair<std::string, std::string>* Find(std::string_view env_name) const noexcept;
+				// Appends an entry and indexes it, the index is rebuilt only when it is half full.
+				void Add(std::string_view env_name, std::string_view value);
+				void Rebuild();
+			};
+			// Applies one change to `next`, `false` if `overwrite` is off and the variable exists.
+			void Apply(State& next, std::string_view env_name, std::string_view value, bool overwrite) const;
+			void Publish(std::unique_ptr<State> next) noexcept;
+			static void DeleteState(void* state) noexcept;
+
+			EnvSnapshot m_base;
+			std::atomic<const State*> m_state;
+			std::mutex m_write_mutex;
+		};
+	} // namespace detail
+
+	/**
+	* @brief Options of `EnvCfg::InitEnv(env_map, options)`.
+	*/
+	struct EnvInitOptions
+	{
+		/// Number of threads used to fetch and parse the entries, `1` processes them on the calling thread.
+		std::size_t threads = 1;
+		/// Minimal number of entries per thread, smaller maps use fewer threads.
+		std::size_t min_entries_per_thread = 256;
+		/// Only records the keys; each key is fetched and parsed by the first read of it, `threads` is ignored.
+		bool lazy = false;
+	};
+
+	/**
+	* @brief Declaration of a list valued key in an `EnvMap`, e.g. `{"BROKERS", env_cfg::EnvList{ env_cfg::EnvCfgTypes::string_ }}`.
+	*
+	* The value is split at `separator` and every element is parsed as `element` once by `InitEnv`; elements
+	* are trimmed of spaces and tabs, an empty element is an error. Any scalar type except `bool_` can be an element.
+	*/
+	struct EnvList
+	{
+		EnvCfgTypes element = EnvCfgTypes::string_;
+		char separator = ',';
+		/// Sorts the elements and drops duplicates, so that `EnvListView::Contains` is a binary search.
+		bool sorted = false;
+		/// Raw value used if the variable is not set or empty, e.g. `"a:9092,b:9092"`.
+		std::string fallback;
+	};
+
+	namespace detail
+	{
+		// Location of a string list element relative to the start of the list text.
+		struct EnvTextRef
+		{
+			std::uint32_t offset;
+			std::uint32_t length;
+		};
+
+		template <typename T, typename = void>
+		inline constexpr bool is_env_list_element_v = std::is_same_v<T, std::string_view>;
+		template <typename T>
+		inline constexpr bool is_env_list_element_v<T, std::enable_if_t<is_env_type_v<T>>> =
+			std::is_same_v<T, typename EnvTypeTraits<T>::canonical> && !std::is_same_v<T, bool> && !std::is_same_v<T, std::string>;
+
+		template <typename T>
+		inline bool ListLess(const T& left, const T& right) noexcept
+		{
+			using Traits = EnvTypeTraits<T>;
+			return Traits::Store(left) < Traits::Store(right);
+		}
+	} // namespace detail
+
+	/**
+	* @brief Read-only contiguous view of the parsed elements of a list, valid until the next `InitEnv`/`Refresh`.
+	*
+	* `T` is the canonical element type: `int`, `double`, `long long`, `std::int16_t`, `std::uint16_t`,
+	* `std::uint32_t`, `std::uint64_t`, `float`, `std::chrono::nanoseconds` or `EnvBytes`.
+	*/
+	template <typename T>
+	class EnvListView
+	{
+	public:
+		using value_type = T;
+		using const_iterator = const T*;
+
+		EnvListView() noexcept = default;
+
+		inline const T* data() const noexcept
+		{
+			return m_data;
+		}
+
+		inline const T* begin() const noexcept
+		{
+			return m_data;
+		}
+
+		inline const T* end() const noexcept
+		{
+			return m_data + m_size;
+		}
+
+		inline std::size_t size() const noexcept
+		{
+			return m_size;
+		}
+
+		inline bool empty() const noexcept
+		{
+			return m_size == 0;
+		}
+
+		inline const T& operator[](std::size_t index) const noexcept
+		{
+			return m_data[index];
+		}
+		/**
+		* @brief Returns `true` if the list holds `value`, a binary search for `EnvList::sorted` lists.
+		*/
+		bool Contains(const T& value) const noexcept
+		{
+			if (m_sorted)
+			{
+				const T* it = std::lower_bound(begin(), end(), value, detail::ListLess<T>);
+				return it != end() && !detail::ListLess(value, *it);
+			}
+			return std::find(begin(), end(), value) != end();
+		}
+
+		inline bool sorted() const noexcept
+		{
+			return m_sorted;
+		}
+	private:
+		friend class EnvCfg;
+		EnvListView(const T* data, std::size_t size, bool sorted) noexcept : m_data(data), m_size(size), m_sorted(sorted) {}
+		const T* m_data = nullptr;
+		std::size_t m_size = 0;
+		bool m_sorted = false;
+	};
+
+	/**
+	* @brief View of the elements of a string list, each one a `std::string_view` into the configuration storage.
+	*/
+	template <>
+	class EnvListView<std::string_view>
+	{
+	public:
+		using value_type = std::string_view;
+
+		class const_iterator
+		{
+		public:
+			using iterator_category = std::random_access_iterator_tag;
+			using value_type = std::string_view;
+			using difference_type = std::ptrdiff_t;
+			using pointer = void;
+			using reference = std::string_view;
+
+			const_iterator() noexcept = default;
+
+			inline std::string_view operator*() const noexcept
+			{
+				return std::string_view(m_text + m_ref->offset, m_ref->length);
+			}
+
+			inline std::string_view operator[](difference_type n) const noexcept
+			{
+				return *(*this + n);
+			}
+
+			inline const_iterator& operator++() noexcept
+			{
+				++m_ref;
+				return *this;
+			}
+
+			inline const_iterator operator++(int) noexcept
+			{
+				const_iterator copy = *this;
+				++m_ref;
+				return copy;
+			}
+
+			inline const_iterator& operator--() noexcept
+			{
+				--m_ref;
+				return *this;
+			}
+
+			inline const_iterator operator--(int) noexcept
+			{
+				const_iterator copy = *this;
+				--m_ref;
+				return copy;
+			}
+
+			inline const_iterator& operator+=(difference_type n) noexcept
+			{
+				m_ref += n;
+				return *this;
+			}
+
+			inline const_iterator& operator-=(difference_type n) noexcept
+			{
+				m_ref -= n;
+				return *this;
+			}
+
+			inline friend const_iterator operator+(const_iterator it, difference_type n) noexcept
+			{
+				return it += n;
+			}
+
+			inline friend const_iterator operator-(const_iterator it, difference_type n) noexcept
+			{
+				return it -= n;
+			}
+
+			inline friend difference_type operator-(const const_iterator& left, const const_iterator& right) noexcept
+			{
+				return left.m_ref - right.m_ref;
+			}
+
+			inline bool operator==(const const_iterator& other) const noexcept
+			{
+				return m_ref == other.m_ref;
+			}
+
+			inline bool operator!=(const const_iterator& other) const noexcept
+			{
+				return m_ref != other.m_ref;
+			}
+
+			inline bool operator<(const const_iterator& other) const noexcept
+			{
+				return m_ref < other.m_ref;
+			}
+		private:
+			friend class EnvListView;
+			const_iterator(const char* text, const detail::EnvTextRef* ref) noexcept : m_text(text), m_ref(ref) {}
+			const char* m_text = nullptr;
+			const detail::EnvTextRef* m_ref = nullptr;
+		};
+
+		EnvListView() noexcept = default;
+
+		inline const_iterator begin() const noexcept
+		{
+			return const_iterator(m_text, m_refs);
+		}
+
+		inline const_iterator end() const noexcept
+		{
+			return const_iterator(m_text, m_refs + m_size);
+		}
+
+		inline std::size_t size() const noexcept
+		{
+			return m_size;
+		}
+
+		inline bool empty() const noexcept
+		{
+			return m_size == 0;
+		}
+
+		inline std::string_view operator[](std::size_t index) const noexcept
+		{
+			return std::string_view(m_text + m_refs[index].offset, m_refs[index].length);
+		}
+		/**
+		* @brief Returns `true` if the list holds `value`, a binary search for `EnvList::sorted` lists.
+		*/
+		bool Contains(std::string_view value) const noexcept
+		{
+			if (m_sorted)
+			{
+				const const_iterator it = std::lower_bound(begin(), end(), value);
+				return it != end() && *it == value;
+			}
+			return std::find(begin(), end(), value) != end();
+		}
+
+		inline bool sorted() const noexcept
+		{
+			return m_sorted;
+		}
+	private:
+		friend class EnvCfg;
+		EnvListView(const char* text, const detail::EnvTextRef* refs, std::size_t size, bool sorted) noexcept : m_text(text), m_refs(refs), m_size(size), m_sorted(sorted) {}
+		const char* m_text = nullptr;
+		const detail::EnvTextRef* m_refs = nullptr;
+		std::size_t m_size = 0;
+		bool m_sorted = false;
+	};
+
+	namespace detail
+	{
+		// Slot indices of an EnvCfg ordered by key, built by the first reader after the keys changed.
+		// Copies and moves start out empty, a moved-from order is emptied as well.
+		class EnvKeyOrder
+		{
+		public:
+			EnvKeyOrder() = default;
+			EnvKeyOrder(const EnvKeyOrder&) noexcept {}
+			EnvKeyOrder(EnvKeyOrder&& other) noexcept
+			{
+				other.Invalidate();
+			}
+			EnvKeyOrder& operator=(const EnvKeyOrder&) noexcept
+			{
+				Invalidate();
+				return *this;
+			}
+			EnvKeyOrder& operator=(EnvKeyOrder&& other) noexcept
+			{
+				Invalidate();
+				other.Invalidate();
+				return *this;
+			}
+			// Must not run concurrently with Get.
+			inline void Invalidate() noexcept
+			{
+				m_ready.store(false, std::memory_order_relaxed);
+			}
+			// `build` fills the order, it is called once until the next Invalidate even by concurrent readers.
+			template <class F>
+			const std::vector<std::uint32_t>& Get(F&& build) const
+			{
+				if (!m_ready.load(std::memory_order_acquire))
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					if (!m_ready.load(std::memory_order_relaxed))
+					{
+						build(m_order);
+						m_ready.store(true, std::memory_order_release);
+					}
+				}
+				return m_order;
+			}
+		private:
+			mutable std::mutex m_mutex;
+			mutable std::atomic<bool> m_ready{ false };
+			mutable std::vector<std::uint32_t> m_order;
+		};
+
+		// Glob patterns (`*` matches any sequence of characters, the empty one included) indexed by a trie over
+		// their literal prefixes, so that a name is matched against all patterns in a single walk over it.
+		class EnvPatternSet
+		{
+		public:
+			static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+			void Add(std::string_view pattern, std::size_t id);
+			// Returns the id of the matching pattern with the most literal characters (the lexicographically
+			// smaller one of equally specific patterns), or npos.
+			std::size_t Match(std::string_view name) const noexcept;
+		private:
+			struct Node
+			{
+				std::vector<std::pair<char, std::uint32_t>> children;
+				// Patterns whose literal prefix ends at this node.
+				std::vector<std::uint32_t> patterns;
+			};
+			struct Pattern
+			{
+				std::string text;
+				// Offset of the first '*' in `text`, the rest is matched by Glob.
+				std::size_t prefix;
+				std::size_t literal;
+				std::size_t id;
+			};
+			static bool Glob(std::string_view pattern, std::string_view name) noexcept;
+			std::vector<Node> m_nodes = std::vector<Node>(1);
+			std::vector<Pattern> m_patterns;
+		};
+	}
+
+	/**
+	* @brief Typed handle to a key initialized via `EnvCfg::InitEnv`.
+	*
+	* Obtained with `EnvCfg::Key<T>()`. Reading through a handle indexes directly into the dense
+	* value storage of the `EnvCfg` it was obtained from, so the key name is not hashed on every read.
+	* A handle stays valid for the lifetime of that `EnvCfg`, repeated `InitEnv` calls included. A handle
+	* beyond the keys of the `EnvCfg` it is used on, e.g. one of an `EnvSchema` the configuration was not
+	* initialized with, is not found: `Get` throws `EnvBadGet`, `GetN` returns `std::nullopt`.
+	*/
+	template <typename T>
+	class EnvKey
+	{
+	public:
+		inline constexpr std::size_t index() const noexcept
+		{
+			return m_index;
+		}
+	private:
+		friend class EnvCfg;
+		template <std::size_t N>
+		friend class EnvSchema;
+		explicit constexpr EnvKey(std::size_t index) noexcept : m_index(index) {}
+		std::size_t m_index;
+	};
+
+	class EnvCfg
+	{
+	private:
+		template <typename T, typename = std::enable_if_t<detail::is_env_type_v<T>>>
+		class EnvDefaultValue
+		{
+		public:
+			explicit EnvDefaultValue(const std::optional<T>& value) : m_value(value) {}
+			EnvDefaultValue(const std::string& env_name, const std::optional<T>& value) : m_value(value), m_error(EnvErrc::empty), m_env_name(env_name) {}
+			EnvDefaultValue(const std::string& env_name, const std::optional<T>& value, const EnvBadGet& error) : EnvDefaultValue(env_name, value)
+			{
+				m_exception = std::make_exception_ptr(error);
+			}
+			EnvDefaultValue(const std::string& env_name, const std::optional<T>& value, const EnvException& error) : EnvDefaultValue(env_name, value)
+			{
+				m_exception = std::make_exception_ptr(error);
+			}
+			EnvDefaultValue(const std::string& env_name, const std::optional<T>& value, std::exception_ptr error) : EnvDefaultValue(env_name, value)
+			{
+				m_exception = std::move(error);
+			}
+			/**
+			* @brief Deferred error: only the code, the key and the raw value are kept (inline up to 64 characters),
+			*        the exception is created by the conversion to `T`.
+			*/
+			EnvDefaultValue(std::string_view env_name, EnvErrc error, std::string_view raw) : m_error(error), m_env_name(env_name), m_raw(raw) {}
+			inline T default_value(T default_value) const noexcept
+			{
+				return m_value.value_or(default_value);
+			}
+
+			operator T() const
+			{
+				if (m_exception)
+				{
+					std::rethrow_exception(m_exception);
+				}
+				if (m_error != EnvErrc::ok && m_error != EnvErrc::empty)
+				{
+					std::rethrow_exception(MakeParseError<T>(m_error, m_raw.str(), m_env_name.str()));
+				}
+				if (!m_value)
+				{
+					if (!m_env_name.empty())
+					{
+						throw EnvBadGet("no value for " + m_env_name.str());
+					}
+					throw EnvBadGet("no value for unknow environment");
+				}
+				return m_value.value();
+			}
+			/**
+			* @brief Returns `EnvErrc::ok` if there is a value, `EnvErrc::empty` if the variable is missing or the parsing error.
+			*/
+			inline EnvErrc error() const noexcept
+			{
+				return m_value ? EnvErrc::ok : m_error;
+			}
+		private:
+			std::exception_ptr m_exception;
+			std::optional<T> m_value;
+			EnvErrc m_error = EnvErrc::ok;
+			detail::InlineText<64> m_env_name;
+			detail::InlineText<64> m_raw;
+		};
+
+	public:
+		struct EnvValue {
+			using VariantType = std::variant<int, double, long long, std::string, bool, EnvCfgTypes, std::int16_t, std::uint16_t, std::uint32_t, std::uint64_t, float, std::chrono::nanoseconds, EnvBytes, EnvList>;
+			std::optional<VariantType> data;
+	
+			template <typename T>
+			EnvValue(T&& value) {
+				using DecayedT = std::decay_t<T>;
+				if constexpr (std::is_same_v<DecayedT, const char*> || std::is_same_v<DecayedT, char*>)
+				{
+					data.emplace(std::in_place_type<std::string>, value);
+				}
+				else if constexpr (std::is_integral_v<DecayedT> && !std::is_same_v<DecayedT, bool>)
+				{
+					// Integer defaults keep their historical types; use Of<T>() for the sized ones.
+					if constexpr (std::numeric_limits<DecayedT>::max() <= std::numeric_limits<int>::max())
+					{
+						data.emplace(static_cast<int>(value));
+					}
+					else if constexpr (std::numeric_limits<DecayedT>::max() <= std::numeric_limits<long long>::max())
+					{
+						data.emplace(static_cast<long long>(value));
+					}
+					else
+					{
+						data.emplace(static_cast<std::uint64_t>(value));
+					}
+				}
+				else if constexpr (std::is_same_v<DecayedT, EnvCfgTypes> || std::is_same_v<DecayedT, std::string> || std::is_same_v<DecayedT, EnvList>)
+				{
+					data.emplace(std::forward<T>(value));
+				}
+				else
+				{
+					static_assert(detail::is_env_type_v<DecayedT>, "Invalid type for EnvValue");
+					using Traits = detail::EnvTypeTraits<DecayedT>;
+					data.emplace(std::in_place_type<typename Traits::canonical>, Traits::To(value));
+				}
+			}
+				EnvValue(std::nullopt_t) : data(std::nullopt) {}
+			/**
+			* @brief Returns a default value declared as exactly `T`, e.g. `EnvValue::Of<std::uint16_t>(8080)`:
+			*        the constructor turns every integer into `int` or `long long`.
+			*/
+			template <typename T, typename = std::enable_if_t<detail::is_env_type_v<T>>>
+			static EnvValue Of(T value)
+			{
+				if constexpr (std::is_same_v<T, std::string>)
+				{
+					return EnvValue(std::move(value));
+				}
+				else
+				{
+					using Traits = detail::EnvTypeTraits<T>;
+					EnvValue result(std::nullopt);
+					result.data.emplace(std::in_place_type<typename Traits::canonical>, Traits::To(value));
+					return result;
+				}
+			}
+		};
+		/**
+		* @brief Retrieves a pre-initialized environment value by key or returns a default value.
+		*
+		* This method attempts to fetch the value of the environment variable `env_name` initialized via `InitEnv`.
+		* If the value is unavailable (not found, empty, or type mismatch), it returns default value it it was
+		* provided during `InitEnv` initialization.
+		*
+		* @tparam T Supported types: `int`, `long long`, `std::int16_t`, `std::uint16_t`, `std::uint32_t`, `std::uint64_t`,
+		*           `double`, `float`, `bool`, `std::string`, any `std::chrono::duration` and `EnvBytes`.
+		*           Keys declared with `EnvList` are read with `GetList`.
+		*           Unsupported types will be blocked at compile time.
+		*
+		* @param env_name Key name initialized via `InitEnv`.
+		*
+		* @return T
+		*         - Returns a copy of the initialized value if:
+		*             * Key exists in pre-initialized data
+		*             * Value type matches `T`
+		*             * Value is non-empty
+		*		  - On failure: Throw EnvBadGet exception in cases:
+		*             * Key not found in initialization data
+		*             * Value is empty
+		*             * Type mismatch with stored value
+		* @note This method throw EnvBadGet exception on errors.
+		*/
+		template <typename T, typename = std::enable_if_t<detail::is_env_type_v<T>>>
+		T Get(std::string_view env_name) const;
+		/**
+		* @brief Checks if the environment configuration data is empty.
+		*
+		* This method verifies whether any environment variables were successfully
+		* initialized and stored during the `InitEnv` call.
+		*
+		* @return bool
+		*         - `true`: No environment data was loaded (container is empty).
+		*         - `false`: Environment data exists (at least one key-value pair is present).
+		*
+		* @note This check is performed on the initialized data, not the system environment.
+		*/
+		inline bool Empty() const
+		{
+			return m_slots.empty();
+		}
+		EnvCfg() = default;
+		/**
+		* @brief Copies the configuration; lazy keys that were not read yet are resolved independently by the copy.
+		*/
+		EnvCfg(const EnvCfg& other);
+		EnvCfg& operator=(const EnvCfg& other);
+		EnvCfg(EnvCfg&&) noexcept = default;
+		EnvCfg& operator=(EnvCfg&&) noexcept = default;
+		/**
+		* @brief Retrieves a pre-initialized environment value by key or returns a default value.
+		*
+		* This method attempts to fetch the value of the environment variable `env_name` initialized via `InitEnv`.
+		* If the value is unavailable (not found, empty, or type mismatch), it returns default value it it was
+		* provided during `InitEnv` initialization.
+		* @tparam T Supported types: `int`, `long long`, `std::int16_t`, `std::uint16_t`, `std::uint32_t`, `std::uint64_t`,
+		*           `double`, `float`, `bool`, `std::string`, any `std::chrono::duration` and `EnvBytes`.
+		*           Keys declared with `EnvList` are read with `GetList`.
+		*           Unsupported types will be blocked at compile time.
+		*
+		* @param env_name Environment name used during `InitEnv` initialization.
+		*
+		* @return std::optional<T>
+		*         - Contains a copy of the initialized value if:
+		*             * Key exists in pre-initialized data
+		*             * Value type matches `T`
+		*             * Value is non-empty
+		*         - Returns `std::nullopt` if:
+		*             * Key not found in initialization data
+		*             * Value is empty
+		*             * Type mismatch with stored value
+		*
+		* @note Noexcept guarantee: This method never throws exceptions.
+		**/
+		template <typename T, typename = std::enable_if_t<detail::is_env_type_v<T>>>
+		std::optional<T> GetN(std::string_view env_name) const noexcept;
+		/**
+		* @brief Checks if a specific environment key has a valid initialized value.
+		*
+		* This method verifies whether the key `env_name` exists in the pre-initialized data via `InitEnv`
+		* and contains a non-empty value of any supported type.
+		*
+		* @param env_name Key name to check in the initialized environment data.
+		*
+		* @return bool
+		*         - `true`: Key exists **and** has a valid value (not `std::nullopt`).
+		*         - `false`: Key does not exist **or** value is empty.
+		*
+		* @note This check is performed only on the data initialized via `InitEnv`,
+		*       not the live system environment.
+		* @note Does not validate the value's type. Use `IsType<T>()` for type-specific checks.
+		*/
+		bool HasValue(std::string_view env_name) const noexcept;
+		/**
+		* @brief Initializes environment configuration from a provided key-value map(EnvCfg::EnvMap).
+		*
+		* This method populates the internal environment store using a map of expected keys
+		* and their type hints or default values. Each entry is processed as follows:
+		* - If the entry contains a value of `EnvCfgTypes`, it attempts to fetch and parse
+		*   the corresponding environment variable to the specified type.
+		* - If the entry contains a direct value (e.g., `int`, `std::string`), it uses it
+		*   as a default if the environment variable is not set.
+		* - If neither the environment variable nor a default value is provided,
+		*   the entry is stored as `std::nullopt`.
+		*
+		* @param env_map A map where:
+		*   - **Key**: Environment variable name (e.g., "PORT")
+		*   - **Value**: Either:
+		*     * A type tag from `EnvCfgTypes` (e.g., `EnvCfgTypes::int_`) to enforce parsing.
+		*
+		* Keys holding a `*` are patterns, `*` matching any sequence of characters (e.g. `{"TENANT_*_QUOTA", EnvCfgTypes::int_}`).
+		* After the other entries the environment is scanned once, all patterns are matched in the same walk over every
+		* name, and each variable matching a pattern is stored with the type or default of the pattern with the most
+		* literal characters. Keys of `env_map` are not overridden by a pattern, the patterns themselves are not stored.
+		*
+		* @note This method throw EnvCfgException exception on errors.
+		*/
+		void InitEnv(std::unordered_map<std::string, EnvValue>& env_map);
+		/**
+		* @brief Initializes environment configuration from a provided key-value map with options (`EnvInitOptions`).
+		*
+		* With `options.threads > 1` the entries are fetched and parsed by a pool of worker threads, each into its
+		* own buffer, and merged afterwards. The result is the same as of `InitEnv(env_map)`: if an entry fails,
+		* the entries preceding it in the map iteration order are stored and its exception is re-thrown.
+		*
+		* With `options.lazy` only the declared type and the default value of each entry are recorded. The first
+		* `Get`/`GetN`/`HasValue`/`IsType` of a key (or iteration) fetches and parses it, exactly once even if several
+		* threads read it concurrently, and the result is memoized. A parsing error is re-thrown by every `Get` of the
+		* key instead of by `InitEnv`, whereas `GetN` returns `std::nullopt`.
+		*
+		* @param env_map A map of expected keys and their type hints or default values, see `InitEnv(env_map)`.
+		* @param options Initialization options.
+		*
+		* @note This method throw EnvCfgException exception on errors.
+		* @note Must not run concurrently with `SetEnv`/`setenv` calls, in the lazy mode this extends to the first reads.
+		*/
+		void InitEnv(std::unordered_map<std::string, EnvValue>& env_map, const EnvInitOptions& options);
+		/**
+		* @brief Initializes environment configuration from a compile-time schema (`EnvSchema`).
+		*
+		* Fields are processed in schema order exactly like `EnvMap` entries, so the handles returned by
+		* `EnvSchema::Key<T>()` can be used with `Get(EnvKey<T>)` on this `EnvCfg`.
+		*
+		* @param schema Schema created with `MakeEnvSchema`.
+		*
+		* @note This method throw EnvException exception on errors, including the case when a schema key
+		*       was already initialized by an earlier `InitEnv` at another position.
+		*/
+		template <std::size_t N>
+		void InitEnv(const EnvSchema<N>& schema);
+		/**
+		* @brief Initializes the fields described by `binding` and copies their values into the struct `out`.
+		*
+		* Every field is processed like an `EnvMap` entry (so `Get`/`GetN` work for it as well) and its value is
+		* assigned to the bound member in the same pass. Members of keys without a value are left unchanged.
+		*
+		* @param binding Field descriptions created with `EnvBinding<S>::Field`.
+		* @param out Struct receiving the values.
+		*
+		* @note This method throw EnvException exception on errors; the members assigned before the failed field keep their values.
+		*/
+		template <class S>
+		void InitEnv(const EnvBinding<S>& binding, S& out);
+		/**
+		* @brief Writes the configuration into a binary snapshot file, see `LoadSnapshot`.
+		*
+		* The snapshot holds the keys, declared types, parsed values and defaults together with the lookup index,
+		* as fixed-size little-endian records of a versioned format, and the hash of the raw value every key was
+		* parsed from. Lazy keys are resolved first. The file is written to a unique temporary file in the same
+		* directory, synced to disk and renamed over `path`, so it is replaced atomically, also when several threads
+		* or processes save the same path concurrently (the last rename wins).
+		*
+		* @param path Path of the snapshot file.
+		*
+		* @note This method throw EnvException exception if the file can not be written, or the exception of a lazy key
+		*       which failed to resolve.
+		*/
+		void SaveSnapshot(const std::string& path) const;
+		/**
+		* @brief Loads a configuration written by `SaveSnapshot` without parsing any value.
+		*
+		* The file is mapped and its records are copied into the storage, the prebuilt index is used as is when the
+		* key hash of this build matches. With `validate` (default) the raw value of every key is hashed and compared
+		* to the hash recorded in the snapshot; keys whose variable changed since `SaveSnapshot` are parsed again (or
+		* fall back to their default), so the result is the same as of a fresh `InitEnv`.
+		*
+		* @code
+		* env_cfg::EnvCfg env = env_cfg::EnvCfg::LoadSnapshot("/var/cache/service/env.snapshot");
+		* @endcode
+		*
+		* @param path Path of the snapshot file.
+		* @param validate Re-resolve the keys whose raw value differs from the recorded one.
+		*
+		* @note This method throw EnvException exception if the file can not be read, is not a snapshot of this
+		*       format version or is corrupt, or the parsing exception of a changed value.
+		*/
+		static EnvCfg LoadSnapshot(const std::string& path, bool validate = true);
+		/**
+		* @brief Re-reads the environment and updates the keys whose raw value changed since they were resolved.
+		*
+		* Every slot remembers a hash of the raw value it was parsed from, so unchanged variables cost one lookup
+		* and a hash, without any conversion. Changed values are parsed like in `InitEnv` (or fall back to their
+		* default); lazy keys that were read are reset and resolved again on their next read, the others are skipped.
+		*
+		* @code
+		* for (std::string_view key : env.Refresh())
+		* {
+		*     std::cout << key << " changed" << std::endl;
+		* }
+		* @endcode
+		*
+		* @return The keys whose value changed, in slot order. The views are valid until the next `InitEnv` or `Refresh`.
+		*
+		* @note This method throw EnvException exception on parsing errors; the configuration is left unchanged then.
+		* @note Not thread-safe: must not be called concurrently with reads of this `EnvCfg`.
+		*/
+		std::vector<std::string_view> Refresh();
+		/**
+		* @brief Like `Refresh()`, then stores the variables newly matching the pattern keys of `env_map`.
+		*
+		* `env_map` is the map the configuration was initialized with. Variables matching one of its pattern keys
+		* (e.g. `"POOL_*_SIZE"`) which are not keys of the configuration yet are resolved like in `InitEnv` and
+		* reported as changed; with `options.lazy` they are stored lazily and not reported. Variables which are no
+		* longer set keep their slot and fall back to their default, like the other keys.
+		*
+		* @note This method throw EnvException exception on parsing errors. The keys found before the failing
+		*       one stay in the configuration then.
+		*/
+		std::vector<std::string_view> Refresh(const std::unordered_map<std::string, EnvValue>& env_map, const EnvInitOptions& options = EnvInitOptions());
+#if defined(CPPLIBENV_INSTRUMENT)
+		/**
+		* @brief Returns how many times every key was read, as (key, reads) pairs in the iteration order of the configuration.
+		*
+		* Only available when the library is compiled with `CPPLIBENV_INSTRUMENT`. Reads by name (`Get`, `GetN`,
+		* `GetView`, `IsType`, `HasValue`, `Key`) and through `EnvKey` handles are counted, summed over all threads;
+		* the counts are kept across `InitEnv` and `Refresh`, a copy of the configuration starts from zero.
+		*
+		* Example:
+		* @code
+		* for (const auto& [key, reads] : env.ReadCounts())
+		* {
+		*     std::cout << key << ": " << reads << std::endl;
+		* }
+		* @endcode
+		*
+		* @note Not thread-safe against `InitEnv` and `Refresh`, concurrent reads may or may not be counted yet.
+		*/
+		std::vector<std::pair<std::string, std::uint64_t>> ReadCounts() const;
+		/**
+		* @brief Sets the read counts of all keys back to zero; not thread-safe against concurrent reads.
+		*/
+		void ResetReadCounts() noexcept;
+		/**
+		* @brief Returns the latency histogram of parsing values of `type` from the environment in the whole process.
+		*
+		* Only available with `CPPLIBENV_INSTRUMENT`. Every conversion made by `InitEnv`, `Refresh`, `LoadSnapshot`
+		* validation and the first read of a lazy key is recorded.
+		*/
+		static EnvLatencyHistogram ParseLatency(EnvCfgTypes type) noexcept;
+		/**
+		* @brief Returns the latency histogram of the `InitEnv` calls in the whole process, only with `CPPLIBENV_INSTRUMENT`.
+		*/
+		static EnvLatencyHistogram InitLatency() noexcept;
+		/**
+		* @brief Clears the histograms returned by `ParseLatency` and `InitLatency`.
+		*/
+		static void ResetLatency() noexcept;
+#endif
+		/**
+		* @brief Checks if the initialized environment value for a key matches the specified type.
+		*
+		* This method verifies whether the value stored for the key `env_name` initialized via `InitEnv`
+		* is of type `T` and is non-empty.
+		*
+		* @tparam T Supported types: `int`, `long long`, `std::int16_t`, `std::uint16_t`, `std::uint32_t`, `std::uint64_t`,
+		*           `double`, `float`, `bool`, `std::string`, any `std::chrono::duration` and `EnvBytes`.
+		*           Keys declared with `EnvList` are read with `GetList`.
+		*           Unsupported types will be blocked at compile time.
+		*
+		* @param env_name Key name to check in the initialized environment data.
+		*
+		* @return bool
+		*         - `true`: If all conditions are met:
+		*             * Key exists in initialized data
+		*             * Value is non-empty
+		*             * Value's type **exactly matches** `T`
+		*         - `false`: If any condition fails:
+		*             * Key does not exist
+		*             * Value is empty
+		*             * Type mismatch
+		*
+		* @note This check is performed only on data initialized via `InitEnv`.
+		* @note For existence check without type validation, use `HasValue()`
+		*/
+		template <typename T, typename = std::enable_if_t<detail::is_env_type_v<T>>>
+		bool IsType(std::string_view env_name) const noexcept;
+		/**
+		* @brief Returns a typed handle for a key initialized via `InitEnv`.
+		*
+		* The handle is resolved once and then used with `Get(EnvKey<T>)`, `GetN(EnvKey<T>)` and
+		* `HasValue(EnvKey<T>)`, which index straight into the value storage instead of looking the key up by name.
+		*
+		* @tparam T Supported types: `int`, `long long`, `std::int16_t`, `std::uint16_t`, `std::uint32_t`, `std::uint64_t`,
+		*           `double`, `float`, `bool`, `std::string`, any `std::chrono::duration` and `EnvBytes`.
+		*           Keys declared with `EnvList` are read with `GetList`.
+		*           Must match the type declared for the key in `InitEnv`.
+		*
+		* @param env_name Key name initialized via `InitEnv`.
+		*
+		* @return EnvKey<T> handle, valid for the lifetime of this `EnvCfg`.
+		*
+		* @note This method throw EnvBadGet exception if the key was not initialized or
+		*       was declared with a different type.
+		*/
+		template <typename T, typename = std::enable_if_t<detail::is_env_type_v<T>>>
+		EnvKey<T> Key(std::string_view env_name) const;
+		/**
+		* @brief Retrieves a pre-initialized environment value by handle.
+		*
+		* @return T copy of the stored value.
+		* @note This method throw EnvBadGet exception if the handle is not found or the value is empty.
+		*/
+		template <typename T>
+		T Get(EnvKey<T> key) const;
+		/**
+		* @brief Retrieves a pre-initialized environment value by handle (no-throw version).
+		*
+		* @return std::optional<T> with a copy of the stored value or `std::nullopt` if the handle is not found or the value is empty.
+		*/
+		template <typename T>
+		std::optional<T> GetN(EnvKey<T> key) const noexcept;
+		/**
+		* @brief Checks if the key behind the handle has a valid initialized value.
+		*/
+		template <typename T>
+		bool HasValue(EnvKey<T> key) const noexcept;
+		/**
+		* @brief Retrieves a pre-initialized string value without copying it.
+		*
+		* String values of an `EnvCfg` live in one arena where equal values are stored once, so the view
+		* neither allocates nor copies.
+		*
+		* @return std::string_view into the configuration, valid until the next `InitEnv` or `Refresh`.
+		* @note This method throw EnvBadGet exception if the key is missing, has no value or is not a string.
+		*/
+		std::string_view GetView(std::string_view env_name) const;
+		/**
+		* @brief Retrieves a pre-initialized string value without copying it (no-throw version).
+		*
+		* @return View of the value, or `std::nullopt` if the key is missing, has no value or is not a string.
+		*/
+		std::optional<std::string_view> GetViewN(std::string_view env_name) const noexcept;
+		/**
+		* @brief Retrieves a pre-initialized string value by handle without copying it.
+		*
+		* @note This method throw EnvBadGet exception if the value is empty.
+		*/
+		std::string_view GetView(EnvKey<std::string> key) const;
+		/**
+		* @brief Retrieves a pre-initialized string value by handle without copying it (no-throw version).
+		*/
+		std::optional<std::string_view> GetViewN(EnvKey<std::string> key) const noexcept;
+		/**
+		* @brief Retrieves the elements of a list declared with `EnvList`, split and parsed once by `InitEnv`.
+		*
+		* @code
+		* env_cfg::EnvMap config = { {"ALLOWED_IDS", env_cfg::EnvList{ env_cfg::EnvCfgTypes::uint64_, ',', true }} };
+		* env.InitEnv(config);
+		* bool allowed = env.GetList<std::uint64_t>("ALLOWED_IDS").Contains(id);
+		* @endcode
+		*
+		* @tparam T The canonical element type, `std::string_view` for `string_` elements.
+		* @return EnvListView<T> into the configuration, valid until the next `InitEnv` or `Refresh`.
+		* @note This method throw EnvBadGet exception if the key is missing, has no value or is not a list of `T`.
+		*/
+		template <typename T, typename = std::enable_if_t<detail::is_env_list_element_v<T>>>
+		EnvListView<T> GetList(std::string_view env_name) const;
+		/**
+		* @brief Retrieves the elements of a list declared with `EnvList` (no-throw version).
+		*
+		* @return The view, or `std::nullopt` if the key is missing, has no value or is not a list of `T`.
+		*/
+		template <typename T, typename = std::enable_if_t<detail::is_env_list_element_v<T>>>
+		std::optional<EnvListView<T>> GetListN(std::string_view env_name) const noexcept;
+		/**
+		* @brief Retrieves an environment variable and parses it into the specified type.
+		*
+		* This static method fetches the value of the environment variable `env_name`,
+		* converts it to the requested type `T`, and returns a wrapper object `EnvDefaultValue<T>`.
+		* The wrapper provides two ways to access the value:
+		*   1. **Implicit conversion to `T`**: Throws an exception if the value is missing or parsing fails.
+		*   2. **`.default_value(T)`**: Returns a fallback value if the environment variable is missing or empty,
+		*      without throwing exceptions.
+		*
+		* @tparam T Supported types: `int`, `long long`, `std::int16_t`, `std::uint16_t`, `std::uint32_t`, `std::uint64_t`,
+		*           `double`, `float`, `bool`, `std::string`, any `std::chrono::duration` and `EnvBytes`.
+		*           Unsupported types will result in a compile-time error.
+		*
+		* @param env_name Name of the environment variable to retrieve (case-sensitive).
+		*
+		* @return EnvDefaultValue<T>
+		*         - Contains the parsed value, a fallback state, or the error (if parsing failed).
+		*
+		* @note
+		*   - If parsing fails (e.g., invalid format), only the error code, the key and the raw value are stored in
+		*     the wrapper; the exception is created and thrown during implicit conversion to `T`.
+		*   - `.default_value()` does not throw and always returns either the parsed value or the fallback.
+		*     Neither it nor `GetW` allocate for a missing or malformed variable whose name and value fit into 64 characters.
+		*   - A source attached with `AttachSource` which is still fetching is waited for; if its fetch failed,
+		*     `GetW` throws that error.
+		*/
+		template <typename T, typename = std::enable_if_t<detail::is_env_type_v<T>>>
+		static const EnvDefaultValue<T> GetW(const std::string& env_name)
+		{
+			WaitSource();
+			return WithEnvView(env_name, [&](std::string_view raw) {
+				EnvResult<T> result = ParseValue<T>(raw);
+				if (result)
+				{
+					return EnvDefaultValue<T>(std::move(result).value());
+				}
+				if (result.error() == EnvErrc::empty)
+				{
+					return EnvDefaultValue<T>(env_name, EnvErrc::empty, std::string_view());
+				}
+				return EnvDefaultValue<T>(env_name, result.error(), raw);
+			});
+		}
+		/**
+		* @brief Retrieves an environment variable and parses it into the specified type without throwing.
+		*
+		* The value returned by `getenv` is parsed in place, so the success path performs no allocations
+		* (except for the returned `std::string` when `T` is `std::string`). Errors are reported as `EnvErrc`
+		* codes and are never formatted.
+		*
+		* @tparam T Supported types: `int`, `long long`, `std::int16_t`, `std::uint16_t`, `std::uint32_t`, `std::uint64_t`,
+		*           `double`, `float`, `bool`, `std::string`, any `std::chrono::duration` and `EnvBytes`.
+		*
+		* @param env_name Name of the environment variable to retrieve (case-sensitive).
+		*
+		* @return EnvResult<T>
+		*         - Contains the parsed value on success.
+		*         - `EnvErrc::empty` if the variable is not set or empty, otherwise the parsing error code.
+		*         - `EnvErrc::source_unavailable` if an attached source failed to fetch its variables.
+		*/
+		template <typename T, typename = std::enable_if_t<detail::is_env_type_v<T>>>
+		static EnvResult<T> TryGetEnv(const std::string& env_name) noexcept
+		{
+			if (!WaitSourceN())
+			{
+				return EnvErrc::source_unavailable;
+			}
+			return WithEnvView(env_name, [](std::string_view raw) noexcept {
+				return ParseValue<T>(raw);
+			});
+		}
+		/**
+		* @brief Parses a raw value into the specified type without throwing.
+		*
+		* Accepts the same input as the `std::stoi`/`std::stoll`/`std::stod` based parsing used by
+		* `InitEnv` and `GetW` (leading whitespace, optional sign, trailing characters are ignored),
+		* but is built on `std::from_chars` and does not allocate. Decimal integers of up to 16 digits are
+		* converted by a vectorized kernel.
+		* Booleans are matched case-insensitively against `true`/`false`, `yes`/`no` and `1`/`0`.
+		*
+		* @tparam T Supported types: `int`, `long long`, `std::int16_t`, `std::uint16_t`, `std::uint32_t`, `std::uint64_t`,
+		*           `double`, `float`, `bool`, `std::string`, any `std::chrono::duration` and `EnvBytes`.
+		*
+		* @param raw Raw value, e.g. the result of `getenv`.
+		*
+		* @return EnvResult<T> with the parsed value or the error code.
+		*/
+		template <typename T, typename = std::enable_if_t<detail::is_env_type_v<T>>>
+		static EnvResult<T> ParseValue(std::string_view raw) noexcept;
+		/**
+		* @brief Parses `count` raw values at once, the bulk counterpart of `ParseValue`.
+		*
+		* @param raw Raw values.
+		* @param count Number of values.
+		* @param values Receives the parsed values, entries of failed values are left unchanged.
+		* @param errors Receives `EnvErrc::ok` or the error code of every value.
+		*/
+		template <typename T, typename = std::enable_if_t<detail::is_env_type_v<T>>>
+		static void ParseBatch(const std::string_view* raw, std::size_t count, T* values, EnvErrc* errors) noexcept;
+		/**
+		* @brief Sets an environment variable with the specified name and value.
+		*
+		* @param env_name The name of the environment variable. Must not be empty or contain the '=' character.
+		* @param value The value to assign to the environment variable.
+		* @param overwrite If `true` (default), overwrites an existing variable. If `false`, preserves the existing variable (if present).
+		*
+		* @throw EnvSetError In the following cases:
+		*   - Invalid variable name (empty or contains '=').
+		*   - Failure of the system function `setenv` (e.g., memory allocation error).
+		*
+		* @note
+		*   - Environment variable names cannot contain the '=' character.
+		*   - If `overwrite = false` and the variable already exists, its value remains unchanged.
+		*   - To modify an existing variable, use `overwrite = true`.
+		*   - This method affects the environment of the current process.
+		*   - While the overlay is enabled (see `EnableOverlay()`), the value is stored in the overlay and
+		*     `setenv` is not called.
+		*/
+		static void SetEnv(const std::string& env_name, const std::string& value, bool overwrite = true);
+		/**
+		* @brief Sets an environment variable (no-throw version) with the specified name and value.
+		*
+		* @param env_name The name of the environment variable.
+		* @param value The value to assign to the environment variable.
+		* @param overwrite If `true`, overwrites an existing variable. If `false`, preserves the existing variable (if present).
+		*
+		* @return `true` if the environment variable was successfully set/updated.
+		* @return `false` if the operation failed (e.g., invalid name, memory error).
+		*
+		* @note
+		*   - Unlike `SetEnv`, this method does not validate the `env_name` format (e.g., empty name or '=' character).
+		*   - This method is `noexcept` and never throws exceptions. Errors are reported via the return value.
+		*/
+		static bool SetEnvN(const std::string& env_name, const std::string& value, bool overwrite = true) noexcept;
+		/**
+		* @brief Sets several environment variables, like `SetEnv` for each `{name, value}` pair in order.
+		*
+		* While the overlay is enabled, the overlay table is copied and published once for the whole batch
+		* instead of once per variable, so setting N variables costs O(N) instead of O(N^2).
+		*
+		* @throw EnvSetError If a name is empty or contains '=' (nothing is set then), or if `setenv` fails.
+		*
+		* @note Without the overlay the variables before a failing `setenv` stay set.
+		*/
+		static void SetEnvs(const std::vector<std::pair<std::string, std::string>>& values, bool overwrite = true);
+		/**
+		* @brief Sets several environment variables (no-throw version of `SetEnvs`).
+		*
+		* @return `false` if a name is invalid (nothing is set then) or if `setenv` failed.
+		*/
+		static bool SetEnvsN(const std::vector<std::pair<std::string, std::string>>& values, bool overwrite = true) noexcept;
+		/**
+		* @brief Enables the snapshot mode: indexes the process environment with one pass over `environ`.
+		*
+		* Until `DisableSnapshot()`, `InitEnv`, `GetW` and `TryGetEnv` resolve variables against the index
+		* instead of calling `getenv` (a linear scan of `environ`) for every key. Calling it again rebuilds the index.
+		*
+		* @note `SetEnv` and `SetEnvN` keep the index up to date. Changes made with `setenv`/`putenv` directly
+		*       are not visible until the next `EnableSnapshot()`.
+		* @note Not thread-safe: must not be called concurrently with other methods reading the environment.
+		*/
+		static void EnableSnapshot();
+		/**
+		* @brief Disables the snapshot mode, variables are read with `getenv` again.
+		*/
+		static void DisableSnapshot() noexcept;
+		/**
+		* @brief Checks if the snapshot mode is enabled.
+		*/
+		static bool IsSnapshotEnabled() noexcept;
+		/**
+		* @brief Enables the overlay environment: a process local layer over the current `environ`.
+		*
+		* While enabled, `SetEnv`/`SetEnvN` store the values in the overlay instead of calling `setenv`, and
+		* `InitEnv`, `GetW` and `TryGetEnv` read the overlay first, then the `environ` captured when it was enabled.
+		* Reads are lock-free and writes are thread-safe, unlike mixing `getenv` and `setenv` across threads.
+		* Overwriting a variable does not leak the previous value. Use `MaterializeEnv()` to pass the resulting
+		* environment to a child process. Does nothing if the overlay is already enabled.
+		*
+		* @note Changes made with `setenv`/`putenv` directly are not visible while the overlay is enabled.
+		*/
+		static void EnableOverlay();
+		/**
+		* @brief Disables the overlay environment, the values set in it are discarded.
+		*
+		* Safe while other threads call `SetEnv`/`SetEnvs`: a write racing with it either lands in the discarded
+		* overlay or falls back to `setenv`.
+		*/
+		static void DisableOverlay() noexcept;
+		/**
+		* @brief Checks if the overlay environment is enabled.
+		*/
+		static bool IsOverlayEnabled() noexcept;
+		/**
+		* @brief Builds the `envp` block of the current environment, the overlay included.
+		*
+		* @code
+		* env_cfg::EnvBlock block = env_cfg::EnvCfg::MaterializeEnv();
+		* posix_spawn(&pid, path, nullptr, nullptr, argv, block.envp());
+		* @endcode
+		*/
+		static EnvBlock MaterializeEnv();
+		/**
+		* @brief Clears `block` and fills it with the current environment, reusing its memory across spawns.
+		*/
+		static void MaterializeEnv(EnvBlock& block);
+		/**
+		* @brief Attaches a `.env` file source to `InitEnv`, `GetW` and `TryGetEnv`, replacing the attached one.
+		*
+		* With `EnvPrecedence::environment_` (default) the file provides the keys which are not set in the
+		* environment (the overlay included), with `EnvPrecedence::file_` the keys defined by the file take
+		* precedence. Lookups stay lock-free; a replaced source is released once no reader uses it.
+		*
+		* @code
+		* env_cfg::EnvCfg::AttachFile(std::make_shared<env_cfg::EnvFileSource>("/etc/service/tenants.env"));
+		* env.InitEnv(config);
+		* @endcode
+		*
+		* @note Variables from the file are not part of `MaterializeEnv()`.
+		*/
+		static void AttachFile(std::shared_ptr<const EnvFileSource> source, EnvPrecedence precedence = EnvPrecedence::environment_);
+		/**
+		* @brief Detaches the file source, if any.
+		*/
+		static void DetachFile() noexcept;
+		/**
+		* @brief Attaches a source of variables (`EnvSource`) like `AttachFile`, replacing the attached source or file.
+		*
+		* `InitEnv` and `Refresh` call `EnvSource::Wait()` first, so a source which is still fetching
+		* (`EnvAsyncSource`) is waited for and its error is thrown from there. The values resolved from the source
+		* are parsed into the same typed storage as the ones from the environment.
+		*
+		* @note Variables from the source are not part of `MaterializeEnv()`.
+		*/
+		static void AttachSource(std::shared_ptr<const EnvSource> source, EnvPrecedence precedence = EnvPrecedence::environment_);
+		/**
+		* @brief Detaches the attached source or file, if any.
+		*/
+		static void DetachSource() noexcept;
+	private:
+		using EnvValueMember = std::optional<std::variant<int, double, long long, std::string, bool, std::int16_t, std::uint16_t, std::uint32_t, std::uint64_t, float, std::chrono::nanoseconds, EnvBytes>>;
+		// Location of a key or a string value inside m_arena.
+		struct EnvArenaRef
+		{
+			std::uint32_t offset;
+			std::uint32_t length;
+		};
+		// Tagged value cell of the flat storage, `type` is the type declared for the key in `InitEnv`.
+		struct EnvCell
+		{
+			union
+			{
+				int int_value;
+				double double_value;
+				long long longlong_value;
+				bool bool_value;
+				EnvArenaRef string_value;
+				std::int16_t int16_value;
+				std::uint16_t uint16_value;
+				std::uint32_t uint32_value;
+				std::uint64_t uint64_value;
+				float float_value;
+			};
+			EnvCfgTypes type;
+			bool has_value;
+			// The value is resolved on first use into m_lazy[slot], `type` is the declared type.
+			bool lazy;
+		};
+		// Member of `cell` (EnvCell or const EnvCell) holding the values of storage type S, see detail::EnvTypeTraits.
+		template <typename S, typename Cell>
+		static inline auto& CellStorage(Cell& cell) noexcept
+		{
+			if constexpr (std::is_same_v<S, int>)
+			{
+				return cell.int_value;
+			}
+			else if constexpr (std::is_same_v<S, double>)
+			{
+				return cell.double_value;
+			}
+			else if constexpr (std::is_same_v<S, long long>)
+			{
+				return cell.longlong_value;
+			}
+			else if constexpr (std::is_same_v<S, bool>)
+			{
+				return cell.bool_value;
+			}
+			else if constexpr (std::is_same_v<S, std::int16_t>)
+			{
+				return cell.int16_value;
+			}
+			else if constexpr (std::is_same_v<S, std::uint16_t>)
+			{
+				return cell.uint16_value;
+			}
+			else if constexpr (std::is_same_v<S, std::uint32_t>)
+			{
+				return cell.uint32_value;
+			}
+			else if constexpr (std::is_same_v<S, std::uint64_t>)
+			{
+				return cell.uint64_value;
+			}
+			else
+			{
+				static_assert(std::is_same_v<S, float>, "no cell member for the storage type");
+				return cell.float_value;
+			}
+		}
+		struct EnvSlot
+		{
+			EnvArenaRef key;
+			EnvCell cell;
+		};
+		class EnvCfgIterator {
+		public:
+			EnvCfgIterator(const EnvCfg* cfg, std::size_t index) : m_cfg(cfg), m_index(index) {}
+
+			inline std::string EnvValueToString(const EnvCfg::EnvSlot& slot) const
+			{
+				const EnvCfg::EnvCell& cell = m_cfg->SlotCell(slot);
+				if (!cell.has_value) return "nullopt";
+				switch (cell.type)
+				{
+				case EnvCfgTypes::string_:
+				case EnvCfgTypes::list_:
+					return std::string(m_cfg->CellString(slot, cell));
+				case EnvCfgTypes::int_:
+					return std::to_string(cell.int_value);
+				case EnvCfgTypes::double_:
+					return std::to_string(cell.double_value);
+				case EnvCfgTypes::longlong_:
+					return std::to_string(cell.longlong_value);
+				case EnvCfgTypes::bool_:
+					return cell.bool_value ? "true" : "false";
+				default:
+				{
+					char buffer[64];
+					const std::to_chars_result result = EnvValueRef(*m_cfg, slot).ToChars(buffer, buffer + sizeof(buffer));
+					return std::string(buffer, result.ptr);
+				}
+				}
+			}
+
+			auto operator*() const
+			{
+				const EnvSlot& slot = m_cfg->m_slots[m_index];
+				return std::make_pair(std::string(m_cfg->ArenaView(slot.key)), EnvValueToString(slot));
+			}
+
+			EnvCfgIterator& operator++()
+			{
+				++m_index;
+				return *this;
+			}
+
+			bool operator!=(const EnvCfgIterator& other) const
+			{
+				return m_index != other.m_index || m_cfg != other.m_cfg;
+			}
+
+		private:
+			const EnvCfg* m_cfg;
+			std::size_t m_index;
+		};
+
+		template <class T>
+		static std::optional<T> ParseEnv(std::string_view raw, const std::string& env_name);
+		static EnvValueMember ParseMember(EnvCfgTypes type, std::string_view raw, const std::string& env_name);
+		// Calls `f` with the raw value of `env_name`; the view is only valid during the call. The attached source
+		// must have been waited for (WaitSource), otherwise its fetch blocks inside the read section.
+		template <class F>
+		static auto WithEnvView(const std::string& env_name, F&& f);
+		static std::string_view GetEnvView(const std::string& env_name) noexcept;
+		static std::unique_ptr<EnvSnapshot>& Snapshot() noexcept;
+		static std::atomic<detail::EnvOverlay*>& Overlay() noexcept;
+		struct EnvSourceBinding
+		{
+			std::shared_ptr<const EnvSource> source;
+			EnvPrecedence precedence;
+		};
+		static std::atomic<EnvSourceBinding*>& Source() noexcept;
+		// Calls EnvSource::Wait() of the attached source outside of any EpochSection.
+		static void WaitSource();
+		// Like WaitSource(), returns false instead of throwing the error of the source.
+		static bool WaitSourceN() noexcept;
+		// Resolves `env_name` against the overlay and the attached file, must run inside an EpochSection.
+		static std::string_view ResolveView(const std::string& env_name) noexcept;
+		// Calls `f(name, value)` for every variable `ResolveView` finds with the value it resolves to, in one pass
+		// over the sources; must run inside an EpochSection if the overlay or a file is enabled.
+		template <class F>
+		static void ForEachEnv(F&& f);
+		// Stores the variables matched by the pattern keys of `env_map` which are not keys of `env_map` themselves,
+		// with `only_new` only those which are not keys of the configuration yet.
+		void InitPatterns(const std::unordered_map<std::string, EnvValue>& env_map, bool lazy, bool only_new = false);
+		template <class T>
+		static EnvErrc ParseInteger(std::string_view raw, T& out, const char*& end) noexcept;
+		template <class T>
+		static EnvErrc ParseFloating(std::string_view raw, T& out) noexcept;
+		template <class T>
+		static std::exception_ptr MakeParseError(EnvErrc error, std::string_view raw, const std::string& env_name);
+		// Parsed elements of a list slot; the text of the list is the string value of its cell, string elements
+		// are located relative to the start of that text.
+		using EnvListValues = std::variant<std::vector<detail::EnvTextRef>, std::vector<int>, std::vector<double>, std::vector<long long>,
+			std::vector<std::int16_t>, std::vector<std::uint16_t>, std::vector<std::uint32_t>, std::vector<std::uint64_t>, std::vector<float>,
+			std::vector<std::chrono::nanoseconds>, std::vector<EnvBytes>>;
+		struct EnvListData
+		{
+			EnvCfgTypes element;
+			char separator;
+			bool sorted;
+			EnvListValues values;
+		};
+		// Value resolved from the environment or the default, before it is stored into a slot.
+		struct EnvResolved
+		{
+			EnvCfgTypes type;
+			EnvValueMember value;
+			std::uint64_t raw_hash;
+			// Elements of a `list_` value, the value holds their text.
+			std::unique_ptr<EnvListData> list;
+		};
+		std::size_t ProcessEntry(const std::string& env_name, const EnvValue& default_value);
+		// Fetches `env_name` and resolves it with ResolveRaw.
+		static EnvResolved ResolveEntry(const std::string& env_name, const EnvValue& default_value);
+		// Parses the raw value of `env_name` (empty if it is not set) or falls back to the default.
+		static EnvResolved ResolveRaw(const std::string& env_name, const EnvValue& default_value, std::string_view raw);
+		static EnvValue FieldValue(const EnvField& field);
+		template <typename T>
+		static EnvResolved HandleType(const EnvValue& value, std::string_view raw, const std::string& env_name);
+		static EnvResolved HandleEnumType(const EnvValue& value, std::string_view raw, const std::string& env_name);
+		static EnvResolved HandleList(const EnvList& list, std::string_view raw, const std::string& env_name);
+		// Splits `raw` (`fallback` if `raw` is empty) into the elements of `list`, returns the text of the value.
+		static EnvValueMember ParseListValue(EnvListData& list, std::string_view raw, std::string_view fallback, const std::string& env_name);
+		static void ParseList(EnvListData& list, std::string_view text, const std::string& env_name);
+		template <typename T>
+		std::optional<EnvListView<T>> ListView(const EnvSlot& slot) const noexcept;
+		const EnvSlot* FindSlot(std::string_view env_name) const noexcept;
+		std::size_t StoreValue(const std::string& env_name, EnvResolved resolved, const EnvValue& default_value);
+		template <typename T>
+		static bool CellHolds(const EnvCell& cell) noexcept;
+		template <typename T>
+		T CellValue(const EnvSlot& slot, const EnvCell& cell) const;
+		// Lazily resolved value of a slot recorded by InitEnv with `EnvInitOptions::lazy`.
+		struct EnvLazySlot
+		{
+			explicit EnvLazySlot(const EnvValue& value) : default_value(value) {}
+			std::once_flag once;
+			EnvValue default_value;
+			EnvCell cell{};
+			std::string text;
+			std::exception_ptr error;
+			std::uint64_t raw_hash = 0;
+			bool resolved = false;
+		};
+		// How the value of a slot was obtained, to check it against the environment later on.
+		struct EnvSlotOrigin
+		{
+			// detail::RawHash of the raw value the cell was resolved from, lazy slots keep it in their record.
+			std::uint64_t raw_hash;
+			// Default value of the key, `has_value` is false if there is none.
+			EnvCell fallback;
+		};
+		template <class F>
+		static EnvCell MakeCell(EnvCfgTypes type, EnvValueMember& value, F&& store_string);
+		static EnvCfgTypes DeclaredType(const EnvValue& value);
+		void StoreLazy(const std::string& env_name, const EnvValue& default_value);
+		EnvCell MakeFallback(const EnvValue& default_value);
+		std::size_t PlaceCell(const std::string& env_name, const EnvCell& cell, const EnvSlotOrigin& origin);
+		// Parses again the values whose raw value changed since they were resolved, returns their slots. The raw
+		// values are looked up in `source` if given, in the environment otherwise.
+		std::vector<std::size_t> RevalidateSlots(const EnvSource* source = nullptr);
+		// Stores the keys of `env_map` resolved against `source` alone, pattern keys are rejected.
+		void InitSource(const std::unordered_map<std::string, EnvValue>& env_map, const EnvSource& source);
+		friend class EnvLayeredCfg;
+		const EnvCell& SlotCell(const EnvSlot& slot) const noexcept;
+		void ResolveLazy(const EnvSlot& slot, EnvLazySlot& lazy) const noexcept;
+		void ThrowLazyError(const EnvSlot& slot) const;
+		std::string_view CellString(const EnvSlot& slot, const EnvCell& cell) const noexcept;
+		// Strings and the text of lists are kept in the arena.
+		static inline bool InArena(const EnvCell& cell) noexcept
+		{
+			return cell.has_value && (cell.type == EnvCfgTypes::string_ || cell.type == EnvCfgTypes::list_);
+		}
+		inline std::string_view ArenaView(EnvArenaRef ref) const noexcept
+		{
+			return std::string_view(m_arena.data() + ref.offset, ref.length);
+		}
+		EnvArenaRef ArenaAppend(std::string_view value);
+		void Compact();
+		// Open addressing index over m_slots, so lookups by std::string_view neither allocate nor copy the key.
+		struct EnvIndexEntry
+		{
+			std::size_t hash;
+			std::size_t slot;
+		};
+		static constexpr std::size_t npos_slot = static_cast<std::size_t>(-1);
+		static std::size_t HashKey(std::string_view env_name) noexcept;
+		std::size_t FindSlotIndex(std::string_view env_name, std::size_t hash) const noexcept;
+		void InsertIndex(std::size_t hash, std::size_t slot) noexcept;
+		void GrowIndex();
+		std::vector<EnvSlot> m_slots;
+		std::vector<EnvIndexEntry> m_env_result;
+		// Keys and string values of all slots; strings replaced by a later InitEnv are counted in
+		// m_arena_garbage until Compact() lays the arena out again.
+		std::string m_arena;
+		std::size_t m_arena_garbage = 0;
+		// Records of the lazy slots by slot index, empty for the eagerly stored ones.
+		std::vector<std::unique_ptr<EnvLazySlot>> m_lazy;
+		// Origins of the slots by slot index, always as long as m_slots.
+		std::vector<EnvSlotOrigin> m_origins;
+		// Elements of the list slots by slot index, set for every slot of type `list_`.
+		std::vector<std::unique_ptr<EnvListData>> m_lists;
+		detail::EnvKeyOrder m_key_order;
+#if defined(CPPLIBENV_INSTRUMENT)
+		detail::EnvReadCounters m_reads;
+#endif
+		inline void CountRead(std::size_t slot) const noexcept
+		{
+#if defined(CPPLIBENV_INSTRUMENT)
+			m_reads.Count(slot);
+#else
+			(void)slot;
+#endif
+		}
+
+	public:
+		EnvCfgIterator begin() const
+		{
+			return EnvCfgIterator(this, 0);
+		}
+
+		EnvCfgIterator end() const
+		{
+			return EnvCfgIterator(this, m_slots.size());
+		}
+
+		/**
+		* @brief Non-owning typed reference to an initialized value, valid until the next `InitEnv`.
+		*/
+		class EnvValueRef
+		{
+		public:
+			/**
+			* @brief Returns the type declared for the key in `InitEnv`.
+			*/
+			inline EnvCfgTypes type() const noexcept
+			{
+				return m_cell->type;
+			}
+
+			inline bool has_value() const noexcept
+			{
+				return m_cell->has_value;
+			}
+			/**
+			* @brief Returns the value if it holds `T` (`std::string_view` is accepted for strings), otherwise `std::nullopt`.
+			*/
+			template <typename T>
+			std::optional<T> GetN() const noexcept;
+			/**
+			* @brief Calls `f` with the value as the canonical type of its `EnvCfgTypes` (`int`, `double`, `long long`,
+			*        `bool`, `std::string_view`, `std::int16_t`, `std::uint16_t`, `std::uint32_t`, `std::uint64_t`, `float`,
+			*        `std::chrono::nanoseconds`, `EnvBytes`), or `std::nullopt` if there is no value.
+			*/
+			template <class F>
+			decltype(auto) Visit(F&& f) const;
+			/**
+			* @brief Writes the textual form of the value into `[first, last)` without allocating.
+			*
+			* Numbers are formatted with `std::to_chars` (the shortest round-trip form for `double`), booleans
+			* as `true`/`false`, durations and byte sizes with the largest exact unit (`90m`, `64MiB`), a missing
+			* value as `nullopt`. Nothing is terminated with '\0'.
+			*
+			* @return `std::to_chars_result`; `ec` is `std::errc::value_too_large` if the buffer is too small.
+			*/
+			std::to_chars_result ToChars(char* first, char* last) const noexcept;
+		private:
+			friend class EnvCfg;
+			EnvValueRef(const EnvCfg& cfg, const EnvSlot& slot) noexcept : m_cfg(&cfg), m_slot(&slot), m_cell(&cfg.SlotCell(slot)) {}
+			const EnvCfg* m_cfg;
+			const EnvSlot* m_slot;
+			const EnvCell* m_cell;
+		};
+
+		/**
+		* @brief Element of `Entries()`: the key and a reference to its value.
+		*/
+		struct EnvEntry
+		{
+			std::string_view key;
+			EnvValueRef value;
+		};
+
+		class EnvEntryIterator
+		{
+		public:
+			inline EnvEntry operator*() const noexcept
+			{
+				const EnvSlot& slot = m_cfg->m_slots[m_index];
+				return EnvEntry{ m_cfg->ArenaView(slot.key), EnvValueRef(*m_cfg, slot) };
+			}
+
+			inline EnvEntryIterator& operator++() noexcept
+			{
+				++m_index;
+				return *this;
+			}
+
+			inline bool operator==(const EnvEntryIterator& other) const noexcept
+			{
+				return m_index == other.m_index && m_cfg == other.m_cfg;
+			}
+
+			inline bool operator!=(const EnvEntryIterator& other) const noexcept
+			{
+				return !(*this == other);
+			}
+		private:
+			friend class EnvCfg;
+			EnvEntryIterator(const EnvCfg* cfg, std::size_t index) noexcept : m_cfg(cfg), m_index(index) {}
+			const EnvCfg* m_cfg;
+			std::size_t m_index;
+		};
+
+		struct EnvEntryRange
+		{
+			EnvEntryIterator first;
+			EnvEntryIterator last;
+
+			inline EnvEntryIterator begin() const noexcept
+			{
+				return first;
+			}
+
+			inline EnvEntryIterator end() const noexcept
+			{
+				return last;
+			}
+
+			inline std::size_t size() const noexcept
+			{
+				return last.m_index - first.m_index;
+			}
+		};
+		/**
+		* @brief Returns a view over the initialized keys which neither copies nor formats anything.
+		*
+		* @code
+		* char buffer[64];
+		* for (const auto& [key, value] : env.Entries())
+		* {
+		*     auto [end, ec] = value.ToChars(buffer, buffer + sizeof(buffer));
+		*     if (ec == std::errc()) exporter.Write(key, std::string_view(buffer, end - buffer));
+		* }
+		* @endcode
+		*
+		* An iteration in the lazy mode (`EnvInitOptions::lazy`) resolves the values it dereferences.
+		*/
+		inline EnvEntryRange Entries() const noexcept
+		{
+			return EnvEntryRange{ EnvEntryIterator(this, 0), EnvEntryIterator(this, m_slots.size()) };
+		}
+
+		/**
+		* @brief Non-owning view of the keys that start with a prefix, see `Scope`. Valid until the next `InitEnv`
+		*        of the `EnvCfg` it was obtained from.
+		*
+		* Keys are passed to and enumerated from the view without the prefix. Lookups search the sorted keys of
+		* the scope, so neither the prefix is concatenated nor the key hashed.
+		*/
+		class EnvCfgView
+		{
+		public:
+			class const_iterator
+			{
+			public:
+				/**
+				* @brief Returns the entry; its key is stripped of the prefix of the view.
+				*/
+				inline EnvEntry operator*() const noexcept
+				{
+					const EnvSlot& slot = m_cfg->m_slots[*m_pos];
+					return EnvEntry{ m_cfg->ArenaView(slot.key).substr(m_prefix), EnvValueRef(*m_cfg, slot) };
+				}
+
+				inline const_iterator& operator++() noexcept
+				{
+					++m_pos;
+					return *this;
+				}
+
+				inline bool operator==(const const_iterator& other) const noexcept
+				{
+					return m_pos == other.m_pos;
+				}
+
+				inline bool operator!=(const const_iterator& other) const noexcept
+				{
+					return !(*this == other);
+				}
+			private:
+				friend class EnvCfgView;
+				const_iterator(const EnvCfg* cfg, const std::uint32_t* pos, std::size_t prefix) noexcept : m_cfg(cfg), m_pos(pos), m_prefix(prefix) {}
+				const EnvCfg* m_cfg;
+				const std::uint32_t* m_pos;
+				std::size_t m_prefix;
+			};
+
+			/**
+			* @brief Creates an empty view.
+			*/
+			EnvCfgView() noexcept = default;
+			/**
+			* @brief Same as `EnvCfg::Get`, `name` is the key without the prefix of the view.
+			*
+			* @note This method throw EnvBadGet exception on errors.
+			*/
+			template <typename T, typename = std::enable_if_t<detail::is_env_type_v<T>>>
+			T Get(std::string_view name) const;
+			/**
+			* @brief Same as `EnvCfg::GetN`, `name` is the key without the prefix of the view.
+			*/
+			template <typename T, typename = std::enable_if_t<detail::is_env_type_v<T>>>
+			std::optional<T> GetN(std::string_view name) const noexcept;
+			/**
+			* @brief Same as `EnvCfg::GetView`, `name` is the key without the prefix of the view.
+			*
+			* @note This method throw EnvBadGet exception on errors.
+			*/
+			std::string_view GetView(std::string_view name) const;
+			std::optional<std::string_view> GetViewN(std::string_view name) const noexcept;
+			bool HasValue(std::string_view name) const noexcept;
+			template <typename T, typename = std::enable_if_t<detail::is_env_type_v<T>>>
+			bool IsType(std::string_view name) const noexcept;
+			/**
+			* @brief Same as `EnvCfg::Key`, the handle is used with the `EnvCfg` of the view.
+			*
+			* @note This method throw EnvBadGet exception on errors.
+			*/
+			template <typename T, typename = std::enable_if_t<detail::is_env_type_v<T>>>
+			EnvKey<T> Key(std::string_view name) const;
+			/**
+			* @brief Returns the view of the keys of this view that continue with `prefix`, in O(log n).
+			*/
+			EnvCfgView Scope(std::string_view prefix) const noexcept;
+
+			inline std::size_t size() const noexcept
+			{
+				return static_cast<std::size_t>(m_last - m_first);
+			}
+
+			inline bool empty() const noexcept
+			{
+				return m_first == m_last;
+			}
+			/**
+			* @brief Iterates over the keys of the view in ascending order.
+			*/
+			inline const_iterator begin() const noexcept
+			{
+				return const_iterator(m_cfg, m_first, m_prefix);
+			}
+
+			inline const_iterator end() const noexcept
+			{
+				return const_iterator(m_cfg, m_last, m_prefix);
+			}
+		private:
+			friend class EnvCfg;
+			EnvCfgView(const EnvCfg* cfg, const std::uint32_t* first, const std::uint32_t* last, std::size_t prefix) noexcept
+				: m_cfg(cfg), m_first(first), m_last(last), m_prefix(prefix) {}
+			const EnvSlot* Find(std::string_view name) const noexcept;
+			// Full key of `name` for error messages.
+			std::string KeyName(std::string_view name) const;
+			const EnvCfg* m_cfg = nullptr;
+			const std::uint32_t* m_first = nullptr;
+			const std::uint32_t* m_last = nullptr;
+			std::size_t m_prefix = 0;
+		};
+	private:
+		// Keys of m_slots in ascending order for EnvCfgView.
+		const std::vector<std::uint32_t>& KeyOrder() const;
+		// Narrows the keys in `[first, last)`, which share the first `offset` characters, to those continuing with `prefix`.
+		EnvCfgView ScopeRange(const std::uint32_t* first, const std::uint32_t* last, std::size_t offset, std::string_view prefix) const noexcept;
+		const EnvSlot* FindScoped(const std::uint32_t* first, const std::uint32_t* last, std::size_t offset, std::string_view name) const noexcept;
+		// Reads of a found slot which throw like Get; `env_name` names a missing key.
+		template <typename T>
+		T SlotGet(const EnvSlot* slot, std::string_view env_name) const;
+		std::string_view SlotView(const EnvSlot* slot, std::string_view env_name) const;
+		template <typename T>
+		EnvKey<T> SlotKey(const EnvSlot* slot, std::string_view env_name) const;
+	public:
+		/**
+		* @brief Returns the view of the keys that start with `prefix`.
+		*
+		* The first call after an `InitEnv` that added keys sorts the keys, later calls find the scope in O(log n)
+		* and its enumeration takes O(k) for k keys. `Scope("")` enumerates all keys in ascending order.
+		*
+		* @code
+		* env_cfg::EnvCfg::EnvCfgView db = env.Scope("SVC_DB_");
+		* std::string host = db.Get<std::string>("HOST");  // reads SVC_DB_HOST
+		* @endcode
+		*/
+		EnvCfgView Scope(std::string_view prefix) const;
+	};
+
+	using EnvMap = std::unordered_map<std::string, EnvCfg::EnvValue>;
+	using EnvCfgView = EnvCfg::EnvCfgView;
+
+// Instantiations of the parsing templates for the canonical value types, `extern` in the compiled mode and
+// defined by libenv.cpp.
+#define CPPLIBENV_FOR_EACH_TYPE(X) X(std::string) X(int) X(double) X(long long) X(bool) X(std::int16_t) X(std::uint16_t) \
+	X(std::uint32_t) X(std::uint64_t) X(float) X(std::chrono::nanoseconds) X(env_cfg::EnvBytes)
+#define CPPLIBENV_FOR_EACH_INTEGER(X) X(int) X(long long) X(std::int16_t) X(std::uint16_t) X(std::uint32_t) X(std::uint64_t)
+#define CPPLIBENV_FOR_EACH_FLOATING(X) X(float) X(double)
+#define CPPLIBENV_INSTANTIATE_TYPE(prefix, T) \
+	prefix EnvResult<T> EnvCfg::ParseValue<T>(std::string_view) noexcept; \
+	prefix void EnvCfg::ParseBatch<T>(const std::string_view*, std::size_t, T*, EnvErrc*) noexcept; \
+	prefix std::optional<T> EnvCfg::ParseEnv<T>(std::string_view, const std::string&); \
+	prefix std::exception_ptr EnvCfg::MakeParseError<T>(EnvErrc, std::string_view, const std::string&); \
+	prefix EnvCfg::EnvResolved EnvCfg::HandleType<T>(const EnvValue&, std::string_view, const std::string&);
+#define CPPLIBENV_INSTANTIATE_INTEGER(prefix, T) \
+	prefix EnvErrc EnvCfg::ParseInteger<T>(std::string_view, T&, const char*&) noexcept;
+#define CPPLIBENV_INSTANTIATE_FLOATING(prefix, T) \
+	prefix EnvErrc EnvCfg::ParseFloating<T>(std::string_view, T&) noexcept;
+#if defined(CPPLIBENV_COMPILED)
+#define CPPLIBENV_EXTERN_TYPE(T) CPPLIBENV_INSTANTIATE_TYPE(extern template, T)
+#define CPPLIBENV_EXTERN_INTEGER(T) CPPLIBENV_INSTANTIATE_INTEGER(extern template, T)
+#define CPPLIBENV_EXTERN_FLOATING(T) CPPLIBENV_INSTANTIATE_FLOATING(extern template, T)
+	CPPLIBENV_FOR_EACH_TYPE(CPPLIBENV_EXTERN_TYPE)
+	CPPLIBENV_FOR_EACH_INTEGER(CPPLIBENV_EXTERN_INTEGER)
+	CPPLIBENV_FOR_EACH_FLOATING(CPPLIBENV_EXTERN_FLOATING)
+#undef CPPLIBENV_EXTERN_TYPE
+#undef CPPLIBENV_EXTERN_INTEGER
+#undef CPPLIBENV_EXTERN_FLOATING
+#endif
+
+	/**
+	* @brief Compile-time default value of an `EnvField`.
+	*/
+	class EnvFieldDefault
+	{
+	public:
+		constexpr EnvFieldDefault() noexcept : m_type(EnvCfgTypes::string_), m_has_value(false) {}
+		constexpr EnvFieldDefault(int value) noexcept : m_type(EnvCfgTypes::int_), m_has_value(true), m_integer(value) {}
+		constexpr EnvFieldDefault(long long value) noexcept : m_type(EnvCfgTypes::longlong_), m_has_value(true), m_integer(value) {}
+		constexpr EnvFieldDefault(double value) noexcept : m_type(EnvCfgTypes::double_), m_has_value(true), m_double(value) {}
+		constexpr EnvFieldDefault(float value) noexcept : m_type(EnvCfgTypes::float_), m_has_value(true), m_double(value) {}
+		template <typename Rep, typename Period>
+		constexpr EnvFieldDefault(std::chrono::duration<Rep, Period> value) noexcept : m_type(EnvCfgTypes::duration_), m_has_value(true),
+			m_integer(std::chrono::duration_cast<std::chrono::nanoseconds>(value).count()) {}
+		constexpr EnvFieldDefault(EnvBytes value) noexcept : m_type(EnvCfgTypes::bytes_), m_has_value(true), m_integer(static_cast<long long>(value.count())) {}
+		constexpr EnvFieldDefault(bool value) noexcept : m_type(EnvCfgTypes::bool_), m_has_value(true), m_bool(value) {}
+		constexpr EnvFieldDefault(const char* value) noexcept : m_type(EnvCfgTypes::string_), m_has_value(true), m_string(value) {}
+		constexpr EnvFieldDefault(std::string_view value) noexcept : m_type(EnvCfgTypes::string_), m_has_value(true), m_string(value) {}
+
+		inline constexpr bool has_value() const noexcept
+		{
+			return m_has_value;
+		}
+
+		inline constexpr EnvCfgTypes type() const noexcept
+		{
+			return m_type;
+		}
+
+		inline constexpr long long integer() const noexcept
+		{
+			return m_integer;
+		}
+
+		inline constexpr double floating() const noexcept
+		{
+			return m_type == EnvCfgTypes::double_ || m_type == EnvCfgTypes::float_ ? m_double : static_cast<double>(m_integer);
+		}
+
+		inline constexpr bool boolean() const noexcept
+		{
+			return m_bool;
+		}
+
+		inline constexpr std::string_view string() const noexcept
+		{
+			return m_string;
+		}
+	private:
+		EnvCfgTypes m_type;
+		bool m_has_value;
+		long long m_integer = 0;
+		double m_double = 0.0;
+		bool m_bool = false;
+		std::string_view m_string;
+	};
+
+	/**
+	* @brief Compile-time description of a single key: name, type and optional default value.
+	*/
+	struct EnvField
+	{
+		std::string_view name;
+		EnvCfgTypes type;
+		EnvFieldDefault default_value = {};
+	};
+
+	namespace detail
+	{
+		inline constexpr std::uint64_t SchemaHash(std::uint64_t seed, std::string_view name) noexcept
+		{
+			std::uint64_t hash = 14695981039346656037ull ^ (seed * 0x9E3779B97F4A7C15ull);
+			for (char c : name)
+			{
+				hash ^= static_cast<unsigned char>(c);
+				hash *= 1099511628211ull;
+			}
+			hash ^= hash >> 33;
+			hash *= 0xff51afd7ed558ccdull;
+			hash ^= hash >> 33;
+			return hash;
+		}
+	} // namespace detail
+
+	/**
+	* @brief Statically known set of keys with a minimal perfect hash generated at compile time.
+	*
+	* Create it with `MakeEnvSchema` as a `constexpr` variable. Name lookups via `Find()` cost one hash
+	* and one comparison without probing, and `Key<T>()` evaluated at compile time turns a typo in a key name
+	* or a wrong type into a compile error:
+	*
+	* @code
+	* constexpr auto schema = env_cfg::MakeEnvSchema({
+	*     {"PORT", env_cfg::EnvCfgTypes::int_, 8080},
+	*     {"HOST", env_cfg::EnvCfgTypes::string_, "localhost"}
+	* });
+	* constexpr auto port_key = schema.Key<int>("PORT");
+	* env.InitEnv(schema);
+	* int port = env.Get(port_key);
+	* @endcode
+	*
+	* @tparam N Number of fields.
+	*/
+	template <std::size_t N>
+	class EnvSchema
+	{
+	public:
+		static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+		constexpr explicit EnvSchema(const std::array<EnvField, N>& fields) : m_fields(fields)
+		{
+			Build();
+		}
+
+		inline constexpr std::size_t size() const noexcept
+		{
+			return N;
+		}
+
+		inline constexpr const EnvField& operator[](std::size_t index) const noexcept
+		{
+			return m_fields[index];
+		}
+
+		/**
+		* @brief Returns the index of the field `name` or `npos` if the schema does not contain it.
+		*/
+		constexpr std::size_t Find(std::string_view name) const noexcept
+		{
+			if constexpr (N == 0)
+			{
+				return npos;
+			}
+			else
+			{
+				const std::int64_t displace = m_displace[detail::SchemaHash(0, name) % N];
+				const std::size_t position = displace < 0
+					? static_cast<std::size_t>(-displace - 1)
+					: static_cast<std::size_t>(detail::SchemaHash(static_cast<std::uint64_t>(displace), name) % N);
+				const std::size_t field = m_position_to_field[position];
+				return m_fields[field].name == name ? field : npos;
+			}
+		}
+
+		/**
+		* @brief Returns the index of the field `name`.
+		* @note Throws EnvBadGet at run time, or fails to compile in a constant expression, if the field is missing.
+		*/
+		constexpr std::size_t Index(std::string_view name) const
+		{
+			const std::size_t index = Find(name);
+			if (index == npos)
+			{
+				throw EnvBadGet(std::string(name) + " not found in schema");
+			}
+			return index;
+		}
+
+		/**
+		* @brief Returns a typed handle for the field `name`, usable with an `EnvCfg` initialized from this schema.
+		* @note Throws EnvBadGet at run time, or fails to compile in a constant expression, if the field is missing
+		*       or declared with another type.
+		*/
+		template <typename T>
+		constexpr EnvKey<T> Key(std::string_view name) const
+		{
+			const std::size_t index = Index(name);
+			if (m_fields[index].type != detail::TypeTag<T>())
+			{
+				throw EnvBadGet("invalid type for " + std::string(name) + " in schema");
+			}
+			return EnvKey<T>(index);
+		}
+	private:
+		// Hash and displace: fields are grouped into buckets by SchemaHash(0, name), then every bucket with
+		// several fields gets a seed that moves all of them to free positions, single fields take what is left.
+		constexpr void Build()
+		{
+			std::array<std::size_t, N> bucket_of{};
+			std::array<std::size_t, N> bucket_size{};
+			std::array<std::size_t, N> order{};
+			std::array<bool, N> used{};
+			for (std::size_t i = 0; i < N; ++i)
+			{
+				ValidateField(i);
+				bucket_of[i] = static_cast<std::size_t>(detail::SchemaHash(0, m_fields[i].name) % N);
+				++bucket_size[bucket_of[i]];
+				order[i] = i;
+				m_position_to_field[i] = 0;
+			}
+			for (std::size_t i = 1; i < N; ++i)
+			{
+				for (std::size_t j = i; j > 0 && bucket_size[order[j - 1]] < bucket_size[order[j]]; --j)
+				{
+					const std::size_t tmp = order[j - 1];
+					order[j - 1] = order[j];
+					order[j] = tmp;
+				}
+			}
+			std::size_t free_position = 0;
+			for (std::size_t b = 0; b < N; ++b)
+			{
+				const std::size_t bucket = order[b];
+				if (bucket_size[bucket] == 0)
+				{
+					break;
+				}
+				if (bucket_size[bucket] == 1)
+				{
+					while (used[free_position])
+					{
+						++free_position;
+					}
+					for (std::size_t i = 0; i < N; ++i)
+					{
+						if (bucket_of[i] == bucket)
+						{
+							used[free_position] = true;
+							m_position_to_field[free_position] = i;
+							m_displace[bucket] = -static_cast<std::int64_t>(free_position) - 1;
+						}
+					}
+					continue;
+				}
+				for (std::uint64_t seed = 1; ; ++seed)
+				{
+					if (seed > (1u << 20))
+					{
+						throw EnvException("failed to build perfect hash for schema");
+					}
+					std::array<std::size_t, N> taken{};
+					std::size_t count = 0;
+					bool placed = true;
+					for (std::size_t i = 0; i < N && placed; ++i)
+					{
+						if (bucket_of[i] != bucket)
+						{
+							continue;
+						}
+						const std::size_t position = static_cast<std::size_t>(detail::SchemaHash(seed, m_fields[i].name) % N);
+						placed = !used[position];
+						for (std::size_t k = 0; k < count && placed; ++k)
+						{
+							placed = taken[k] != position;
+						}
+						taken[count++] = position;
+					}
+					if (!placed)
+					{
+						continue;
+					}
+					count = 0;
+					for (std::size_t i = 0; i < N; ++i)
+					{
+						if (bucket_of[i] == bucket)
+						{
+							used[taken[count]] = true;
+							m_position_to_field[taken[count++]] = i;
+						}
+					}
+					m_displace[bucket] = static_cast<std::int64_t>(seed);
+					break;
+				}
+			}
+		}
+
+		constexpr void ValidateField(std::size_t index) const
+		{
+			const EnvField& field = m_fields[index];
+			if (field.name.empty())
+			{
+				throw EnvException("empty key in schema");
+			}
+			for (std::size_t i = 0; i < index; ++i)
+			{
+				if (m_fields[i].name == field.name)
+				{
+					throw EnvException("duplicate key " + std::string(field.name) + " in schema");
+				}
+			}
+			if (static_cast<std::size_t>(field.type) >= detail::type_count)
+			{
+				throw EnvException("unsupported type for " + std::string(field.name) + " in schema");
+			}
+			const EnvFieldDefault& value = field.default_value;
+			if (value.has_value() && value.type() != field.type && !Promotable(value, field.type))
+			{
+				throw EnvException("default value type mismatch for " + std::string(field.name) + " in schema");
+			}
+		}
+
+		// An `int` default fits every integer type it is in the range of, `long long`, `double`, `float` and (if not
+		// negative) `bytes_`; a floating default fits both floating types.
+		static constexpr bool Promotable(const EnvFieldDefault& value, EnvCfgTypes type) noexcept
+		{
+			const long long integer = value.integer();
+			switch (value.type())
+			{
+			case EnvCfgTypes::int_:
+				switch (type)
+				{
+				case EnvCfgTypes::int16_:
+					return integer >= std::numeric_limits<std::int16_t>::min() && integer <= std::numeric_limits<std::int16_t>::max();
+				case EnvCfgTypes::uint16_:
+					return integer >= 0 && integer <= std::numeric_limits<std::uint16_t>::max();
+				case EnvCfgTypes::uint32_:
+				case EnvCfgTypes::uint64_:
+				case EnvCfgTypes::bytes_:
+					return integer >= 0;
+				case EnvCfgTypes::longlong_:
+				case EnvCfgTypes::double_:
+				case EnvCfgTypes::float_:
+					return true;
+				default:
+					return false;
+				}
+			case EnvCfgTypes::double_:
+			case EnvCfgTypes::float_:
+				return type == EnvCfgTypes::double_ || type == EnvCfgTypes::float_;
+			default:
+				return false;
+			}
+		}
+
+		std::array<EnvField, N> m_fields{};
+		std::array<std::int64_t, N> m_displace{};
+		std::array<std::size_t, N> m_position_to_field{};
+	};
+
+	/**
+	* @brief Creates a `constexpr` schema from a braced list of `EnvField`.
+	*/
+	template <std::size_t N>
+	constexpr EnvSchema<N> MakeEnvSchema(const EnvField (&fields)[N])
+	{
+		std::array<EnvField, N> array{};
+		for (std::size_t i = 0; i < N; ++i)
+		{
+			array[i] = fields[i];
+		}
+		return EnvSchema<N>(array);
+	}
+
+	template <std::size_t N>
+	inline void EnvCfg::InitEnv(const EnvSchema<N>& schema)
+	{
+		detail::EnvStatTimer timer(detail::stat_init_kind);
+		WaitSource();
+		try
+		{
+			for (std::size_t i = 0; i < N; ++i)
+			{
+				const EnvField& field = schema[i];
+				const std::string env_name(field.name);
+				ProcessEntry(env_name, FieldValue(field));
+				if (FindSlotIndex(env_name, HashKey(env_name)) != i)
+				{
+					throw EnvException("schema key " + env_name + " is already initialized at another position");
+				}
+			}
+		}
+		catch (...)
+		{
+			Compact();
+			throw;
+		}
+		Compact();
+	}
+
+	/**
+	* @brief Description of how the members of a plain struct `S` map to environment variables.
+	*
+	* @code
+	* struct ServerConfig { int port = 0; std::string host; bool debug = false; };
+	*
+	* const auto binding = env_cfg::EnvBinding<ServerConfig>()
+	*     .Field("PORT", &ServerConfig::port)
+	*     .Field("HOST", &ServerConfig::host, "localhost")
+	*     .Field("DEBUG_MODE", &ServerConfig::debug, false);
+	*
+	* ServerConfig config;
+	* env.InitEnv(binding, config);
+	* @endcode
+	*/
+	template <class S>
+	class EnvBinding
+	{
+	public:
+		/**
+		* @brief Binds `member` to `env_name` without a default value.
+		*
+		* @tparam T Supported member types: every type supported by `EnvCfg::Get`, e.g. `int`, `std::uint16_t`,
+		*           `float`, `std::string`, `std::chrono::milliseconds` or `EnvBytes`.
+		*/
+		template <typename T, typename = std::enable_if_t<detail::is_env_type_v<T>>>
+		EnvBinding& Field(std::string env_name, T S::* member)
+		{
+			m_fields.push_back(EnvBoundField{ std::move(env_name), EnvCfg::EnvValue(detail::TypeTag<T>()), Assign(member) });
+			return *this;
+		}
+		/**
+		* @brief Binds `member` to `env_name` with the default value `default_value` (converted to the member type).
+		*/
+		template <typename T, typename D, typename = std::enable_if_t<detail::is_env_type_v<T>>>
+		EnvBinding& Field(std::string env_name, T S::* member, D&& default_value)
+		{
+			m_fields.push_back(EnvBoundField{ std::move(env_name), EnvCfg::EnvValue::Of<T>(T(std::forward<D>(default_value))), Assign(member) });
+			return *this;
+		}
+
+		inline std::size_t size() const noexcept
+		{
+			return m_fields.size();
+		}
+	private:
+		friend class EnvCfg;
+		// Stores the value of a field into `out`, `name` is the key of the field.
+		using AssignFunction = std::function<void(S& out, const EnvCfg::EnvValueRef& value, const std::string& name)>;
+		// The typed member pointer is captured, so every field assigns through its own member type.
+		template <typename T>
+		static AssignFunction Assign(T S::* member)
+		{
+			return [member](S& out, const EnvCfg::EnvValueRef& value, const std::string& name) {
+				std::optional<T> typed = value.template GetN<T>();
+				if (!typed)
+				{
+					throw EnvBadGet("invalid type for " + name);
+				}
+				out.*member = std::move(*typed);
+			};
+		}
+		struct EnvBoundField
+		{
+			std::string name;
+			EnvCfg::EnvValue value;
+			AssignFunction assign;
+		};
+		std::vector<EnvBoundField> m_fields;
+	};
+
+	template <class S>
+	inline void EnvCfg::InitEnv(const EnvBinding<S>& binding, S& out)
+	{
+		detail::EnvStatTimer timer(detail::stat_init_kind);
+		WaitSource();
+		try
+		{
+			for (const auto& field : binding.m_fields)
+			{
+				const EnvSlot& slot = m_slots[ProcessEntry(field.name, field.value)];
+				if (!slot.cell.has_value)
+				{
+					continue;
+				}
+				field.assign(out, EnvValueRef(*this, slot), field.name);
+			}
+		}
+		catch (...)
+		{
+			Compact();
+			throw;
+		}
+		Compact();
+	}
+
+#if CPPLIBENV_DEFINITIONS
+	CPPLIBENV_INLINE EnvCfg::EnvValue EnvCfg::FieldValue(const EnvField& field)
+	{
+		const EnvFieldDefault& value = field.default_value;
+		if (!value.has_value())
+		{
+			return EnvValue(field.type);
+		}
+		return detail::DispatchType(field.type, [&value](auto type) {
+			using ValueType = typename decltype(type)::type;
+			if constexpr (std::is_same_v<ValueType, std::string>)
+			{
+				return EnvValue(std::string(value.string()));
+			}
+			else if constexpr (std::is_same_v<ValueType, bool>)
+			{
+				return EnvValue(value.boolean());
+			}
+			else if constexpr (std::is_floating_point_v<ValueType>)
+			{
+				return EnvValue::Of(static_cast<ValueType>(value.floating()));
+			}
+			else if constexpr (std::is_same_v<ValueType, std::chrono::nanoseconds>)
+			{
+				return EnvValue(std::chrono::nanoseconds(value.integer()));
+			}
+			else if constexpr (std::is_same_v<ValueType, EnvBytes>)
+			{
+				return EnvValue(EnvBytes(static_cast<std::uint64_t>(value.integer())));
+			}
+			else
+			{
+				return EnvValue::Of(static_cast<ValueType>(value.integer()));
+			}
+		});
+	}
+#endif
+
+	template <typename T, typename>
+	inline T EnvCfg::Get(std::string_view env_name) const
+	{
+		return SlotGet<T>(FindSlot(env_name), env_name);
+	}
+
+	template <typename T>
+	inline T EnvCfg::SlotGet(const EnvSlot* slot, std::string_view env_name) const
+	{
+		if (!slot)
+		{
+			throw EnvBadGet(std::string(env_name) + " not found ");
+		}
+		const EnvCell& cell = SlotCell(*slot);
+		if (!cell.has_value)
+		{
+			ThrowLazyError(*slot);
+			throw EnvBadGet("no value for " + std::string(ArenaView(slot->key)));
+		}
+		if (!CellHolds<T>(cell))
+		{
+			throw EnvBadGet("invalid type for " + std::string(ArenaView(slot->key)));
+		}
+		return CellValue<T>(*slot, cell);
+	}
+
+	template <typename T, typename>
+	inline std::optional<T> EnvCfg::GetN(std::string_view env_name) const noexcept
+	{
+		const EnvSlot* slot = FindSlot(env_name);
+		if (!slot || !CellHolds<T>(SlotCell(*slot)))
+		{
+			return std::nullopt;
+		}
+		return CellValue<T>(*slot, SlotCell(*slot));
+	}
+
+#if CPPLIBENV_DEFINITIONS
+	CPPLIBENV_INLINE std::string_view EnvCfg::GetView(std::string_view env_name) const
+	{
+		return SlotView(FindSlot(env_name), env_name);
+	}
+
+	CPPLIBENV_INLINE std::string_view EnvCfg::SlotView(const EnvSlot* slot, std::string_view env_name) const
+	{
+		if (!slot)
+		{
+			throw EnvBadGet(std::string(env_name) + " not found ");
+		}
+		const EnvCell& cell = SlotCell(*slot);
+		if (!cell.has_value)
+		{
+			ThrowLazyError(*slot);
+			throw EnvBadGet("no value for " + std::string(ArenaView(slot->key)));
+		}
+		if (!CellHolds<std::string>(cell))
+		{
+			throw EnvBadGet("invalid type for " + std::string(ArenaView(slot->key)));
+		}
+		return CellString(*slot, cell);
+	}
+
+	CPPLIBENV_INLINE std::optional<std::string_view> EnvCfg::GetViewN(std::string_view env_name) const noexcept
+	{
+		const EnvSlot* slot = FindSlot(env_name);
+		if (!slot || !CellHolds<std::string>(SlotCell(*slot)))
+		{
+			return std::nullopt;
+		}
+		return CellString(*slot, SlotCell(*slot));
+	}
+
+	CPPLIBENV_INLINE std::string_view EnvCfg::GetView(EnvKey<std::string> key) const
+	{
+		if (key.m_index >= m_slots.size())
+		{
+			throw EnvBadGet("key handle " + std::to_string(key.m_index) + " not found ");
+		}
+		const EnvSlot& slot = m_slots[key.m_index];
+		CountRead(key.m_index);
+		const EnvCell& cell = SlotCell(slot);
+		if (!CellHolds<std::string>(cell))
+		{
+			ThrowLazyError(slot);
+			throw EnvBadGet("no value for " + std::string(ArenaView(slot.key)));
+		}
+		return CellString(slot, cell);
+	}
+
+	CPPLIBENV_INLINE std::optional<std::string_view> EnvCfg::GetViewN(EnvKey<std::string> key) const noexcept
+	{
+		if (key.m_index >= m_slots.size())
+		{
+			return std::nullopt;
+		}
+		const EnvSlot& slot = m_slots[key.m_index];
+		CountRead(key.m_index);
+		const EnvCell& cell = SlotCell(slot);
+		if (!CellHolds<std::string>(cell))
+		{
+			return std::nullopt;
+		}
+		return CellString(slot, cell);
+	}
+#endif
+
+	template <typename T, typename>
+	inline EnvListView<T> EnvCfg::GetList(std::string_view env_name) const
+	{
+		const EnvSlot* slot = FindSlot(env_name);
+		if (!slot)
+		{
+			throw EnvBadGet(std::string(env_name) + " not found ");
+		}
+		const EnvCell& cell = SlotCell(*slot);
+		if (cell.type == EnvCfgTypes::list_ && !cell.has_value)
+		{
+			throw EnvBadGet("no value for " + std::string(env_name));
+		}
+		std::optional<EnvListView<T>> view = ListView<T>(*slot);
+		if (!view)
+		{
+			throw EnvBadGet("invalid type for " + std::string(env_name));
+		}
+		return *view;
+	}
+
+	template <typename T, typename>
+	inline std::optional<EnvListView<T>> EnvCfg::GetListN(std::string_view env_name) const noexcept
+	{
+		const EnvSlot* slot = FindSlot(env_name);
+		if (!slot)
+		{
+			return std::nullopt;
+		}
+		return ListView<T>(*slot);
+	}
+
+	template <typename T>
+	inline std::optional<EnvListView<T>> EnvCfg::ListView(const EnvSlot& slot) const noexcept
+	{
+		// List slots are never lazy.
+		if (!slot.cell.has_value || slot.cell.type != EnvCfgTypes::list_)
+		{
+			return std::nullopt;
+		}
+		const EnvListData& list = *m_lists[static_cast<std::size_t>(&slot - m_slots.data())];
+		if constexpr (std::is_same_v<T, std::string_view>)
+		{
+			const auto* refs = std::get_if<std::vector<detail::EnvTextRef>>(&list.values);
+			if (!refs)
+			{
+				return std::nullopt;
+			}
+			return EnvListView<T>(ArenaView(slot.cell.string_value).data(), refs->data(), refs->size(), list.sorted);
+		}
+		else
+		{
+			const auto* values = std::get_if<std::vector<T>>(&list.values);
+			if (!values)
+			{
+				return std::nullopt;
+			}
+			return EnvListView<T>(values->data(), values->size(), list.sorted);
+		}
+	}
+
+	template <typename T, typename>
+	inline bool EnvCfg::IsType(std::string_view env_name) const noexcept
+	{
+		const EnvSlot* slot = FindSlot(env_name);
+		return slot && CellHolds<T>(SlotCell(*slot));
+	}
+
+	template <typename T, typename>
+	inline EnvKey<T> EnvCfg::Key(std::string_view env_name) const
+	{
+		return SlotKey<T>(FindSlot(env_name), env_name);
+	}
+
+	template <typename T>
+	inline EnvKey<T> EnvCfg::SlotKey(const EnvSlot* slot, std::string_view env_name) const
+	{
+		if (!slot)
+		{
+			throw EnvBadGet(std::string(env_name) + " not found ");
+		}
+		if (slot->cell.type != detail::TypeTag<T>())
+		{
+			throw EnvBadGet("invalid type for " + std::string(ArenaView(slot->key)));
+		}
+		return EnvKey<T>(static_cast<std::size_t>(slot - m_slots.data()));
+	}
+
+	template <typename T, typename>
+	inline T EnvCfg::EnvCfgView::Get(std::string_view name) const
+	{
+		const EnvSlot* slot = Find(name);
+		if (!slot)
+		{
+			throw EnvBadGet(KeyName(name) + " not found ");
+		}
+		return m_cfg->SlotGet<T>(slot, name);
+	}
+
+	template <typename T, typename>
+	inline std::optional<T> EnvCfg::EnvCfgView::GetN(std::string_view name) const noexcept
+	{
+		const EnvSlot* slot = Find(name);
+		if (!slot || !CellHolds<T>(m_cfg->SlotCell(*slot)))
+		{
+			return std::nullopt;
+		}
+		return m_cfg->CellValue<T>(*slot, m_cfg->SlotCell(*slot));
+	}
+
+	template <typename T, typename>
+	inline bool EnvCfg::EnvCfgView::IsType(std::string_view name) const noexcept
+	{
+		const EnvSlot* slot = Find(name);
+		return slot && CellHolds<T>(m_cfg->SlotCell(*slot));
+	}
+
+	template <typename T, typename>
+	inline EnvKey<T> EnvCfg::EnvCfgView::Key(std::string_view name) const
+	{
+		const EnvSlot* slot = Find(name);
+		if (!slot)
+		{
+			throw EnvBadGet(KeyName(name) + " not found ");
+		}
+		return m_cfg->SlotKey<T>(slot, name);
+	}
+
+	template <typename T>
+	inline T EnvCfg::Get(EnvKey<T> key) const
+	{
+		if (key.m_index >= m_slots.size())
+		{
+			throw EnvBadGet("key handle " + std::to_string(key.m_index) + " not found ");
+		}
+		const EnvSlot& slot = m_slots[key.m_index];
+		CountRead(key.m_index);
+		const EnvCell& cell = SlotCell(slot);
+		if (!CellHolds<T>(cell))
+		{
+			if (!cell.has_value)
+			{
+				ThrowLazyError(slot);
+				throw EnvBadGet("no value for " + std::string(ArenaView(slot.key)));
+			}
+			throw EnvBadGet("invalid type for " + std::string(ArenaView(slot.key)));
+		}
+		return CellValue<T>(slot, cell);
+	}
+
+	template <typename T>
+	inline std::optional<T> EnvCfg::GetN(EnvKey<T> key) const noexcept
+	{
+		if (key.m_index >= m_slots.size())
+		{
+			return std::nullopt;
+		}
+		const EnvSlot& slot = m_slots[key.m_index];
+		CountRead(key.m_index);
+		const EnvCell& cell = SlotCell(slot);
+		if (!CellHolds<T>(cell))
+		{
+			return std::nullopt;
+		}
+		return CellValue<T>(slot, cell);
+	}
+
+	template <typename T>
+	inline bool EnvCfg::HasValue(EnvKey<T> key) const noexcept
+	{
+		if (key.m_index >= m_slots.size())
+		{
+			return false;
+		}
+		CountRead(key.m_index);
+		return SlotCell(m_slots[key.m_index]).has_value;
+	}
+
+	template <typename T>
+	inline bool EnvCfg::CellHolds(const EnvCell& cell) noexcept
+	{
+		return cell.has_value && cell.type == detail::TypeTag<T>();
+	}
+
+	template <typename T>
+	inline T EnvCfg::CellValue(const EnvSlot& slot, const EnvCell& cell) const
+	{
+		if constexpr (std::is_same_v<T, std::string>)
+		{
+			return T(CellString(slot, cell));
+		}
+		else
+		{
+			using Traits = detail::EnvTypeTraits<T>;
+			return Traits::From(Traits::Load(CellStorage<typename Traits::storage>(cell)));
+		}
+	}
+
+	template<class T>
+	CPPLIBENV_TEMPLATE std::optional<T> EnvCfg::ParseEnv(std::string_view raw, const std::string& env_name)
+	{
+		detail::EnvStatTimer timer(static_cast<std::size_t>(detail::TypeTag<T>()));
+		EnvResult<T> result = ParseValue<T>(raw);
+		if (result)
+		{
+			return std::move(result).value();
+		}
+		if (result.error() == EnvErrc::empty)
+		{
+			return std::nullopt;
+		}
+		std::rethrow_exception(MakeParseError<T>(result.error(), raw, env_name));
+	}
+
+	template <class F>
+	inline auto EnvCfg::WithEnvView(const std::string& env_name, F&& f)
+	{
+		if (Overlay().load(std::memory_order_acquire) || Source().load(std::memory_order_acquire))
+		{
+			detail::EpochSection section;
+			return f(ResolveView(env_name));
+		}
+		return f(GetEnvView(env_name));
+	}
+
+	template <class F>
+	inline void EnvCfg::ForEachEnv(F&& f)
+	{
+		const detail::EnvOverlay* overlay = Overlay().load(std::memory_order_seq_cst);
+		const EnvSourceBinding* binding = Source().load(std::memory_order_seq_cst);
+		const bool source_first = binding && binding->precedence == EnvPrecedence::source_;
+		auto environment = [&](std::string_view env_name, std::string_view value) {
+			// Variables defined by a source which takes precedence are reported with the source.
+			if (!source_first || !binding->source->Find(env_name).data())
+			{
+				f(env_name, value);
+			}
+		};
+		const EnvSnapshot* snapshot = Snapshot().get();
+		// Keys of a source are only reported if the environment does not set them, which is looked up in an index.
+		std::unique_ptr<EnvSnapshot> index;
+		if (overlay)
+		{
+			overlay->ForEach(environment);
+		}
+		else
+		{
+			if (!snapshot && binding && !source_first)
+			{
+				index = std::make_unique<EnvSnapshot>();
+				snapshot = index.get();
+			}
+			if (snapshot)
+			{
+				snapshot->ForEach(environment);
+			}
+			else
+			{
+				for (char** env = environ; env && *env; ++env)
+				{
+					const char* entry = *env;
+					if (const char* separator = std::strchr(entry, '='))
+					{
+						environment(std::string_view(entry, static_cast<std::size_t>(separator - entry)), std::string_view(separator + 1));
+					}
+				}
+			}
+		}
+		if (binding)
+		{
+			binding->source->ForEach([&](std::string_view env_name, std::string_view value) {
+				if (source_first || !(overlay ? overlay->Find(env_name) : snapshot->Find(env_name)).data())
+				{
+					f(env_name, value);
+				}
+			});
+		}
+	}
+
+	namespace detail
+	{
+		// Returns the number of leading ASCII digits of [first, last), at most 16.
+		inline std::size_t CountDigits(const char* first, const char* last) noexcept
+		{
+			const std::size_t size = static_cast<std::size_t>(last - first);
+#if defined(__SSE2__)
+			if (size >= 16)
+			{
+				const __m128i chunk = _mm_sub_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(first)), _mm_set1_epi8('0'));
+				// A byte is a digit if it is not greater than 9 after subtracting '0' (unsigned).
+				const __m128i digits = _mm_cmpeq_epi8(_mm_min_epu8(chunk, _mm_set1_epi8(9)), chunk);
+				const unsigned mask = ~static_cast<unsigned>(_mm_movemask_epi8(digits)) & 0xFFFFu;
+				return mask ? static_cast<std::size_t>(__builtin_ctz(mask)) : 16;
+			}
+#endif
+			// Short values are not worth a padded copy.
+			const std::size_t limit = std::min<std::size_t>(16, size);
+			std::size_t count = 0;
+			while (count < limit && static_cast<unsigned char>(first[count] - '0') <= 9)
+			{
+				++count;
+			}
+			return count;
+		}
+
+		// Converts 8 ASCII digits to their value with SWAR arithmetic (a little-endian load).
+		inline std::uint32_t ParseEightDigits(const char* digits) noexcept
+		{
+			std::uint64_t value;
+			std::memcpy(&value, digits, sizeof(value));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+			value = __builtin_bswap64(value);
+#endif
+			value = ((value & 0x0F0F0F0F0F0F0F0Full) * 2561) >> 8;
+			value = ((value & 0x00FF00FF00FF00FFull) * 6553601) >> 16;
+			return static_cast<std::uint32_t>(((value & 0x0000FFFF0000FFFFull) * 42949672960001ull) >> 32);
+		}
+
+		// Converts `count` (at most 16) ASCII digits to their value, eight digits per step.
+		inline std::uint64_t ParseDigits(const char* digits, std::size_t count) noexcept
+		{
+			std::uint64_t value = 0;
+			for (; count >= 8; count -= 8, digits += 8)
+			{
+				value = value * 100000000u + ParseEightDigits(digits);
+			}
+			for (; count > 0; --count, ++digits)
+			{
+				value = value * 10 + static_cast<std::uint64_t>(*digits - '0');
+			}
+			return value;
+		}
+
+		// Case-insensitive match of `true`/`false`/`yes`/`no`/`1`/`0`: the value is loaded into one word and
+		// compared against every token, the lowercase bit is forced on the letter positions only.
+		inline bool MatchBool(std::string_view raw, bool& out) noexcept
+		{
+			struct Token
+			{
+				std::uint64_t value;
+				std::uint64_t lowercase;
+				std::size_t size;
+				bool result;
+			};
+			constexpr auto pack = [](const char* text, std::size_t size) {
+				std::uint64_t word = 0;
+				for (std::size_t i = 0; i < size; ++i)
+				{
+					word |= static_cast<std::uint64_t>(static_cast<unsigned char>(text[i])) << (8 * i);
+				}
+				return word;
+			};
+			constexpr std::uint64_t letters4 = 0x20202020ull;
+			static constexpr Token tokens[] = {
+				{ pack("true", 4), letters4, 4, true },
+				{ pack("false", 5), letters4 | 0x2000000000ull, 5, false },
+				{ pack("yes", 3), 0x202020ull, 3, true },
+				{ pack("no", 2), 0x2020ull, 2, false },
+				{ pack("1", 1), 0, 1, true },
+				{ pack("0", 1), 0, 1, false },
+			};
+			if (raw.empty() || raw.size() > 5)
+			{
+				return false;
+			}
+			const std::uint64_t word = pack(raw.data(), raw.size());
+			for (const Token& token : tokens)
+			{
+				if (token.size == raw.size() && (word | token.lowercase) == token.value)
+				{
+					out = token.result;
+					return true;
+				}
+			}
+			return false;
+		}
+
+		inline bool IsSpace(char c) noexcept
+		{
+			return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+		}
+
+		// Skips leading whitespace and an optional sign the same way strtol/strtod do.
+		// Returns false if a sign is not followed by a character which may start a number body.
+		inline bool SkipPrefix(const char*& first, const char* last, bool& negative) noexcept
+		{
+			while (first != last && IsSpace(*first))
+			{
+				++first;
+			}
+			negative = false;
+			if (first != last && (*first == '+' || *first == '-'))
+			{
+				negative = *first == '-';
+				++first;
+				if (first != last && (*first == '+' || *first == '-'))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		// Number of a duration or byte size value: the integer part and up to 18 fraction digits.
+		struct EnvDecimal
+		{
+			std::uint64_t whole = 0;
+			std::uint64_t fraction = 0;
+			// 10 to the power of the number of fraction digits kept.
+			std::uint64_t scale = 1;
+		};
+
+		// Parses `<digits>[.<digits>]` at `first`, at least one digit is required before the point.
+		inline EnvErrc ParseDecimal(const char*& first, const char* last, EnvDecimal& out) noexcept
+		{
+			out = EnvDecimal{};
+			const char* const start = first;
+			for (; first != last && static_cast<unsigned char>(*first - '0') <= 9; ++first)
+			{
+				const std::uint64_t digit = static_cast<std::uint64_t>(*first - '0');
+				if (out.whole > (std::numeric_limits<std::uint64_t>::max() - digit) / 10)
+				{
+					return EnvErrc::out_of_range;
+				}
+				out.whole = out.whole * 10 + digit;
+			}
+			if (first == start)
+			{
+				return EnvErrc::invalid_format;
+			}
+			if (first != last && *first == '.')
+			{
+				for (++first; first != last && static_cast<unsigned char>(*first - '0') <= 9; ++first)
+				{
+					if (out.scale < 1000000000000000000ull)
+					{
+						out.fraction = out.fraction * 10 + static_cast<std::uint64_t>(*first - '0');
+						out.scale *= 10;
+					}
+				}
+			}
+			return EnvErrc::ok;
+		}
+
+		// Returns `number * unit` into `out`, the fraction truncated; false on overflow of `limit`.
+		inline bool ScaleDecimal(const EnvDecimal& number, std::uint64_t unit, std::uint64_t limit, std::uint64_t& out) noexcept
+		{
+			if (number.whole > limit / unit)
+			{
+				return false;
+			}
+#if defined(__SIZEOF_INT128__)
+			const std::uint64_t fraction = static_cast<std::uint64_t>(static_cast<unsigned __int128>(number.fraction) * unit / number.scale);
+#else
+			const std::uint64_t fraction = static_cast<std::uint64_t>(static_cast<long double>(number.fraction) * unit / number.scale);
+#endif
+			out = number.whole * unit;
+			if (fraction > limit - out)
+			{
+				return false;
+			}
+			out += fraction;
+			return true;
+		}
+
+		struct EnvUnit
+		{
+			std::string_view name;
+			std::uint64_t scale;
+		};
+
+		// Largest first, the formatting picks the first unit dividing the value.
+		inline constexpr EnvUnit duration_units[] = {
+			{ "d", 86400000000000ull }, { "h", 3600000000000ull }, { "m", 60000000000ull }, { "s", 1000000000ull },
+			{ "ms", 1000000ull }, { "us", 1000ull }, { "ns", 1ull }, { "min", 60000000000ull }
+		};
+
+		// Parses a duration in nanoseconds: one or more `<number>[.<fraction>]<unit>` components (`1h30m`, `1.5s`)
+		// with the units ns, us, ms, s, m or min, h and d; a zero may omit the unit. Leading and trailing whitespace
+		// and a sign are accepted.
+		inline EnvErrc ParseDuration(std::string_view raw, long long& out) noexcept
+		{
+			const char* first = raw.data();
+			const char* last = raw.data() + raw.size();
+			bool negative = false;
+			if (!SkipPrefix(first, last, negative))
+			{
+				return EnvErrc::invalid_format;
+			}
+			const std::uint64_t limit = static_cast<std::uint64_t>(std::numeric_limits<long long>::max()) + (negative ? 1u : 0u);
+			std::uint64_t total = 0;
+			bool empty = true;
+			while (first != last && !IsSpace(*first))
+			{
+				EnvDecimal number;
+				const EnvErrc error = ParseDecimal(first, last, number);
+				if (error != EnvErrc::ok)
+				{
+					return error;
+				}
+				const char* unit = first;
+				while (first != last && *first >= 'a' && *first <= 'z')
+				{
+					++first;
+				}
+				const std::string_view name(unit, static_cast<std::size_t>(first - unit));
+				std::uint64_t scale = 0;
+				for (const EnvUnit& candidate : duration_units)
+				{
+					if (candidate.name == name)
+					{
+						scale = candidate.scale;
+					}
+				}
+				if (scale == 0 && name.empty() && empty && number.whole == 0 && number.fraction == 0)
+				{
+					scale = 1;
+				}
+				std::uint64_t value = 0;
+				if (scale == 0)
+				{
+					return EnvErrc::invalid_format;
+				}
+				if (!ScaleDecimal(number, scale, limit - total, value))
+				{
+					return EnvErrc::out_of_range;
+				}
+				total += value;
+				empty = false;
+			}
+			while (first != last && IsSpace(*first))
+			{
+				++first;
+			}
+			if (empty || first != last)
+			{
+				return EnvErrc::invalid_format;
+			}
+			out = negative ? static_cast<long long>(0u - total) : static_cast<long long>(total);
+			return EnvErrc::ok;
+		}
+
+		// Parses a byte size: `<number>[.<fraction>]` and an optional unit, `B`, an SI prefix K, M, G, T, P or E
+		// (powers of 1000, optionally followed by `B`) or an IEC one (`Ki`, `KiB`, ... powers of 1024), in any case.
+		inline EnvErrc ParseBytes(std::string_view raw, std::uint64_t& out) noexcept
+		{
+			const char* first = raw.data();
+			const char* last = raw.data() + raw.size();
+			bool negative = false;
+			if (!SkipPrefix(first, last, negative))
+			{
+				return EnvErrc::invalid_format;
+			}
+			EnvDecimal number;
+			const EnvErrc error = ParseDecimal(first, last, number);
+			if (error != EnvErrc::ok)
+			{
+				return error;
+			}
+			while (first != last && IsSpace(*first))
+			{
+				++first;
+			}
+			auto lower = [](char c) noexcept {
+				return static_cast<char>(c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c);
+			};
+			std::uint64_t scale = 1;
+			constexpr std::string_view prefixes = "kmgtpe";
+			const std::size_t prefix = first != last ? prefixes.find(lower(*first)) : std::string_view::npos;
+			if (prefix != std::string_view::npos)
+			{
+				++first;
+				const bool binary = first != last && lower(*first) == 'i';
+				first += binary ? 1 : 0;
+				for (std::size_t i = 0; i <= prefix; ++i)
+				{
+					scale *= binary ? 1024 : 1000;
+				}
+			}
+			if (first != last && lower(*first) == 'b')
+			{
+				++first;
+			}
+			while (first != last && IsSpace(*first))
+			{
+				++first;
+			}
+			if (first != last)
+			{
+				return EnvErrc::invalid_format;
+			}
+			if (!ScaleDecimal(number, scale, std::numeric_limits<std::uint64_t>::max(), out))
+			{
+				return EnvErrc::out_of_range;
+			}
+			if (negative && out != 0)
+			{
+				return EnvErrc::out_of_range;
+			}
+			return EnvErrc::ok;
+		}
+
+		// Writes `count` followed by `unit` into [first, last).
+		template <typename T>
+		inline std::to_chars_result UnitToChars(char* first, char* last, T count, std::string_view unit) noexcept
+		{
+			std::to_chars_result result = std::to_chars(first, last, count);
+			if (result.ec != std::errc() || static_cast<std::size_t>(last - result.ptr) < unit.size())
+			{
+				return std::to_chars_result{ last, std::errc::value_too_large };
+			}
+			std::memcpy(result.ptr, unit.data(), unit.size());
+			result.ptr += unit.size();
+			return result;
+		}
+
+		// Formats a duration with the largest unit which represents it exactly, e.g. `90m` or `1500ms`.
+		inline std::to_chars_result DurationToChars(char* first, char* last, long long nanoseconds) noexcept
+		{
+			for (const EnvUnit& unit : duration_units)
+			{
+				const long long scale = static_cast<long long>(unit.scale);
+				if (nanoseconds % scale == 0)
+				{
+					return UnitToChars(first, last, nanoseconds / scale, nanoseconds == 0 ? std::string_view("s") : unit.name);
+				}
+			}
+			return UnitToChars(first, last, nanoseconds, std::string_view("ns"));
+		}
+
+		// Formats a byte size with the largest IEC unit which represents it exactly, e.g. `64MiB` or `1000B`.
+		inline std::to_chars_result BytesToChars(char* first, char* last, std::uint64_t bytes) noexcept
+		{
+			constexpr std::string_view units[] = { "EiB", "PiB", "TiB", "GiB", "MiB", "KiB" };
+			for (std::size_t i = 0; i < 6 && bytes != 0; ++i)
+			{
+				const unsigned shift = static_cast<unsigned>(60 - 10 * i);
+				if ((bytes & ((std::uint64_t(1) << shift) - 1)) == 0)
+				{
+					return UnitToChars(first, last, bytes >> shift, units[i]);
+				}
+			}
+			return UnitToChars(first, last, bytes, "B");
+		}
+	} // namespace detail
+
+	template <typename T, typename>
+	CPPLIBENV_TEMPLATE EnvResult<T> EnvCfg::ParseValue(std::string_view raw) noexcept
+	{
+		if (raw.empty())
+		{
+			return EnvErrc::empty;
+		}
+		if constexpr (std::is_same_v<T, std::string>)
+		{
+			return std::string(raw);
+		}
+		else if constexpr (detail::is_env_integer_v<T>)
+		{
+			T value{};
+			const char* end = raw.data();
+			const EnvErrc error = ParseInteger(raw, value, end);
+			// `long long` keeps the std::stoll behaviour of ignoring a fractional part.
+			if constexpr (detail::TypeTag<T>() != EnvCfgTypes::longlong_)
+			{
+				// Any '.' makes the value fractional, there is none if all characters were consumed.
+				if ((error != EnvErrc::ok || end != raw.data() + raw.size()) && raw.find('.') != std::string_view::npos)
+				{
+					return EnvErrc::fractional;
+				}
+			}
+			if (error != EnvErrc::ok)
+			{
+				return error;
+			}
+			return value;
+		}
+		else if constexpr (std::is_floating_point_v<T>)
+		{
+			T value{};
+			const EnvErrc error = ParseFloating(raw, value);
+			if (error != EnvErrc::ok)
+			{
+				return error;
+			}
+			return value;
+		}
+		else if constexpr (detail::TypeTag<T>() == EnvCfgTypes::duration_)
+		{
+			long long nanoseconds = 0;
+			const EnvErrc error = detail::ParseDuration(raw, nanoseconds);
+			if (error != EnvErrc::ok)
+			{
+				return error;
+			}
+			return detail::EnvTypeTraits<T>::From(std::chrono::nanoseconds(nanoseconds));
+		}
+		else if constexpr (std::is_same_v<T, EnvBytes>)
+		{
+			std::uint64_t bytes = 0;
+			const EnvErrc error = detail::ParseBytes(raw, bytes);
+			if (error != EnvErrc::ok)
+			{
+				return error;
+			}
+			return EnvBytes(bytes);
+		}
+		else if constexpr (std::is_same_v<T, bool>)
+		{
+			bool value = false;
+			if (!detail::MatchBool(raw, value))
+			{
+				return EnvErrc::invalid_format;
+			}
+			return value;
+		}
+		else
+		{
+			return EnvErrc::unhandled_type;
+		}
+	}
+
+	template <typename T, typename>
+	CPPLIBENV_TEMPLATE void EnvCfg::ParseBatch(const std::string_view* raw, std::size_t count, T* values, EnvErrc* errors) noexcept
+	{
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			EnvResult<T> result = ParseValue<T>(raw[i]);
+			if (result)
+			{
+				values[i] = std::move(result).value();
+				errors[i] = EnvErrc::ok;
+			}
+			else
+			{
+				errors[i] = result.error();
+			}
+		}
+	}
+
+	template <class T>
+	CPPLIBENV_TEMPLATE EnvErrc EnvCfg::ParseInteger(std::string_view raw, T& out, const char*& end) noexcept
+	{
+		const char* first = raw.data();
+		const char* last = raw.data() + raw.size();
+		bool negative = false;
+		if (!detail::SkipPrefix(first, last, negative))
+		{
+			return EnvErrc::invalid_format;
+		}
+		const std::size_t digits = detail::CountDigits(first, last);
+		if (digits == 0)
+		{
+			return EnvErrc::invalid_format;
+		}
+		if (digits < 16 || (digits == 16 && (last - first == 16 || static_cast<unsigned char>(first[16] - '0') > 9)))
+		{
+			using Unsigned = std::make_unsigned_t<T>;
+			const std::uint64_t magnitude = detail::ParseDigits(first, digits);
+			end = first + digits;
+			// Unsigned types only take "-0", instead of wrapping around like std::stoul.
+			const std::uint64_t limit = std::is_unsigned_v<T> && negative ? 0u
+				: static_cast<std::uint64_t>(std::numeric_limits<T>::max()) + (negative ? 1u : 0u);
+			if (magnitude > limit)
+			{
+				return EnvErrc::out_of_range;
+			}
+			const Unsigned value = static_cast<Unsigned>(magnitude);
+			out = static_cast<T>(negative ? static_cast<Unsigned>(0u - value) : value);
+			return EnvErrc::ok;
+		}
+		// from_chars accepts only '-' itself, so step back onto it instead of negating,
+		// which keeps the minimum value representable.
+		if constexpr (std::is_unsigned_v<T>)
+		{
+			if (negative)
+			{
+				// CountDigits stops at 16, only a zero is in range however many digits spell it.
+				bool zero = true;
+				for (end = first; end != last && static_cast<unsigned char>(*end - '0') <= 9; ++end)
+				{
+					zero = zero && *end == '0';
+				}
+				if (zero)
+				{
+					out = 0;
+					return EnvErrc::ok;
+				}
+				return EnvErrc::out_of_range;
+			}
+		}
+		else if (negative)
+		{
+			--first;
+		}
+		const auto [ptr, ec] = std::from_chars(first, last, out, 10);
+		end = ptr;
+		if (ec == std::errc::invalid_argument)
+		{
+			return EnvErrc::invalid_format;
+		}
+		if (ec == std::errc::result_out_of_range)
+		{
+			return EnvErrc::out_of_range;
+		}
+		return EnvErrc::ok;
+	}
+
+	template <class T>
+	CPPLIBENV_TEMPLATE EnvErrc EnvCfg::ParseFloating(std::string_view raw, T& out) noexcept
+	{
+		const char* first = raw.data();
+		const char* last = raw.data() + raw.size();
+		bool negative = false;
+		if (!detail::SkipPrefix(first, last, negative))
+		{
+			return EnvErrc::invalid_format;
+		}
+		std::from_chars_result result{};
+		if (last - first >= 2 && first[0] == '0' && (first[1] == 'x' || first[1] == 'X'))
+		{
+			// strtod accepts hexadecimal floats with a "0x" prefix, from_chars only without it. from_chars would
+			// also take a sign, "inf" or "nan" there, strtod requires a hexadecimal digit or the point.
+			const char next = last - first > 2 ? first[2] : '\0';
+			const bool digits = (next >= '0' && next <= '9') || ((next | 0x20) >= 'a' && (next | 0x20) <= 'f') || next == '.';
+			result = digits ? std::from_chars(first + 2, last, out, std::chars_format::hex) : std::from_chars_result{ first, std::errc::invalid_argument };
+			if (result.ec == std::errc::invalid_argument)
+			{
+				// Only the leading "0" is a valid number, like strtod does.
+				out = 0;
+				result.ec = std::errc();
+			}
+		}
+		else
+		{
+			result = std::from_chars(first, last, out, std::chars_format::general);
+		}
+		if (result.ec == std::errc::invalid_argument)
+		{
+			return EnvErrc::invalid_format;
+		}
+		// strtod reports ERANGE for overflow as well as for subnormal results.
+		constexpr T smallest = std::numeric_limits<T>::min();
+		if (result.ec == std::errc::result_out_of_range || (out != 0 && out == out && out > -smallest && out < smallest))
+		{
+			return EnvErrc::out_of_range;
+		}
+		if (negative)
+		{
+			out = -out;
+		}
+		return EnvErrc::ok;
+	}
+
+	template <class T>
+	CPPLIBENV_TEMPLATE std::exception_ptr EnvCfg::MakeParseError(EnvErrc error, std::string_view raw, const std::string& env_name)
+	{
+		const std::string value(raw);
+		const std::string type = detail::EnvTypeTraits<T>::name;
+		switch (error)
+		{
+		case EnvErrc::fractional:
+			return std::make_exception_ptr(EnvBadGet("expected " + type + ", but it's dooble " + value + " for enviroment " + env_name));
+		case EnvErrc::invalid_format:
+			return std::make_exception_ptr(EnvBadGet("expected " + type + " " + value + " for enviroment " + env_name));
+		case EnvErrc::out_of_range:
+			if constexpr (std::is_floating_point_v<T>)
+			{
+				return std::make_exception_ptr(EnvException(type + " out of range " + value + " for enviroment " + env_name));
+			}
+			return std::make_exception_ptr(EnvBadGet(type + " overflow " + value + " for enviroment " + env_name));
+		default:
+			return std::make_exception_ptr(EnvException("unhandled type " + type + " for enviroment " + env_name));
+		}
+	}
+
+	template<typename T>
+	CPPLIBENV_TEMPLATE EnvCfg::EnvResolved EnvCfg::HandleType(const EnvValue& value, std::string_view raw, const std::string& env_name)
+	{
+		using ValueType = std::decay_t<T>;
+
+		EnvResolved resolved{ detail::TypeTag<ValueType>(), std::nullopt, detail::RawHash(raw), nullptr };
+		if (std::optional<ValueType> env_val = ParseEnv<ValueType>(raw, env_name))
+		{
+			resolved.value = std::move(env_val.value());
+		}
+		else if (value.data)
+		{
+			if (const ValueType* ptr = std::get_if<ValueType>(&value.data.value()))
+			{
+				resolved.value = *ptr;
+			}
+		}
+		return resolved;
+	}
+
+#if CPPLIBENV_DEFINITIONS
+	CPPLIBENV_INLINE void EnvCfg::InitEnv(std::unordered_map<std::string, EnvValue>& env_map)
+	{
+		detail::EnvStatTimer timer(detail::stat_init_kind);
+		WaitSource();
+		try
+		{
+			bool patterns = false;
+			for (const auto& entry : env_map)
+			{
+				if (detail::IsEnvPattern(entry.first))
+				{
+					patterns = true;
+					continue;
+				}
+				ProcessEntry(entry.first, entry.second);
+			}
+			if (patterns)
+			{
+				InitPatterns(env_map, false);
+			}
+		}
+		catch (...)
+		{
+			Compact();
+			throw;
+		}
+		Compact();
+	}
+
+	CPPLIBENV_INLINE void EnvCfg::InitEnv(std::unordered_map<std::string, EnvValue>& env_map, const EnvInitOptions& options)
+	{
+		detail::EnvStatTimer timer(detail::stat_init_kind);
+		WaitSource();
+		if (options.lazy)
+		{
+			try
+			{
+				bool patterns = false;
+				for (const auto& entry : env_map)
+				{
+					if (detail::IsEnvPattern(entry.first))
+					{
+						patterns = true;
+						continue;
+					}
+					StoreLazy(entry.first, entry.second);
+				}
+				if (patterns)
+				{
+					InitPatterns(env_map, true);
+				}
+			}
+			catch (...)
+			{
+				Compact();
+				throw;
+			}
+			Compact();
+			return;
+		}
+		const std::size_t threads = std::min(options.threads, env_map.size() / std::max<std::size_t>(1, options.min_entries_per_thread));
+		if (threads <= 1)
+		{
+			InitEnv(env_map);
+			return;
+		}
+
+		// Entries are split into contiguous chunks of the map iteration order. Every worker resolves its chunk
+		// into its own part of `resolved` and stops at the first exception, then the chunks are stored in order up to
+		// the first failed entry, which leaves the configuration exactly as the sequential InitEnv would.
+		struct Chunk
+		{
+			std::size_t first;
+			std::size_t last;
+			std::size_t done;
+			std::exception_ptr error;
+		};
+		std::vector<const std::pair<const std::string, EnvValue>*> entries;
+		entries.reserve(env_map.size());
+		bool patterns = false;
+		for (const auto& entry : env_map)
+		{
+			if (detail::IsEnvPattern(entry.first))
+			{
+				patterns = true;
+				continue;
+			}
+			entries.push_back(&entry);
+		}
+		std::vector<EnvResolved> resolved(entries.size());
+		std::vector<Chunk> chunks(threads);
+		for (std::size_t i = 0; i < threads; ++i)
+		{
+			chunks[i].first = entries.size() * i / threads;
+			chunks[i].last = entries.size() * (i + 1) / threads;
+			chunks[i].done = chunks[i].first;
+		}
+		auto work = [&entries, &resolved](Chunk& chunk) {
+			try
+			{
+				for (; chunk.done < chunk.last; ++chunk.done)
+				{
+					const auto& [env_name, default_value] = *entries[chunk.done];
+					resolved[chunk.done] = ResolveEntry(env_name, default_value);
+				}
+			}
+			catch (...)
+			{
+				chunk.error = std::current_exception();
+			}
+		};
+
+		std::vector<std::thread> workers;
+		workers.reserve(threads - 1);
+		for (std::size_t i = 1; i < threads; ++i)
+		{
+			try
+			{
+				workers.emplace_back(work, std::ref(chunks[i]));
+			}
+			catch (const std::system_error&)
+			{
+				work(chunks[i]);
+			}
+		}
+		work(chunks[0]);
+		for (std::thread& worker : workers)
+		{
+			worker.join();
+		}
+
+		try
+		{
+			for (const Chunk& chunk : chunks)
+			{
+				for (std::size_t i = chunk.first; i < chunk.done; ++i)
+				{
+					StoreValue(entries[i]->first, std::move(resolved[i]), entries[i]->second);
+				}
+				if (chunk.error)
+				{
+					std::rethrow_exception(chunk.error);
+				}
+			}
+			if (patterns)
+			{
+				InitPatterns(env_map, false);
+			}
+		}
+		catch (...)
+		{
+			Compact();
+			throw;
+		}
+		Compact();
+	}
+
+	CPPLIBENV_INLINE void EnvCfg::InitPatterns(const std::unordered_map<std::string, EnvValue>& env_map, bool lazy, bool only_new)
+	{
+		detail::EnvPatternSet patterns;
+		std::vector<const EnvValue*> values;
+		for (const auto& entry : env_map)
+		{
+			if (detail::IsEnvPattern(entry.first))
+			{
+				patterns.Add(entry.first, values.size());
+				values.push_back(&entry.second);
+			}
+		}
+		std::optional<detail::EpochSection> section;
+		if (Overlay().load(std::memory_order_acquire) || Source().load(std::memory_order_acquire))
+		{
+			section.emplace();
+		}
+		// The values come with the names, so the matches are not looked up again.
+		std::string env_name;
+		ForEachEnv([&](std::string_view name, std::string_view raw) {
+			const std::size_t match = patterns.Match(name);
+			if (match == detail::EnvPatternSet::npos)
+			{
+				return;
+			}
+			env_name.assign(name.data(), name.size());
+			if (env_map.count(env_name) || (only_new && FindSlot(env_name)))
+			{
+				return;
+			}
+			const EnvValue& value = *values[match];
+			if (lazy)
+			{
+				StoreLazy(env_name, value);
+			}
+			else
+			{
+				StoreValue(env_name, ResolveRaw(env_name, value, raw), value);
+			}
+		});
+	}
+
+	CPPLIBENV_INLINE void EnvCfg::SetEnv(const std::string& env_name, const std::string& value, bool overwrite)
+	{
+		if (env_name.empty() || env_name.find('=') != std::string::npos)
+		{
+			throw EnvSetError("invalid environment variable name " + env_name);
+		}
+		if (Overlay().load(std::memory_order_acquire))
+		{
+			// DisableOverlay() retires the overlay, the section keeps it alive until the write is done.
+			detail::EpochSection section;
+			if (detail::EnvOverlay* overlay = Overlay().load(std::memory_order_seq_cst))
+			{
+				overlay->Set(env_name, value, overwrite);
+				return;
+			}
+		}
+		if (setenv(env_name.c_str(), value.c_str(), overwrite ? 1 : 0) != 0)
+		{
+			throw EnvSetError("setenv failed for variable " + env_name + " with value " + value);
+		}
+		if (auto& snapshot = Snapshot())
+		{
+			try
+			{
+				snapshot->Update(env_name);
+			}
+			catch (...)
+			{
+				snapshot.reset();
+				throw;
+			}
+		}
+	}
+
+	CPPLIBENV_INLINE bool EnvCfg::SetEnvN(const std::string& env_name, const std::string& value, bool overwrite) noexcept
+	{
+		if (Overlay().load(std::memory_order_acquire))
+		{
+			try
+			{
+				detail::EpochSection section;
+				if (detail::EnvOverlay* overlay = Overlay().load(std::memory_order_seq_cst))
+				{
+					return overlay->Set(env_name, value, overwrite);
+				}
+			}
+			catch (...)
+			{
+				return false;
+			}
+		}
+		if (setenv(env_name.c_str(), value.c_str(), overwrite ? 1 : 0) != 0)
+		{
+			return false;
+		}
+		if (auto& snapshot = Snapshot())
+		{
+			try
+			{
+				snapshot->Update(env_name);
+			}
+			catch (...)
+			{
+				// The index can not be kept up to date, fall back to getenv.
+				snapshot.reset();
+			}
+		}
+		return true;
+	}
+
+	CPPLIBENV_INLINE void EnvCfg::SetEnvs(const std::vector<std::pair<std::string, std::string>>& values, bool overwrite)
+	{
+		for (const auto& entry : values)
+		{
+			if (entry.first.empty() || entry.first.find('=') != std::string::npos)
+			{
+				throw EnvSetError("invalid environment variable name " + entry.first);
+			}
+		}
+		if (Overlay().load(std::memory_order_acquire))
+		{
+			detail::EpochSection section;
+			if (detail::EnvOverlay* overlay = Overlay().load(std::memory_order_seq_cst))
+			{
+				overlay->SetAll(values, overwrite);
+				return;
+			}
+		}
+		for (const auto& entry : values)
+		{
+			SetEnv(entry.first, entry.second, overwrite);
+		}
+	}
+
+	CPPLIBENV_INLINE bool EnvCfg::SetEnvsN(const std::vector<std::pair<std::string, std::string>>& values, bool overwrite) noexcept
+	{
+		if (Overlay().load(std::memory_order_acquire))
+		{
+			try
+			{
+				detail::EpochSection section;
+				if (detail::EnvOverlay* overlay = Overlay().load(std::memory_order_seq_cst))
+				{
+					return overlay->SetAll(values, overwrite);
+				}
+			}
+			catch (...)
+			{
+				return false;
+			}
+		}
+		for (const auto& entry : values)
+		{
+			if (entry.first.empty() || entry.first.find('=') != std::string::npos)
+			{
+				return false;
+			}
+		}
+		for (const auto& entry : values)
+		{
+			if (!SetEnvN(entry.first, entry.second, overwrite))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	CPPLIBENV_INLINE std::string_view EnvCfg::GetEnvView(const std::string& env_name) noexcept
+	{
+		if (const auto& snapshot = Snapshot())
+		{
+			return snapshot->Find(env_name);
+		}
+		if (const char* env_value = std::getenv(env_name.c_str()))
+		{
+			return env_value;
+		}
+		return std::string_view();
+	}
+
+	CPPLIBENV_INLINE std::unique_ptr<EnvSnapshot>& EnvCfg::Snapshot() noexcept
+	{
+		static std::unique_ptr<EnvSnapshot> snapshot;
+		return snapshot;
+	}
+
+	CPPLIBENV_INLINE void EnvCfg::EnableSnapshot()
+	{
+		Snapshot() = std::make_unique<EnvSnapshot>();
+	}
+
+	CPPLIBENV_INLINE void EnvCfg::DisableSnapshot() noexcept
+	{
+		Snapshot().reset();
+	}
+
+	CPPLIBENV_INLINE bool EnvCfg::IsSnapshotEnabled() noexcept
+	{
+		return Snapshot() != nullptr;
+	}
+
+	CPPLIBENV_INLINE std::atomic<detail::EnvOverlay*>& EnvCfg::Overlay() noexcept
+	{
+		static std::atomic<detail::EnvOverlay*> overlay{ nullptr };
+		return overlay;
+	}
+
+	CPPLIBENV_INLINE void EnvCfg::EnableOverlay()
+	{
+		if (Overlay().load(std::memory_order_acquire))
+		{
+			return;
+		}
+		auto overlay = std::make_unique<detail::EnvOverlay>();
+		detail::EnvOverlay* expected = nullptr;
+		if (Overlay().compare_exchange_strong(expected, overlay.get(), std::memory_order_seq_cst))
+		{
+			overlay.release();
+		}
+	}
+
+	CPPLIBENV_INLINE void EnvCfg::DisableOverlay() noexcept
+	{
+		if (detail::EnvOverlay* overlay = Overlay().exchange(nullptr, std::memory_order_seq_cst))
+		{
+			detail::EpochDomain::Instance().Retire(overlay, [](void* ptr) noexcept {
+				delete static_cast<detail::EnvOverlay*>(ptr);
+			});
+		}
+	}
+
+	CPPLIBENV_INLINE bool EnvCfg::IsOverlayEnabled() noexcept
+	{
+		return Overlay().load(std::memory_order_acquire) != nullptr;
+	}
+
+	CPPLIBENV_INLINE EnvBlock EnvCfg::MaterializeEnv()
+	{
+		EnvBlock block;
+		MaterializeEnv(block);
+		return block;
+	}
+
+	CPPLIBENV_INLINE void EnvCfg::MaterializeEnv(EnvBlock& block)
+	{
+		block.Clear();
+		if (Overlay().load(std::memory_order_acquire))
+		{
+			detail::EpochSection section;
+			if (const detail::EnvOverlay* overlay = Overlay().load(std::memory_order_seq_cst))
+			{
+				overlay->Materialize(block);
+				return;
+			}
+		}
+		for (char** env = environ; env && *env; ++env)
+		{
+			const char* entry = *env;
+			if (const char* separator = std::strchr(entry, '='))
+			{
+				block.Append(std::string_view(entry, static_cast<std::size_t>(separator - entry)), separator + 1);
+			}
+		}
+	}
+
+	CPPLIBENV_INLINE std::string_view EnvCfg::ResolveView(const std::string& env_name) noexcept
+	{
+		const detail::EnvOverlay* overlay = Overlay().load(std::memory_order_seq_cst);
+		const EnvSourceBinding* binding = Source().load(std::memory_order_seq_cst);
+		if (binding && binding->precedence == EnvPrecedence::source_)
+		{
+			const std::string_view value = binding->source->Find(env_name);
+			if (value.data())
+			{
+				return value;
+			}
+		}
+		// A null data() means the variable is not set, an empty value still shadows the source.
+		const std::string_view value = overlay ? overlay->Find(env_name) : GetEnvView(env_name);
+		if (!value.data() && binding && binding->precedence == EnvPrecedence::environment_)
+		{
+			return binding->source->Find(env_name);
+		}
+		return value;
+	}
+
+	CPPLIBENV_INLINE std::atomic<EnvCfg::EnvSourceBinding*>& EnvCfg::Source() noexcept
+	{
+		static std::atomic<EnvSourceBinding*> source{ nullptr };
+		return source;
+	}
+
+	CPPLIBENV_INLINE void EnvCfg::AttachFile(std::shared_ptr<const EnvFileSource> source, EnvPrecedence precedence)
+	{
+		if (!source)
+		{
+			throw EnvException("can not attach an empty file source");
+		}
+		AttachSource(std::move(source), precedence);
+	}
+
+	CPPLIBENV_INLINE void EnvCfg::DetachFile() noexcept
+	{
+		DetachSource();
+	}
+
+	CPPLIBENV_INLINE void EnvCfg::AttachSource(std::shared_ptr<const EnvSource> source, EnvPrecedence precedence)
+	{
+		if (!source)
+		{
+			throw EnvException("can not attach an empty source");
+		}
+		auto binding = std::make_unique<EnvSourceBinding>(EnvSourceBinding{ std::move(source), precedence });
+		if (EnvSourceBinding* old = Source().exchange(binding.release(), std::memory_order_seq_cst))
+		{
+			detail::EpochDomain::Instance().Retire(old, [](void* ptr) noexcept {
+				delete static_cast<EnvSourceBinding*>(ptr);
+			});
+		}
+	}
+
+	CPPLIBENV_INLINE void EnvCfg::WaitSource()
+	{
+		if (!Source().load(std::memory_order_acquire))
+		{
+			return;
+		}
+		std::shared_ptr<const EnvSource> source;
+		{
+			detail::EpochSection section;
+			if (const EnvSourceBinding* binding = Source().load(std::memory_order_seq_cst))
+			{
+				source = binding->source;
+			}
+		}
+		if (source)
+		{
+			source->Wait();
+		}
+	}
+
+	CPPLIBENV_INLINE bool EnvCfg::WaitSourceN() noexcept
+	{
+		try
+		{
+			WaitSource();
+			return true;
+		}
+		catch (...)
+		{
+			return false;
+		}
+	}
+
+	CPPLIBENV_INLINE void EnvCfg::DetachSource() noexcept
+	{
+		if (EnvSourceBinding* old = Source().exchange(nullptr, std::memory_order_seq_cst))
+		{
+			detail::EpochDomain::Instance().Retire(old, [](void* ptr) noexcept {
+				delete static_cast<EnvSourceBinding*>(ptr);
+			});
+		}
+	}
+
+	CPPLIBENV_INLINE detail::MappedFile::MappedFile(const std::string& path, const char* what)
+	{
+		const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd < 0)
+		{
+			throw EnvException(std::string("can not open ") + what + " " + path);
+		}
+		struct stat info {};
+		if (::fstat(fd, &info) != 0)
+		{
+			::close(fd);
+			throw EnvException(std::string("can not stat ") + what + " " + path);
+		}
+		m_length = static_cast<std::size_t>(info.st_size);
+		if (m_length > 0)
+		{
+			void* data = ::mmap(nullptr, m_length, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (data == MAP_FAILED)
+			{
+				::close(fd);
+				throw EnvException(std::string("can not map ") + what + " " + path);
+			}
+			m_data = static_cast<const char*>(data);
+		}
+		// The mapping stays valid after the descriptor is closed.
+		::close(fd);
+	}
+
+	CPPLIBENV_INLINE detail::MappedFile::~MappedFile()
+	{
+		if (m_data)
+		{
+			::munmap(const_cast<char*>(m_data), m_length);
+		}
+	}
+
+	CPPLIBENV_INLINE EnvFileSource::EnvFileSource(const std::string& path) : m_file(path, "env file")
+	{
+		Index();
+	}
+
+	CPPLIBENV_INLINE EnvFileSource::~EnvFileSource() = default;
+
+	CPPLIBENV_INLINE std::string_view EnvFileSource::Find(std::string_view env_name) const noexcept
+	{
+		if (m_entries.empty())
+		{
+			return std::string_view();
+		}
+		return m_entries[Position(env_name, std::hash<std::string_view>{}(env_name))].value;
+	}
+
+	CPPLIBENV_INLINE void EnvFileSource::ForEach(const std::function<void(std::string_view, std::string_view)>& f) const
+	{
+		ForEach<const std::function<void(std::string_view, std::string_view)>&>(f);
+	}
+
+	struct EnvAsyncSource::State
+	{
+		std::mutex mutex;
+		std::condition_variable completed;
+		std::atomic<bool> done{ false };
+		std::exception_ptr error;
+		// Sorted by name once the fetch completed.
+		Values values;
+
+		void Complete(Values result, std::exception_ptr failure)
+		{
+			// The last value of a key repeated in the result wins.
+			std::stable_sort(result.begin(), result.end(), [](const auto& lhs, const auto& rhs) {
+				return lhs.first < rhs.first;
+			});
+			Values unique;
+			unique.reserve(result.size());
+			for (auto& entry : result)
+			{
+				if (!unique.empty() && unique.back().first == entry.first)
+				{
+					unique.back().second = std::move(entry.second);
+				}
+				else
+				{
+					unique.push_back(std::move(entry));
+				}
+			}
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (done.load(std::memory_order_relaxed))
+				{
+					return;
+				}
+				values = std::move(unique);
+				error = std::move(failure);
+				done.store(true, std::memory_order_release);
+			}
+			completed.notify_all();
+		}
+	};
+
+	// Shared by the copies of a Completion, fails the fetch when the last copy is gone before it was called.
+	struct EnvAsyncSource::Completion::Token
+	{
+		explicit Token(std::shared_ptr<State> fetch) noexcept : state(std::move(fetch)) {}
+		Token(const Token&) = delete;
+		Token& operator=(const Token&) = delete;
+		~Token()
+		{
+			if (!state->done.load(std::memory_order_acquire))
+			{
+				state->Complete({}, std::make_exception_ptr(EnvException("fetch of the async source was abandoned")));
+			}
+		}
+		std::shared_ptr<State> state;
+	};
+
+	CPPLIBENV_INLINE void EnvAsyncSource::Completion::operator()(Values values) const
+	{
+		m_token->state->Complete(std::move(values), nullptr);
+	}
+
+	CPPLIBENV_INLINE void EnvAsyncSource::Completion::Fail(std::exception_ptr error) const
+	{
+		m_token->state->Complete({}, error ? error : std::make_exception_ptr(EnvException("fetch of the async source failed")));
+	}
+
+	CPPLIBENV_INLINE EnvAsyncSource::EnvAsyncSource(std::vector<std::string> keys, const Fetcher& fetcher) : m_state(std::make_shared<State>())
+	{
+		if (!fetcher)
+		{
+			throw EnvException("can not fetch an async source without a fetcher");
+		}
+		fetcher(std::move(keys), Completion(std::make_shared<Completion::Token>(m_state)));
+	}
+
+	CPPLIBENV_INLINE bool EnvAsyncSource::Ready() const noexcept
+	{
+		return m_state->done.load(std::memory_order_acquire);
+	}
+
+	CPPLIBENV_INLINE std::mutex& EnvAsyncSource::Mutex() const noexcept
+	{
+		return m_state->mutex;
+	}
+
+	CPPLIBENV_INLINE std::condition_variable& EnvAsyncSource::Completed() const noexcept
+	{
+		return m_state->completed;
+	}
+
+	CPPLIBENV_INLINE void EnvAsyncSource::Await() const noexcept
+	{
+		if (Ready())
+		{
+			return;
+		}
+		std::unique_lock<std::mutex> lock(m_state->mutex);
+		m_state->completed.wait(lock, [this]() {
+			return Ready();
+		});
+	}
+
+	CPPLIBENV_INLINE void EnvAsyncSource::Wait() const
+	{
+		Await();
+		if (m_state->error)
+		{
+			std::rethrow_exception(m_state->error);
+		}
+	}
+
+	CPPLIBENV_INLINE std::string_view EnvAsyncSource::Find(std::string_view env_name) const noexcept
+	{
+		Await();
+		const Values& values = m_state->values;
+		auto it = std::lower_bound(values.begin(), values.end(), env_name, [](const auto& entry, std::string_view name) {
+			return std::string_view(entry.first) < name;
+		});
+		if (it == values.end() || it->first != env_name)
+		{
+			return std::string_view();
+		}
+		return it->second;
+	}
+
+	CPPLIBENV_INLINE void EnvAsyncSource::ForEach(const std::function<void(std::string_view, std::string_view)>& f) const
+	{
+		Await();
+		for (const auto& entry : m_state->values)
+		{
+			f(entry.first, entry.second);
+		}
+	}
+
+	CPPLIBENV_INLINE void EnvFileSource::Index()
+	{
+		m_entries.assign(16, Entry{ 0, std::string_view(), std::string_view() });
+		const char* const end = m_file.data() + m_file.size();
+		for (const char* line = m_file.data(); line && line < end;)
+		{
+			const char* newline = static_cast<const char*>(std::memchr(line, '\n', static_cast<std::size_t>(end - line)));
+			const char* line_end = newline ? newline : end;
+			IndexLine(std::string_view(line, static_cast<std::size_t>(line_end - line)));
+			line = newline ? newline + 1 : nullptr;
+		}
+	}
+
+	CPPLIBENV_INLINE void EnvFileSource::IndexLine(std::string_view line)
+	{
+		auto is_blank = [](char c) {
+			return c == ' ' || c == '\t' || c == '\r';
+		};
+		auto trim = [&is_blank](std::string_view text) {
+			while (!text.empty() && is_blank(text.front()))
+			{
+				text.remove_prefix(1);
+			}
+			while (!text.empty() && is_blank(text.back()))
+			{
+				text.remove_suffix(1);
+			}
+			return text;
+		};
+		line = trim(line);
+		if (line.empty() || line.front() == '#')
+		{
+			return;
+		}
+		if (line.size() > 7 && line.compare(0, 6, "export") == 0 && is_blank(line[6]))
+		{
+			line = trim(line.substr(7));
+		}
+		const std::size_t separator = line.find('=');
+		if (separator == std::string_view::npos)
+		{
+			return;
+		}
+		const std::string_view name = trim(line.substr(0, separator));
+		std::string_view value = trim(line.substr(separator + 1));
+		if (name.empty())
+		{
+			return;
+		}
+		const bool quoted = !value.empty() && (value.front() == '"' || value.front() == '\'');
+		const std::size_t close = quoted ? value.find(value.front(), 1) : std::string_view::npos;
+		const std::string_view rest = close == std::string_view::npos ? std::string_view() : trim(value.substr(close + 1));
+		if (close != std::string_view::npos && (rest.empty() || rest.front() == '#'))
+		{
+			value = value.substr(1, close - 1);
+		}
+		else if (value.size() >= 2 && quoted && value.back() == value.front())
+		{
+			value = value.substr(1, value.size() - 2);
+		}
+		else
+		{
+			for (std::size_t i = 1; i < value.size(); ++i)
+			{
+				if (value[i] == '#' && is_blank(value[i - 1]))
+				{
+					value = trim(value.substr(0, i));
+					break;
+				}
+			}
+		}
+		// Keep a non-null data() for empty values, it distinguishes them from missing keys.
+		Insert(name, value.empty() ? std::string_view(name.data() + name.size(), 0) : value);
+	}
+
+	CPPLIBENV_INLINE void EnvFileSource::Insert(std::string_view name, std::string_view value)
+	{
+		if ((m_size + 1) * 2 > m_entries.size())
+		{
+			Grow();
+		}
+		const std::size_t hash = std::hash<std::string_view>{}(name);
+		Entry& entry = m_entries[Position(name, hash)];
+		if (!entry.name.data())
+		{
+			++m_size;
+		}
+		entry = Entry{ hash, name, value };
+	}
+
+	CPPLIBENV_INLINE std::size_t EnvFileSource::Position(std::string_view env_name, std::size_t hash) const noexcept
+	{
+		const std::size_t mask = m_entries.size() - 1;
+		for (std::size_t pos = hash & mask; ; pos = (pos + 1) & mask)
+		{
+			const Entry& entry = m_entries[pos];
+			if (!entry.name.data() || (entry.hash == hash && entry.name == env_name))
+			{
+				return pos;
+			}
+		}
+	}
+
+	CPPLIBENV_INLINE void EnvFileSource::Grow()
+	{
+		std::vector<Entry> old(m_entries.size() * 2, Entry{ 0, std::string_view(), std::string_view() });
+		old.swap(m_entries);
+		for (const Entry& entry : old)
+		{
+			if (entry.name.data())
+			{
+				m_entries[Position(entry.name, entry.hash)] = entry;
+			}
+		}
+	}
+
+	CPPLIBENV_INLINE void EnvBlock::Append(std::string_view env_name, std::string_view value)
+	{
+		if ((m_offsets.size() + 1) * 2 > m_index.size())
+		{
+			GrowIndex();
+		}
+		const std::size_t bucket = Bucket(env_name);
+		m_offsets.push_back(m_buffer.size());
+		m_buffer.insert(m_buffer.end(), env_name.begin(), env_name.end());
+		m_buffer.push_back('=');
+		m_buffer.insert(m_buffer.end(), value.begin(), value.end());
+		m_buffer.push_back('\0');
+		m_index[bucket] = m_offsets.size();
+		m_envp.clear();
+	}
+
+	CPPLIBENV_INLINE void EnvBlock::Set(std::string_view env_name, std::string_view value)
+	{
+		CheckName(env_name);
+		Replace(env_name, value);
+	}
+
+	CPPLIBENV_INLINE void EnvBlock::CheckName(std::string_view env_name)
+	{
+		if (env_name.empty() || env_name.find('=') != std::string_view::npos)
+		{
+			throw EnvSetError("invalid environment variable name " + std::string(env_name));
+		}
+	}
+
+	CPPLIBENV_INLINE void EnvBlock::Replace(std::string_view env_name, std::string_view value)
+	{
+		const std::size_t entry = m_index.empty() ? 0 : m_index[Bucket(env_name)];
+		if (!entry)
+		{
+			Append(env_name, value);
+			return;
+		}
+		// The new string goes to the end of the buffer, the replaced one stays unused until Clear().
+		const std::size_t offset = m_buffer.size();
+		m_buffer.insert(m_buffer.end(), env_name.begin(), env_name.end());
+		m_buffer.push_back('=');
+		m_buffer.insert(m_buffer.end(), value.begin(), value.end());
+		m_buffer.push_back('\0');
+		m_offsets[entry - 1] = offset;
+		m_envp.clear();
+	}
+
+	CPPLIBENV_INLINE std::string_view EnvBlock::Find(std::string_view env_name) const noexcept
+	{
+		const std::size_t entry = m_index.empty() ? 0 : m_index[Bucket(env_name)];
+		if (!entry)
+		{
+			return std::string_view();
+		}
+		const char* text = m_buffer.data() + m_offsets[entry - 1] + env_name.size() + 1;
+		return std::string_view(text);
+	}
+
+	CPPLIBENV_INLINE void EnvBlock::Clear() noexcept
+	{
+		m_buffer.clear();
+		m_offsets.clear();
+		m_envp.clear();
+		std::fill(m_index.begin(), m_index.end(), 0);
+	}
+
+	CPPLIBENV_INLINE void EnvBlock::Reserve(std::size_t entries, std::size_t bytes)
+	{
+		m_buffer.reserve(bytes + 2 * entries);
+		m_offsets.reserve(entries);
+		m_envp.reserve(entries + 1);
+		while (entries * 2 > m_index.size())
+		{
+			GrowIndex();
+		}
+	}
+
+	CPPLIBENV_INLINE std::string_view EnvBlock::Name(std::size_t entry) const noexcept
+	{
+		const char* text = m_buffer.data() + m_offsets[entry];
+		return std::string_view(text, static_cast<std::size_t>(std::strchr(text, '=') - text));
+	}
+
+	CPPLIBENV_INLINE std::size_t EnvBlock::Bucket(std::string_view env_name) const noexcept
+	{
+		const std::size_t mask = m_index.size() - 1;
+		std::size_t pos = std::hash<std::string_view>{}(env_name) & mask;
+		while (m_index[pos] != 0 && Name(m_index[pos] - 1) != env_name)
+		{
+			pos = (pos + 1) & mask;
+		}
+		return pos;
+	}
+
+	CPPLIBENV_INLINE void EnvBlock::GrowIndex()
+	{
+		std::vector<std::size_t> index(std::max<std::size_t>(16, m_index.size() * 2), 0);
+		m_index.swap(index);
+		const std::size_t mask = m_index.size() - 1;
+		for (std::size_t position : index)
+		{
+			if (position == 0)
+			{
+				continue;
+			}
+			std::size_t pos = std::hash<std::string_view>{}(Name(position - 1)) & mask;
+			while (m_index[pos] != 0)
+			{
+				pos = (pos + 1) & mask;
+			}
+			m_index[pos] = position;
+		}
+	}
+
+	CPPLIBENV_INLINE EnvBlockPool::Lease EnvBlockPool::Acquire()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (!m_idle.empty())
+			{
+				std::unique_ptr<EnvBlock> block = std::move(m_idle.back());
+				m_idle.pop_back();
+				return Lease(*this, std::move(block));
+			}
+		}
+		return Lease(*this, std::make_unique<EnvBlock>());
+	}
+
+	CPPLIBENV_INLINE void EnvBlockPool::Release(std::unique_ptr<EnvBlock> block) noexcept
+	{
+		block->Clear();
+		std::lock_guard<std::mutex> lock(m_mutex);
+		try
+		{
+			m_idle.push_back(std::move(block));
+		}
+		catch (...)
+		{
+			// The block is freed instead of pooled.
+		}
+	}
+
+	CPPLIBENV_INLINE char* const* EnvBlock::envp()
+	{
+		if (m_envp.empty())
+		{
+			m_envp.reserve(m_offsets.size() + 1);
+			for (std::size_t offset : m_offsets)
+			{
+				m_envp.push_back(m_buffer.data() + offset);
+			}
+			m_envp.push_back(nullptr);
+		}
+		return m_envp.data();
+	}
+
+	CPPLIBENV_INLINE detail::EnvOverlay::EnvOverlay() : m_state(new State())
+	{
+	}
+
+	CPPLIBENV_INLINE detail::EnvOverlay::~EnvOverlay()
+	{
+		delete m_state.load(std::memory_order_relaxed);
+	}
+
+	CPPLIBENV_INLINE std::string_view detail::EnvOverlay::Find(std::string_view env_name) const noexcept
+	{
+		if (const auto* entry = m_state.load(std::memory_order_seq_cst)->Find(env_name))
+		{
+			return entry->second;
+		}
+		return m_base.Find(env_name);
+	}
+
+	CPPLIBENV_INLINE bool detail::EnvOverlay::Set(std::string_view env_name, std::string_view value, bool overwrite)
+	{
+		if (env_name.empty() || env_name.find('=') != std::string_view::npos)
+		{
+			return false;
+		}
+		std::lock_guard<std::mutex> lock(m_write_mutex);
+		const State* current = m_state.load(std::memory_order_relaxed);
+		// EnvSnapshot::Find returns a null view for missing variables only.
+		if (!overwrite && (current->Find(env_name) || m_base.Find(env_name).data()))
+		{
+			return true;
+		}
+		auto next = std::make_unique<State>(*current);
+		Apply(*next, env_name, value, true);
+		Publish(std::move(next));
+		return true;
+	}
+
+	CPPLIBENV_INLINE bool detail::EnvOverlay::SetAll(const std::vector<std::pair<std::string, std::string>>& values, bool overwrite)
+	{
+		for (const auto& entry : values)
+		{
+			if (entry.first.empty() || entry.first.find('=') != std::string::npos)
+			{
+				return false;
+			}
+		}
+		if (values.empty())
+		{
+			return true;
+		}
+		std::lock_guard<std::mutex> lock(m_write_mutex);
+		auto next = std::make_unique<State>(*m_state.load(std::memory_order_relaxed));
+		for (const auto& entry : values)
+		{
+			Apply(*next, entry.first, entry.second, overwrite);
+		}
+		Publish(std::move(next));
+		return true;
+	}
+
+	CPPLIBENV_INLINE void detail::EnvOverlay::Apply(State& next, std::string_view env_name, std::string_view value, bool overwrite) const
+	{
+		if (const auto* existing = next.Find(env_name))
+		{
+			if (overwrite)
+			{
+				next.entries[static_cast<std::size_t>(existing - next.entries.data())].second.assign(value.data(), value.size());
+			}
+		}
+		else if (overwrite || !m_base.Find(env_name).data())
+		{
+			next.Add(env_name, value);
+		}
+	}
+
+	CPPLIBENV_INLINE void detail::EnvOverlay::Publish(std::unique_ptr<State> next) noexcept
+	{
+		const State* old = m_state.exchange(next.release(), std::memory_order_seq_cst);
+		EpochDomain::Instance().Retire(const_cast<State*>(old), &DeleteState);
+	}
+
+	CPPLIBENV_INLINE void detail::EnvOverlay::Materialize(EnvBlock& block) const
+	{
+		ForEach([&block](std::string_view env_name, std::string_view value) {
+			block.Append(env_name, value);
+		});
+	}
+
+	CPPLIBENV_INLINE const std::pair<std::string, std::string>* detail::EnvOverlay::State::Find(std::string_view env_name) const noexcept
+	{
+		if (index.empty())
+		{
+			return nullptr;
+		}
+		const std::size_t mask = index.size() - 1;
+		for (std::size_t pos = std::hash<std::string_view>{}(env_name) & mask; index[pos] != 0; pos = (pos + 1) & mask)
+		{
+			const auto& entry = entries[index[pos] - 1];
+			if (entry.first == env_name)
+			{
+				return &entry;
+			}
+		}
+		return nullptr;
+	}
+
+	CPPLIBENV_INLINE void detail::EnvOverlay::State::Add(std::string_view env_name, std::string_view value)
+	{
+		entries.emplace_back(std::string(env_name), std::string(value));
+		if (index.size() < entries.size() * 2)
+		{
+			Rebuild();
+			return;
+		}
+		const std::size_t mask = index.size() - 1;
+		std::size_t pos = std::hash<std::string_view>{}(env_name) & mask;
+		while (index[pos] != 0)
+		{
+			pos = (pos + 1) & mask;
+		}
+		index[pos] = entries.size();
+	}
+
+	CPPLIBENV_INLINE void detail::EnvOverlay::State::Rebuild()
+	{
+		std::size_t capacity = 16;
+		while (capacity < entries.size() * 2)
+		{
+			capacity *= 2;
+		}
+		index.assign(capacity, 0);
+		const std::size_t mask = capacity - 1;
+		for (std::size_t i = 0; i < entries.size(); ++i)
+		{
+			std::size_t pos = std::hash<std::string_view>{}(entries[i].first) & mask;
+			while (index[pos] != 0)
+			{
+				pos = (pos + 1) & mask;
+			}
+			index[pos] = i + 1;
+		}
+	}
+
+	CPPLIBENV_INLINE void detail::EnvOverlay::DeleteState(void* state) noexcept
+	{
+		delete static_cast<State*>(state);
+	}
+
+	CPPLIBENV_INLINE void detail::EnvPatternSet::Add(std::string_view pattern, std::size_t id)
+	{
+		const std::size_t prefix = std::min(pattern.find('*'), pattern.size());
+		std::uint32_t node = 0;
+		for (std::size_t i = 0; i < prefix; ++i)
+		{
+			std::vector<std::pair<char, std::uint32_t>>& children = m_nodes[node].children;
+			auto it = std::find_if(children.begin(), children.end(), [&](const auto& child) {
+				return child.first == pattern[i];
+			});
+			if (it == children.end())
+			{
+				const std::uint32_t child = static_cast<std::uint32_t>(m_nodes.size());
+				children.emplace_back(pattern[i], child);
+				m_nodes.emplace_back();
+				node = child;
+			}
+			else
+			{
+				node = it->second;
+			}
+		}
+		m_nodes[node].patterns.push_back(static_cast<std::uint32_t>(m_patterns.size()));
+		const std::size_t literal = pattern.size() - static_cast<std::size_t>(std::count(pattern.begin(), pattern.end(), '*'));
+		m_patterns.push_back(Pattern{ std::string(pattern), prefix, literal, id });
+	}
+
+	CPPLIBENV_INLINE std::size_t detail::EnvPatternSet::Match(std::string_view name) const noexcept
+	{
+		const Pattern* best = nullptr;
+		std::uint32_t node = 0;
+		for (std::size_t depth = 0; ; ++depth)
+		{
+			for (std::uint32_t index : m_nodes[node].patterns)
+			{
+				const Pattern& pattern = m_patterns[index];
+				if (best && (pattern.literal < best->literal || (pattern.literal == best->literal && pattern.text > best->text)))
+				{
+					continue;
+				}
+				if (Glob(std::string_view(pattern.text).substr(pattern.prefix), name.substr(depth)))
+				{
+					best = &pattern;
+				}
+			}
+			if (depth == name.size())
+			{
+				break;
+			}
+			const std::vector<std::pair<char, std::uint32_t>>& children = m_nodes[node].children;
+			auto it = std::find_if(children.begin(), children.end(), [&](const auto& child) {
+				return child.first == name[depth];
+			});
+			if (it == children.end())
+			{
+				break;
+			}
+			node = it->second;
+		}
+		return best ? best->id : npos;
+	}
+
+	CPPLIBENV_INLINE bool detail::EnvPatternSet::Glob(std::string_view pattern, std::string_view name) noexcept
+	{
+		// Greedy matching which backtracks to the last '*' only, linear for patterns with a single '*'.
+		std::size_t p = 0;
+		std::size_t n = 0;
+		std::size_t star = std::string_view::npos;
+		std::size_t resume = 0;
+		while (n < name.size())
+		{
+			if (p < pattern.size() && pattern[p] == '*')
+			{
+				star = p++;
+				resume = n;
+			}
+			else if (p < pattern.size() && pattern[p] == name[n])
+			{
+				++p;
+				++n;
+			}
+			else if (star != std::string_view::npos)
+			{
+				p = star + 1;
+				n = ++resume;
+			}
+			else
+			{
+				return false;
+			}
+		}
+		while (p < pattern.size() && pattern[p] == '*')
+		{
+			++p;
+		}
+		return p == pattern.size();
+	}
+
+	CPPLIBENV_INLINE EnvSnapshot::EnvSnapshot()
+	{
+		std::size_t count = 0;
+		for (char** env = environ; env && *env; ++env)
+		{
+			++count;
+		}
+		std::size_t capacity = 16;
+		while (capacity < count * 2)
+		{
+			capacity *= 2;
+		}
+		m_entries.assign(capacity, Entry{ 0, std::string_view(), nullptr });
+		for (char** env = environ; env && *env; ++env)
+		{
+			const char* entry = *env;
+			const char* separator = std::strchr(entry, '=');
+			if (!separator)
+			{
+				continue;
+			}
+			Insert(std::string_view(entry, static_cast<std::size_t>(separator - entry)), separator + 1);
+		}
+	}
+
+	CPPLIBENV_INLINE std::string_view EnvSnapshot::Find(std::string_view env_name) const noexcept
+	{
+		const Entry& entry = m_entries[Position(env_name, std::hash<std::string_view>{}(env_name))];
+		if (!entry.value)
+		{
+			return std::string_view();
+		}
+		return entry.value;
+	}
+
+	CPPLIBENV_INLINE void EnvSnapshot::ForEach(const std::function<void(std::string_view, std::string_view)>& f) const
+	{
+		ForEach<const std::function<void(std::string_view, std::string_view)>&>(f);
+	}
+
+	CPPLIBENV_INLINE void EnvSnapshot::Update(const std::string& env_name)
+	{
+		const char* value = std::getenv(env_name.c_str());
+		if (!value)
+		{
+			return;
+		}
+		// getenv returns a pointer behind "NAME=" of the environ entry, which holds the name as well.
+		const std::string_view name(value - env_name.size() - 1, env_name.size());
+		Entry& entry = m_entries[Position(name, std::hash<std::string_view>{}(name))];
+		if (entry.value)
+		{
+			entry.name = name;
+			entry.value = value;
+			return;
+		}
+		Insert(name, value);
+	}
+
+	CPPLIBENV_INLINE void EnvSnapshot::Insert(std::string_view name, const char* value)
+	{
+		if ((m_size + 1) * 2 > m_entries.size())
+		{
+			Grow();
+		}
+		const std::size_t hash = std::hash<std::string_view>{}(name);
+		Entry& entry = m_entries[Position(name, hash)];
+		if (entry.value)
+		{
+			// getenv returns the first match for duplicated names.
+			return;
+		}
+		entry = Entry{ hash, name, value };
+		++m_size;
+	}
+
+	CPPLIBENV_INLINE std::size_t EnvSnapshot::Position(std::string_view env_name, std::size_t hash) const noexcept
+	{
+		const std::size_t mask = m_entries.size() - 1;
+		for (std::size_t pos = hash & mask; ; pos = (pos + 1) & mask)
+		{
+			const Entry& entry = m_entries[pos];
+			if (!entry.value || (entry.hash == hash && entry.name == env_name))
+			{
+				return pos;
+			}
+		}
+	}
+
+	CPPLIBENV_INLINE void EnvSnapshot::Grow()
+	{
+		std::vector<Entry> old(std::max<std::size_t>(16, m_entries.size() * 2), Entry{ 0, std::string_view(), nullptr });
+		old.swap(m_entries);
+		m_size = 0;
+		for (const Entry& entry : old)
+		{
+			if (entry.value)
+			{
+				m_entries[Position(entry.name, entry.hash)] = entry;
+				++m_size;
+			}
+		}
+	}
+
+	CPPLIBENV_INLINE std::size_t EnvCfg::ProcessEntry(const std::string& env_name, const EnvValue& default_value)
+	{
+		return StoreValue(env_name, ResolveEntry(env_name, default_value), default_value);
+	}
+
+	CPPLIBENV_INLINE EnvCfg::EnvResolved EnvCfg::ResolveEntry(const std::string& env_name, const EnvValue& default_value)
+	{
+		return WithEnvView(env_name, [&](std::string_view raw) {
+			return ResolveRaw(env_name, default_value, raw);
+		});
+	}
+
+	CPPLIBENV_INLINE EnvCfg::EnvResolved EnvCfg::ResolveRaw(const std::string& env_name, const EnvValue& default_value, std::string_view raw)
+	{
+		return std::visit([&](const auto& val) {
+			using ValueType = std::decay_t<decltype(val)>;
+			if constexpr (std::is_same_v<ValueType, EnvCfgTypes>)
+			{
+				return HandleEnumType(default_value, raw, env_name);
+			}
+			else if constexpr (std::is_same_v<ValueType, EnvList>)
+			{
+				return HandleList(val, raw, env_name);
+			}
+			else
+			{
+				return HandleType<ValueType>(default_value, raw, env_name);
+			}
+		}, default_value.data.value());
+	}
+
+	CPPLIBENV_INLINE EnvCfg::EnvResolved EnvCfg::HandleEnumType(const EnvValue& value, std::string_view raw, const std::string& env_name)
+	{
+		return detail::DispatchType(std::get<EnvCfgTypes>(value.data.value()), [&](auto type) {
+			return HandleType<typename decltype(type)::type>(value, raw, env_name);
+		});
+	}
+
+	CPPLIBENV_INLINE EnvCfg::EnvResolved EnvCfg::HandleList(const EnvList& list, std::string_view raw, const std::string& env_name)
+	{
+		if (static_cast<std::size_t>(list.element) >= detail::type_count || list.element == EnvCfgTypes::bool_)
+		{
+			throw EnvException("unsupported list element type for enviroment " + env_name);
+		}
+		EnvResolved resolved{ EnvCfgTypes::list_, std::nullopt, detail::RawHash(raw), std::make_unique<EnvListData>(EnvListData{ list.element, list.separator, list.sorted, {} }) };
+		resolved.value = ParseListValue(*resolved.list, raw, list.fallback, env_name);
+		return resolved;
+	}
+
+	CPPLIBENV_INLINE EnvCfg::EnvValueMember EnvCfg::ParseListValue(EnvListData& list, std::string_view raw, std::string_view fallback, const std::string& env_name)
+	{
+		const std::string_view text = raw.empty() ? fallback : raw;
+		if (text.empty())
+		{
+			return std::nullopt;
+		}
+		ParseList(list, text, env_name);
+		return std::string(text);
+	}
+
+	CPPLIBENV_INLINE void EnvCfg::ParseList(EnvListData& list, std::string_view text, const std::string& env_name)
+	{
+		detail::EnvStatTimer timer(static_cast<std::size_t>(EnvCfgTypes::list_));
+		// Calls `element(offset, view)` for every trimmed element in a single pass over the text.
+		auto split = [&](auto&& element) {
+			std::size_t first = 0;
+			while (true)
+			{
+				const std::size_t separator = std::min(text.find(list.separator, first), text.size());
+				std::size_t begin = first;
+				std::size_t end = separator;
+				while (begin < end && (text[begin] == ' ' || text[begin] == '\t'))
+				{
+					++begin;
+				}
+				while (end > begin && (text[end - 1] == ' ' || text[end - 1] == '\t'))
+				{
+					--end;
+				}
+				if (begin == end)
+				{
+					throw EnvBadGet("empty list element for enviroment " + env_name);
+				}
+				element(begin, text.substr(begin, end - begin));
+				if (separator == text.size())
+				{
+					return;
+				}
+				first = separator + 1;
+			}
+		};
+		detail::DispatchType(list.element, [&](auto tag) {
+			using ValueType = typename decltype(tag)::type;
+			if constexpr (std::is_same_v<ValueType, bool>)
+			{
+				throw EnvException("unsupported list element type for enviroment " + env_name);
+			}
+			else if constexpr (std::is_same_v<ValueType, std::string>)
+			{
+				std::vector<detail::EnvTextRef> refs;
+				split([&refs](std::size_t offset, std::string_view element) {
+					refs.push_back(detail::EnvTextRef{ static_cast<std::uint32_t>(offset), static_cast<std::uint32_t>(element.size()) });
+				});
+				if (list.sorted)
+				{
+					auto view = [text](const detail::EnvTextRef& ref) {
+						return text.substr(ref.offset, ref.length);
+					};
+					std::sort(refs.begin(), refs.end(), [&view](const detail::EnvTextRef& left, const detail::EnvTextRef& right) {
+						return view(left) < view(right);
+					});
+					refs.erase(std::unique(refs.begin(), refs.end(), [&view](const detail::EnvTextRef& left, const detail::EnvTextRef& right) {
+						return view(left) == view(right);
+					}), refs.end());
+				}
+				list.values = std::move(refs);
+			}
+			else
+			{
+				std::vector<ValueType> values;
+				split([&values, &env_name](std::size_t, std::string_view element) {
+					EnvResult<ValueType> result = ParseValue<ValueType>(element);
+					if (!result)
+					{
+						std::rethrow_exception(MakeParseError<ValueType>(result.error(), element, env_name));
+					}
+					values.push_back(result.value());
+				});
+				if (list.sorted)
+				{
+					std::sort(values.begin(), values.end(), detail::ListLess<ValueType>);
+					values.erase(std::unique(values.begin(), values.end(), [](const ValueType& left, const ValueType& right) {
+						return !detail::ListLess(left, right) && !detail::ListLess(right, left);
+					}), values.end());
+				}
+				list.values = std::move(values);
+			}
+		});
+	}
+
+	CPPLIBENV_INLINE bool EnvCfg::HasValue(std::string_view env_name) const noexcept
+	{
+		const EnvSlot* slot = FindSlot(env_name);
+		return slot && SlotCell(*slot).has_value;
+	}
+
+	CPPLIBENV_INLINE const EnvCfg::EnvSlot* EnvCfg::FindSlot(std::string_view env_name) const noexcept
+	{
+		const std::size_t slot = FindSlotIndex(env_name, HashKey(env_name));
+		if (slot == npos_slot)
+		{
+			return nullptr;
+		}
+		CountRead(slot);
+		return &m_slots[slot];
+	}
+
+	CPPLIBENV_INLINE const std::vector<std::uint32_t>& EnvCfg::KeyOrder() const
+	{
+		return m_key_order.Get([this](std::vector<std::uint32_t>& order) {
+			order.resize(m_slots.size());
+			for (std::size_t i = 0; i < order.size(); ++i)
+			{
+				order[i] = static_cast<std::uint32_t>(i);
+			}
+			std::sort(order.begin(), order.end(), [this](std::uint32_t lhs, std::uint32_t rhs) {
+				return ArenaView(m_slots[lhs].key) < ArenaView(m_slots[rhs].key);
+			});
+		});
+	}
+
+	CPPLIBENV_INLINE EnvCfg::EnvCfgView EnvCfg::Scope(std::string_view prefix) const
+	{
+		const std::vector<std::uint32_t>& order = KeyOrder();
+		return ScopeRange(order.data(), order.data() + order.size(), 0, prefix);
+	}
+
+	CPPLIBENV_INLINE EnvCfg::EnvCfgView EnvCfg::ScopeRange(const std::uint32_t* first, const std::uint32_t* last, std::size_t offset, std::string_view prefix) const noexcept
+	{
+		// Keys continuing with `prefix` follow each other in the order, starting at the first one not less than it.
+		first = std::lower_bound(first, last, prefix, [this, offset](std::uint32_t slot, std::string_view value) {
+			return ArenaView(m_slots[slot].key).substr(offset) < value;
+		});
+		last = std::partition_point(first, last, [this, offset, prefix](std::uint32_t slot) {
+			return ArenaView(m_slots[slot].key).substr(offset, prefix.size()) == prefix;
+		});
+		return EnvCfgView(this, first, last, offset + prefix.size());
+	}
+
+	CPPLIBENV_INLINE const EnvCfg::EnvSlot* EnvCfg::FindScoped(const std::uint32_t* first, const std::uint32_t* last, std::size_t offset, std::string_view name) const noexcept
+	{
+		const std::uint32_t* it = std::lower_bound(first, last, name, [this, offset](std::uint32_t slot, std::string_view value) {
+			return ArenaView(m_slots[slot].key).substr(offset) < value;
+		});
+		if (it == last || ArenaView(m_slots[*it].key).substr(offset) != name)
+		{
+			return nullptr;
+		}
+		CountRead(*it);
+		return &m_slots[*it];
+	}
+
+	CPPLIBENV_INLINE const EnvCfg::EnvSlot* EnvCfg::EnvCfgView::Find(std::string_view name) const noexcept
+	{
+		return m_cfg ? m_cfg->FindScoped(m_first, m_last, m_prefix, name) : nullptr;
+	}
+
+	CPPLIBENV_INLINE std::string EnvCfg::EnvCfgView::KeyName(std::string_view name) const
+	{
+		if (empty())
+		{
+			return std::string(name);
+		}
+		return std::string(m_cfg->ArenaView(m_cfg->m_slots[*m_first].key).substr(0, m_prefix)).append(name);
+	}
+
+	CPPLIBENV_INLINE std::string_view EnvCfg::EnvCfgView::GetView(std::string_view name) const
+	{
+		const EnvSlot* slot = Find(name);
+		if (!slot)
+		{
+			throw EnvBadGet(KeyName(name) + " not found ");
+		}
+		return m_cfg->SlotView(slot, name);
+	}
+
+	CPPLIBENV_INLINE std::optional<std::string_view> EnvCfg::EnvCfgView::GetViewN(std::string_view name) const noexcept
+	{
+		const EnvSlot* slot = Find(name);
+		if (!slot || !CellHolds<std::string>(m_cfg->SlotCell(*slot)))
+		{
+			return std::nullopt;
+		}
+		return m_cfg->CellString(*slot, m_cfg->SlotCell(*slot));
+	}
+
+	CPPLIBENV_INLINE bool EnvCfg::EnvCfgView::HasValue(std::string_view name) const noexcept
+	{
+		const EnvSlot* slot = Find(name);
+		return slot && m_cfg->SlotCell(*slot).has_value;
+	}
+
+	CPPLIBENV_INLINE EnvCfg::EnvCfgView EnvCfg::EnvCfgView::Scope(std::string_view prefix) const noexcept
+	{
+		if (!m_cfg)
+		{
+			return EnvCfgView();
+		}
+		return m_cfg->ScopeRange(m_first, m_last, m_prefix, prefix);
+	}
+#endif
+
+	template <class F>
+	inline EnvCfg::EnvCell EnvCfg::MakeCell(EnvCfgTypes type, EnvValueMember& value, F&& store_string)
+	{
+		static_assert(sizeof(EnvCell) <= 16, "EnvCell is expected to fit into 16 bytes");
+		EnvCell cell{};
+		cell.type = type;
+		cell.has_value = value.has_value();
+		if (value)
+		{
+			std::visit([&cell, &store_string](auto& v) {
+				using ValueType = std::decay_t<decltype(v)>;
+				if constexpr (std::is_same_v<ValueType, std::string>)
+				{
+					cell.string_value = store_string(v);
+				}
+				else
+				{
+					using Traits = detail::EnvTypeTraits<ValueType>;
+					CellStorage<typename Traits::storage>(cell) = Traits::Store(v);
+				}
+			}, value.value());
+		}
+		return cell;
+	}
+
+#if CPPLIBENV_DEFINITIONS
+	CPPLIBENV_INLINE std::size_t EnvCfg::StoreValue(const std::string& env_name, EnvResolved resolved, const EnvValue& default_value)
+	{
+		const EnvCell cell = MakeCell(resolved.type, resolved.value, [this](const std::string& v) {
+			return ArenaAppend(v);
+		});
+		const std::size_t slot = PlaceCell(env_name, cell, EnvSlotOrigin{ resolved.raw_hash, MakeFallback(default_value) });
+		if (slot < m_lazy.size())
+		{
+			m_lazy[slot].reset();
+		}
+		if (resolved.list)
+		{
+			m_lists.resize(std::max(m_lists.size(), slot + 1));
+			m_lists[slot] = std::move(resolved.list);
+		}
+		else if (slot < m_lists.size())
+		{
+			m_lists[slot].reset();
+		}
+		return slot;
+	}
+
+	CPPLIBENV_INLINE void EnvCfg::StoreLazy(const std::string& env_name, const EnvValue& default_value)
+	{
+		// Lists are split right away, their views must not change while they are read.
+		if (std::holds_alternative<EnvList>(default_value.data.value()))
+		{
+			ProcessEntry(env_name, default_value);
+			return;
+		}
+		EnvCell cell{};
+		cell.type = DeclaredType(default_value);
+		cell.lazy = true;
+		auto lazy = std::make_unique<EnvLazySlot>(default_value);
+		m_lazy.resize(std::max(m_lazy.size(), m_slots.size() + 1));
+		const std::size_t slot = PlaceCell(env_name, cell, EnvSlotOrigin{ 0, MakeFallback(default_value) });
+		m_lazy[slot] = std::move(lazy);
+		if (slot < m_lists.size())
+		{
+			m_lists[slot].reset();
+		}
+	}
+
+	CPPLIBENV_INLINE EnvCfg::EnvCell EnvCfg::MakeFallback(const EnvValue& default_value)
+	{
+		EnvValueMember value;
+		std::visit([&value](const auto& val) {
+			using ValueType = std::decay_t<decltype(val)>;
+			if constexpr (std::is_same_v<ValueType, EnvList>)
+			{
+				if (!val.fallback.empty())
+				{
+					value = val.fallback;
+				}
+			}
+			else if constexpr (!std::is_same_v<ValueType, EnvCfgTypes>)
+			{
+				value = val;
+			}
+		}, default_value.data.value());
+		return MakeCell(DeclaredType(default_value), value, [this](const std::string& v) {
+			return ArenaAppend(v);
+		});
+	}
+
+	CPPLIBENV_INLINE std::size_t EnvCfg::PlaceCell(const std::string& env_name, const EnvCell& cell, const EnvSlotOrigin& origin)
+	{
+		const std::size_t hash = HashKey(env_name);
+		const std::size_t slot = FindSlotIndex(env_name, hash);
+		if (slot != npos_slot)
+		{
+			EnvCell& old = m_slots[slot].cell;
+			EnvCell& old_fallback = m_origins[slot].fallback;
+			for (const EnvCell* replaced : { &old, &old_fallback })
+			{
+				if (InArena(*replaced))
+				{
+					m_arena_garbage += replaced->string_value.length;
+				}
+			}
+			old = cell;
+			m_origins[slot] = origin;
+			return slot;
+		}
+		if ((m_slots.size() + 1) * 2 > m_env_result.size())
+		{
+			GrowIndex();
+		}
+		m_slots.push_back(EnvSlot{ ArenaAppend(env_name), cell });
+		m_origins.push_back(origin);
+		m_key_order.Invalidate();
+		InsertIndex(hash, m_slots.size() - 1);
+		return m_slots.size() - 1;
+	}
+
+	CPPLIBENV_INLINE EnvCfgTypes EnvCfg::DeclaredType(const EnvValue& value)
+	{
+		return std::visit([](const auto& val) {
+			using ValueType = std::decay_t<decltype(val)>;
+			if constexpr (std::is_same_v<ValueType, EnvCfgTypes>)
+			{
+				if (static_cast<std::size_t>(val) >= detail::type_count)
+				{
+					throw EnvException("unknown enum type");
+				}
+				return val;
+			}
+			else if constexpr (std::is_same_v<ValueType, EnvList>)
+			{
+				return EnvCfgTypes::list_;
+			}
+			else
+			{
+				return detail::TypeTag<ValueType>();
+			}
+		}, value.data.value());
+	}
+
+	CPPLIBENV_INLINE const EnvCfg::EnvCell& EnvCfg::SlotCell(const EnvSlot& slot) const noexcept
+	{
+		if (!slot.cell.lazy)
+		{
+			return slot.cell;
+		}
+		EnvLazySlot& lazy = *m_lazy[static_cast<std::size_t>(&slot - m_slots.data())];
+		std::call_once(lazy.once, [this, &slot, &lazy] {
+			ResolveLazy(slot, lazy);
+		});
+		return lazy.cell;
+	}
+
+	CPPLIBENV_INLINE void EnvCfg::ResolveLazy(const EnvSlot& slot, EnvLazySlot& lazy) const noexcept
+	{
+		try
+		{
+			EnvResolved resolved = ResolveEntry(std::string(ArenaView(slot.key)), lazy.default_value);
+			lazy.raw_hash = resolved.raw_hash;
+			lazy.resolved = true;
+			lazy.cell = MakeCell(resolved.type, resolved.value, [&lazy](std::string& v) {
+				if (v.size() > std::numeric_limits<std::uint32_t>::max())
+				{
+					throw EnvException("environment value exceeds 4 GiB");
+				}
+				lazy.text = std::move(v);
+				return EnvArenaRef{ 0, static_cast<std::uint32_t>(lazy.text.size()) };
+			});
+		}
+		catch (...)
+		{
+			lazy.error = std::current_exception();
+			lazy.cell = EnvCell{};
+			lazy.cell.type = slot.cell.type;
+			// The rejected raw value is recorded as well, so that Refresh() notices when it is fixed.
+			try
+			{
+				lazy.raw_hash = WithEnvView(std::string(ArenaView(slot.key)), [](std::string_view raw) noexcept {
+					return detail::RawHash(raw);
+				});
+				lazy.resolved = true;
+			}
+			catch (...)
+			{
+			}
+		}
+	}
+
+	CPPLIBENV_INLINE void EnvCfg::ThrowLazyError(const EnvSlot& slot) const
+	{
+		if (slot.cell.lazy)
+		{
+			const EnvLazySlot& lazy = *m_lazy[static_cast<std::size_t>(&slot - m_slots.data())];
+			if (lazy.error)
+			{
+				std::rethrow_exception(lazy.error);
+			}
+		}
+	}
+#endif
+
+	template <typename T>
+	inline std::optional<T> EnvCfg::EnvValueRef::GetN() const noexcept
+	{
+		if constexpr (std::is_same_v<T, std::string_view>)
+		{
+			if (!CellHolds<std::string>(*m_cell))
+			{
+				return std::nullopt;
+			}
+			return m_cfg->CellString(*m_slot, *m_cell);
+		}
+		else
+		{
+			if (!CellHolds<T>(*m_cell))
+			{
+				return std::nullopt;
+			}
+			return m_cfg->CellValue<T>(*m_slot, *m_cell);
+		}
+	}
+
+	template <class F>
+	inline decltype(auto) EnvCfg::EnvValueRef::Visit(F&& f) const
+	{
+		if (!m_cell->has_value)
+		{
+			return f(std::nullopt);
+		}
+		if (m_cell->type == EnvCfgTypes::list_)
+		{
+			return f(m_cfg->CellString(*m_slot, *m_cell));
+		}
+		return detail::DispatchType(m_cell->type, [this, &f](auto type) -> decltype(auto) {
+			using ValueType = typename decltype(type)::type;
+			if constexpr (std::is_same_v<ValueType, std::string>)
+			{
+				return f(m_cfg->CellString(*m_slot, *m_cell));
+			}
+			else
+			{
+				return f(m_cfg->CellValue<ValueType>(*m_slot, *m_cell));
+			}
+		});
+	}
+
+#if CPPLIBENV_DEFINITIONS
+	CPPLIBENV_INLINE void EnvBlock::SetAll(const EnvCfg& cfg)
+	{
+		for (const auto& entry : cfg.Entries())
+		{
+			CheckName(entry.key);
+		}
+		char buffer[64];
+		for (const auto& entry : cfg.Entries())
+		{
+			if (!entry.value.has_value())
+			{
+				continue;
+			}
+			entry.value.Visit([&](auto value) {
+				if constexpr (std::is_same_v<decltype(value), std::string_view>)
+				{
+					Replace(entry.key, value);
+				}
+				else
+				{
+					const std::to_chars_result result = entry.value.ToChars(buffer, buffer + sizeof(buffer));
+					Replace(entry.key, std::string_view(buffer, static_cast<std::size_t>(result.ptr - buffer)));
+				}
+			});
+		}
+	}
+
+	CPPLIBENV_INLINE std::to_chars_result EnvCfg::EnvValueRef::ToChars(char* first, char* last) const noexcept
+	{
+		auto copy = [first, last](std::string_view text) noexcept {
+			if (static_cast<std::size_t>(last - first) < text.size())
+			{
+				return std::to_chars_result{ last, std::errc::value_too_large };
+			}
+			std::memcpy(first, text.data(), text.size());
+			return std::to_chars_result{ first + text.size(), std::errc() };
+		};
+		return Visit([&](auto value) noexcept {
+			using ValueType = decltype(value);
+			if constexpr (std::is_same_v<ValueType, std::nullopt_t>)
+			{
+				return copy("nullopt");
+			}
+			else if constexpr (std::is_same_v<ValueType, bool>)
+			{
+				return copy(value ? "true" : "false");
+			}
+			else if constexpr (std::is_same_v<ValueType, std::string_view>)
+			{
+				return copy(value);
+			}
+			else if constexpr (std::is_same_v<ValueType, std::chrono::nanoseconds>)
+			{
+				return detail::DurationToChars(first, last, value.count());
+			}
+			else if constexpr (std::is_same_v<ValueType, EnvBytes>)
+			{
+				return detail::BytesToChars(first, last, value.count());
+			}
+			else
+			{
+				return std::to_chars(first, last, value);
+			}
+		});
+	}
+
+	CPPLIBENV_INLINE EnvCfg::EnvValueMember EnvCfg::ParseMember(EnvCfgTypes type, std::string_view raw, const std::string& env_name)
+	{
+		return detail::DispatchType(type, [&](auto tag) -> EnvValueMember {
+			if (auto value = ParseEnv<typename decltype(tag)::type>(raw, env_name))
+			{
+				return std::move(value.value());
+			}
+			return std::nullopt;
+		});
+	}
+
+	CPPLIBENV_INLINE std::vector<std::size_t> EnvCfg::RevalidateSlots(const EnvSource* source)
+	{
+		// All changed values are parsed before the first slot is touched, so a parsing error leaves the
+		// configuration as it was.
+		struct Change
+		{
+			std::size_t slot;
+			std::uint64_t raw_hash;
+			EnvValueMember value;
+			std::unique_ptr<EnvListData> list;
+		};
+		std::vector<Change> changes;
+		// Without the overlay, a file or the snapshot mode every lookup is a getenv (a linear scan of environ),
+		// so for more than a few keys environ is indexed once instead.
+		std::unique_ptr<EnvSnapshot> environment;
+		if (!source && m_slots.size() > 16 && !Snapshot() && !Overlay().load(std::memory_order_acquire) && !Source().load(std::memory_order_acquire))
+		{
+			environment = std::make_unique<EnvSnapshot>();
+			source = environment.get();
+		}
+		std::string env_name;
+		for (std::size_t slot = 0; slot < m_slots.size(); ++slot)
+		{
+			const EnvCell& cell = m_slots[slot].cell;
+			const EnvLazySlot* lazy = cell.lazy ? m_lazy[slot].get() : nullptr;
+			if (lazy && !lazy->resolved)
+			{
+				continue;
+			}
+			const std::uint64_t recorded = lazy ? lazy->raw_hash : m_origins[slot].raw_hash;
+			env_name.assign(ArenaView(m_slots[slot].key));
+			auto check = [&](std::string_view raw) {
+				const std::uint64_t raw_hash = detail::RawHash(raw);
+				if (raw_hash == recorded)
+				{
+					return;
+				}
+				if (cell.type == EnvCfgTypes::list_)
+				{
+					const EnvListData& old = *m_lists[slot];
+					auto list = std::make_unique<EnvListData>(EnvListData{ old.element, old.separator, old.sorted, {} });
+					const EnvCell& fallback = m_origins[slot].fallback;
+					EnvValueMember value = ParseListValue(*list, raw, fallback.has_value ? ArenaView(fallback.string_value) : std::string_view(), env_name);
+					changes.push_back(Change{ slot, raw_hash, std::move(value), std::move(list) });
+					return;
+				}
+				// Lazy slots are resolved again on their next read.
+				changes.push_back(Change{ slot, raw_hash, lazy ? std::nullopt : ParseMember(cell.type, raw, env_name), nullptr });
+			};
+			if (source)
+			{
+				check(source->Find(env_name));
+			}
+			else
+			{
+				WithEnvView(env_name, check);
+			}
+		}
+
+		std::vector<std::size_t> changed;
+		changed.reserve(changes.size());
+		for (Change& change : changes)
+		{
+			changed.push_back(change.slot);
+			EnvCell& cell = m_slots[change.slot].cell;
+			if (cell.lazy)
+			{
+				m_lazy[change.slot] = std::make_unique<EnvLazySlot>(m_lazy[change.slot]->default_value);
+				continue;
+			}
+			const EnvSlotOrigin& origin = m_origins[change.slot];
+			if (InArena(cell))
+			{
+				m_arena_garbage += cell.string_value.length;
+			}
+			if (change.list)
+			{
+				m_lists[change.slot] = std::move(change.list);
+			}
+			if (!change.value && origin.fallback.has_value)
+			{
+				cell = origin.fallback;
+				if (cell.type == EnvCfgTypes::string_)
+				{
+					cell.string_value = ArenaAppend(std::string(ArenaView(origin.fallback.string_value)));
+				}
+			}
+			else
+			{
+				cell = MakeCell(cell.type, change.value, [this](const std::string& v) {
+					return ArenaAppend(v);
+				});
+			}
+			m_origins[change.slot].raw_hash = change.raw_hash;
+		}
+		return changed;
+	}
+
+	CPPLIBENV_INLINE void EnvCfg::InitSource(const std::unordered_map<std::string, EnvValue>& env_map, const EnvSource& source)
+	{
+		try
+		{
+			for (const auto& entry : env_map)
+			{
+				if (detail::IsEnvPattern(entry.first))
+				{
+					throw EnvException("pattern keys are not supported by a layered configuration: " + entry.first);
+				}
+				StoreValue(entry.first, ResolveRaw(entry.first, entry.second, source.Find(entry.first)), entry.second);
+			}
+		}
+		catch (...)
+		{
+			Compact();
+			throw;
+		}
+		Compact();
+	}
+
+	CPPLIBENV_INLINE std::vector<std::string_view> EnvCfg::Refresh()
+	{
+		WaitSource();
+		std::vector<std::size_t> changed = RevalidateSlots();
+		if (!changed.empty())
+		{
+			Compact();
+		}
+		std::vector<std::string_view> keys;
+		keys.reserve(changed.size());
+		for (std::size_t slot : changed)
+		{
+			keys.push_back(ArenaView(m_slots[slot].key));
+		}
+		return keys;
+	}
+
+	CPPLIBENV_INLINE std::vector<std::string_view> EnvCfg::Refresh(const std::unordered_map<std::string, EnvValue>& env_map, const EnvInitOptions& options)
+	{
+		WaitSource();
+		std::vector<std::size_t> changed = RevalidateSlots();
+		const std::size_t known = m_slots.size();
+		if (std::any_of(env_map.begin(), env_map.end(), [](const auto& entry) { return detail::IsEnvPattern(entry.first); }))
+		{
+			try
+			{
+				InitPatterns(env_map, options.lazy, true);
+			}
+			catch (...)
+			{
+				Compact();
+				throw;
+			}
+		}
+		if (!options.lazy)
+		{
+			for (std::size_t slot = known; slot < m_slots.size(); ++slot)
+			{
+				changed.push_back(slot);
+			}
+		}
+		if (!changed.empty() || m_slots.size() != known)
+		{
+			Compact();
+		}
+		std::vector<std::string_view> keys;
+		keys.reserve(changed.size());
+		for (std::size_t slot : changed)
+		{
+			keys.push_back(ArenaView(m_slots[slot].key));
+		}
+		return keys;
+	}
+
+	CPPLIBENV_INLINE void EnvCfg::SaveSnapshot(const std::string& path) const
+	{
+		// Keys first, like Compact() lays out m_arena, then the string values and defaults.
+		std::string arena;
+		auto append = [&arena](std::string_view text) {
+			if (text.size() > std::numeric_limits<std::uint32_t>::max() - arena.size())
+			{
+				throw EnvException("environment storage exceeds 4 GiB");
+			}
+			const std::uint64_t ref = arena.size() | (static_cast<std::uint64_t>(text.size()) << 32);
+			arena.append(text.data(), text.size());
+			return ref;
+		};
+		auto encode = [&append](const EnvCell& cell, std::string_view text) -> std::uint64_t {
+			if (!cell.has_value)
+			{
+				return 0;
+			}
+			if (cell.type == EnvCfgTypes::list_)
+			{
+				return append(text);
+			}
+			return detail::DispatchType(cell.type, [&](auto type) -> std::uint64_t {
+				using ValueType = typename decltype(type)::type;
+				if constexpr (std::is_same_v<ValueType, std::string>)
+				{
+					return append(text);
+				}
+				else
+				{
+					return detail::StorageWord(CellStorage<typename detail::EnvTypeTraits<ValueType>::storage>(cell));
+				}
+			});
+		};
+		std::vector<std::uint64_t> keys;
+		keys.reserve(m_slots.size());
+		for (const EnvSlot& slot : m_slots)
+		{
+			keys.push_back(append(ArenaView(slot.key)));
+		}
+
+		std::string payload;
+		payload.reserve(m_slots.size() * detail::snapshot_slot_size + m_env_result.size() * detail::snapshot_bucket_size + arena.size());
+		for (std::size_t i = 0; i < m_slots.size(); ++i)
+		{
+			const EnvSlot& slot = m_slots[i];
+			const EnvCell& cell = SlotCell(slot);
+			ThrowLazyError(slot);
+			const EnvSlotOrigin& origin = m_origins[i];
+			const unsigned flags = (cell.has_value ? 1u : 0u) | (origin.fallback.has_value ? 2u : 0u);
+			std::uint64_t type = static_cast<std::uint64_t>(cell.type) | (flags << 8);
+			if (cell.type == EnvCfgTypes::list_)
+			{
+				// Element type, separator and the sorted flag of a list follow the flags.
+				const EnvListData& list = *m_lists[i];
+				type |= (static_cast<std::uint64_t>(list.element) << 16) | (static_cast<std::uint64_t>(static_cast<unsigned char>(list.separator)) << 24)
+					| (static_cast<std::uint64_t>(list.sorted) << 32);
+			}
+			detail::StoreLE(payload, keys[i], 8);
+			detail::StoreLE(payload, type, 8);
+			detail::StoreLE(payload, encode(cell, cell.has_value ? CellString(slot, cell) : std::string_view()), 8);
+			detail::StoreLE(payload, encode(origin.fallback, origin.fallback.has_value ? ArenaView(origin.fallback.string_value) : std::string_view()), 8);
+			detail::StoreLE(payload, slot.cell.lazy ? m_lazy[i]->raw_hash : origin.raw_hash, 8);
+		}
+		for (const EnvIndexEntry& entry : m_env_result)
+		{
+			detail::StoreLE(payload, entry.hash, 8);
+			detail::StoreLE(payload, entry.slot == npos_slot ? ~std::uint64_t(0) : entry.slot, 8);
+		}
+		payload += arena;
+
+		std::string header(detail::snapshot_magic, sizeof(detail::snapshot_magic));
+		detail::StoreLE(header, detail::snapshot_version, 4);
+		detail::StoreLE(header, detail::snapshot_header_size, 4);
+		detail::StoreLE(header, m_slots.size(), 8);
+		detail::StoreLE(header, m_env_result.size(), 8);
+		detail::StoreLE(header, arena.size(), 8);
+		detail::StoreLE(header, HashKey(detail::snapshot_seed_key), 8);
+		detail::StoreLE(header, detail::Hash64(payload.data(), payload.size()), 8);
+		detail::StoreLE(header, 0, 8);
+
+		// Written to a unique file next to the target, flushed to disk and renamed, so a concurrent LoadSnapshot
+		// never sees a partial file and concurrent savers of the same path do not write into each other's file.
+		std::string temp = path + ".XXXXXX";
+		const int fd = mkstemp(temp.data());
+		if (fd < 0)
+		{
+			throw EnvException("can not create snapshot " + temp);
+		}
+		auto write_all = [fd](const std::string& data) {
+			for (std::size_t done = 0; done < data.size();)
+			{
+				const ssize_t count = write(fd, data.data() + done, data.size() - done);
+				if (count < 0 && errno != EINTR)
+				{
+					return false;
+				}
+				done += count > 0 ? static_cast<std::size_t>(count) : 0;
+			}
+			return true;
+		};
+		// mkstemp creates the file readable by the owner only, snapshots are shared like the files fopen creates.
+		bool written = fchmod(fd, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH) == 0 && write_all(header) && write_all(payload) && fsync(fd) == 0;
+		written = close(fd) == 0 && written;
+		if (!written || std::rename(temp.c_str(), path.c_str()) != 0)
+		{
+			std::remove(temp.c_str());
+			throw EnvException("can not write snapshot " + path);
+		}
+	}
+
+	CPPLIBENV_INLINE EnvCfg EnvCfg::LoadSnapshot(const std::string& path, bool validate)
+	{
+		const detail::MappedFile file(path, "snapshot");
+		const char* const data = file.data();
+		auto invalid = [&path](const char* reason) {
+			return EnvException("invalid snapshot " + path + ": " + reason);
+		};
+		if (file.size() < detail::snapshot_header_size || std::memcmp(data, detail::snapshot_magic, sizeof(detail::snapshot_magic)) != 0)
+		{
+			throw invalid("not a snapshot");
+		}
+		if (detail::LoadLE(data + 8, 4) != detail::snapshot_version || detail::LoadLE(data + 12, 4) != detail::snapshot_header_size)
+		{
+			throw invalid("unsupported version");
+		}
+		const std::uint64_t slot_count = detail::LoadLE(data + 16, 8);
+		const std::uint64_t index_size = detail::LoadLE(data + 24, 8);
+		const std::uint64_t arena_size = detail::LoadLE(data + 32, 8);
+		const std::uint64_t payload_size = file.size() - detail::snapshot_header_size;
+		if (slot_count > payload_size / detail::snapshot_slot_size || index_size > payload_size / detail::snapshot_bucket_size
+			|| arena_size > std::numeric_limits<std::uint32_t>::max()
+			|| slot_count * detail::snapshot_slot_size + index_size * detail::snapshot_bucket_size + arena_size != payload_size)
+		{
+			throw invalid("truncated");
+		}
+		const char* const slots = data + detail::snapshot_header_size;
+		if (detail::Hash64(slots, payload_size) != detail::LoadLE(data + 48, 8))
+		{
+			throw invalid("checksum mismatch");
+		}
+		const char* const buckets = slots + slot_count * detail::snapshot_slot_size;
+		const char* const arena = buckets + index_size * detail::snapshot_bucket_size;
+
+		EnvCfg cfg;
+		cfg.m_arena.assign(arena, arena_size);
+		auto decode_ref = [arena_size](std::uint64_t word, EnvArenaRef& ref) noexcept {
+			ref = EnvArenaRef{ static_cast<std::uint32_t>(word), static_cast<std::uint32_t>(word >> 32) };
+			return static_cast<std::uint64_t>(ref.offset) + ref.length <= arena_size;
+		};
+		auto decode = [&decode_ref](EnvCell& cell, std::uint64_t word) noexcept {
+			if (!cell.has_value)
+			{
+				return true;
+			}
+			if (cell.type == EnvCfgTypes::list_)
+			{
+				return decode_ref(word, cell.string_value);
+			}
+			return detail::DispatchType(cell.type, [&](auto type) {
+				using ValueType = typename decltype(type)::type;
+				if constexpr (std::is_same_v<ValueType, std::string>)
+				{
+					return decode_ref(word, cell.string_value);
+				}
+				else
+				{
+					return detail::WordStorage(word, CellStorage<typename detail::EnvTypeTraits<ValueType>::storage>(cell));
+				}
+			});
+		};
+		cfg.m_slots.resize(slot_count);
+		cfg.m_origins.resize(slot_count);
+		for (std::size_t i = 0; i < slot_count; ++i)
+		{
+			const char* record = slots + i * detail::snapshot_slot_size;
+			EnvSlot& slot = cfg.m_slots[i];
+			EnvSlotOrigin& origin = cfg.m_origins[i];
+			const std::uint64_t type = detail::LoadLE(record + 8, 1);
+			const std::uint64_t flags = detail::LoadLE(record + 9, 1);
+			if (!decode_ref(detail::LoadLE(record, 8), slot.key) || type > static_cast<std::uint64_t>(EnvCfgTypes::list_) || flags > 3)
+			{
+				throw invalid("malformed slot");
+			}
+			slot.cell = EnvCell{};
+			slot.cell.type = static_cast<EnvCfgTypes>(type);
+			slot.cell.has_value = (flags & 1) != 0;
+			origin.fallback = EnvCell{};
+			origin.fallback.type = slot.cell.type;
+			origin.fallback.has_value = (flags & 2) != 0;
+			origin.raw_hash = detail::LoadLE(record + 32, 8);
+			if (!decode(slot.cell, detail::LoadLE(record + 16, 8)) || !decode(origin.fallback, detail::LoadLE(record + 24, 8)))
+			{
+				throw invalid("malformed slot");
+			}
+			if (slot.cell.type == EnvCfgTypes::list_)
+			{
+				const std::uint64_t element = detail::LoadLE(record + 10, 1);
+				const std::uint64_t sorted = detail::LoadLE(record + 12, 1);
+				if (element >= detail::type_count || element == static_cast<std::uint64_t>(EnvCfgTypes::bool_) || sorted > 1)
+				{
+					throw invalid("malformed slot");
+				}
+				cfg.m_lists.resize(static_cast<std::size_t>(slot_count));
+				cfg.m_lists[i] = std::make_unique<EnvListData>(EnvListData{ static_cast<EnvCfgTypes>(element), static_cast<char>(detail::LoadLE(record + 11, 1)), sorted != 0, {} });
+				if (slot.cell.has_value)
+				{
+					try
+					{
+						ParseList(*cfg.m_lists[i], cfg.ArenaView(slot.cell.string_value), std::string(cfg.ArenaView(slot.key)));
+					}
+					catch (const EnvException&)
+					{
+						throw invalid("malformed list");
+					}
+				}
+			}
+		}
+
+		// The prebuilt buckets are taken as they are if keys hash the same way in this build, otherwise the
+		// index is built again from the keys.
+		const bool same_hash = detail::LoadLE(data + 40, 8) == static_cast<std::uint64_t>(HashKey(detail::snapshot_seed_key));
+		if (same_hash && index_size > slot_count && (index_size & (index_size - 1)) == 0)
+		{
+			cfg.m_env_result.resize(index_size);
+			std::uint64_t used = 0;
+			for (std::size_t i = 0; i < index_size; ++i)
+			{
+				const char* bucket = buckets + i * detail::snapshot_bucket_size;
+				const std::uint64_t slot = detail::LoadLE(bucket + 8, 8);
+				if (slot != ~std::uint64_t(0) && (slot >= slot_count || ++used > slot_count))
+				{
+					throw invalid("malformed index");
+				}
+				cfg.m_env_result[i] = EnvIndexEntry{ static_cast<std::size_t>(detail::LoadLE(bucket, 8)), slot < slot_count ? static_cast<std::size_t>(slot) : npos_slot };
+			}
+			if (used != slot_count)
+			{
+				throw invalid("malformed index");
+			}
+		}
+		else
+		{
+			for (std::size_t i = 0; i < slot_count; ++i)
+			{
+				if ((i + 1) * 2 > cfg.m_env_result.size())
+				{
+					cfg.GrowIndex();
+				}
+				cfg.InsertIndex(HashKey(cfg.ArenaView(cfg.m_slots[i].key)), i);
+			}
+		}
+
+		if (validate && !cfg.RevalidateSlots().empty())
+		{
+			cfg.Compact();
+		}
+#if defined(CPPLIBENV_INSTRUMENT)
+		cfg.m_reads.Resize(cfg.m_slots.size());
+#endif
+		return cfg;
+	}
+
+	CPPLIBENV_INLINE EnvCfg::EnvCfg(const EnvCfg& other) : m_slots(other.m_slots), m_env_result(other.m_env_result), m_arena(other.m_arena), m_arena_garbage(other.m_arena_garbage), m_origins(other.m_origins)
+	{
+		m_lazy.resize(other.m_lazy.size());
+		for (std::size_t slot = 0; slot < other.m_lazy.size(); ++slot)
+		{
+			if (other.m_lazy[slot])
+			{
+				m_lazy[slot] = std::make_unique<EnvLazySlot>(other.m_lazy[slot]->default_value);
+			}
+		}
+		m_lists.resize(other.m_lists.size());
+		for (std::size_t slot = 0; slot < other.m_lists.size(); ++slot)
+		{
+			if (other.m_lists[slot])
+			{
+				m_lists[slot] = std::make_unique<EnvListData>(*other.m_lists[slot]);
+			}
+		}
+#if defined(CPPLIBENV_INSTRUMENT)
+		m_reads.Resize(m_slots.size());
+#endif
+	}
+#endif
+
+#if defined(CPPLIBENV_INSTRUMENT)
+#if CPPLIBENV_DEFINITIONS
+	CPPLIBENV_INLINE std::vector<std::pair<std::string, std::uint64_t>> EnvCfg::ReadCounts() const
+	{
+		std::vector<std::pair<std::string, std::uint64_t>> counts;
+		counts.reserve(m_slots.size());
+		for (std::size_t slot = 0; slot < m_slots.size(); ++slot)
+		{
+			counts.emplace_back(std::string(ArenaView(m_slots[slot].key)), m_reads.Total(slot));
+		}
+		return counts;
+	}
+
+	CPPLIBENV_INLINE void EnvCfg::ResetReadCounts() noexcept
+	{
+		m_reads.Reset();
+	}
+
+	CPPLIBENV_INLINE EnvLatencyHistogram EnvCfg::ParseLatency(EnvCfgTypes type) noexcept
+	{
+		return detail::EnvLatencyStats::Instance().Histogram(static_cast<std::size_t>(type));
+	}
+
+	CPPLIBENV_INLINE EnvLatencyHistogram EnvCfg::InitLatency() noexcept
+	{
+		return detail::EnvLatencyStats::Instance().Histogram(detail::stat_init_kind);
+	}
+
+	CPPLIBENV_INLINE void EnvCfg::ResetLatency() noexcept
+	{
+		detail::EnvLatencyStats::Instance().Reset();
+	}
+#endif
+#endif
+
+#if CPPLIBENV_DEFINITIONS
+	CPPLIBENV_INLINE EnvCfg& EnvCfg::operator=(const EnvCfg& other)
+	{
+		if (this != &other)
+		{
+			EnvCfg copy(other);
+			*this = std::move(copy);
+		}
+		return *this;
+	}
+
+	CPPLIBENV_INLINE std::string_view EnvCfg::CellString(const EnvSlot& slot, const EnvCell& cell) const noexcept
+	{
+		if (slot.cell.lazy)
+		{
+			return m_lazy[static_cast<std::size_t>(&slot - m_slots.data())]->text;
+		}
+		return ArenaView(cell.string_value);
+	}
+
+	CPPLIBENV_INLINE EnvCfg::EnvArenaRef EnvCfg::ArenaAppend(std::string_view value)
+	{
+		if (value.size() > std::numeric_limits<std::uint32_t>::max() - m_arena.size())
+		{
+			throw EnvException("environment storage exceeds 4 GiB");
+		}
+		const EnvArenaRef ref{ static_cast<std::uint32_t>(m_arena.size()), static_cast<std::uint32_t>(value.size()) };
+		m_arena.append(value.data(), value.size());
+		return ref;
+	}
+
+	CPPLIBENV_INLINE void EnvCfg::Compact()
 	{
-		auto it = m_env_result.find(env_name);
-		if (it == m_env_result.end())
+#if defined(CPPLIBENV_INSTRUMENT)
+		m_reads.Resize(m_slots.size());
+#endif
+		if (m_arena_garbage == 0 && m_arena.capacity() == m_arena.size() && m_slots.capacity() == m_slots.size())
 		{
-			throw EnvBadGet(env_name + " not found ");
+			return;
 		}
-		if (!it->second)
+		// Keys first, so that the lookup path touches as few cache lines as possible, then string values.
+		// Equal string values (and defaults) are interned: they share one copy in the new arena, so
+		// m_arena_garbage may count a shared copy more than once.
+		std::string arena;
+		arena.reserve(m_arena.size() - std::min(m_arena_garbage, m_arena.size()));
+		auto move_ref = [this, &arena](EnvArenaRef& ref) {
+			const std::uint32_t offset = static_cast<std::uint32_t>(arena.size());
+			arena.append(m_arena, ref.offset, ref.length);
+			ref.offset = offset;
+		};
+		for (EnvSlot& slot : m_slots)
 		{
-			throw EnvBadGet("no value for " + env_name);
+			move_ref(slot.key);
 		}
-		try
+		// Open addressing set of the strings moved so far, by their location in the new arena.
+		struct Interned
+		{
+			std::size_t hash;
+			EnvArenaRef ref;
+		};
+		constexpr std::uint32_t empty = std::numeric_limits<std::uint32_t>::max();
+		std::size_t strings = 0;
+		for (std::size_t slot = 0; slot < m_slots.size(); ++slot)
 		{
-			return std::get<T>(it->second.value());
+			const EnvCell* cells[] = { &m_slots[slot].cell, &m_origins[slot].fallback };
+			for (const EnvCell* cell : cells)
+			{
+				strings += InArena(*cell);
+			}
 		}
-		catch (const std::bad_variant_access&)
+		std::size_t buckets = 16;
+		while (buckets < strings * 2)
 		{
-			throw EnvBadGet("invalid type for " + env_name);
+			buckets *= 2;
 		}
-	}
-
-	template <typename T, typename>
-	inline std::optional<T> EnvCfg::GetN(const std::string& env_name) const noexcept
-	{
-		auto it = m_env_result.find(env_name);
-		if (it == m_env_result.end() || !it->second)
+		std::vector<Interned> interned(strings ? buckets : 0, Interned{ 0, EnvArenaRef{ empty, 0 } });
+		auto intern_ref = [this, &arena, &move_ref, &interned](EnvArenaRef& ref) {
+			const std::string_view value = ArenaView(ref);
+			const std::size_t hash = HashKey(value);
+			const std::size_t mask = interned.size() - 1;
+			std::size_t pos = hash & mask;
+			for (; interned[pos].ref.offset != empty; pos = (pos + 1) & mask)
+			{
+				const Interned& entry = interned[pos];
+				if (entry.hash == hash && std::string_view(arena.data() + entry.ref.offset, entry.ref.length) == value)
+				{
+					ref.offset = entry.ref.offset;
+					return;
+				}
+			}
+			move_ref(ref);
+			interned[pos] = Interned{ hash, ref };
+		};
+		for (EnvSlot& slot : m_slots)
 		{
-			return std::nullopt;
+			if (InArena(slot.cell))
+			{
+				intern_ref(slot.cell.string_value);
+			}
 		}
-		if (auto* t_ptr = std::get_if<T>(&it->second.value()))
+		for (EnvSlotOrigin& origin : m_origins)
 		{
-			return *t_ptr;
+			if (InArena(origin.fallback))
+			{
+				intern_ref(origin.fallback.string_value);
+			}
 		}
-		return std::nullopt;
+		m_arena.swap(arena);
+		m_arena_garbage = 0;
+		m_slots.shrink_to_fit();
+		m_origins.shrink_to_fit();
 	}
 
-	template <typename T, typename>
-	inline bool EnvCfg::IsType(const std::string& env_name) const noexcept
+	CPPLIBENV_INLINE std::size_t EnvCfg::HashKey(std::string_view env_name) noexcept
+	{
+		return std::hash<std::string_view>{}(env_name);
+	}
+
+	CPPLIBENV_INLINE std::size_t EnvCfg::FindSlotIndex(std::string_view env_name, std::size_t hash) const noexcept
 	{
-		auto it = m_env_result.find(env_name);
-		if (it == m_env_result.end() || !it->second)
+		if (m_env_result.empty())
 		{
-			return false;
+			return npos_slot;
 		}
-		if (auto* t_ptr = std::get_if<T>(&it->second.value()))
+		const std::size_t mask = m_env_result.size() - 1;
+		for (std::size_t pos = hash & mask; ; pos = (pos + 1) & mask)
 		{
-			return true;
+			const EnvIndexEntry& entry = m_env_result[pos];
+			if (entry.slot == npos_slot)
+			{
+				return npos_slot;
+			}
+			if (entry.hash == hash && ArenaView(m_slots[entry.slot].key) == env_name)
+			{
+				return entry.slot;
+			}
 		}
-		return false;
 	}
 
-	template<class T>
-	inline std::optional<T> EnvCfg::GetEnvByType(const std::string& env_name)
+	CPPLIBENV_INLINE void EnvCfg::InsertIndex(std::size_t hash, std::size_t slot) noexcept
 	{
-		std::string result = GetEnv(env_name);
-		if (result.empty())
-		{
-			return std::nullopt;
-		}
-		else if constexpr (std::is_same_v<T, std::string>)
+		const std::size_t mask = m_env_result.size() - 1;
+		std::size_t pos = hash & mask;
+		while (m_env_result[pos].slot != npos_slot)
 		{
-			return result;
+			pos = (pos + 1) & mask;
 		}
-		else if constexpr (std::is_same_v<T, const char*>)
+		m_env_result[pos] = EnvIndexEntry{ hash, slot };
+	}
+
+	CPPLIBENV_INLINE void EnvCfg::GrowIndex()
+	{
+		std::vector<EnvIndexEntry> old(std::max<std::size_t>(16, m_env_result.size() * 2), EnvIndexEntry{ 0, npos_slot });
+		old.swap(m_env_result);
+		for (const EnvIndexEntry& entry : old)
 		{
-			return result.c_str();
+			if (entry.slot != npos_slot)
+			{
+				InsertIndex(entry.hash, entry.slot);
+			}
 		}
-		else if constexpr (std::is_same_v<T, int>)
+	}
+#endif
+
+	/**
+	* @brief How the name of an `EnvCfgHolder` subscription is matched against the changed keys.
+	*/
+	enum class EnvMatch
+	{
+		key_,
+		prefix_
+	};
+
+	/**
+	* @brief Changed key delivered to an `EnvCfgHolder` subscriber, `value` is the value after the reload
+	*        (`std::nullopt` if the key has no value or holds another type).
+	*/
+	template <typename T>
+	struct EnvChange
+	{
+		std::string key;
+		std::optional<T> value;
+	};
+
+	/**
+	* @brief Reloadable holder of an `EnvCfg` with lock-free concurrent readers.
+	*
+	* Readers obtain the current immutable configuration with `Read()`; the read path takes no locks and
+	* touches no shared counters, it only publishes an epoch in a cache line owned by the reading thread.
+	* `Reload()` builds a fresh `EnvCfg` off to the side from the stored `EnvMap`, publishes it with an atomic
+	* pointer swap and destroys the previous configuration once no reader can reference it anymore.
+	*
+	* @code
+	* env_cfg::EnvCfgHolder holder(config);
+	* // reader threads
+	* int port = holder.Read()->Get<int>("PORT");
+	* // reload thread
+	* holder.Reload();
+	* @endcode
+	*/
+	class EnvCfgHolder
+	{
+	public:
+		/**
+		* @brief Read section holding the configuration which was current when it was created.
+		*
+		* The configuration stays alive until the guard is destroyed. Guards must not outlive the holder
+		* and should be short lived, since a replaced configuration is only freed once its guards are gone.
+		*/
+		class ReadGuard
 		{
-			if (result.find(".") != std::string::npos)
+		public:
+			ReadGuard(const ReadGuard&) = delete;
+			ReadGuard& operator=(const ReadGuard&) = delete;
+			ReadGuard(ReadGuard&& other) noexcept : m_record(other.m_record), m_cfg(other.m_cfg)
 			{
-				throw EnvBadGet("expected int, but it's dooble " + result + " for enviroment " + env_name);
+				other.m_record = nullptr;
 			}
-			try
+			ReadGuard& operator=(ReadGuard&&) = delete;
+			~ReadGuard()
 			{
-				T result_int = std::stoi(result);
-				return result_int;
+				if (m_record)
+				{
+					detail::EpochDomain::Instance().Leave(*m_record);
+				}
 			}
-			catch (const std::invalid_argument&)
+
+			inline const EnvCfg& operator*() const noexcept
 			{
-				throw EnvBadGet("expected int " + result + " for enviroment " + env_name);
+				return *m_cfg;
 			}
-			catch (const std::out_of_range&)
+
+			inline const EnvCfg* operator->() const noexcept
 			{
-				throw EnvBadGet("int overflow " + result + " for enviroment " + env_name);
+				return m_cfg;
 			}
-			catch (const std::exception& err)
+		private:
+			friend class EnvCfgHolder;
+			ReadGuard(detail::EpochDomain::Record& record, const std::atomic<const EnvCfg*>& current) noexcept : m_record(&record)
 			{
-				throw EnvException("catch unhandled exception " + static_cast<std::string>(err.what()) + " for enviroment " + env_name);
+				detail::EpochDomain::Instance().Enter(record);
+				m_cfg = current.load(std::memory_order_seq_cst);
 			}
-		}
-		else if constexpr (std::is_same_v<T, double>)
+			detail::EpochDomain::Record* m_record;
+			const EnvCfg* m_cfg;
+		};
+
+		/**
+		* @brief Creates the holder and initializes the first configuration from `env_map`.
+		*
+		* @note This method throw EnvException exception on errors, see `EnvCfg::InitEnv`.
+		*/
+		explicit EnvCfgHolder(EnvMap env_map, EnvInitOptions options = EnvInitOptions());
+		EnvCfgHolder(const EnvCfgHolder&) = delete;
+		EnvCfgHolder& operator=(const EnvCfgHolder&) = delete;
+		~EnvCfgHolder();
+		/**
+		* @brief Returns a read section over the current configuration (lock-free).
+		*/
+		ReadGuard Read() const;
+		/**
+		* @brief Re-initializes the configuration from the stored `EnvMap` and publishes it atomically.
+		*
+		* A copy of the current configuration is refreshed (see `EnvCfg::Refresh`), so only the changed variables
+		* are parsed, and variables newly matching a pattern key of the map are added and reported as changed
+		* (see `EnvCfg::Refresh(env_map, options)`); nothing is published if no value changed and no variable was
+		* added. Readers keep using the previous configuration until
+		* they create a new `ReadGuard`. Concurrent reloads are serialized. The subscribers of the changed keys are
+		* notified afterwards; keys initialized lazily are not reported.
+		*
+		* @note This method throw EnvException exception on errors; the current configuration is kept in that case.
+		*/
+		void Reload();
+		/**
+		* @brief Publishes an externally built configuration.
+		*
+		* Subscribers are not notified; the next `Reload()` initializes the configuration from the stored
+		* `EnvMap` again and reports all of its keys.
+		*/
+		void Publish(std::unique_ptr<EnvCfg> cfg);
+		/**
+		* @brief Registers a callback invoked once per `Reload()` with all changes of the matching keys.
+		*
+		* With `EnvMatch::key_` the subscription matches the key `name`, with `EnvMatch::prefix_` every key
+		* starting with `name`. The batch holds the changed keys matching the subscription, in slot order, with
+		* their new values read as `T`. Callbacks are handed to the executor (see `SetExecutor`) after the new
+		* configuration is published and the holder lock is released.
+		*
+		* @code
+		* holder.Subscribe<int>("POOL_", [](const std::vector<env_cfg::EnvChange<int>>& changes) {
+		*     for (const auto& change : changes) { Resize(change.key, change.value.value_or(1)); }
+		* }, env_cfg::EnvMatch::prefix_);
+		* @endcode
+		*
+		* @return Id of the subscription for `Unsubscribe`.
+		*/
+		template <typename T, typename = std::enable_if_t<detail::is_env_type_v<T>>>
+		std::size_t Subscribe(std::string name, std::function<void(const std::vector<EnvChange<T>>&)> callback, EnvMatch match = EnvMatch::key_);
+		/**
+		* @brief Removes a subscription; a batch already handed to the executor is still delivered.
+		*/
+		void Unsubscribe(std::size_t id);
+		/**
+		* @brief Sets the executor running the callbacks, e.g. one posting them to a worker thread.
+		*
+		* By default callbacks run on the thread calling `Reload()`, and an exception thrown by a callback
+		* propagates from `Reload()` (the new configuration stays published).
+		*/
+		void SetExecutor(std::function<void(std::function<void()>)> executor);
+	private:
+		struct Subscription
 		{
-			try
-			{
-				T result_double = std::stod(result);
-				return result_double;
-			}
-			catch (const std::invalid_argument&)
-			{
-				throw EnvBadGet("expected double " + result + " for enviroment " + env_name);
-			}
-			catch (const std::exception& err)
-			{
-				throw EnvException("catch unhandled exception " + static_cast<std::string>(err.what()) + " for enviroment " + env_name);
-			}
-		}
-		else if constexpr (std::is_same_v<T, long long>)
+			std::size_t id;
+			// Builds the batch of the matching keys from the published configuration, nullptr if none matches.
+			std::function<std::function<void()>(const EnvCfg&, const std::vector<std::string_view>&)> prepare;
+		};
+		EnvMap m_env_map;
+		EnvInitOptions m_options;
+		std::atomic<const EnvCfg*> m_current{ nullptr };
+		std::mutex m_write_mutex;
+		// Whether m_current was built from m_env_map and can be refreshed instead of initialized again.
+		bool m_refreshable = true;
+		std::vector<Subscription> m_subscriptions;
+		std::size_t m_next_subscription = 0;
+		std::function<void(std::function<void()>)> m_executor;
+
+		// Hands a replaced configuration to the epoch domain, it is destroyed once no guard references it.
+		static void Retire(const EnvCfg* cfg) noexcept;
+	};
+
+#if CPPLIBENV_DEFINITIONS
+	CPPLIBENV_INLINE EnvCfgHolder::EnvCfgHolder(EnvMap env_map, EnvInitOptions options) : m_env_map(std::move(env_map)), m_options(options)
+	{
+		auto cfg = std::make_unique<EnvCfg>();
+		cfg->InitEnv(m_env_map, m_options);
+		m_current.store(cfg.release(), std::memory_order_release);
+	}
+
+	CPPLIBENV_INLINE EnvCfgHolder::~EnvCfgHolder()
+	{
+		delete m_current.load(std::memory_order_acquire);
+	}
+
+	CPPLIBENV_INLINE EnvCfgHolder::ReadGuard EnvCfgHolder::Read() const
+	{
+		return ReadGuard(detail::EpochDomain::Instance().ThreadRecord(), m_current);
+	}
+
+	CPPLIBENV_INLINE void EnvCfgHolder::Reload()
+	{
+		std::vector<std::function<void()>> batches;
+		std::function<void(std::function<void()>)> executor;
+		const EnvCfg* old = nullptr;
 		{
-			try
-			{
-				T result_longlong = std::stoll(result);
-				return result_longlong;
-			}
-			catch (const std::invalid_argument&)
+			std::lock_guard<std::mutex> lock(m_write_mutex);
+			std::unique_ptr<EnvCfg> cfg;
+			std::vector<std::string_view> changed;
+			if (m_refreshable)
 			{
-				throw EnvBadGet("expected long long " + result + " for enviroment " + env_name);
+				const EnvCfg& current = *m_current.load(std::memory_order_acquire);
+				cfg = std::make_unique<EnvCfg>(current);
+				changed = cfg->Refresh(m_env_map, m_options);
+				// Lazily stored new pattern matches are not reported, but the configuration holding them is published.
+				if (changed.empty() && cfg->Entries().size() == current.Entries().size())
+				{
+					return;
+				}
 			}
-			catch (const std::out_of_range&)
+			else
 			{
-				throw EnvBadGet("long long overflow " + result + " for enviroment " + env_name);
+				cfg = std::make_unique<EnvCfg>();
+				cfg->InitEnv(m_env_map, m_options);
+				for (const auto& entry : cfg->Entries())
+				{
+					changed.push_back(entry.key);
+				}
 			}
-			catch (const std::exception& err)
+			for (const Subscription& subscription : m_subscriptions)
 			{
-				throw EnvException("catch unhandled exception " + static_cast<std::string>(err.what()) + " for enviroment " + env_name);
+				if (std::function<void()> batch = subscription.prepare(*cfg, changed))
+				{
+					batches.push_back(std::move(batch));
+				}
 			}
+			old = m_current.exchange(cfg.release(), std::memory_order_seq_cst);
+			m_refreshable = true;
+			executor = m_executor;
 		}
-		else if constexpr (std::is_same_v<T, bool>)
+		Retire(old);
+		for (std::function<void()>& batch : batches)
 		{
-			std::transform(result.begin(), result.end(), result.begin(),
-				[](unsigned char a) {return std::tolower(a); });
-			if (result == "true")
-			{
-				T result_bool = true;
-				return result_bool;
-			}
-			else if (result == "false")
+			if (executor)
 			{
-				T result_bool = false;
-				return result_bool;
+				executor(std::move(batch));
 			}
 			else
 			{
-				throw EnvBadGet("expected bool " + result + " for enviroment " + env_name);
+				batch();
 			}
 		}
-		else
+	}
+
+	CPPLIBENV_INLINE void EnvCfgHolder::Publish(std::unique_ptr<EnvCfg> cfg)
+	{
+		if (!cfg)
+		{
+			throw EnvException("can not publish an empty configuration");
+		}
+		const EnvCfg* old = nullptr;
 		{
-			std::string type = typeid(T).name();
-			throw EnvException("unhandled type " + type + " for enviroment " + env_name);
+			std::lock_guard<std::mutex> lock(m_write_mutex);
+			old = m_current.exchange(cfg.release(), std::memory_order_seq_cst);
+			m_refreshable = false;
 		}
+		Retire(old);
 	}
 
-	template<typename T>
-	inline void EnvCfg::HandleType(const EnvValue& value, const std::string& env_name)
+	CPPLIBENV_INLINE void EnvCfgHolder::Retire(const EnvCfg* cfg) noexcept
 	{
-		using ValueType = std::decay_t<T>;
+		// Destroyed by a later retirement once the guards which could have seen it are gone, never waits,
+		// so a thread holding a guard can reload and writers do not wait for readers of other holders.
+		detail::EpochDomain::Instance().Retire(const_cast<EnvCfg*>(cfg), [](void* ptr) noexcept {
+			delete static_cast<EnvCfg*>(ptr);
+		});
+	}
+#endif
 
-		if (std::optional<ValueType> env_val = GetEnvByType<ValueType>(env_name))
+	template <typename T, typename>
+	inline std::size_t EnvCfgHolder::Subscribe(std::string name, std::function<void(const std::vector<EnvChange<T>>&)> callback, EnvMatch match)
+	{
+		if (!callback)
 		{
-			m_env_result[env_name] = env_val.value();
+			throw EnvException("can not subscribe an empty callback");
 		}
-		else if (value.data)
-		{
-			const auto& variant_val = value.data.value();
-
-			if (std::holds_alternative<ValueType>(variant_val))
+		auto prepare = [name = std::move(name), match, callback = std::move(callback)](const EnvCfg& cfg, const std::vector<std::string_view>& changed) {
+			std::vector<EnvChange<T>> changes;
+			for (std::string_view key : changed)
 			{
-				const ValueType* ptr = std::get_if<ValueType>(&variant_val);
-				if (ptr)
-				{
-					m_env_result[env_name] = *ptr;
-				}
-				else
+				if (match == EnvMatch::key_ ? key == name : key.substr(0, name.size()) == name)
 				{
-					m_env_result[env_name] = std::nullopt;
+					changes.push_back(EnvChange<T>{ std::string(key), cfg.GetN<T>(key) });
 				}
 			}
-			else
+			if (changes.empty())
 			{
-				m_env_result[env_name] = std::nullopt;
+				return std::function<void()>();
 			}
+			return std::function<void()>([callback, changes = std::move(changes)] {
+				callback(changes);
+			});
+		};
+		std::lock_guard<std::mutex> lock(m_write_mutex);
+		const std::size_t id = m_next_subscription++;
+		m_subscriptions.push_back(Subscription{ id, std::move(prepare) });
+		return id;
+	}
+
+#if CPPLIBENV_DEFINITIONS
+	CPPLIBENV_INLINE void EnvCfgHolder::Unsubscribe(std::size_t id)
+	{
+		std::lock_guard<std::mutex> lock(m_write_mutex);
+		m_subscriptions.erase(std::remove_if(m_subscriptions.begin(), m_subscriptions.end(), [id](const Subscription& subscription) {
+			return subscription.id == id;
+		}), m_subscriptions.end());
+	}
+
+	CPPLIBENV_INLINE void EnvCfgHolder::SetExecutor(std::function<void(std::function<void()>)> executor)
+	{
+		std::lock_guard<std::mutex> lock(m_write_mutex);
+		m_executor = std::move(executor);
+	}
+#endif
+
+	/**
+	* @brief Layer of an `EnvLayeredCfg`, from the lowest to the highest precedence.
+	*
+	* The default of a key in the `EnvMap` is below every layer, runtime overrides are above every layer.
+	*/
+	enum class EnvLayer
+	{
+		file_,
+		environment_
+	};
+
+	/**
+	* @brief Configuration resolved from layered sources: defaults < file < environment < runtime overrides.
+	*
+	* Layers are set, replaced and removed independently. Whenever a layer changes the winning raw value of every
+	* key is looked up through the layers from the top, and only the keys whose winning value changed are parsed
+	* again into the flat table of `Cfg()`, so a read is a single lookup no matter how many layers exist.
+	* A change which fails to parse leaves the configuration and the layers as they were.
+	*
+	* @code
+	* env_cfg::EnvLayeredCfg layered(config); // environment layer: the process environment
+	* layered.SetLayer(env_cfg::EnvLayer::file_, std::make_shared<env_cfg::EnvFileSource>("/etc/service/defaults.env"));
+	* layered.SetOverride("LOG_LEVEL", "debug");
+	* int port = layered.Get<int>("PORT");
+	* @endcode
+	*
+	* @note Not thread-safe against concurrent reads, publish copies of `Cfg()` through an `EnvCfgHolder` for that.
+	*/
+	class EnvLayeredCfg
+	{
+	public:
+		/**
+		* @brief Resolves the keys of `env_map` with the process environment as the only layer.
+		*
+		* @note This method throw EnvException exception on errors, pattern keys are not supported.
+		*/
+		explicit EnvLayeredCfg(const EnvMap& env_map);
+		/**
+		* @brief Sets or replaces `layer` and resolves the configuration again.
+		*
+		* `EnvSource::Wait()` of the layers is called first, so an `EnvAsyncSource` can be used as a layer.
+		*
+		* @return The keys whose value changed, valid until the next change of the configuration.
+		* @note This method throw EnvException exception on errors.
+		*/
+		std::vector<std::string_view> SetLayer(EnvLayer layer, std::shared_ptr<const EnvSource> source);
+		/**
+		* @brief Removes `layer`, the keys it provided fall through to the layers below or the defaults.
+		*/
+		std::vector<std::string_view> RemoveLayer(EnvLayer layer);
+		/**
+		* @brief Sets the runtime override of `env_name`, which wins over every layer.
+		*
+		* An empty value shadows the layers and resolves to the default, like an empty variable does.
+		*/
+		std::vector<std::string_view> SetOverride(std::string_view env_name, std::string value);
+		/**
+		* @brief Removes the runtime override of `env_name`, if any.
+		*/
+		std::vector<std::string_view> ClearOverride(std::string_view env_name);
+		/**
+		* @brief Resolves the configuration again, e.g. after the environment changed.
+		*/
+		std::vector<std::string_view> Refresh();
+		/**
+		* @brief Returns the process environment as a layer, as `InitEnv` reads it (overlay and attached source included).
+		*/
+		static std::shared_ptr<const EnvSource> Environment();
+
+		inline const EnvCfg& Cfg() const noexcept
+		{
+			return m_cfg;
 		}
-		else
+
+		template <typename T, typename = std::enable_if_t<detail::is_env_type_v<T>>>
+		inline T Get(std::string_view env_name) const
+		{
+			return m_cfg.Get<T>(env_name);
+		}
+
+		template <typename T, typename = std::enable_if_t<detail::is_env_type_v<T>>>
+		inline std::optional<T> GetN(std::string_view env_name) const noexcept
+		{
+			return m_cfg.GetN<T>(env_name);
+		}
+
+		inline bool HasValue(std::string_view env_name) const noexcept
 		{
-			m_env_result[env_name] = std::nullopt;
+			return m_cfg.HasValue(env_name);
 		}
+	private:
+		using Layers = std::array<std::shared_ptr<const EnvSource>, 2>;
+		using Overrides = std::vector<std::pair<std::string, std::string>>;
+		// The process environment, every lookup runs in its own EpochSection.
+		class ProcessEnvironment final : public EnvSource
+		{
+		public:
+			std::string_view Find(std::string_view env_name) const noexcept override;
+			void ForEach(const std::function<void(std::string_view, std::string_view)>& f) const override;
+		};
+		// Overrides and layers looked up from the top, the source RevalidateSlots resolves the keys against.
+		class Stack final : public EnvSource
+		{
+		public:
+			Stack(const Layers& layers, const Overrides& overrides) noexcept : m_layers(layers), m_overrides(overrides) {}
+			std::string_view Find(std::string_view env_name) const noexcept override;
+			void ForEach(const std::function<void(std::string_view, std::string_view)>& f) const override;
+		private:
+			const Layers& m_layers;
+			const Overrides& m_overrides;
+		};
+		static Overrides::const_iterator FindOverride(const Overrides& overrides, std::string_view env_name) noexcept;
+		// Resolves the configuration against `layers` and `overrides` and keeps them if that succeeds.
+		std::vector<std::string_view> Apply(Layers layers, Overrides overrides);
+		Layers m_layers;
+		// Sorted by name.
+		Overrides m_overrides;
+		EnvCfg m_cfg;
+	};
+
+#if CPPLIBENV_DEFINITIONS
+	CPPLIBENV_INLINE EnvLayeredCfg::EnvLayeredCfg(const EnvMap& env_map)
+	{
+		m_layers[static_cast<std::size_t>(EnvLayer::environment_)] = Environment();
+		m_layers[static_cast<std::size_t>(EnvLayer::environment_)]->Wait();
+		const Stack stack(m_layers, m_overrides);
+		detail::EpochSection section;
+		m_cfg.InitSource(env_map, stack);
 	}
 
-	template<typename T>
-	inline bool EnvCfg::TryHandleType(const EnvValue& value, const std::string& env_name)
+	CPPLIBENV_INLINE std::shared_ptr<const EnvSource> EnvLayeredCfg::Environment()
 	{
-		const bool is_type_present = std::visit([&env_name, &value, this](const auto& v) {
-			if constexpr (std::is_same_v<std::decay_t<decltype(v)>, std::decay_t<T>>)
-			{
-				HandleType<T>(value, env_name);
-				return true;
-			}
-			return false;
-			}, value.data.value());
-		return is_type_present;
+		static const std::shared_ptr<const EnvSource> environment = std::make_shared<ProcessEnvironment>();
+		return environment;
 	}
 
-	inline void EnvCfg::InitEnv(std::unordered_map<std::string, EnvValue>& env_map)
+	CPPLIBENV_INLINE std::vector<std::string_view> EnvLayeredCfg::SetLayer(EnvLayer layer, std::shared_ptr<const EnvSource> source)
 	{
-		for (const auto& entry : env_map)
+		if (!source)
 		{
-			ProcessEntry(entry);
+			throw EnvException("can not set an empty source as a layer");
 		}
+		Layers layers = m_layers;
+		layers[static_cast<std::size_t>(layer)] = std::move(source);
+		return Apply(std::move(layers), m_overrides);
 	}
 
-	inline void EnvCfg::SetEnv(const std::string& env_name, const std::string& value, bool overwrite)
+	CPPLIBENV_INLINE std::vector<std::string_view> EnvLayeredCfg::RemoveLayer(EnvLayer layer)
 	{
-		if (env_name.empty() || env_name.find('=') != std::string::npos)
+		Layers layers = m_layers;
+		layers[static_cast<std::size_t>(layer)].reset();
+		return Apply(std::move(layers), m_overrides);
+	}
+
+	CPPLIBENV_INLINE std::vector<std::string_view> EnvLayeredCfg::SetOverride(std::string_view env_name, std::string value)
+	{
+		Overrides overrides = m_overrides;
+		auto it = overrides.begin() + (FindOverride(overrides, env_name) - overrides.cbegin());
+		if (it != overrides.end() && it->first == env_name)
 		{
-			throw EnvSetError("invalid environment variable name " + env_name);
+			it->second = std::move(value);
 		}
-		if (setenv(env_name.c_str(), value.c_str(), overwrite ? 1 : 0) != 0)
+		else
 		{
-			throw EnvSetError("setenv failed for variable " + env_name + " with value " + value);
+			overrides.emplace(it, std::string(env_name), std::move(value));
 		}
+		return Apply(m_layers, std::move(overrides));
 	}
 
-	inline bool EnvCfg::SetEnvN(const std::string& env_name, const std::string& value, bool overwrite) noexcept
+	CPPLIBENV_INLINE std::vector<std::string_view> EnvLayeredCfg::ClearOverride(std::string_view env_name)
 	{
-		if (setenv(env_name.c_str(), value.c_str(), overwrite ? 1 : 0) != 0)
+		const auto it = FindOverride(m_overrides, env_name);
+		if (it == m_overrides.cend() || it->first != env_name)
 		{
-			return false;
+			return {};
 		}
-		return true;
+		Overrides overrides = m_overrides;
+		overrides.erase(overrides.begin() + (it - m_overrides.cbegin()));
+		return Apply(m_layers, std::move(overrides));
 	}
 
-	inline std::string EnvCfg::GetEnv(const std::string& env_name) noexcept
+	CPPLIBENV_INLINE std::vector<std::string_view> EnvLayeredCfg::Refresh()
 	{
-		if (char* env_value = std::getenv(env_name.c_str()))
-		{
-			return env_value;
-		}
-		return std::string();
+		return Apply(m_layers, m_overrides);
 	}
 
-	inline void EnvCfg::ProcessEntry(const std::pair<std::string, EnvValue>& entry)
+	CPPLIBENV_INLINE EnvLayeredCfg::Overrides::const_iterator EnvLayeredCfg::FindOverride(const Overrides& overrides, std::string_view env_name) noexcept
 	{
-		const auto& [env_name, default_value] = entry;
-		std::visit([&](const auto& val) {
-			if constexpr (std::is_same_v<std::decay_t<decltype(val)>, EnvCfgTypes>)
+		return std::lower_bound(overrides.begin(), overrides.end(), env_name, [](const std::pair<std::string, std::string>& entry, std::string_view name) {
+			return std::string_view(entry.first) < name;
+		});
+	}
+
+	CPPLIBENV_INLINE std::vector<std::string_view> EnvLayeredCfg::Apply(Layers layers, Overrides overrides)
+	{
+		for (const std::shared_ptr<const EnvSource>& layer : layers)
+		{
+			if (layer)
 			{
-				HandleEnumType(default_value, env_name);
+				layer->Wait();
 			}
-			else
+		}
+		std::vector<std::size_t> changed;
+		{
+			// Keeps the overlay tables and the attached source read by the environment layer alive for the whole pass.
+			detail::EpochSection section;
+			const Stack stack(layers, overrides);
+			changed = m_cfg.RevalidateSlots(&stack);
+		}
+		m_layers = std::move(layers);
+		m_overrides = std::move(overrides);
+		if (!changed.empty())
+		{
+			m_cfg.Compact();
+		}
+		std::vector<std::string_view> keys;
+		keys.reserve(changed.size());
+		for (std::size_t slot : changed)
+		{
+			keys.push_back(m_cfg.ArenaView(m_cfg.m_slots[slot].key));
+		}
+		return keys;
+	}
+
+	CPPLIBENV_INLINE std::string_view EnvLayeredCfg::ProcessEnvironment::Find(std::string_view env_name) const noexcept
+	{
+		detail::EpochSection section;
+		try
+		{
+			return EnvCfg::ResolveView(std::string(env_name));
+		}
+		catch (...)
+		{
+			return std::string_view();
+		}
+	}
+
+	CPPLIBENV_INLINE void EnvLayeredCfg::ProcessEnvironment::ForEach(const std::function<void(std::string_view, std::string_view)>& f) const
+	{
+		detail::EpochSection section;
+		EnvCfg::ForEachEnv(f);
+	}
+
+	CPPLIBENV_INLINE std::string_view EnvLayeredCfg::Stack::Find(std::string_view env_name) const noexcept
+	{
+		const auto it = FindOverride(m_overrides, env_name);
+		if (it != m_overrides.end() && it->first == env_name)
+		{
+			return it->second;
+		}
+		for (auto layer = m_layers.rbegin(); layer != m_layers.rend(); ++layer)
+		{
+			if (*layer)
 			{
-				if (!TryHandleType<decltype(val)>(default_value, env_name))
+				const std::string_view value = (*layer)->Find(env_name);
+				if (value.data())
 				{
-					std::string type = typeid(val).name();
-					throw EnvException("unhandled type " + type);
+					return value;
 				}
 			}
-		}, default_value.data.value());
-	}
-
-	inline void EnvCfg::HandleEnumType(const EnvValue& value, const std::string& env_name)
-	{
-		auto type = std::get<EnvCfgTypes>(value.data.value());
-		switch (type)
-		{
-		case EnvCfgTypes::string_:
-			HandleType<std::string>(value, env_name);
-			break;
-		case EnvCfgTypes::int_:
-			HandleType<int>(value, env_name);
-			break;
-		case EnvCfgTypes::double_:
-			HandleType<double>(value, env_name);
-			break;
-		case EnvCfgTypes::longlong_:
-			HandleType<long long>(value, env_name);
-			break;
-		case EnvCfgTypes::bool_:
-			HandleType<bool>(value, env_name);
-			break;
-		default:
-			throw EnvException("unknown enum type");
 		}
+		return std::string_view();
 	}
 
-	inline bool EnvCfg::HasValue(const std::string& env_name) const noexcept
+	CPPLIBENV_INLINE void EnvLayeredCfg::Stack::ForEach(const std::function<void(std::string_view, std::string_view)>& f) const
 	{
-		auto it = m_env_result.find(env_name);
-		if (it == m_env_result.end())
+		// A variable is reported by the highest layer defining it.
+		for (const auto& [name, value] : m_overrides)
 		{
-			return false;
+			f(name, value);
 		}
-		if (!it->second)
+		for (std::size_t level = m_layers.size(); level-- > 0;)
 		{
-			return false;
+			if (!m_layers[level])
+			{
+				continue;
+			}
+			m_layers[level]->ForEach([&](std::string_view name, std::string_view value) {
+				const auto it = FindOverride(m_overrides, name);
+				if (it != m_overrides.end() && it->first == name)
+				{
+					return;
+				}
+				for (std::size_t above = level + 1; above < m_layers.size(); ++above)
+				{
+					if (m_layers[above] && m_layers[above]->Find(name).data())
+					{
+						return;
+					}
+				}
+				f(name, value);
+			});
 		}
-		return true;
 	}
-} // namespace env_cgf
+#endif
+} // namespace env_cgf
\ No newline at end of file
@@ -4,6 +4,13 @@
 
 #include "libenv.h"
 
+struct AppConfig
+{
+    std::string name;
+    int workers = 1;
+    bool verbose = false;
+};
+
 int main()
 {
     env_cfg::EnvMap env_conf =
@@ -70,5 +77,22 @@ int main()
     {
         std::cout << k << " = " << v << '\n';
     }
+
+    // Describe the struct once, the members are filled in a single pass and read without lookups
+    const auto binding = env_cfg::EnvBinding<AppConfig>()
+        .Field("TEST_ENV1", &AppConfig::name)
+        .Field("TEST_ENV2", &AppConfig::workers, 4)
+        .Field("TEST_ENV3", &AppConfig::verbose, false);
+    AppConfig app;
+    try
+    {
+        a.InitEnv(binding, app);
+    }
+    catch (const env_cfg::EnvException& err)
+    {
+        std::cerr << err.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << app.name << ' ' << app.workers << ' ' << app.verbose << std::endl;
     return EXIT_SUCCESS;
 }
\ No newline at end of file
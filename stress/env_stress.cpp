@@ -0,0 +1,428 @@
+// Stress harness: InitEnv throughput and peak RSS over large synthetic environments (mixed types, malformed
+// values), and read latency of concurrent readers while a writer reloads, across thread counts.
+//
+// g++ -std=c++17 -O2 -o env_stress env_stress.cpp -pthread
+// ./env_stress [--max-vars N] [--seconds S] [--max-threads T]
+#include "../cpp-envlib/libenv.h"
+#include <cstdio>
+#include <fstream>
+#include <thread>
+#include <sys/resource.h>
+#include <unistd.h>
+
+using namespace env_cfg;
+using Clock = std::chrono::steady_clock;
+
+namespace
+{
+    struct Options
+    {
+        std::size_t max_vars = 100000;
+        double seconds = 1.0;
+        std::size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+    };
+
+    // Resets the peak resident set size to the current one, false if the kernel does not allow it.
+    bool ResetPeakRss()
+    {
+        std::ofstream clear_refs("/proc/self/clear_refs");
+        clear_refs << "5";
+        clear_refs.flush();
+        return static_cast<bool>(clear_refs);
+    }
+
+    // Peak resident set size in KiB since the last ResetPeakRss, or of the process lifetime without the reset.
+    long PeakRssKiB()
+    {
+        std::ifstream status("/proc/self/status");
+        for (std::string line; std::getline(status, line);)
+        {
+            if (line.compare(0, 6, "VmHWM:") == 0)
+            {
+                return std::stol(line.substr(6));
+            }
+        }
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss;
+    }
+
+    // Current resident set size of the process in KiB.
+    long CurrentRssKiB()
+    {
+        long pages = 0;
+        long resident = 0;
+        std::ifstream statm("/proc/self/statm");
+        statm >> pages >> resident;
+        return resident * (sysconf(_SC_PAGESIZE) / 1024);
+    }
+
+    // Environment block of `count` synthetic variables installed as `environ`, every 20th value is malformed.
+    class SyntheticEnv
+    {
+    public:
+        explicit SyntheticEnv(std::size_t count) : m_saved(environ)
+        {
+            m_strings.reserve(count);
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                const EnvCfgTypes type = Type(i);
+                // Strings have no malformed values.
+                const bool malformed = i % 20 == 19 && type != EnvCfgTypes::string_;
+                m_strings.push_back(Name(i) + "=" + Value(i, malformed));
+                const EnvCfg::EnvValue value = type == EnvCfgTypes::list_ ? EnvCfg::EnvValue(EnvList{ EnvCfgTypes::int_, ',', false, "" }) : EnvCfg::EnvValue(type);
+                m_keys.push_back(Key{ Name(i), value, malformed });
+                if (!malformed)
+                {
+                    m_map.emplace(Name(i), value);
+                }
+                // Lists are never lazy, their malformed values are only declared in the eager schemas.
+                if (!malformed || type != EnvCfgTypes::list_)
+                {
+                    m_lazy_malformed += malformed;
+                    m_lazy_map.emplace(Name(i), value);
+                }
+            }
+            for (char** env = environ; env && *env; ++env)
+            {
+                m_envp.push_back(*env);
+            }
+            for (std::string& entry : m_strings)
+            {
+                m_envp.push_back(entry.data());
+            }
+            m_envp.push_back(nullptr);
+            environ = m_envp.data();
+        }
+        SyntheticEnv(const SyntheticEnv&) = delete;
+        SyntheticEnv& operator=(const SyntheticEnv&) = delete;
+        ~SyntheticEnv()
+        {
+            environ = m_saved;
+        }
+
+        // Schema of the well-formed variables.
+        EnvMap& Map()
+        {
+            return m_map;
+        }
+
+        // Schema of all variables for the lazy run, the malformed scalars included.
+        EnvMap& LazyMap()
+        {
+            return m_lazy_map;
+        }
+
+        std::size_t lazy_malformed() const
+        {
+            return m_lazy_malformed;
+        }
+
+        // Schemas covering the variables in order, each ending with one malformed key so that InitEnv fails on it.
+        // A malformed key only closes a schema of at least `min_size` keys, the ones in between are not declared.
+        std::vector<EnvMap> FailingMaps(std::size_t min_size) const
+        {
+            std::vector<EnvMap> maps(1);
+            for (const Key& key : m_keys)
+            {
+                if (!key.malformed)
+                {
+                    maps.back().emplace(key.name, key.value);
+                }
+                else if (maps.back().size() + 1 >= min_size)
+                {
+                    maps.back().emplace(key.name, key.value);
+                    maps.emplace_back();
+                }
+            }
+            return maps;
+        }
+
+        static std::string Name(std::size_t i)
+        {
+            return "STRESS_VAR_" + std::to_string(i);
+        }
+
+    private:
+        struct Key
+        {
+            std::string name;
+            EnvCfg::EnvValue value;
+            bool malformed;
+        };
+
+        static EnvCfgTypes Type(std::size_t i)
+        {
+            static const EnvCfgTypes types[] = { EnvCfgTypes::int_, EnvCfgTypes::double_, EnvCfgTypes::longlong_, EnvCfgTypes::bool_,
+                EnvCfgTypes::string_, EnvCfgTypes::duration_, EnvCfgTypes::bytes_, EnvCfgTypes::list_ };
+            return types[i % 8];
+        }
+
+        static std::string Value(std::size_t i, bool malformed)
+        {
+            const std::string n = std::to_string(i);
+            switch (Type(i))
+            {
+            case EnvCfgTypes::int_:
+                return malformed ? n + ".5" : n;
+            case EnvCfgTypes::double_:
+                return malformed ? "x" + n : n + ".25";
+            case EnvCfgTypes::longlong_:
+                return malformed ? "99999999999999999999" : n + "000000";
+            case EnvCfgTypes::bool_:
+                return malformed ? "maybe" : (i % 16 < 8 ? "true" : "no");
+            case EnvCfgTypes::string_:
+                return "value-" + n;
+            case EnvCfgTypes::duration_:
+                return malformed ? n + "parsecs" : n + "ms";
+            case EnvCfgTypes::bytes_:
+                return malformed ? "-" + n + "KiB" : n + "KiB";
+            default:
+                return malformed ? n + ",x," + n : n + "," + n + "," + n;
+            }
+        }
+
+        char** m_saved;
+        std::vector<std::string> m_strings;
+        std::vector<char*> m_envp;
+        std::vector<Key> m_keys;
+        EnvMap m_map;
+        EnvMap m_lazy_map;
+        std::size_t m_lazy_malformed = 0;
+    };
+
+    template <class F>
+    double Seconds(F&& f)
+    {
+        const Clock::time_point start = Clock::now();
+        f();
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    void InitThroughput(const Options& options)
+    {
+        const bool peak_per_mode = ResetPeakRss();
+        std::printf("InitEnv throughput (every 20th value malformed, peak RSS %s)\n", peak_per_mode ? "per mode" : "of the process");
+        std::printf("%10s %-16s %12s %14s %12s %12s %14s\n", "vars", "mode", "time ms", "vars/s", "rss KiB", "peak KiB", "errors");
+        for (std::size_t count = 1000; count <= options.max_vars; count *= 10)
+        {
+            SyntheticEnv env(count);
+            auto run = [&](const char* mode, std::size_t vars, auto&& f) {
+                ResetPeakRss();
+                std::size_t expected = 0;
+                std::size_t errors = 0;
+                const double seconds = Seconds([&] { f(expected, errors); });
+                std::printf("%10zu %-16s %12.2f %14.0f %12ld %12ld %7zu/%-6zu\n", count, mode, seconds * 1e3, static_cast<double>(vars) / seconds,
+                    CurrentRssKiB(), PeakRssKiB(), errors, expected);
+                if (errors != expected)
+                {
+                    std::printf("  unexpected: %zu values rejected, %zu malformed\n", errors, expected);
+                }
+            };
+            // Each failing schema is initialized into a fresh configuration, the EnvBadGet of its malformed key is counted.
+            auto eager = [&](const char* mode, const EnvInitOptions& init, std::size_t min_size) {
+                std::vector<EnvMap> maps = env.FailingMaps(min_size);
+                std::size_t vars = 0;
+                for (const EnvMap& map : maps)
+                {
+                    vars += map.size();
+                }
+                run(mode, vars, [&](std::size_t& expected, std::size_t& errors) {
+                    expected = maps.size() - 1;
+                    for (EnvMap& map : maps)
+                    {
+                        EnvCfg cfg;
+                        try
+                        {
+                            cfg.InitEnv(map, init);
+                        }
+                        catch (const EnvBadGet&)
+                        {
+                            ++errors;
+                        }
+                    }
+                });
+            };
+            EnvInitOptions sequential;
+            EnvInitOptions threads;
+            threads.threads = 4;
+            // Without the snapshot every key is a getenv, a linear scan of environ.
+            if (count <= 10000)
+            {
+                run("getenv", env.Map().size(), [&](std::size_t&, std::size_t&) { EnvCfg().InitEnv(env.Map()); });
+                eager("getenv+errors", sequential, 1);
+            }
+            EnvCfg::EnableSnapshot();
+            run("snapshot", env.Map().size(), [&](std::size_t&, std::size_t&) { EnvCfg().InitEnv(env.Map()); });
+            eager("snapshot+errors", sequential, 1);
+            run("threads=4", env.Map().size(), [&](std::size_t&, std::size_t&) { EnvCfg().InitEnv(env.Map(), threads); });
+            // Smaller schemas would not be split over the threads, one malformed key per 4 * 256 keys is declared.
+            eager("threads=4+errors", threads, threads.threads * threads.min_entries_per_thread);
+            run("lazy+read", env.LazyMap().size(), [&](std::size_t& expected, std::size_t& errors) {
+                EnvInitOptions lazy;
+                lazy.lazy = true;
+                EnvCfg cfg;
+                cfg.InitEnv(env.LazyMap(), lazy);
+                for (const auto& entry : env.LazyMap())
+                {
+                    errors += !cfg.HasValue(entry.first);
+                }
+                expected = env.lazy_malformed();
+            });
+            EnvCfg::DisableSnapshot();
+        }
+        std::printf("\n");
+    }
+
+    struct ReadStats
+    {
+        double reads_per_second;
+        double p50;
+        double p99;
+        double p999;
+        std::size_t reloads;
+    };
+
+    // Median cost of a pair of Clock::now() calls, subtracted from the sampled latencies.
+    double ClockOverhead()
+    {
+        std::vector<double> samples(10000);
+        for (double& sample : samples)
+        {
+            const Clock::time_point start = Clock::now();
+            sample = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        }
+        std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+        return samples[samples.size() / 2];
+    }
+
+    ReadStats ReadWhileReloading(EnvCfgHolder& holder, const std::vector<std::string>& names, std::size_t readers, double seconds, double overhead)
+    {
+        std::atomic<bool> stop{ false };
+        std::vector<std::vector<float>> samples(readers);
+        std::vector<std::size_t> reads(readers, 0);
+        std::vector<std::thread> threads;
+        for (std::size_t t = 0; t < readers; ++t)
+        {
+            threads.emplace_back([&, t] {
+                std::vector<float>& latencies = samples[t];
+                latencies.reserve(1 << 20);
+                std::uint64_t state = 0x9E3779B97F4A7C15ull * (t + 1);
+                std::size_t count = 0;
+                long long sum = 0;
+                while (!stop.load(std::memory_order_relaxed))
+                {
+                    state ^= state << 13;
+                    state ^= state >> 7;
+                    state ^= state << 17;
+                    const std::string& name = names[state % names.size()];
+                    // One read out of 8 is timed, so the clock does not dominate the throughput.
+                    if ((count & 7) == 0 && latencies.size() < latencies.capacity())
+                    {
+                        const Clock::time_point start = Clock::now();
+                        sum += holder.Read()->Get<int>(name);
+                        latencies.push_back(static_cast<float>(std::chrono::duration<double, std::nano>(Clock::now() - start).count() - overhead));
+                    }
+                    else
+                    {
+                        sum += holder.Read()->GetN<int>(name).value_or(0);
+                    }
+                    ++count;
+                }
+                reads[t] = count;
+                if (sum == 42)
+                {
+                    std::printf(" ");
+                }
+            });
+        }
+        std::size_t reloads = 0;
+        const Clock::time_point start = Clock::now();
+        const Clock::time_point end = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+        while (Clock::now() < end)
+        {
+            setenv(names[0].c_str(), std::to_string(reloads % 100).c_str(), 1);
+            holder.Reload();
+            ++reloads;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        stop = true;
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+        const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        std::vector<float> all;
+        std::size_t total = 0;
+        for (std::size_t t = 0; t < readers; ++t)
+        {
+            all.insert(all.end(), samples[t].begin(), samples[t].end());
+            total += reads[t];
+        }
+        auto percentile = [&all](double p) -> double {
+            if (all.empty())
+            {
+                return 0;
+            }
+            const std::size_t index = std::min(all.size() - 1, static_cast<std::size_t>(p * static_cast<double>(all.size())));
+            std::nth_element(all.begin(), all.begin() + static_cast<std::ptrdiff_t>(index), all.end());
+            return std::max(0.0, static_cast<double>(all[index]));
+        };
+        return ReadStats{ static_cast<double>(total) / elapsed, percentile(0.5), percentile(0.99), percentile(0.999), reloads };
+    }
+
+    void ReaderScaling(const Options& options)
+    {
+        constexpr std::size_t keys = 1000;
+        std::vector<std::string> names;
+        EnvMap map;
+        for (std::size_t i = 0; i < keys; ++i)
+        {
+            names.push_back("STRESS_READ_" + std::to_string(i));
+            setenv(names.back().c_str(), std::to_string(i).c_str(), 1);
+            map.emplace(names.back(), EnvCfgTypes::int_);
+        }
+        EnvCfgHolder holder(map);
+        const double overhead = ClockOverhead();
+        std::printf("Readers while a writer reloads every 1ms (%zu keys, clock overhead %.0f ns subtracted)\n", keys, overhead);
+        std::printf("%8s %14s %10s %10s %10s %10s\n", "threads", "reads/s", "p50 ns", "p99 ns", "p99.9 ns", "reloads");
+        for (std::size_t readers = 1; readers <= options.max_threads; readers *= 2)
+        {
+            const ReadStats stats = ReadWhileReloading(holder, names, readers, options.seconds, overhead);
+            std::printf("%8zu %14.0f %10.0f %10.0f %10.0f %10zu\n", readers, stats.reads_per_second, stats.p50, stats.p99, stats.p999, stats.reloads);
+        }
+        for (const std::string& name : names)
+        {
+            unsetenv(name.c_str());
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--max-vars")
+        {
+            options.max_vars = std::stoul(argv[i + 1]);
+        }
+        else if (arg == "--seconds")
+        {
+            options.seconds = std::stod(argv[i + 1]);
+        }
+        else if (arg == "--max-threads")
+        {
+            options.max_threads = std::max<std::size_t>(1, std::stoul(argv[i + 1]));
+        }
+        else
+        {
+            std::fprintf(stderr, "usage: %s [--max-vars N] [--seconds S] [--max-threads T]\n", argv[0]);
+            return 1;
+        }
+    }
+    InitThroughput(options);
+    ReaderScaling(options);
+    return 0;
+}
@@ -0,0 +1,495 @@
+// Differential fuzz target: EnvCfg::ParseValue<T> against the std::stoi/std::stoll/std::stod/std::stof
+// semantics it replaces, the sized integers against std::strtoll/std::strtoull with a range check, booleans
+// against the case-insensitive true/false/yes/no/1/0 matching, durations and byte sizes by a round trip
+// through their formatting, and lists against a split of the raw value parsed with std::stoll.
+//
+// libFuzzer:   clang++ -std=c++17 -g -O1 -fsanitize=fuzzer,address,undefined -o parse_fuzz parse_fuzz.cpp
+// standalone:  g++ -std=c++17 -O1 -DCPPLIBENV_FUZZ_STANDALONE -o parse_fuzz parse_fuzz.cpp
+//              ./parse_fuzz [--runs N] [--seed S] [files...]
+//
+// The first byte of an input selects the type, the remaining bytes are the raw value.
+#include "../cpp-envlib/libenv.h"
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <fstream>
+#include <sstream>
+
+using namespace env_cfg;
+
+namespace
+{
+    // Result of the reference parsing: the value, or the error code it maps to.
+    template <typename T>
+    struct Expected
+    {
+        std::optional<T> value;
+        EnvErrc error = EnvErrc::ok;
+    };
+
+    template <typename T>
+    Expected<T> ParseWithStd(std::string_view raw)
+    {
+        if (raw.empty())
+        {
+            return { std::nullopt, EnvErrc::empty };
+        }
+        const std::string text(raw);
+        const bool has_point = raw.find('.') != std::string_view::npos;
+        try
+        {
+            std::size_t pos = 0;
+            if constexpr (std::is_same_v<T, int>)
+            {
+                const int value = std::stoi(text, &pos);
+                // Integers other than long long reject a fractional part which std::stoi would ignore.
+                if (pos != text.size() && has_point)
+                {
+                    return { std::nullopt, EnvErrc::fractional };
+                }
+                return { value, EnvErrc::ok };
+            }
+            else if constexpr (std::is_same_v<T, long long>)
+            {
+                return { std::stoll(text, &pos), EnvErrc::ok };
+            }
+            else if constexpr (std::is_same_v<T, double>)
+            {
+                return { std::stod(text, &pos), EnvErrc::ok };
+            }
+            else
+            {
+                return { std::stof(text, &pos), EnvErrc::ok };
+            }
+        }
+        catch (const std::out_of_range&)
+        {
+            return { std::nullopt, std::is_same_v<T, int> && has_point ? EnvErrc::fractional : EnvErrc::out_of_range };
+        }
+        catch (const std::invalid_argument&)
+        {
+            return { std::nullopt, std::is_same_v<T, int> && has_point ? EnvErrc::fractional : EnvErrc::invalid_format };
+        }
+    }
+
+    template <typename T>
+    Expected<T> ParseSizedWithStd(std::string_view raw)
+    {
+        if (raw.empty())
+        {
+            return { std::nullopt, EnvErrc::empty };
+        }
+        const std::string text(raw);
+        const char* const begin = text.c_str();
+        char* end = nullptr;
+        EnvErrc error = EnvErrc::ok;
+        T value{};
+        errno = 0;
+        if constexpr (std::is_signed_v<T>)
+        {
+            const long long parsed = std::strtoll(begin, &end, 10);
+            if (end == begin)
+            {
+                error = EnvErrc::invalid_format;
+            }
+            else if (errno == ERANGE || parsed < std::numeric_limits<T>::min() || parsed > std::numeric_limits<T>::max())
+            {
+                error = EnvErrc::out_of_range;
+            }
+            value = static_cast<T>(parsed);
+        }
+        else
+        {
+            const char* first = begin;
+            while (*first && std::isspace(static_cast<unsigned char>(*first)))
+            {
+                ++first;
+            }
+            // std::strtoull wraps negative values around, only "-0" is in range.
+            const unsigned long long parsed = std::strtoull(begin, &end, 10);
+            if (end == begin)
+            {
+                error = EnvErrc::invalid_format;
+            }
+            else if (errno == ERANGE || (*first == '-' && parsed != 0) || parsed > std::numeric_limits<T>::max())
+            {
+                error = EnvErrc::out_of_range;
+            }
+            value = static_cast<T>(parsed);
+        }
+        // Integers other than long long reject a fractional part which std::strtoll would ignore.
+        if ((error != EnvErrc::ok || end != begin + text.size()) && raw.find('.') != std::string_view::npos)
+        {
+            return { std::nullopt, EnvErrc::fractional };
+        }
+        if (error != EnvErrc::ok)
+        {
+            return { std::nullopt, error };
+        }
+        return { value, EnvErrc::ok };
+    }
+
+    Expected<bool> ParseBoolReference(std::string_view raw)
+    {
+        if (raw.empty())
+        {
+            return { std::nullopt, EnvErrc::empty };
+        }
+        std::string lower(raw);
+        for (char& c : lower)
+        {
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+        if (lower == "true" || lower == "yes" || lower == "1")
+        {
+            return { true, EnvErrc::ok };
+        }
+        if (lower == "false" || lower == "no" || lower == "0")
+        {
+            return { false, EnvErrc::ok };
+        }
+        return { std::nullopt, EnvErrc::invalid_format };
+    }
+
+    template <typename T>
+    bool SameValue(T parsed, T expected)
+    {
+        if constexpr (std::is_floating_point_v<T>)
+        {
+            if (std::isnan(parsed) || std::isnan(expected))
+            {
+                return std::isnan(parsed) && std::isnan(expected);
+            }
+            return std::memcmp(&parsed, &expected, sizeof(T)) == 0;
+        }
+        else
+        {
+            return parsed == expected;
+        }
+    }
+
+    [[noreturn]] void Report(const char* type, std::string_view raw, const std::string& parsed, const std::string& expected)
+    {
+        std::cerr << "mismatch for " << type << " input \"";
+        for (char c : raw)
+        {
+            if (std::isprint(static_cast<unsigned char>(c)))
+            {
+                std::cerr << c;
+            }
+            else
+            {
+                std::cerr << "\\x" << std::hex << static_cast<int>(static_cast<unsigned char>(c)) << std::dec;
+            }
+        }
+        std::cerr << "\": ParseValue " << parsed << ", reference " << expected << std::endl;
+        std::abort();
+    }
+
+    // Streams the characters types as numbers and the unit types as their count.
+    template <typename T>
+    auto Printable(const T& value)
+    {
+        if constexpr (std::is_same_v<T, std::chrono::nanoseconds> || std::is_same_v<T, EnvBytes>)
+        {
+            return value.count();
+        }
+        else if constexpr (std::is_integral_v<T> && sizeof(T) < sizeof(int))
+        {
+            return static_cast<int>(value);
+        }
+        else
+        {
+            return value;
+        }
+    }
+
+    template <typename T>
+    std::string Describe(const EnvResult<T>& result)
+    {
+        std::ostringstream out;
+        out.precision(17);
+        if (result)
+        {
+            out << Printable(result.value());
+        }
+        else
+        {
+            out << "error " << static_cast<int>(result.error());
+        }
+        return out.str();
+    }
+
+    template <typename T>
+    std::string Describe(const Expected<T>& expected)
+    {
+        std::ostringstream out;
+        out.precision(17);
+        if (expected.value)
+        {
+            out << Printable(*expected.value);
+        }
+        else
+        {
+            out << "error " << static_cast<int>(expected.error);
+        }
+        return out.str();
+    }
+
+    template <typename T>
+    void Check(const char* type, std::string_view raw, const Expected<T>& expected)
+    {
+        const EnvResult<T> parsed = EnvCfg::ParseValue<T>(raw);
+        const bool same = parsed.has_value() == expected.value.has_value() &&
+            (parsed ? SameValue(parsed.value(), *expected.value) : parsed.error() == expected.error);
+        if (!same)
+        {
+            Report(type, raw, Describe(parsed), Describe(expected));
+        }
+    }
+
+    // Formats `count` with `format` and checks that the text parses back to it.
+    template <typename T, typename Count, typename Format>
+    void CheckFormatted(const char* type, Count count, Format format)
+    {
+        char buffer[64];
+        const std::to_chars_result result = format(buffer, buffer + sizeof(buffer), count);
+        const std::string_view text(buffer, result.ec == std::errc() ? static_cast<std::size_t>(result.ptr - buffer) : 0);
+        const EnvResult<T> parsed = EnvCfg::ParseValue<T>(text);
+        if (!parsed || static_cast<Count>(parsed.value().count()) != count)
+        {
+            Report(type, text, Describe(parsed), std::to_string(count));
+        }
+    }
+
+    // Durations and byte sizes have no std counterpart: a parsed value has to survive formatting and parsing it
+    // again, and a count built from the input bytes has to parse back from its formatted text.
+    template <typename T, typename Count, typename Format>
+    void CheckRoundTrip(const char* type, std::string_view raw, Format format)
+    {
+        const EnvResult<T> parsed = EnvCfg::ParseValue<T>(raw);
+        if (parsed)
+        {
+            CheckFormatted<T>(type, static_cast<Count>(parsed.value().count()), format);
+        }
+        Count count{};
+        std::memcpy(&count, raw.data(), std::min(raw.size(), sizeof(count)));
+        CheckFormatted<T>(type, count, format);
+    }
+
+    // Source answering the list under test from the raw value of the current input.
+    class ListSource final : public EnvSource
+    {
+    public:
+        static constexpr std::string_view key = "CPPLIBENV_FUZZ_LIST";
+
+        std::string_view Find(std::string_view env_name) const noexcept override
+        {
+            return env_name == key ? std::string_view(value) : std::string_view();
+        }
+
+        void ForEach(const std::function<void(std::string_view, std::string_view)>& f) const override
+        {
+            f(key, value);
+        }
+
+        std::string value;
+    };
+
+    void CheckList(std::string_view raw, bool sorted)
+    {
+        static const std::shared_ptr<ListSource> source = [] {
+            auto list = std::make_shared<ListSource>();
+            EnvCfg::AttachSource(list, EnvPrecedence::source_);
+            return list;
+        }();
+        source->value.assign(raw);
+
+        // Elements are split at ',' and trimmed of spaces and tabs, an empty or invalid element rejects the list.
+        std::optional<std::vector<long long>> expected;
+        if (!raw.empty())
+        {
+            expected.emplace();
+            for (std::size_t first = 0; expected;)
+            {
+                const std::size_t separator = std::min(raw.find(',', first), raw.size());
+                std::string_view element = raw.substr(first, separator - first);
+                while (!element.empty() && (element.front() == ' ' || element.front() == '\t'))
+                {
+                    element.remove_prefix(1);
+                }
+                while (!element.empty() && (element.back() == ' ' || element.back() == '\t'))
+                {
+                    element.remove_suffix(1);
+                }
+                const Expected<long long> value = ParseWithStd<long long>(element);
+                if (element.empty() || !value.value)
+                {
+                    expected.reset();
+                    break;
+                }
+                expected->push_back(*value.value);
+                if (separator == raw.size())
+                {
+                    break;
+                }
+                first = separator + 1;
+            }
+            if (expected && sorted)
+            {
+                std::sort(expected->begin(), expected->end());
+                expected->erase(std::unique(expected->begin(), expected->end()), expected->end());
+            }
+        }
+
+        EnvMap map = {{std::string(ListSource::key), EnvList{ EnvCfgTypes::longlong_, ',', sorted, "" }}};
+        EnvCfg cfg;
+        bool rejected = false;
+        try
+        {
+            cfg.InitEnv(map);
+        }
+        catch (const EnvException&)
+        {
+            rejected = true;
+        }
+        const std::optional<EnvListView<long long>> list = rejected ? std::nullopt : cfg.GetListN<long long>(ListSource::key);
+        const bool same = raw.empty() ? !rejected && !list
+            : expected ? list && std::equal(list->begin(), list->end(), expected->begin(), expected->end()) : rejected;
+        if (!same)
+        {
+            auto describe = [](const long long* first, const long long* last) {
+                std::string text = std::to_string(last - first) + " elements";
+                for (; first != last; ++first)
+                {
+                    text += " " + std::to_string(*first);
+                }
+                return text;
+            };
+            Report("list", raw, rejected ? "rejected" : list ? describe(list->begin(), list->end()) : "no value",
+                expected ? describe(expected->data(), expected->data() + expected->size()) : raw.empty() ? "no value" : "rejected");
+        }
+    }
+
+    void RunOne(const std::uint8_t* data, std::size_t size)
+    {
+        if (size == 0)
+        {
+            return;
+        }
+        const std::string_view raw(reinterpret_cast<const char*>(data + 1), size - 1);
+        switch (data[0] % 12)
+        {
+        case 0:
+            Check<int>("int", raw, ParseWithStd<int>(raw));
+            break;
+        case 1:
+            Check<long long>("long long", raw, ParseWithStd<long long>(raw));
+            break;
+        case 2:
+            Check<double>("double", raw, ParseWithStd<double>(raw));
+            break;
+        case 3:
+            Check<float>("float", raw, ParseWithStd<float>(raw));
+            break;
+        case 4:
+            Check<bool>("bool", raw, ParseBoolReference(raw));
+            break;
+        case 5:
+            Check<std::int16_t>("int16_t", raw, ParseSizedWithStd<std::int16_t>(raw));
+            break;
+        case 6:
+            Check<std::uint16_t>("uint16_t", raw, ParseSizedWithStd<std::uint16_t>(raw));
+            break;
+        case 7:
+            Check<std::uint32_t>("uint32_t", raw, ParseSizedWithStd<std::uint32_t>(raw));
+            break;
+        case 8:
+            Check<std::uint64_t>("uint64_t", raw, ParseSizedWithStd<std::uint64_t>(raw));
+            break;
+        case 9:
+            CheckRoundTrip<std::chrono::nanoseconds, long long>("duration", raw, detail::DurationToChars);
+            break;
+        case 10:
+            CheckRoundTrip<EnvBytes, std::uint64_t>("bytes", raw, detail::BytesToChars);
+            break;
+        default:
+            CheckList(raw, (data[0] / 12) % 2 == 1);
+            break;
+        }
+    }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t* data, std::size_t size)
+{
+    RunOne(data, size);
+    return 0;
+}
+
+#if defined(CPPLIBENV_FUZZ_STANDALONE)
+// Random inputs built from the fragments the parsers branch on, for compilers without libFuzzer.
+static std::string Generate(std::mt19937_64& random)
+{
+    static const char* fragments[] = { "0", "1", "7", "9", "42", "2147483647", "2147483648", "9223372036854775807",
+        "9223372036854775808", "18446744073709551616", "00000000000000000", "123456789012345678", "-", "+", " ", "\t",
+        "\n", "\v", ".", "e", "E", "e-", "e+", "x", "0x", "0X", "p", "p-", "a", "f", "F", "inf", "INF", "infinity", "nan",
+        "nan(0x1)", "true", "TRUE", "tRuE", "false", "yes", "YES", "no", "No", "1e308", "1e309", "1e-320", "3.4e38",
+        "1e39", "1.17549435e-38", "1e-46", "kg", "_", "\x00", "\xff", "\x11", "32767", "-32768", "65535", "65536",
+        "4294967295", "4294967296", "18446744073709551615", "ns", "us", "ms", "s", "m", "min", "h", "d", "B", "k", "KiB", "Ki",
+        "MB", "gib", "E", "EiB", "16", ",", ", ", ",," };
+    std::string raw(1, static_cast<char>(random() % 24));
+    const std::size_t count = random() % 6;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const char* fragment = fragments[random() % (sizeof(fragments) / sizeof(fragments[0]))];
+        raw.append(fragment, std::max<std::size_t>(1, std::strlen(fragment)));
+    }
+    if (random() % 8 == 0)
+    {
+        raw.push_back(static_cast<char>(random() % 256));
+    }
+    return raw;
+}
+
+int main(int argc, char** argv)
+{
+    std::uint64_t runs = 1000000;
+    std::uint64_t seed = 1;
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--runs" && i + 1 < argc)
+        {
+            runs = std::stoull(argv[++i]);
+        }
+        else if (arg == "--seed" && i + 1 < argc)
+        {
+            seed = std::stoull(argv[++i]);
+        }
+        else
+        {
+            files.push_back(arg);
+        }
+    }
+    for (const std::string& file : files)
+    {
+        std::ifstream in(file, std::ios::binary);
+        const std::string input((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        RunOne(reinterpret_cast<const std::uint8_t*>(input.data()), input.size());
+    }
+    if (files.empty())
+    {
+        std::mt19937_64 random(seed);
+        for (std::uint64_t run = 0; run < runs; ++run)
+        {
+            const std::string input = Generate(random);
+            RunOne(reinterpret_cast<const std::uint8_t*>(input.data()), input.size());
+        }
+    }
+    std::cout << "parse_fuzz: " << (files.empty() ? runs : files.size()) << " inputs, no mismatch" << std::endl;
+    return 0;
+}
+#endif
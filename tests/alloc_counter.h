@@ -0,0 +1,111 @@
+#pragma once
+
+// Replaces the global allocation functions to count heap allocations.
+// Include into exactly one translation unit of a test binary.
+//
+// The replacements are kept out of line: inlined into a caller, GCC pairs the `free` of a
+// `delete` with the `operator new` of the same pointer and reports -Wmismatched-new-delete.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<std::size_t> g_allocations{0};
+
+#if defined(__GNUC__)
+#define LIBENV_TEST_NOINLINE __attribute__((noinline))
+#else
+#define LIBENV_TEST_NOINLINE
+#endif
+
+LIBENV_TEST_NOINLINE static void* CountedAlloc(std::size_t size, std::size_t alignment) noexcept
+{
+    ++g_allocations;
+    if (alignment <= alignof(std::max_align_t))
+    {
+        return std::malloc(size ? size : 1);
+    }
+    // aligned_alloc requires a size which is a multiple of the alignment.
+    return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+LIBENV_TEST_NOINLINE void* operator new(std::size_t size)
+{
+    if (void* ptr = CountedAlloc(size, alignof(std::max_align_t)))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+LIBENV_TEST_NOINLINE void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+LIBENV_TEST_NOINLINE void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return CountedAlloc(size, alignof(std::max_align_t));
+}
+
+LIBENV_TEST_NOINLINE void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return CountedAlloc(size, alignof(std::max_align_t));
+}
+
+LIBENV_TEST_NOINLINE void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    if (void* ptr = CountedAlloc(size, static_cast<std::size_t>(alignment)))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+LIBENV_TEST_NOINLINE void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+LIBENV_TEST_NOINLINE void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+LIBENV_TEST_NOINLINE void operator delete[](void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+LIBENV_TEST_NOINLINE void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+LIBENV_TEST_NOINLINE void operator delete[](void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+LIBENV_TEST_NOINLINE void operator delete(void* ptr, std::align_val_t) noexcept
+{
+    std::free(ptr);
+}
+
+LIBENV_TEST_NOINLINE void operator delete[](void* ptr, std::align_val_t) noexcept
+{
+    std::free(ptr);
+}
+
+LIBENV_TEST_NOINLINE void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept
+{
+    std::free(ptr);
+}
+
+LIBENV_TEST_NOINLINE void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept
+{
+    std::free(ptr);
+}
+
+#undef LIBENV_TEST_NOINLINE
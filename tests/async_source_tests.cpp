@@ -0,0 +1,232 @@
+#include "../cpp-envlib/libenv.h"
+#include <gtest/gtest.h>
+#include <map>
+#include <thread>
+
+using namespace env_cfg;
+using namespace std::chrono_literals;
+
+// Source backed by a std::map, as a custom EnvSource would be.
+class MapSource : public EnvSource {
+public:
+    explicit MapSource(std::map<std::string, std::string, std::less<>> values) : m_values(std::move(values)) {}
+
+    std::string_view Find(std::string_view env_name) const noexcept override
+    {
+        auto it = m_values.find(env_name);
+        return it == m_values.end() ? std::string_view() : std::string_view(it->second);
+    }
+
+    void ForEach(const std::function<void(std::string_view, std::string_view)>& f) const override
+    {
+        for (const auto& [name, value] : m_values)
+        {
+            f(name, value);
+        }
+    }
+
+private:
+    std::map<std::string, std::string, std::less<>> m_values;
+};
+
+class EnvCfgAsyncSourceTest : public ::testing::Test {
+protected:
+    void SetUp() override
+    {
+        EnvCfg::SetEnv("TEST_ASYNC_SHARED", "from_env");
+        unsetenv("TEST_ASYNC_PORT");
+        unsetenv("TEST_ASYNC_HOSTS");
+        unsetenv("TEST_ASYNC_TENANT_1_QUOTA");
+        map = {
+            {"TEST_ASYNC_SHARED", EnvCfgTypes::string_},
+            {"TEST_ASYNC_PORT", 80},
+            {"TEST_ASYNC_HOSTS", EnvList{ EnvCfgTypes::string_, ',', false, "" }}
+        };
+    }
+
+    void TearDown() override
+    {
+        EnvCfg::DetachSource();
+        for (std::thread& thread : m_io)
+        {
+            thread.join();
+        }
+    }
+
+    // Fetcher answering from another thread after `delay`, recording the batched requests.
+    EnvAsyncSource::Fetcher Remote(std::chrono::milliseconds delay)
+    {
+        return [this, delay](std::vector<std::string> keys, EnvAsyncSource::Completion done) {
+            requests.push_back(keys);
+            m_io.emplace_back([keys, done, delay]() {
+                std::this_thread::sleep_for(delay);
+                EnvAsyncSource::Values values;
+                for (const std::string& key : keys)
+                {
+                    if (key == "TEST_ASYNC_PORT")
+                    {
+                        values.emplace_back(key, "8080");
+                    }
+                    else if (key == "TEST_ASYNC_HOSTS")
+                    {
+                        values.emplace_back(key, "a,b");
+                    }
+                    else if (key == "TEST_ASYNC_SHARED")
+                    {
+                        values.emplace_back(key, "from_remote");
+                    }
+                }
+                done(std::move(values));
+            });
+        };
+    }
+
+    EnvMap map;
+    EnvCfg env;
+    std::vector<std::vector<std::string>> requests;
+
+private:
+    std::vector<std::thread> m_io;
+};
+
+TEST_F(EnvCfgAsyncSourceTest, CustomSourceWithPrecedence)
+{
+    auto source = std::make_shared<MapSource>(std::map<std::string, std::string, std::less<>>{
+        {"TEST_ASYNC_SHARED", "from_source"}, {"TEST_ASYNC_PORT", "9000"}, {"TEST_ASYNC_TENANT_1_QUOTA", "5"}});
+    EnvCfg::AttachSource(source);
+    env.InitEnv(map);
+    EXPECT_EQ(env.Get<std::string>("TEST_ASYNC_SHARED"), "from_env");
+    EXPECT_EQ(env.Get<int>("TEST_ASYNC_PORT"), 9000);
+    EXPECT_EQ(EnvCfg::GetW<int>("TEST_ASYNC_PORT").default_value(0), 9000);
+
+    EnvCfg::AttachSource(source, EnvPrecedence::source_);
+    EnvMap patterns = {{"TEST_ASYNC_*", EnvCfgTypes::string_}};
+    EnvCfg scanned;
+    scanned.InitEnv(patterns);
+    EXPECT_EQ(scanned.Get<std::string>("TEST_ASYNC_SHARED"), "from_source");
+    EXPECT_EQ(scanned.Get<std::string>("TEST_ASYNC_TENANT_1_QUOTA"), "5");
+
+    EnvCfg::AttachSource(std::make_shared<EnvSnapshot>(), EnvPrecedence::source_);
+    EnvCfg::SetEnv("TEST_ASYNC_SHARED", "changed");
+    EnvCfg frozen;
+    frozen.InitEnv(map);
+    EXPECT_EQ(frozen.Get<std::string>("TEST_ASYNC_SHARED"), "from_env");
+
+    EnvCfg::DetachSource();
+    EnvCfg live;
+    live.InitEnv(map);
+    EXPECT_EQ(live.Get<std::string>("TEST_ASYNC_SHARED"), "changed");
+    EXPECT_THROW(EnvCfg::AttachSource(nullptr), EnvException);
+}
+
+TEST_F(EnvCfgAsyncSourceTest, OverlapsFetchWithStartup)
+{
+    const auto start = std::chrono::steady_clock::now();
+    auto remote = std::make_shared<EnvAsyncSource>(EnvAsyncSource::Keys(map), Remote(100ms));
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 50ms);
+    EXPECT_FALSE(remote->Ready());
+    EXPECT_FALSE(remote->WaitFor(1ms));
+
+    ASSERT_EQ(requests.size(), 1u);
+    EXPECT_EQ(requests[0].size(), 3u);
+
+    EnvCfg::AttachSource(remote, EnvPrecedence::source_);
+    env.InitEnv(map);
+    EXPECT_TRUE(remote->Ready());
+    EXPECT_GE(std::chrono::steady_clock::now() - start, 100ms);
+    EXPECT_EQ(env.Get<int>("TEST_ASYNC_PORT"), 8080);
+    EXPECT_EQ(env.Get<std::string>("TEST_ASYNC_SHARED"), "from_remote");
+    EXPECT_EQ(env.GetList<std::string_view>("TEST_ASYNC_HOSTS").size(), 2u);
+    EXPECT_EQ(remote->Find("TEST_ASYNC_UNKNOWN").data(), nullptr);
+
+    EnvCfg::AttachSource(remote);
+    env.Refresh();
+    EXPECT_EQ(env.Get<std::string>("TEST_ASYNC_SHARED"), "from_env");
+    EXPECT_EQ(env.Get<int>("TEST_ASYNC_PORT"), 8080);
+}
+
+TEST_F(EnvCfgAsyncSourceTest, LazyReadsWaitForTheFetch)
+{
+    auto remote = std::make_shared<EnvAsyncSource>(EnvAsyncSource::Keys(map), Remote(50ms));
+    EnvCfg::AttachSource(remote);
+    std::size_t seen = 0;
+    remote->ForEach([&seen](std::string_view, std::string_view) {
+        ++seen;
+    });
+    EXPECT_EQ(seen, 3u);
+
+    auto slow = std::make_shared<EnvAsyncSource>(EnvAsyncSource::Keys(map), Remote(50ms));
+    EnvCfg::AttachSource(slow);
+    EXPECT_EQ(slow->Find("TEST_ASYNC_PORT"), "8080");
+    EXPECT_EQ(EnvCfg::GetW<int>("TEST_ASYNC_PORT").default_value(0), 8080);
+}
+
+TEST_F(EnvCfgAsyncSourceTest, DirectReadsWaitOutsideTheReadSection)
+{
+    auto remote = std::make_shared<EnvAsyncSource>(EnvAsyncSource::Keys(map), Remote(200ms));
+    EnvCfg::AttachSource(remote);
+    std::thread reader([] {
+        EXPECT_EQ(EnvCfg::TryGetEnv<int>("TEST_ASYNC_PORT").value(), 8080);
+    });
+    std::this_thread::sleep_for(50ms);
+    // The blocked reader holds no read section, so a retired object is reclaimed right away.
+    bool reclaimed = false;
+    detail::EpochDomain::Instance().Retire(&reclaimed, [](void* flag) noexcept {
+        *static_cast<bool*>(flag) = true;
+    });
+    EXPECT_FALSE(remote->Ready());
+    EXPECT_TRUE(reclaimed);
+    reader.join();
+}
+
+TEST_F(EnvCfgAsyncSourceTest, FailedAndAbandonedFetches)
+{
+    auto failed = std::make_shared<EnvAsyncSource>(EnvAsyncSource::Keys(map), [](std::vector<std::string>, EnvAsyncSource::Completion done) {
+        done.Fail(std::make_exception_ptr(EnvException("store unavailable")));
+        done({{"TEST_ASYNC_PORT", "1"}});
+    });
+    EXPECT_TRUE(failed->Ready());
+    EXPECT_EQ(failed->Find("TEST_ASYNC_PORT").data(), nullptr);
+    EnvCfg::AttachSource(failed);
+    EXPECT_THROW(env.InitEnv(map), EnvException);
+    EXPECT_THROW(env.Refresh(), EnvException);
+    EXPECT_TRUE(env.Empty());
+    // Direct reads report the failed fetch instead of a missing variable.
+    EXPECT_THROW(EnvCfg::GetW<int>("TEST_ASYNC_PORT"), EnvException);
+    EXPECT_EQ(EnvCfg::TryGetEnv<int>("TEST_ASYNC_PORT").error(), EnvErrc::source_unavailable);
+
+    auto abandoned = std::make_shared<EnvAsyncSource>(std::vector<std::string>{"TEST_ASYNC_PORT"}, [](std::vector<std::string>, EnvAsyncSource::Completion) {});
+    EXPECT_TRUE(abandoned->Ready());
+    EXPECT_THROW(abandoned->Wait(), EnvException);
+
+    EXPECT_THROW(EnvAsyncSource({}, [](std::vector<std::string>, EnvAsyncSource::Completion) {
+        throw std::runtime_error("no connection");
+    }), std::runtime_error);
+    EXPECT_THROW(EnvAsyncSource({}, EnvAsyncSource::Fetcher()), EnvException);
+
+    auto repeated = std::make_shared<EnvAsyncSource>(std::vector<std::string>{}, [](std::vector<std::string>, EnvAsyncSource::Completion done) {
+        done({{"TEST_ASYNC_PORT", "1"}, {"TEST_ASYNC_PORT", "2"}});
+    });
+    EXPECT_EQ(repeated->Find("TEST_ASYNC_PORT"), "2");
+    EXPECT_NO_THROW(repeated->Wait());
+}
+
+class ExceptionListener : public testing::EmptyTestEventListener {
+    public:
+        void OnTestPartResult(const testing::TestPartResult& result) override
+        {
+            if (result.fatally_failed()) {
+                std::cout << "[Unhandled Exception] "<< result.message() << std::endl;
+            }
+        }
+    };
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    testing::TestEventListeners& listeners =
+        testing::UnitTest::GetInstance()->listeners();
+    listeners.Append(new ExceptionListener);
+
+    return RUN_ALL_TESTS();
+}
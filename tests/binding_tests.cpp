@@ -0,0 +1,128 @@
+#include "../cpp-envlib/libenv.h"
+#include <gtest/gtest.h>
+
+using namespace env_cfg;
+
+struct ServerConfig
+{
+    int port = 0;
+    std::string host;
+    bool debug = false;
+    double ratio = 0.0;
+    long long limit = -1;
+};
+
+class EnvCfgBindingTest : public ::testing::Test {
+protected:
+    void SetUp() override 
+    {
+        EnvCfg::SetEnvN("TEST_BIND_PORT", "", true);
+        EnvCfg::SetEnvN("TEST_BIND_HOST", "", true);
+        EnvCfg::SetEnvN("TEST_BIND_DEBUG", "", true);
+        EnvCfg::SetEnvN("TEST_BIND_RATIO", "", true);
+        EnvCfg::SetEnvN("TEST_BIND_LIMIT", "", true);
+    }
+
+    static EnvBinding<ServerConfig> MakeBinding()
+    {
+        return EnvBinding<ServerConfig>()
+            .Field("TEST_BIND_PORT", &ServerConfig::port)
+            .Field("TEST_BIND_HOST", &ServerConfig::host, "localhost")
+            .Field("TEST_BIND_DEBUG", &ServerConfig::debug, false)
+            .Field("TEST_BIND_RATIO", &ServerConfig::ratio, 1)
+            .Field("TEST_BIND_LIMIT", &ServerConfig::limit);
+    }
+
+    EnvCfg env;
+};
+
+TEST_F(EnvCfgBindingTest, FillsStructFromEnvironmentAndDefaults) 
+{
+    EnvCfg::SetEnv("TEST_BIND_PORT", "8080");
+    EnvCfg::SetEnv("TEST_BIND_DEBUG", "true");
+    EnvCfg::SetEnv("TEST_BIND_LIMIT", "5000000000");
+
+    const EnvBinding<ServerConfig> binding = MakeBinding();
+    EXPECT_EQ(binding.size(), 5u);
+    ServerConfig config;
+    env.InitEnv(binding, config);
+
+    EXPECT_EQ(config.port, 8080);
+    EXPECT_EQ(config.host, "localhost");
+    EXPECT_TRUE(config.debug);
+    EXPECT_DOUBLE_EQ(config.ratio, 1.0);
+    EXPECT_EQ(config.limit, 5000000000LL);
+
+    EXPECT_EQ(env.Get<int>("TEST_BIND_PORT"), 8080);
+    EXPECT_EQ(env.Get<std::string>("TEST_BIND_HOST"), "localhost");
+}
+
+TEST_F(EnvCfgBindingTest, KeepsMembersWithoutValue) 
+{
+    ServerConfig config;
+    config.port = 99;
+    env.InitEnv(MakeBinding(), config);
+
+    EXPECT_EQ(config.port, 99);
+    EXPECT_EQ(config.limit, -1);
+    EXPECT_FALSE(env.HasValue("TEST_BIND_PORT"));
+}
+
+TEST_F(EnvCfgBindingTest, ParseErrorIsThrown) 
+{
+    EnvCfg::SetEnv("TEST_BIND_HOST", "example.org");
+    EnvCfg::SetEnv("TEST_BIND_DEBUG", "not_a_bool");
+    ServerConfig config;
+    EXPECT_THROW(env.InitEnv(MakeBinding(), config), EnvBadGet);
+    EXPECT_EQ(config.host, "example.org");
+}
+
+struct PackedConfig
+{
+    bool verbose = false;
+    std::int16_t offset = 0;
+    bool color = true;
+    std::uint16_t port = 0;
+    std::chrono::milliseconds timeout{0};
+};
+
+TEST_F(EnvCfgBindingTest, FillsNarrowMembers) 
+{
+    EnvCfg::SetEnv("TEST_BIND_PORT", "65535");
+    EnvCfg::SetEnv("TEST_BIND_DEBUG", "yes");
+    EnvCfg::SetEnv("TEST_BIND_LIMIT", "-300");
+    const auto binding = EnvBinding<PackedConfig>()
+        .Field("TEST_BIND_DEBUG", &PackedConfig::verbose)
+        .Field("TEST_BIND_LIMIT", &PackedConfig::offset)
+        .Field("TEST_BIND_HOST", &PackedConfig::color, false)
+        .Field("TEST_BIND_PORT", &PackedConfig::port)
+        .Field("TEST_BIND_RATIO", &PackedConfig::timeout, std::chrono::seconds(2));
+
+    PackedConfig config;
+    env.InitEnv(binding, config);
+    EXPECT_TRUE(config.verbose);
+    EXPECT_EQ(config.offset, -300);
+    EXPECT_FALSE(config.color);
+    EXPECT_EQ(config.port, 65535);
+    EXPECT_EQ(config.timeout, std::chrono::milliseconds(2000));
+}
+
+class ExceptionListener : public testing::EmptyTestEventListener {
+    public:
+        void OnTestPartResult(const testing::TestPartResult& result) override 
+        {
+            if (result.fatally_failed()) {
+                std::cout << "[Unhandled Exception] "<< result.message() << std::endl;
+            }
+        }
+    };
+
+int main(int argc, char **argv) 
+{
+    testing::InitGoogleTest(&argc, argv);
+    testing::TestEventListeners& listeners = 
+        testing::UnitTest::GetInstance()->listeners();
+    listeners.Append(new ExceptionListener);
+    
+    return RUN_ALL_TESTS();
+}
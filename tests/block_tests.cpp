@@ -0,0 +1,165 @@
+#include "../cpp-envlib/libenv.h"
+#include <gtest/gtest.h>
+#include <map>
+#include <spawn.h>
+#include <sys/wait.h>
+
+using namespace env_cfg;
+
+class EnvBlockTest : public ::testing::Test {
+protected:
+    void SetUp() override
+    {
+        EnvCfg::SetEnv("TEST_BLOCK_PARENT", "parent");
+        unsetenv("TEST_BLOCK_CHILD");
+    }
+
+    void TearDown() override
+    {
+        EnvCfg::DisableOverlay();
+    }
+
+    static std::vector<std::string> Entries(EnvBlock& block)
+    {
+        std::vector<std::string> entries;
+        for (char* const* env = block.envp(); *env; ++env)
+        {
+            entries.emplace_back(*env);
+        }
+        return entries;
+    }
+};
+
+TEST_F(EnvBlockTest, SetReplacesInPlace)
+{
+    EnvBlock block;
+    block.Set("TEST_BLOCK_A", "1");
+    block.Set("TEST_BLOCK_B", "2");
+    block.Set("TEST_BLOCK_A", "3");
+    EXPECT_EQ(Entries(block), (std::vector<std::string>{"TEST_BLOCK_A=3", "TEST_BLOCK_B=2"}));
+    EXPECT_EQ(block.size(), 2u);
+    EXPECT_EQ(block.Find("TEST_BLOCK_A"), "3");
+    EXPECT_EQ(block.Find("TEST_BLOCK_C").data(), nullptr);
+    block.Set("TEST_BLOCK_C", "");
+    EXPECT_EQ(block.Find("TEST_BLOCK_C"), "");
+    EXPECT_NE(block.Find("TEST_BLOCK_C").data(), nullptr);
+
+    EXPECT_THROW(block.Set("", "x"), EnvSetError);
+    EXPECT_THROW(block.Set("TEST=BLOCK", "x"), EnvSetError);
+
+    std::vector<std::pair<std::string, std::string>> invalid = {{"TEST_BLOCK_D", "4"}, {"BAD=NAME", "5"}};
+    EXPECT_THROW(block.SetAll(invalid), EnvSetError);
+    EXPECT_EQ(block.Find("TEST_BLOCK_D").data(), nullptr);
+    EXPECT_EQ(block.size(), 3u);
+}
+
+TEST_F(EnvBlockTest, BatchOverMaterializedEnvironment)
+{
+    EnvBlock block;
+    EnvCfg::MaterializeEnv(block);
+    const std::size_t inherited = block.size();
+    EXPECT_EQ(block.Find("TEST_BLOCK_PARENT"), "parent");
+
+    std::map<std::string, std::string> job;
+    for (int i = 0; i < 300; ++i)
+    {
+        job.emplace("TEST_BLOCK_JOB_" + std::to_string(i), std::to_string(i));
+    }
+    job["TEST_BLOCK_PARENT"] = "child";
+    block.SetAll(job);
+    EXPECT_EQ(block.size(), inherited + 300);
+    EXPECT_EQ(block.Find("TEST_BLOCK_PARENT"), "child");
+    EXPECT_EQ(block.Find("TEST_BLOCK_JOB_299"), "299");
+    EXPECT_STREQ(std::getenv("TEST_BLOCK_PARENT"), "parent");
+    EXPECT_EQ(std::getenv("TEST_BLOCK_JOB_0"), nullptr);
+
+    // Refilling reuses the buffer: the second round keeps the same number of entries.
+    EnvCfg::MaterializeEnv(block);
+    EXPECT_EQ(block.size(), inherited);
+    EXPECT_EQ(block.Find("TEST_BLOCK_PARENT"), "parent");
+    EXPECT_EQ(block.Find("TEST_BLOCK_JOB_0").data(), nullptr);
+
+    EnvCfg::EnableOverlay();
+    EnvCfg::SetEnv("TEST_BLOCK_PARENT", "overlay");
+    EnvCfg::MaterializeEnv(block);
+    EXPECT_EQ(block.Find("TEST_BLOCK_PARENT"), "overlay");
+}
+
+TEST_F(EnvBlockTest, SetAllFromCfg)
+{
+    EnvCfg::SetEnv("TEST_BLOCK_PORT", "8080");
+    EnvCfg::SetEnv("TEST_BLOCK_RATIO", "0.5");
+    EnvMap map = {
+        {"TEST_BLOCK_PORT", EnvCfgTypes::int_},
+        {"TEST_BLOCK_RATIO", EnvCfgTypes::double_},
+        {"TEST_BLOCK_TIMEOUT", std::chrono::nanoseconds(std::chrono::minutes(90))},
+        {"TEST_BLOCK_NAME", std::string("svc")},
+        {"TEST_BLOCK_ENABLED", true},
+        {"TEST_BLOCK_MISSING", EnvCfgTypes::string_}
+    };
+    EnvCfg env;
+    env.InitEnv(map);
+    EnvBlock block;
+    block.SetAll(env);
+    EXPECT_EQ(block.size(), 5u);
+    EXPECT_EQ(block.Find("TEST_BLOCK_PORT"), "8080");
+    EXPECT_EQ(block.Find("TEST_BLOCK_RATIO"), "0.5");
+    EXPECT_EQ(block.Find("TEST_BLOCK_TIMEOUT"), "90m");
+    EXPECT_EQ(block.Find("TEST_BLOCK_NAME"), "svc");
+    EXPECT_EQ(block.Find("TEST_BLOCK_ENABLED"), "true");
+    EXPECT_EQ(block.Find("TEST_BLOCK_MISSING").data(), nullptr);
+    unsetenv("TEST_BLOCK_PORT");
+    unsetenv("TEST_BLOCK_RATIO");
+}
+
+TEST_F(EnvBlockTest, PoolReusesBlocksForSpawn)
+{
+    EnvBlockPool pool;
+    const EnvBlock* first = nullptr;
+    {
+        auto block = pool.Acquire();
+        first = &*block;
+        EnvCfg::MaterializeEnv(*block);
+        block->Set("TEST_BLOCK_CHILD", "spawned");
+
+        char* const argv[] = { const_cast<char*>("/bin/sh"), const_cast<char*>("-c"), const_cast<char*>("test \"$TEST_BLOCK_CHILD\" = spawned"), nullptr };
+        pid_t pid = 0;
+        ASSERT_EQ(posix_spawn(&pid, "/bin/sh", nullptr, nullptr, argv, block->envp()), 0);
+        int status = 0;
+        ASSERT_EQ(waitpid(pid, &status, 0), pid);
+        EXPECT_TRUE(WIFEXITED(status));
+        EXPECT_EQ(WEXITSTATUS(status), 0);
+    }
+    EXPECT_EQ(pool.idle(), 1u);
+    EXPECT_EQ(std::getenv("TEST_BLOCK_CHILD"), nullptr);
+
+    auto reused = pool.Acquire();
+    EXPECT_EQ(&*reused, first);
+    EXPECT_EQ(reused->size(), 0u);
+    EXPECT_EQ(reused->Find("TEST_BLOCK_CHILD").data(), nullptr);
+    auto other = pool.Acquire();
+    EXPECT_NE(&*other, first);
+    EXPECT_EQ(pool.idle(), 0u);
+    auto moved = std::move(other);
+    EXPECT_EQ(moved->size(), 0u);
+}
+
+class ExceptionListener : public testing::EmptyTestEventListener {
+    public:
+        void OnTestPartResult(const testing::TestPartResult& result) override
+        {
+            if (result.fatally_failed()) {
+                std::cout << "[Unhandled Exception] "<< result.message() << std::endl;
+            }
+        }
+    };
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    testing::TestEventListeners& listeners =
+        testing::UnitTest::GetInstance()->listeners();
+    listeners.Append(new ExceptionListener);
+
+    return RUN_ALL_TESTS();
+}
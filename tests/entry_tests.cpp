@@ -0,0 +1,181 @@
+#include "../cpp-envlib/libenv.h"
+#include "alloc_counter.h"
+#include <gtest/gtest.h>
+#include <map>
+#include <string_view>
+
+using namespace env_cfg;
+
+class EnvCfgEntryTest : public ::testing::Test {
+protected:
+    void SetUp() override 
+    {
+        EnvCfg::SetEnv("TEST_ENTRY_INT", "42");
+        EnvCfg::SetEnv("TEST_ENTRY_STR", "hello");
+        EnvMap map = {
+            {"TEST_ENTRY_INT", EnvCfgTypes::int_},
+            {"TEST_ENTRY_STR", EnvCfgTypes::string_},
+            {"TEST_ENTRY_DOUBLE", 0.5},
+            {"TEST_ENTRY_LONG", 1234567890123LL},
+            {"TEST_ENTRY_BOOL", true},
+            {"TEST_ENTRY_MISSING", EnvCfgTypes::double_}
+        };
+        env.InitEnv(map);
+    }
+
+    static std::string Text(const EnvCfg::EnvValueRef& value)
+    {
+        char buffer[64];
+        auto [end, ec] = value.ToChars(buffer, buffer + sizeof(buffer));
+        EXPECT_EQ(ec, std::errc());
+        return std::string(buffer, end);
+    }
+
+    EnvCfg env;
+};
+
+TEST_F(EnvCfgEntryTest, EntriesYieldKeysAndTypedValues) 
+{
+    std::map<std::string, std::string> text;
+    std::size_t count = 0;
+    for (const auto& [key, value] : env.Entries())
+    {
+        text[std::string(key)] = Text(value);
+        ++count;
+    }
+    EXPECT_EQ(count, 6u);
+    EXPECT_EQ(text["TEST_ENTRY_INT"], "42");
+    EXPECT_EQ(text["TEST_ENTRY_STR"], "hello");
+    EXPECT_EQ(text["TEST_ENTRY_DOUBLE"], "0.5");
+    EXPECT_EQ(text["TEST_ENTRY_LONG"], "1234567890123");
+    EXPECT_EQ(text["TEST_ENTRY_BOOL"], "true");
+    EXPECT_EQ(text["TEST_ENTRY_MISSING"], "nullopt");
+}
+
+TEST_F(EnvCfgEntryTest, ValueRefAccessors) 
+{
+    for (const auto& [key, value] : env.Entries())
+    {
+        if (key == "TEST_ENTRY_INT")
+        {
+            EXPECT_EQ(value.type(), EnvCfgTypes::int_);
+            EXPECT_EQ(value.GetN<int>(), 42);
+            EXPECT_FALSE(value.GetN<double>());
+        }
+        else if (key == "TEST_ENTRY_STR")
+        {
+            EXPECT_EQ(value.GetN<std::string_view>(), "hello");
+            EXPECT_EQ(value.GetN<std::string>(), "hello");
+        }
+        else if (key == "TEST_ENTRY_MISSING")
+        {
+            EXPECT_EQ(value.type(), EnvCfgTypes::double_);
+            EXPECT_FALSE(value.has_value());
+            EXPECT_TRUE(value.Visit([](auto v) { return std::is_same_v<decltype(v), std::nullopt_t>; }));
+        }
+    }
+}
+
+TEST_F(EnvCfgEntryTest, ToCharsReportsSmallBuffer) 
+{
+    for (const auto& [key, value] : env.Entries())
+    {
+        if (key == "TEST_ENTRY_STR")
+        {
+            char buffer[3];
+            EXPECT_EQ(value.ToChars(buffer, buffer + sizeof(buffer)).ec, std::errc::value_too_large);
+        }
+    }
+}
+
+TEST_F(EnvCfgEntryTest, IterationDoesNotAllocate) 
+{
+    char buffer[64];
+    std::size_t total = 0;
+    const std::size_t before = g_allocations.load();
+    for (const auto& [key, value] : env.Entries())
+    {
+        total += key.size();
+        total += static_cast<std::size_t>(value.ToChars(buffer, buffer + sizeof(buffer)).ptr - buffer);
+    }
+    EXPECT_EQ(g_allocations.load(), before);
+    EXPECT_GT(total, 0u);
+}
+
+TEST_F(EnvCfgEntryTest, LazyEntriesResolveOnDereference) 
+{
+    EnvMap map = {{"TEST_ENTRY_INT", EnvCfgTypes::int_}};
+    EnvInitOptions options;
+    options.lazy = true;
+    EnvCfg lazy;
+    lazy.InitEnv(map, options);
+    for (const auto& [key, value] : lazy.Entries())
+    {
+        EXPECT_EQ(key, "TEST_ENTRY_INT");
+        EXPECT_EQ(value.GetN<int>(), 42);
+    }
+}
+
+TEST_F(EnvCfgEntryTest, GetViewDoesNotAllocate) 
+{
+    const std::string long_value(100, 'x');
+    EnvCfg::SetEnv("TEST_ENTRY_STR", long_value);
+    EnvMap map = {{"TEST_ENTRY_STR", EnvCfgTypes::string_}};
+    env.InitEnv(map);
+    EnvKey<std::string> key = env.Key<std::string>("TEST_ENTRY_STR");
+
+    const std::size_t before = g_allocations.load();
+    EXPECT_EQ(env.GetView("TEST_ENTRY_STR"), long_value);
+    EXPECT_EQ(env.GetViewN("TEST_ENTRY_STR"), std::string_view(long_value));
+    EXPECT_EQ(env.GetView(key), long_value);
+    EXPECT_EQ(env.GetViewN(key), std::string_view(long_value));
+    EXPECT_FALSE(env.GetViewN("TEST_ENTRY_INT"));
+    EXPECT_FALSE(env.GetViewN("TEST_ENTRY_UNKNOWN"));
+    EXPECT_EQ(g_allocations.load(), before);
+
+    EXPECT_THROW(env.GetView("TEST_ENTRY_INT"), EnvBadGet);
+    EXPECT_THROW(env.GetView("TEST_ENTRY_UNKNOWN"), EnvBadGet);
+    EXPECT_THROW(env.GetView("TEST_ENTRY_MISSING"), EnvBadGet);
+}
+
+TEST_F(EnvCfgEntryTest, EqualStringsAreInterned) 
+{
+    EnvMap map;
+    for (int i = 0; i < 64; ++i)
+    {
+        map.emplace("TEST_ENTRY_REGION_" + std::to_string(i), std::string("eu-central-1-availability-zone-a"));
+    }
+    EnvCfg regions;
+    regions.InitEnv(map);
+
+    const std::string_view first = regions.GetView("TEST_ENTRY_REGION_0");
+    for (int i = 1; i < 64; ++i)
+    {
+        const std::string_view value = regions.GetView("TEST_ENTRY_REGION_" + std::to_string(i));
+        EXPECT_EQ(value, "eu-central-1-availability-zone-a");
+        EXPECT_EQ(value.data(), first.data());
+    }
+
+    EnvCfg copy = regions;
+    EXPECT_EQ(copy.GetView("TEST_ENTRY_REGION_63"), "eu-central-1-availability-zone-a");
+}
+
+class ExceptionListener : public testing::EmptyTestEventListener {
+    public:
+        void OnTestPartResult(const testing::TestPartResult& result) override 
+        {
+            if (result.fatally_failed()) {
+                std::cout << "[Unhandled Exception] "<< result.message() << std::endl;
+            }
+        }
+    };
+
+int main(int argc, char **argv) 
+{
+    testing::InitGoogleTest(&argc, argv);
+    testing::TestEventListeners& listeners = 
+        testing::UnitTest::GetInstance()->listeners();
+    listeners.Append(new ExceptionListener);
+    
+    return RUN_ALL_TESTS();
+}
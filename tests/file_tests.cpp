@@ -0,0 +1,153 @@
+#include "../cpp-envlib/libenv.h"
+#include <gtest/gtest.h>
+#include <fstream>
+
+using namespace env_cfg;
+
+class EnvCfgFileTest : public ::testing::Test {
+protected:
+    void SetUp() override 
+    {
+        EnvCfg::SetEnvN("TEST_FILE_SHARED", "", true);
+        unsetenv("TEST_FILE_ONLY");
+        char path[] = "/tmp/libenv_file_testXXXXXX";
+        const int fd = mkstemp(path);
+        ASSERT_GE(fd, 0);
+        close(fd);
+        m_path = path;
+    }
+
+    void TearDown() override 
+    {
+        EnvCfg::DetachFile();
+        std::remove(m_path.c_str());
+    }
+
+    void Write(const std::string& content)
+    {
+        std::ofstream out(m_path, std::ios::binary | std::ios::trunc);
+        out << content;
+    }
+
+    std::string m_path;
+    EnvCfg env;
+};
+
+TEST_F(EnvCfgFileTest, ParsesDotEnvSyntax) 
+{
+    Write("# comment\n"
+          "\n"
+          "PLAIN=value\n"
+          "  SPACED = padded value   \n"
+          "export EXPORTED=1\n"
+          "QUOTED=\"a # not a comment\"\n"
+          "SINGLE='x=y'\n"
+          "QUOTED_COMMENT=\"quoted\" # c\n"
+          "SINGLE_COMMENT='x' #c\n"
+          "ESCAPED=\"a\\\"b\"\n"
+          "UNTERMINATED=\"open\n"
+          "COMMENTED=42 # trailing comment\n"
+          "EMPTY=\n"
+          "CRLF=windows\r\n"
+          "no separator line\n"
+          "=no_name\n"
+          "PLAIN=override");
+    EnvFileSource source(m_path);
+
+    EXPECT_EQ(source.size(), 12u);
+    EXPECT_EQ(source.Find("PLAIN"), "override");
+    EXPECT_EQ(source.Find("SPACED"), "padded value");
+    EXPECT_EQ(source.Find("EXPORTED"), "1");
+    EXPECT_EQ(source.Find("QUOTED"), "a # not a comment");
+    EXPECT_EQ(source.Find("SINGLE"), "x=y");
+    EXPECT_EQ(source.Find("QUOTED_COMMENT"), "quoted");
+    EXPECT_EQ(source.Find("SINGLE_COMMENT"), "x");
+    // Escapes and multi-line values are not supported, the text is taken verbatim.
+    EXPECT_EQ(source.Find("ESCAPED"), "a\\\"b");
+    EXPECT_EQ(source.Find("UNTERMINATED"), "\"open");
+    EXPECT_EQ(source.Find("COMMENTED"), "42");
+    EXPECT_EQ(source.Find("CRLF"), "windows");
+    EXPECT_NE(source.Find("EMPTY").data(), nullptr);
+    EXPECT_TRUE(source.Find("EMPTY").empty());
+    EXPECT_EQ(source.Find("MISSING").data(), nullptr);
+}
+
+TEST_F(EnvCfgFileTest, EmptyFileAndMissingFile) 
+{
+    EnvFileSource source(m_path);
+    EXPECT_EQ(source.size(), 0u);
+    EXPECT_EQ(source.Find("ANY").data(), nullptr);
+    EXPECT_THROW(EnvFileSource("/nonexistent/libenv.env"), EnvException);
+}
+
+TEST_F(EnvCfgFileTest, EnvironmentTakesPrecedenceByDefault) 
+{
+    Write("TEST_FILE_SHARED=from_file\nTEST_FILE_ONLY=17\n");
+    EnvCfg::SetEnv("TEST_FILE_SHARED", "from_env");
+    EnvCfg::AttachFile(std::make_shared<EnvFileSource>(m_path));
+
+    EnvMap map = {{"TEST_FILE_SHARED", EnvCfgTypes::string_}, {"TEST_FILE_ONLY", EnvCfgTypes::int_}};
+    env.InitEnv(map);
+    EXPECT_EQ(env.Get<std::string>("TEST_FILE_SHARED"), "from_env");
+    EXPECT_EQ(env.Get<int>("TEST_FILE_ONLY"), 17);
+    EXPECT_EQ(EnvCfg::GetW<int>("TEST_FILE_ONLY").default_value(0), 17);
+
+    EnvCfg::DetachFile();
+    EXPECT_FALSE(EnvCfg::TryGetEnv<int>("TEST_FILE_ONLY"));
+}
+
+TEST_F(EnvCfgFileTest, FileTakesPrecedenceWhenRequested) 
+{
+    Write("TEST_FILE_SHARED=from_file\n");
+    EnvCfg::SetEnv("TEST_FILE_SHARED", "from_env");
+    EnvCfg::AttachFile(std::make_shared<EnvFileSource>(m_path), EnvPrecedence::file_);
+    EXPECT_EQ(EnvCfg::GetW<std::string>("TEST_FILE_SHARED").default_value(""), "from_file");
+
+    EnvCfg::EnableOverlay();
+    EnvCfg::SetEnv("TEST_FILE_OVERLAY", "overlay");
+    EXPECT_EQ(EnvCfg::GetW<std::string>("TEST_FILE_SHARED").default_value(""), "from_file");
+    EXPECT_EQ(EnvCfg::GetW<std::string>("TEST_FILE_OVERLAY").default_value(""), "overlay");
+    EnvCfg::DisableOverlay();
+}
+
+TEST_F(EnvCfgFileTest, IndexesLargeFiles) 
+{
+    std::string content;
+    for (int i = 0; i < 20000; ++i)
+    {
+        content += "TENANT_" + std::to_string(i) + "=" + std::to_string(i * 2) + "\n";
+    }
+    Write(content);
+    EnvCfg::AttachFile(std::make_shared<EnvFileSource>(m_path));
+
+    EnvMap map;
+    for (int i = 0; i < 20000; i += 97)
+    {
+        map.emplace("TENANT_" + std::to_string(i), EnvCfgTypes::int_);
+    }
+    env.InitEnv(map);
+    for (int i = 0; i < 20000; i += 97)
+    {
+        EXPECT_EQ(env.Get<int>("TENANT_" + std::to_string(i)), i * 2);
+    }
+}
+
+class ExceptionListener : public testing::EmptyTestEventListener {
+    public:
+        void OnTestPartResult(const testing::TestPartResult& result) override 
+        {
+            if (result.fatally_failed()) {
+                std::cout << "[Unhandled Exception] "<< result.message() << std::endl;
+            }
+        }
+    };
+
+int main(int argc, char **argv) 
+{
+    testing::InitGoogleTest(&argc, argv);
+    testing::TestEventListeners& listeners = 
+        testing::UnitTest::GetInstance()->listeners();
+    listeners.Append(new ExceptionListener);
+    
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,296 @@
+#include "../cpp-envlib/libenv.h"
+#include <gtest/gtest.h>
+#include <map>
+#include <thread>
+
+using namespace env_cfg;
+
+class EnvCfgInitTest : public ::testing::Test {
+protected:
+    static constexpr int count = 4000;
+
+    static void SetUpTestSuite() 
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            EnvCfg::SetEnv("TEST_INIT_" + std::to_string(i), std::to_string(i * 3));
+        }
+    }
+
+    static EnvMap MakeMap()
+    {
+        EnvMap map;
+        for (int i = 0; i < count; ++i)
+        {
+            if (i % 4 == 0)
+            {
+                map.emplace("TEST_INIT_" + std::to_string(i), EnvCfgTypes::int_);
+            }
+            else if (i % 4 == 1)
+            {
+                map.emplace("TEST_INIT_" + std::to_string(i), EnvCfgTypes::string_);
+            }
+            else if (i % 4 == 2)
+            {
+                map.emplace("TEST_INIT_" + std::to_string(i), 1LL);
+            }
+            else
+            {
+                map.emplace("TEST_INIT_MISSING_" + std::to_string(i), 2.5);
+            }
+        }
+        return map;
+    }
+
+    static std::map<std::string, std::string> Dump(const EnvCfg& cfg)
+    {
+        std::map<std::string, std::string> result;
+        for (const auto& [k, v] : cfg)
+        {
+            result[k] = v;
+        }
+        return result;
+    }
+};
+
+TEST_F(EnvCfgInitTest, ParallelMatchesSequential) 
+{
+    EnvMap map = MakeMap();
+    EnvCfg sequential;
+    sequential.InitEnv(map);
+
+    EnvInitOptions options;
+    options.threads = 8;
+    options.min_entries_per_thread = 16;
+    EnvCfg parallel;
+    parallel.InitEnv(map, options);
+
+    EXPECT_EQ(Dump(parallel), Dump(sequential));
+    EXPECT_EQ(parallel.Get<int>("TEST_INIT_8"), 24);
+    EXPECT_EQ(parallel.Get<std::string>("TEST_INIT_9"), "27");
+    EXPECT_EQ(parallel.Get<long long>("TEST_INIT_10"), 30LL);
+    EXPECT_DOUBLE_EQ(parallel.Get<double>("TEST_INIT_MISSING_11"), 2.5);
+}
+
+TEST_F(EnvCfgInitTest, ParallelKeepsExceptionSemantics) 
+{
+    EnvMap map = MakeMap();
+    map.insert_or_assign("TEST_INIT_BAD_1", EnvCfgTypes::bool_);
+    map.insert_or_assign("TEST_INIT_BAD_2", EnvCfgTypes::bool_);
+    EnvCfg::SetEnv("TEST_INIT_BAD_1", "not_a_bool_1");
+    EnvCfg::SetEnv("TEST_INIT_BAD_2", "not_a_bool_2");
+
+    EnvCfg sequential;
+    std::string sequential_error;
+    try
+    {
+        sequential.InitEnv(map);
+    }
+    catch (const EnvBadGet& e)
+    {
+        sequential_error = e.what();
+    }
+
+    EnvInitOptions options;
+    options.threads = 8;
+    options.min_entries_per_thread = 16;
+    EnvCfg parallel;
+    std::string parallel_error;
+    try
+    {
+        parallel.InitEnv(map, options);
+    }
+    catch (const EnvBadGet& e)
+    {
+        parallel_error = e.what();
+    }
+
+    EXPECT_FALSE(sequential_error.empty());
+    EXPECT_EQ(parallel_error, sequential_error);
+    EXPECT_EQ(Dump(parallel), Dump(sequential));
+}
+
+TEST_F(EnvCfgInitTest, SmallMapFallsBackToSequential) 
+{
+    EnvMap map = {{"TEST_INIT_1", EnvCfgTypes::int_}};
+    EnvInitOptions options;
+    options.threads = 4;
+    EnvCfg env;
+    env.InitEnv(map, options);
+
+    EXPECT_EQ(env.Get<int>("TEST_INIT_1"), 3);
+}
+
+TEST_F(EnvCfgInitTest, LazyMatchesEager) 
+{
+    EnvMap map = MakeMap();
+    EnvCfg eager;
+    eager.InitEnv(map);
+
+    EnvInitOptions options;
+    options.lazy = true;
+    EnvCfg lazy;
+    lazy.InitEnv(map, options);
+
+    EXPECT_EQ(lazy.Get<int>("TEST_INIT_8"), 24);
+    EXPECT_EQ(lazy.GetN<std::string>("TEST_INIT_9"), "27");
+    EXPECT_TRUE(lazy.IsType<long long>("TEST_INIT_10"));
+    EXPECT_TRUE(lazy.HasValue("TEST_INIT_MISSING_11"));
+    EXPECT_EQ(lazy.Get(lazy.Key<double>("TEST_INIT_MISSING_11")), 2.5);
+    EXPECT_EQ(Dump(lazy), Dump(eager));
+
+    EnvCfg copy = lazy;
+    EXPECT_EQ(Dump(copy), Dump(eager));
+}
+
+TEST_F(EnvCfgInitTest, LazyResolvesOnFirstRead) 
+{
+    EnvCfg::SetEnv("TEST_INIT_LAZY", "1");
+    EnvMap map = {{"TEST_INIT_LAZY", EnvCfgTypes::int_}, {"TEST_INIT_LAZY_BAD", EnvCfgTypes::bool_}};
+    EnvInitOptions options;
+    options.lazy = true;
+    EnvCfg env;
+    env.InitEnv(map, options);
+
+    EnvCfg::SetEnv("TEST_INIT_LAZY", "2");
+    EnvCfg::SetEnv("TEST_INIT_LAZY_BAD", "not_a_bool");
+    EXPECT_EQ(env.Get<int>("TEST_INIT_LAZY"), 2);
+    EnvCfg::SetEnv("TEST_INIT_LAZY", "3");
+    EXPECT_EQ(env.Get<int>("TEST_INIT_LAZY"), 2);
+
+    EXPECT_THROW(env.Get<bool>("TEST_INIT_LAZY_BAD"), EnvBadGet);
+    EXPECT_THROW(env.Get<bool>("TEST_INIT_LAZY_BAD"), EnvBadGet);
+    EXPECT_FALSE(env.GetN<bool>("TEST_INIT_LAZY_BAD"));
+    EXPECT_FALSE(env.HasValue("TEST_INIT_LAZY_BAD"));
+
+    EnvCfg::SetEnv("TEST_INIT_LAZY_BAD", "true");
+    env.InitEnv(map);
+    EXPECT_EQ(env.Get<int>("TEST_INIT_LAZY"), 3);
+    EXPECT_TRUE(env.Get<bool>("TEST_INIT_LAZY_BAD"));
+}
+
+TEST_F(EnvCfgInitTest, LazyConcurrentFirstReads) 
+{
+    EnvInitOptions options;
+    options.lazy = true;
+    EnvMap map = MakeMap();
+    EnvCfg env;
+    env.InitEnv(map, options);
+
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t)
+    {
+        readers.emplace_back([&env] {
+            for (int i = 0; i < count; i += 4)
+            {
+                EXPECT_EQ(env.Get<int>("TEST_INIT_" + std::to_string(i)), i * 3);
+                EXPECT_EQ(env.Get<std::string>("TEST_INIT_" + std::to_string(i + 1)), std::to_string((i + 1) * 3));
+            }
+        });
+    }
+    for (std::thread& reader : readers)
+    {
+        reader.join();
+    }
+}
+
+TEST_F(EnvCfgInitTest, RefreshReportsChangedKeys) 
+{
+    EnvCfg::SetEnv("TEST_INIT_REFRESH_INT", "1");
+    EnvCfg::SetEnv("TEST_INIT_REFRESH_STRING", "before");
+    unsetenv("TEST_INIT_REFRESH_DEFAULT");
+    EnvMap map = MakeMap();
+    map.emplace("TEST_INIT_REFRESH_INT", EnvCfgTypes::int_);
+    map.emplace("TEST_INIT_REFRESH_STRING", EnvCfgTypes::string_);
+    map.emplace("TEST_INIT_REFRESH_DEFAULT", std::string("fallback"));
+    EnvCfg env;
+    env.InitEnv(map);
+    EXPECT_TRUE(env.Refresh().empty());
+
+    EnvCfg::SetEnv("TEST_INIT_REFRESH_INT", "2");
+    EnvCfg::SetEnv("TEST_INIT_REFRESH_STRING", "after");
+    EnvCfg::SetEnv("TEST_INIT_REFRESH_DEFAULT", "set");
+    std::vector<std::string_view> changed = env.Refresh();
+    std::sort(changed.begin(), changed.end());
+    EXPECT_EQ(changed, (std::vector<std::string_view>{"TEST_INIT_REFRESH_DEFAULT", "TEST_INIT_REFRESH_INT", "TEST_INIT_REFRESH_STRING"}));
+    EXPECT_EQ(env.Get<int>("TEST_INIT_REFRESH_INT"), 2);
+    EXPECT_EQ(env.Get<std::string>("TEST_INIT_REFRESH_STRING"), "after");
+    EXPECT_EQ(env.Get<std::string>("TEST_INIT_REFRESH_DEFAULT"), "set");
+    EXPECT_TRUE(env.Refresh().empty());
+
+    unsetenv("TEST_INIT_REFRESH_DEFAULT");
+    unsetenv("TEST_INIT_REFRESH_STRING");
+    EXPECT_EQ(env.Refresh().size(), 2u);
+    EXPECT_EQ(env.Get<std::string>("TEST_INIT_REFRESH_DEFAULT"), "fallback");
+    EXPECT_FALSE(env.HasValue("TEST_INIT_REFRESH_STRING"));
+
+    EnvCfg fresh;
+    fresh.InitEnv(map);
+    EXPECT_EQ(Dump(env), Dump(fresh));
+}
+
+TEST_F(EnvCfgInitTest, RefreshKeepsConfigurationOnError) 
+{
+    EnvCfg::SetEnv("TEST_INIT_REFRESH_A", "1");
+    EnvCfg::SetEnv("TEST_INIT_REFRESH_B", "2");
+    EnvMap map = {{"TEST_INIT_REFRESH_A", EnvCfgTypes::int_}, {"TEST_INIT_REFRESH_B", EnvCfgTypes::int_}};
+    EnvCfg env;
+    env.InitEnv(map);
+
+    EnvCfg::SetEnv("TEST_INIT_REFRESH_A", "10");
+    EnvCfg::SetEnv("TEST_INIT_REFRESH_B", "bad");
+    EXPECT_THROW(env.Refresh(), EnvBadGet);
+    EXPECT_EQ(env.Get<int>("TEST_INIT_REFRESH_A"), 1);
+    EXPECT_EQ(env.Get<int>("TEST_INIT_REFRESH_B"), 2);
+
+    EnvCfg::SetEnv("TEST_INIT_REFRESH_B", "20");
+    EXPECT_EQ(env.Refresh().size(), 2u);
+    EXPECT_EQ(env.Get<int>("TEST_INIT_REFRESH_A"), 10);
+    EXPECT_EQ(env.Get<int>("TEST_INIT_REFRESH_B"), 20);
+}
+
+TEST_F(EnvCfgInitTest, RefreshResetsReadLazyKeys) 
+{
+    EnvCfg::SetEnv("TEST_INIT_REFRESH_READ", "1");
+    EnvCfg::SetEnv("TEST_INIT_REFRESH_UNREAD", "1");
+    EnvCfg::SetEnv("TEST_INIT_REFRESH_BAD", "bad");
+    EnvMap map = {{"TEST_INIT_REFRESH_READ", EnvCfgTypes::int_}, {"TEST_INIT_REFRESH_UNREAD", EnvCfgTypes::int_},
+        {"TEST_INIT_REFRESH_BAD", EnvCfgTypes::int_}};
+    EnvInitOptions options;
+    options.lazy = true;
+    EnvCfg env;
+    env.InitEnv(map, options);
+    EXPECT_EQ(env.Get<int>("TEST_INIT_REFRESH_READ"), 1);
+    EXPECT_THROW(env.Get<int>("TEST_INIT_REFRESH_BAD"), EnvBadGet);
+    EXPECT_TRUE(env.Refresh().empty());
+
+    EnvCfg::SetEnv("TEST_INIT_REFRESH_READ", "2");
+    EnvCfg::SetEnv("TEST_INIT_REFRESH_UNREAD", "2");
+    EnvCfg::SetEnv("TEST_INIT_REFRESH_BAD", "3");
+    std::vector<std::string_view> changed = env.Refresh();
+    std::sort(changed.begin(), changed.end());
+    EXPECT_EQ(changed, (std::vector<std::string_view>{"TEST_INIT_REFRESH_BAD", "TEST_INIT_REFRESH_READ"}));
+    EXPECT_EQ(env.Get<int>("TEST_INIT_REFRESH_READ"), 2);
+    EXPECT_EQ(env.Get<int>("TEST_INIT_REFRESH_UNREAD"), 2);
+    EXPECT_EQ(env.Get<int>("TEST_INIT_REFRESH_BAD"), 3);
+}
+
+class ExceptionListener : public testing::EmptyTestEventListener {
+    public:
+        void OnTestPartResult(const testing::TestPartResult& result) override 
+        {
+            if (result.fatally_failed()) {
+                std::cout << "[Unhandled Exception] "<< result.message() << std::endl;
+            }
+        }
+    };
+
+int main(int argc, char **argv) 
+{
+    testing::InitGoogleTest(&argc, argv);
+    testing::TestEventListeners& listeners = 
+        testing::UnitTest::GetInstance()->listeners();
+    listeners.Append(new ExceptionListener);
+    
+    return RUN_ALL_TESTS();
+}
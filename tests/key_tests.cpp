@@ -0,0 +1,180 @@
+#include "../cpp-envlib/libenv.h"
+#include "alloc_counter.h"
+#include <gtest/gtest.h>
+#include <map>
+#include <string_view>
+
+using namespace env_cfg;
+
+class EnvCfgKeyTest : public ::testing::Test {
+protected:
+    void SetUp() override 
+    {
+        EnvCfg::SetEnvN("TEST_KEY_INT", "", true);
+        EnvCfg::SetEnvN("TEST_KEY_STR", "", true);
+    }
+
+    EnvCfg env;
+};
+
+TEST_F(EnvCfgKeyTest, HandleReadsInitializedValue) 
+{
+    EnvCfg::SetEnv("TEST_KEY_INT", "8080");
+    EnvMap map = {{"TEST_KEY_INT", EnvCfgTypes::int_}, {"TEST_KEY_STR", "localhost"}};
+    env.InitEnv(map);
+
+    EnvKey<int> port = env.Key<int>("TEST_KEY_INT");
+    EnvKey<std::string> host = env.Key<std::string>("TEST_KEY_STR");
+
+    EXPECT_EQ(env.Get(port), 8080);
+    EXPECT_EQ(env.GetN(port).value(), 8080);
+    EXPECT_TRUE(env.HasValue(port));
+    EXPECT_EQ(env.Get(host), "localhost");
+}
+
+TEST_F(EnvCfgKeyTest, HandleRejectsUnknownKeyAndTypeMismatch) 
+{
+    EnvMap map = {{"TEST_KEY_INT", 42}};
+    env.InitEnv(map);
+
+    EXPECT_THROW(env.Key<int>("MISSING_KEY"), EnvBadGet);
+    EXPECT_THROW(env.Key<double>("TEST_KEY_INT"), EnvBadGet);
+}
+
+TEST_F(EnvCfgKeyTest, HandleOnEmptyValue) 
+{
+    EnvMap map = {{"TEST_KEY_INT", EnvCfgTypes::int_}};
+    env.InitEnv(map);
+
+    EnvKey<int> key = env.Key<int>("TEST_KEY_INT");
+    EXPECT_FALSE(env.HasValue(key));
+    EXPECT_FALSE(env.GetN(key).has_value());
+    EXPECT_THROW(env.Get(key), EnvBadGet);
+}
+
+TEST_F(EnvCfgKeyTest, HandleFromLargerCfgIsNotFound)
+{
+    EnvMap map = {{"TEST_KEY_INT", 1}, {"TEST_KEY_STR", "localhost"}};
+    env.InitEnv(map);
+    EnvKey<int> key = env.Key<int>("TEST_KEY_INT");
+    EnvKey<std::string> host = env.Key<std::string>("TEST_KEY_STR");
+
+    EnvCfg empty;
+    EXPECT_THROW(empty.Get(key), EnvBadGet);
+    EXPECT_FALSE(empty.GetN(key).has_value());
+    EXPECT_FALSE(empty.HasValue(key));
+    EXPECT_THROW(empty.GetView(host), EnvBadGet);
+    EXPECT_FALSE(empty.GetViewN(host).has_value());
+
+    EnvCfg failed;
+    EnvCfg::SetEnv("TEST_KEY_INT", "broken");
+    EnvMap broken = {{"TEST_KEY_INT", EnvCfgTypes::int_}};
+    EXPECT_THROW(failed.InitEnv(broken), EnvBadGet);
+    EXPECT_FALSE(failed.GetN(key).has_value());
+}
+
+TEST_F(EnvCfgKeyTest, HandleSurvivesReinit) 
+{
+    EnvMap map = {{"TEST_KEY_INT", 1}};
+    env.InitEnv(map);
+    EnvKey<int> key = env.Key<int>("TEST_KEY_INT");
+
+    EnvMap more = {{"OTHER_KEY_1", 2}, {"OTHER_KEY_2", 3}, {"TEST_KEY_INT", 4}};
+    env.InitEnv(more);
+
+    EXPECT_EQ(env.Get(key), 4);
+    EXPECT_EQ(env.Get<int>("OTHER_KEY_2"), 3);
+}
+
+TEST_F(EnvCfgKeyTest, StringViewLookup) 
+{
+    EnvMap map = {{"TEST_KEY_INT", 7}, {"TEST_KEY_STR", "value"}};
+    env.InitEnv(map);
+
+    std::string request = "key=TEST_KEY_INT;";
+    std::string_view key = std::string_view(request).substr(4, 12);
+
+    EXPECT_EQ(env.Get<int>(key), 7);
+    EXPECT_EQ(env.GetN<int>(key).value(), 7);
+    EXPECT_TRUE(env.IsType<int>(key));
+    EXPECT_TRUE(env.HasValue(key));
+    EXPECT_FALSE(env.HasValue(std::string_view(request).substr(4, 11)));
+}
+
+TEST_F(EnvCfgKeyTest, LookupDoesNotAllocate) 
+{
+    EnvMap map = {{"TEST_KEY_INT", 7}, {"A_RATHER_LONG_KEY_NAME_BEYOND_SSO", true}};
+    env.InitEnv(map);
+    EnvKey<int> handle = env.Key<int>("TEST_KEY_INT");
+
+    const std::size_t before = g_allocations.load();
+    int sum = env.Get<int>("TEST_KEY_INT") + env.GetN<int>(std::string_view("TEST_KEY_INT")).value() + env.Get(handle);
+    bool flag = env.Get<bool>("A_RATHER_LONG_KEY_NAME_BEYOND_SSO");
+    bool has = env.HasValue("A_RATHER_LONG_KEY_NAME_BEYOND_SSO") && env.IsType<bool>("A_RATHER_LONG_KEY_NAME_BEYOND_SSO");
+    bool missing = env.HasValue("MISSING_KEY_WITH_A_LONG_NAME_TOO");
+    const std::size_t after = g_allocations.load();
+
+    EXPECT_EQ(sum, 21);
+    EXPECT_TRUE(flag);
+    EXPECT_TRUE(has);
+    EXPECT_FALSE(missing);
+    EXPECT_EQ(after, before);
+}
+
+TEST_F(EnvCfgKeyTest, ManyKeysStayReachable) 
+{
+    EnvMap map;
+    for (int i = 0; i < 1000; ++i)
+    {
+        map.emplace("TEST_MANY_" + std::to_string(i), i);
+    }
+    env.InitEnv(map);
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        EXPECT_EQ(env.Get<int>("TEST_MANY_" + std::to_string(i)), i);
+    }
+    EXPECT_FALSE(env.HasValue("TEST_MANY_1000"));
+}
+
+TEST_F(EnvCfgKeyTest, ReinitReplacesStringValues) 
+{
+    EnvCfg::SetEnv("TEST_KEY_STR", "first value which does not fit into SSO");
+    EnvMap map = {{"TEST_KEY_STR", EnvCfgTypes::string_}, {"TEST_KEY_INT", 5}};
+    env.InitEnv(map);
+    EXPECT_EQ(env.Get<std::string>("TEST_KEY_STR"), "first value which does not fit into SSO");
+
+    EnvCfg::SetEnv("TEST_KEY_STR", "second");
+    env.InitEnv(map);
+    EXPECT_EQ(env.Get<std::string>("TEST_KEY_STR"), "second");
+    EXPECT_EQ(env.Get<int>("TEST_KEY_INT"), 5);
+
+    std::map<std::string, std::string> seen;
+    for (const auto& [k, v] : env)
+    {
+        seen[k] = v;
+    }
+    EXPECT_EQ(seen.size(), 2u);
+    EXPECT_EQ(seen["TEST_KEY_STR"], "second");
+    EXPECT_EQ(seen["TEST_KEY_INT"], "5");
+}
+
+class ExceptionListener : public testing::EmptyTestEventListener {
+    public:
+        void OnTestPartResult(const testing::TestPartResult& result) override 
+        {
+            if (result.fatally_failed()) {
+                std::cout << "[Unhandled Exception] "<< result.message() << std::endl;
+            }
+        }
+    };
+
+int main(int argc, char **argv) 
+{
+    testing::InitGoogleTest(&argc, argv);
+    testing::TestEventListeners& listeners = 
+        testing::UnitTest::GetInstance()->listeners();
+    listeners.Append(new ExceptionListener);
+    
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,168 @@
+#include "../cpp-envlib/libenv.h"
+#include <gtest/gtest.h>
+#include <fstream>
+
+using namespace env_cfg;
+
+class EnvCfgLayeredTest : public ::testing::Test {
+protected:
+    void SetUp() override
+    {
+        EnvCfg::SetEnv("TEST_LAYERED_HOST", "env.local");
+        unsetenv("TEST_LAYERED_PORT");
+        unsetenv("TEST_LAYERED_LEVEL");
+        unsetenv("TEST_LAYERED_HOSTS");
+        map = {
+            {"TEST_LAYERED_HOST", std::string("default.local")},
+            {"TEST_LAYERED_PORT", 80},
+            {"TEST_LAYERED_LEVEL", EnvCfgTypes::string_},
+            {"TEST_LAYERED_HOSTS", EnvList{ EnvCfgTypes::string_, ',', false, "" }}
+        };
+    }
+
+    void TearDown() override
+    {
+        EnvCfg::DisableOverlay();
+        for (const std::string& path : m_paths)
+        {
+            std::remove(path.c_str());
+        }
+    }
+
+    std::shared_ptr<EnvFileSource> File(const std::string& content)
+    {
+        char path[] = "/tmp/libenv_layered_testXXXXXX";
+        const int fd = mkstemp(path);
+        EXPECT_GE(fd, 0);
+        close(fd);
+        std::ofstream(path, std::ios::binary | std::ios::trunc) << content;
+        m_paths.emplace_back(path);
+        return std::make_shared<EnvFileSource>(path);
+    }
+
+    EnvMap map;
+
+private:
+    std::vector<std::string> m_paths;
+};
+
+TEST_F(EnvCfgLayeredTest, LayersResolveInOrder)
+{
+    EnvLayeredCfg layered(map);
+    EXPECT_EQ(layered.Get<std::string>("TEST_LAYERED_HOST"), "env.local");
+    EXPECT_EQ(layered.Get<int>("TEST_LAYERED_PORT"), 80);
+    EXPECT_FALSE(layered.HasValue("TEST_LAYERED_LEVEL"));
+
+    std::vector<std::string_view> changed = layered.SetLayer(EnvLayer::file_, File("TEST_LAYERED_HOST=file.local\nTEST_LAYERED_PORT=8080\nTEST_LAYERED_LEVEL=info\n"));
+    EXPECT_EQ(changed.size(), 2u);
+    EXPECT_EQ(layered.Get<std::string>("TEST_LAYERED_HOST"), "env.local");
+    EXPECT_EQ(layered.Get<int>("TEST_LAYERED_PORT"), 8080);
+    EXPECT_EQ(layered.Get<std::string>("TEST_LAYERED_LEVEL"), "info");
+
+    changed = layered.SetOverride("TEST_LAYERED_PORT", "9090");
+    ASSERT_EQ(changed.size(), 1u);
+    EXPECT_EQ(changed[0], "TEST_LAYERED_PORT");
+    EXPECT_EQ(layered.Get<int>("TEST_LAYERED_PORT"), 9090);
+    EXPECT_EQ(layered.SetOverride("TEST_LAYERED_PORT", "9090").size(), 0u);
+    layered.SetOverride("TEST_LAYERED_HOST", "override.local");
+    EXPECT_EQ(layered.Get<std::string>("TEST_LAYERED_HOST"), "override.local");
+
+    layered.ClearOverride("TEST_LAYERED_HOST");
+    EXPECT_EQ(layered.Get<std::string>("TEST_LAYERED_HOST"), "env.local");
+    EXPECT_TRUE(layered.ClearOverride("TEST_LAYERED_UNKNOWN").empty());
+
+    layered.RemoveLayer(EnvLayer::environment_);
+    EXPECT_EQ(layered.Get<std::string>("TEST_LAYERED_HOST"), "file.local");
+    layered.RemoveLayer(EnvLayer::file_);
+    EXPECT_EQ(layered.Get<std::string>("TEST_LAYERED_HOST"), "default.local");
+    EXPECT_EQ(layered.Get<int>("TEST_LAYERED_PORT"), 9090);
+    EXPECT_FALSE(layered.HasValue("TEST_LAYERED_LEVEL"));
+
+    layered.ClearOverride("TEST_LAYERED_PORT");
+    EXPECT_EQ(layered.Get<int>("TEST_LAYERED_PORT"), 80);
+    layered.SetLayer(EnvLayer::environment_, EnvLayeredCfg::Environment());
+    EXPECT_EQ(layered.Get<std::string>("TEST_LAYERED_HOST"), "env.local");
+}
+
+TEST_F(EnvCfgLayeredTest, EmptyOverrideAndLists)
+{
+    EnvLayeredCfg layered(map);
+    layered.SetLayer(EnvLayer::file_, File("TEST_LAYERED_HOSTS=a,b,c\n"));
+    EXPECT_EQ(layered.Cfg().GetList<std::string_view>("TEST_LAYERED_HOSTS").size(), 3u);
+    layered.SetOverride("TEST_LAYERED_HOSTS", "x");
+    EXPECT_EQ(layered.Cfg().GetList<std::string_view>("TEST_LAYERED_HOSTS").size(), 1u);
+
+    // An empty override shadows the layers below and falls back to the default.
+    layered.SetOverride("TEST_LAYERED_HOST", "");
+    EXPECT_EQ(layered.Get<std::string>("TEST_LAYERED_HOST"), "default.local");
+}
+
+TEST_F(EnvCfgLayeredTest, FailedChangeKeepsConfiguration)
+{
+    EnvLayeredCfg layered(map);
+    layered.SetOverride("TEST_LAYERED_PORT", "81");
+    EXPECT_THROW(layered.SetOverride("TEST_LAYERED_PORT", "not a port"), EnvBadGet);
+    EXPECT_EQ(layered.Get<int>("TEST_LAYERED_PORT"), 81);
+    // Shadowed by the override, the invalid value of the file is not parsed until the override goes away.
+    layered.SetLayer(EnvLayer::file_, File("TEST_LAYERED_PORT=nope\n"));
+    EXPECT_THROW(layered.ClearOverride("TEST_LAYERED_PORT"), EnvBadGet);
+    EXPECT_EQ(layered.Get<int>("TEST_LAYERED_PORT"), 81);
+    layered.RemoveLayer(EnvLayer::file_);
+    layered.ClearOverride("TEST_LAYERED_PORT");
+    EXPECT_EQ(layered.Get<int>("TEST_LAYERED_PORT"), 80);
+    EXPECT_THROW(layered.SetLayer(EnvLayer::file_, File("TEST_LAYERED_PORT=nope\n")), EnvBadGet);
+    EXPECT_EQ(layered.Get<int>("TEST_LAYERED_PORT"), 80);
+
+    EXPECT_THROW(layered.SetLayer(EnvLayer::file_, nullptr), EnvException);
+    EnvMap patterns = {{"TEST_LAYERED_*", EnvCfgTypes::string_}};
+    EXPECT_THROW(EnvLayeredCfg{ patterns }, EnvException);
+    EnvMap invalid = {{"TEST_LAYERED_HOST", EnvCfgTypes::int_}};
+    EXPECT_THROW(EnvLayeredCfg{ invalid }, EnvBadGet);
+}
+
+TEST_F(EnvCfgLayeredTest, RefreshFollowsEnvironmentAndOverlay)
+{
+    EnvLayeredCfg layered(map);
+    layered.SetLayer(EnvLayer::file_, File("TEST_LAYERED_PORT=8080\n"));
+    EXPECT_TRUE(layered.Refresh().empty());
+
+    EnvCfg::SetEnv("TEST_LAYERED_PORT", "7070");
+    EnvCfg::SetEnv("TEST_LAYERED_HOST", "changed.local");
+    EXPECT_EQ(layered.Refresh().size(), 2u);
+    EXPECT_EQ(layered.Get<int>("TEST_LAYERED_PORT"), 7070);
+    EXPECT_EQ(layered.Get<std::string>("TEST_LAYERED_HOST"), "changed.local");
+
+    EnvCfg::EnableOverlay();
+    EnvCfg::SetEnv("TEST_LAYERED_PORT", "6060");
+    layered.Refresh();
+    EXPECT_EQ(layered.Get<int>("TEST_LAYERED_PORT"), 6060);
+    EXPECT_EQ(layered.GetN<int>("TEST_LAYERED_PORT"), 6060);
+    EnvCfg::DisableOverlay();
+    unsetenv("TEST_LAYERED_PORT");
+    layered.Refresh();
+    EXPECT_EQ(layered.Get<int>("TEST_LAYERED_PORT"), 8080);
+
+    EnvCfgHolder holder(map);
+    holder.Publish(std::make_unique<EnvCfg>(layered.Cfg()));
+    EXPECT_EQ(holder.Read()->Get<int>("TEST_LAYERED_PORT"), 8080);
+}
+
+class ExceptionListener : public testing::EmptyTestEventListener {
+    public:
+        void OnTestPartResult(const testing::TestPartResult& result) override
+        {
+            if (result.fatally_failed()) {
+                std::cout << "[Unhandled Exception] "<< result.message() << std::endl;
+            }
+        }
+    };
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    testing::TestEventListeners& listeners =
+        testing::UnitTest::GetInstance()->listeners();
+    listeners.Append(new ExceptionListener);
+
+    return RUN_ALL_TESTS();
+}
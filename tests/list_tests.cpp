@@ -0,0 +1,218 @@
+#include "../cpp-envlib/libenv.h"
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <map>
+
+using namespace env_cfg;
+using namespace std::chrono_literals;
+
+class EnvCfgListTest : public ::testing::Test {
+protected:
+    void SetUp() override
+    {
+        EnvCfg::SetEnv("TEST_LIST_BROKERS", "a:9092, b:9092 ,c:9092");
+        EnvCfg::SetEnv("TEST_LIST_IDS", "7,3,5,3,11");
+        EnvCfg::SetEnv("TEST_LIST_PATHS", "/usr/bin:/bin");
+        EnvCfg::SetEnv("TEST_LIST_TIMEOUTS", "250ms,1s,1m");
+        unsetenv("TEST_LIST_MISSING");
+        map = {
+            {"TEST_LIST_BROKERS", EnvList{ EnvCfgTypes::string_, ',', false, "" }},
+            {"TEST_LIST_IDS", EnvList{ EnvCfgTypes::uint64_, ',', true, "" }},
+            {"TEST_LIST_PATHS", EnvList{ EnvCfgTypes::string_, ':', false, "" }},
+            {"TEST_LIST_TIMEOUTS", EnvList{ EnvCfgTypes::duration_, ',', false, "" }},
+            {"TEST_LIST_MISSING", EnvList{ EnvCfgTypes::int_, ',', false, "1,2" }}
+        };
+    }
+
+    EnvMap map;
+    EnvCfg env;
+};
+
+TEST_F(EnvCfgListTest, SplitsOnceDuringInit)
+{
+    env.InitEnv(map);
+
+    const EnvListView<std::string_view> brokers = env.GetList<std::string_view>("TEST_LIST_BROKERS");
+    ASSERT_EQ(brokers.size(), 3u);
+    EXPECT_EQ(brokers[0], "a:9092");
+    EXPECT_EQ(brokers[1], "b:9092");
+    EXPECT_EQ(brokers[2], "c:9092");
+    EXPECT_EQ(std::vector<std::string_view>(brokers.begin(), brokers.end()),
+        (std::vector<std::string_view>{"a:9092", "b:9092", "c:9092"}));
+    EXPECT_TRUE(brokers.Contains("b:9092"));
+    EXPECT_FALSE(brokers.Contains("d:9092"));
+
+    const EnvListView<std::string_view> paths = env.GetList<std::string_view>("TEST_LIST_PATHS");
+    ASSERT_EQ(paths.size(), 2u);
+    EXPECT_EQ(paths[1], "/bin");
+
+    const EnvListView<std::chrono::nanoseconds> timeouts = env.GetList<std::chrono::nanoseconds>("TEST_LIST_TIMEOUTS");
+    ASSERT_EQ(timeouts.size(), 3u);
+    EXPECT_EQ(timeouts[0], 250ms);
+    EXPECT_EQ(timeouts[2], 1min);
+
+    const EnvListView<int> missing = env.GetList<int>("TEST_LIST_MISSING");
+    EXPECT_EQ(std::vector<int>(missing.begin(), missing.end()), (std::vector<int>{1, 2}));
+    EXPECT_THROW(env.GetView("TEST_LIST_PATHS"), EnvBadGet);
+}
+
+TEST_F(EnvCfgListTest, SortedListIsASet)
+{
+    env.InitEnv(map);
+    const EnvListView<std::uint64_t> ids = env.GetList<std::uint64_t>("TEST_LIST_IDS");
+    EXPECT_TRUE(ids.sorted());
+    EXPECT_EQ(std::vector<std::uint64_t>(ids.begin(), ids.end()), (std::vector<std::uint64_t>{3, 5, 7, 11}));
+    EXPECT_TRUE(ids.Contains(5));
+    EXPECT_TRUE(ids.Contains(11));
+    EXPECT_FALSE(ids.Contains(4));
+    EXPECT_FALSE(ids.Contains(12));
+
+    std::string large;
+    for (int i = 5000; i > 0; --i)
+    {
+        large += std::to_string(i * 2) + ",";
+    }
+    large += "0";
+    EnvCfg::SetEnv("TEST_LIST_IDS", large);
+    env.InitEnv(map);
+    const EnvListView<std::uint64_t> many = env.GetList<std::uint64_t>("TEST_LIST_IDS");
+    EXPECT_EQ(many.size(), 5001u);
+    EXPECT_TRUE(std::is_sorted(many.begin(), many.end()));
+    EXPECT_TRUE(many.Contains(9998));
+    EXPECT_FALSE(many.Contains(9999));
+
+    EnvMap strings = {{"TEST_LIST_BROKERS", EnvList{ EnvCfgTypes::string_, ',', true, "" }}};
+    EnvCfg::SetEnv("TEST_LIST_BROKERS", "c,a,b,a");
+    env.InitEnv(strings);
+    const EnvListView<std::string_view> brokers = env.GetList<std::string_view>("TEST_LIST_BROKERS");
+    EXPECT_EQ(std::vector<std::string_view>(brokers.begin(), brokers.end()), (std::vector<std::string_view>{"a", "b", "c"}));
+    EXPECT_TRUE(brokers.Contains("c"));
+    EXPECT_FALSE(brokers.Contains("d"));
+}
+
+TEST_F(EnvCfgListTest, TypeMismatchAndErrors)
+{
+    env.InitEnv(map);
+    EXPECT_THROW(env.GetList<int>("TEST_LIST_IDS"), EnvBadGet);
+    EXPECT_THROW(env.GetList<int>("TEST_LIST_UNKNOWN"), EnvBadGet);
+    EXPECT_THROW(env.Get<std::string>("TEST_LIST_BROKERS"), EnvBadGet);
+    EXPECT_FALSE(env.GetListN<std::string_view>("TEST_LIST_IDS"));
+    EXPECT_TRUE(env.GetListN<std::uint64_t>("TEST_LIST_IDS"));
+    EXPECT_TRUE(env.HasValue("TEST_LIST_IDS"));
+
+    EnvMap bad = {{"TEST_LIST_IDS", EnvList{ EnvCfgTypes::int16_, ',', false, "" }}};
+    EnvCfg::SetEnv("TEST_LIST_IDS", "1,2,40000");
+    EXPECT_THROW(env.InitEnv(bad), EnvBadGet);
+    EnvCfg::SetEnv("TEST_LIST_IDS", "1,,2");
+    EXPECT_THROW(env.InitEnv(bad), EnvBadGet);
+    EnvCfg::SetEnv("TEST_LIST_IDS", "1,2,");
+    EXPECT_THROW(env.InitEnv(bad), EnvBadGet);
+
+    EnvMap flags = {{"TEST_LIST_IDS", EnvList{ EnvCfgTypes::bool_, ',', false, "" }}};
+    EXPECT_THROW(env.InitEnv(flags), EnvException);
+    EnvMap bare = {{"TEST_LIST_IDS", EnvCfgTypes::list_}};
+    EXPECT_THROW(env.InitEnv(bare), EnvException);
+
+    EnvMap empty = {{"TEST_LIST_MISSING", EnvList{ EnvCfgTypes::int_, ',', false, "" }}};
+    env.InitEnv(empty);
+    EXPECT_FALSE(env.HasValue("TEST_LIST_MISSING"));
+    EXPECT_THROW(env.GetList<int>("TEST_LIST_MISSING"), EnvBadGet);
+    EXPECT_FALSE(env.GetListN<int>("TEST_LIST_MISSING"));
+}
+
+TEST_F(EnvCfgListTest, RefreshIterationAndCopies)
+{
+    env.InitEnv(map);
+    std::map<std::string, std::string> values;
+    for (const auto& [key, value] : env)
+    {
+        values[key] = value;
+    }
+    EXPECT_EQ(values["TEST_LIST_PATHS"], "/usr/bin:/bin");
+    EXPECT_EQ(values["TEST_LIST_MISSING"], "1,2");
+    for (const auto& [key, value] : env.Entries())
+    {
+        EXPECT_EQ(value.type() == EnvCfgTypes::list_, key.rfind("TEST_LIST_", 0) == 0) << key;
+    }
+
+    EnvCfg::SetEnv("TEST_LIST_PATHS", "/opt/bin");
+    EnvCfg::SetEnv("TEST_LIST_MISSING", "9");
+    const std::vector<std::string_view> changed = env.Refresh();
+    EXPECT_EQ(changed.size(), 2u);
+    EXPECT_EQ(env.GetList<std::string_view>("TEST_LIST_PATHS")[0], "/opt/bin");
+    EXPECT_EQ(env.GetList<int>("TEST_LIST_MISSING")[0], 9);
+
+    unsetenv("TEST_LIST_MISSING");
+    env.Refresh();
+    EXPECT_EQ(env.GetList<int>("TEST_LIST_MISSING").size(), 2u);
+
+    EnvCfg copy(env);
+    env.InitEnv(map);
+    EXPECT_EQ(copy.GetList<std::string_view>("TEST_LIST_BROKERS")[2], "c:9092");
+    EXPECT_EQ(copy.GetList<std::uint64_t>("TEST_LIST_IDS").size(), 4u);
+
+    EnvMap scalar = {{"TEST_LIST_PATHS", EnvCfgTypes::string_}};
+    env.InitEnv(scalar);
+    EXPECT_FALSE(env.GetListN<std::string_view>("TEST_LIST_PATHS"));
+    EXPECT_EQ(env.Get<std::string>("TEST_LIST_PATHS"), "/opt/bin");
+}
+
+TEST_F(EnvCfgListTest, LazyThreadedAndSnapshot)
+{
+    EnvInitOptions lazy;
+    lazy.lazy = true;
+    EnvCfg lazy_env;
+    lazy_env.InitEnv(map, lazy);
+    EXPECT_EQ(lazy_env.GetList<std::uint64_t>("TEST_LIST_IDS").size(), 4u);
+
+    EnvMap large = map;
+    for (int i = 0; i < 64; ++i)
+    {
+        large.emplace("TEST_LIST_KEY_" + std::to_string(i), EnvList{ EnvCfgTypes::int_, ',', false, std::to_string(i) + ",1" });
+    }
+    EnvInitOptions threads;
+    threads.threads = 4;
+    threads.min_entries_per_thread = 1;
+    EnvCfg threaded;
+    threaded.InitEnv(large, threads);
+    EXPECT_EQ(threaded.GetList<int>("TEST_LIST_KEY_42")[0], 42);
+    EXPECT_EQ(threaded.GetList<std::string_view>("TEST_LIST_BROKERS").size(), 3u);
+
+    char path[] = "/tmp/libenv_list_testXXXXXX";
+    const int fd = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    close(fd);
+    threaded.SaveSnapshot(path);
+    EnvCfg::SetEnv("TEST_LIST_IDS", "1");
+    EnvCfg stale = EnvCfg::LoadSnapshot(path, false);
+    EnvCfg loaded = EnvCfg::LoadSnapshot(path);
+    std::remove(path);
+
+    const EnvListView<std::uint64_t> ids = stale.GetList<std::uint64_t>("TEST_LIST_IDS");
+    EXPECT_TRUE(ids.sorted());
+    EXPECT_EQ(std::vector<std::uint64_t>(ids.begin(), ids.end()), (std::vector<std::uint64_t>{3, 5, 7, 11}));
+    EXPECT_EQ(stale.GetList<std::string_view>("TEST_LIST_PATHS")[0], "/usr/bin");
+    EXPECT_EQ(stale.GetList<int>("TEST_LIST_MISSING").size(), 2u);
+    EXPECT_EQ(loaded.GetList<std::uint64_t>("TEST_LIST_IDS").size(), 1u);
+    EXPECT_EQ(loaded.GetList<int>("TEST_LIST_KEY_7")[0], 7);
+}
+
+class ExceptionListener : public testing::EmptyTestEventListener {
+    public:
+        void OnTestPartResult(const testing::TestPartResult& result) override
+        {
+            if (result.fatally_failed()) {
+                std::cout << "[Unhandled Exception] "<< result.message() << std::endl;
+            }
+        }
+    };
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    testing::TestEventListeners& listeners =
+        testing::UnitTest::GetInstance()->listeners();
+    listeners.Append(new ExceptionListener);
+
+    return RUN_ALL_TESTS();
+}
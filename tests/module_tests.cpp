@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <string>
+
+import libenv;
+
+using namespace env_cfg;
+
+class EnvCfgModuleTest : public ::testing::Test {
+protected:
+    void SetUp() override
+    {
+        EnvCfg::SetEnv("TEST_MODULE_PORT", "8080");
+        EnvCfg::SetEnv("TEST_MODULE_HOSTS", "a,b,c");
+        unsetenv("TEST_MODULE_MISSING");
+    }
+};
+
+TEST_F(EnvCfgModuleTest, ImportedApiReadsEnvironment)
+{
+    EnvMap map = {
+        {"TEST_MODULE_PORT", EnvCfgTypes::int_},
+        {"TEST_MODULE_HOSTS", EnvList{ EnvCfgTypes::string_, ',', false, "" }},
+        {"TEST_MODULE_MISSING", std::string("fallback")}
+    };
+    EnvCfg env;
+    env.InitEnv(map);
+    EXPECT_EQ(env.Get<int>("TEST_MODULE_PORT"), 8080);
+    EXPECT_EQ(env.GetList<std::string_view>("TEST_MODULE_HOSTS").size(), 3u);
+    EXPECT_EQ(env.Get<std::string>("TEST_MODULE_MISSING"), "fallback");
+    EXPECT_THROW(env.Get<int>("TEST_MODULE_UNKNOWN"), EnvBadGet);
+    EXPECT_EQ(EnvCfg::ParseValue<int>("1.5").error(), EnvErrc::fractional);
+}
+
+TEST_F(EnvCfgModuleTest, ImportedHolderReloads)
+{
+    EnvCfgHolder holder({{"TEST_MODULE_PORT", EnvCfgTypes::int_}});
+    EnvCfg::SetEnv("TEST_MODULE_PORT", "9090");
+    holder.Reload();
+    EXPECT_EQ(holder.Read()->Get<int>("TEST_MODULE_PORT"), 9090);
+
+    EnvBlock block;
+    block.Set("TEST_MODULE_CHILD", "1");
+    EXPECT_EQ(block.Find("TEST_MODULE_CHILD"), "1");
+}
+
+class ExceptionListener : public testing::EmptyTestEventListener {
+    public:
+        void OnTestPartResult(const testing::TestPartResult& result) override
+        {
+            if (result.fatally_failed()) {
+                std::cout << "[Unhandled Exception] "<< result.message() << std::endl;
+            }
+        }
+    };
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    testing::TestEventListeners& listeners =
+        testing::UnitTest::GetInstance()->listeners();
+    listeners.Append(new ExceptionListener);
+
+    return RUN_ALL_TESTS();
+}
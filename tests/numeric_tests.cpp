@@ -0,0 +1,280 @@
+#include "../cpp-envlib/libenv.h"
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <map>
+
+using namespace env_cfg;
+using namespace std::chrono_literals;
+
+class EnvCfgNumericTest : public ::testing::Test {
+protected:
+    void SetUp() override
+    {
+        EnvCfg::SetEnv("TEST_NUM_INT16", "-1234");
+        EnvCfg::SetEnv("TEST_NUM_UINT16", "8080");
+        EnvCfg::SetEnv("TEST_NUM_UINT32", "4000000000");
+        EnvCfg::SetEnv("TEST_NUM_UINT64", "18446744073709551615");
+        EnvCfg::SetEnv("TEST_NUM_FLOAT", "0.25");
+        EnvCfg::SetEnv("TEST_NUM_DURATION", "250ms");
+        EnvCfg::SetEnv("TEST_NUM_BYTES", "64MiB");
+        unsetenv("TEST_NUM_MISSING");
+    }
+
+    EnvMap& Single(const std::string& key, EnvCfgTypes type)
+    {
+        single = {{key, type}};
+        return single;
+    }
+
+    std::map<std::string, std::string> Formatted() const
+    {
+        std::map<std::string, std::string> values;
+        for (const auto& [key, value] : env)
+        {
+            values[key] = value;
+        }
+        return values;
+    }
+
+    EnvMap single;
+    EnvCfg env;
+};
+
+TEST_F(EnvCfgNumericTest, ParsesDeclaredTypesOnce)
+{
+    EnvMap map = {
+        {"TEST_NUM_INT16", EnvCfgTypes::int16_},
+        {"TEST_NUM_UINT16", EnvCfgTypes::uint16_},
+        {"TEST_NUM_UINT32", EnvCfgTypes::uint32_},
+        {"TEST_NUM_UINT64", EnvCfgTypes::uint64_},
+        {"TEST_NUM_FLOAT", EnvCfgTypes::float_},
+        {"TEST_NUM_DURATION", EnvCfgTypes::duration_},
+        {"TEST_NUM_BYTES", EnvCfgTypes::bytes_}
+    };
+    env.InitEnv(map);
+
+    EXPECT_EQ(env.Get<std::int16_t>("TEST_NUM_INT16"), -1234);
+    EXPECT_EQ(env.Get<std::uint16_t>("TEST_NUM_UINT16"), 8080);
+    EXPECT_EQ(env.Get<std::uint32_t>("TEST_NUM_UINT32"), 4000000000u);
+    EXPECT_EQ(env.Get<std::uint64_t>("TEST_NUM_UINT64"), std::numeric_limits<std::uint64_t>::max());
+    EXPECT_EQ(env.Get<std::size_t>("TEST_NUM_UINT64"), std::numeric_limits<std::size_t>::max());
+    EXPECT_FLOAT_EQ(env.Get<float>("TEST_NUM_FLOAT"), 0.25f);
+    EXPECT_EQ(env.Get<std::chrono::milliseconds>("TEST_NUM_DURATION"), 250ms);
+    EXPECT_EQ(env.Get<std::chrono::microseconds>("TEST_NUM_DURATION"), 250000us);
+    EXPECT_EQ(env.Get<std::chrono::seconds>("TEST_NUM_DURATION"), 0s);
+    EXPECT_EQ(env.Get<EnvBytes>("TEST_NUM_BYTES").count(), 64u << 20);
+
+    EXPECT_TRUE(env.IsType<std::uint16_t>("TEST_NUM_UINT16"));
+    EXPECT_FALSE(env.IsType<int>("TEST_NUM_UINT16"));
+    EXPECT_FALSE(env.IsType<double>("TEST_NUM_FLOAT"));
+    EXPECT_FALSE(env.IsType<long long>("TEST_NUM_DURATION"));
+    EXPECT_THROW(env.Get<int>("TEST_NUM_INT16"), EnvBadGet);
+
+    const EnvKey<std::chrono::seconds> timeout = env.Key<std::chrono::seconds>("TEST_NUM_DURATION");
+    EXPECT_EQ(env.GetN(timeout), 0s);
+}
+
+TEST_F(EnvCfgNumericTest, RejectsValuesOutOfRange)
+{
+    EnvCfg::SetEnv("TEST_NUM_INT16", "40000");
+    EXPECT_THROW(env.InitEnv(Single("TEST_NUM_INT16", EnvCfgTypes::int16_)), EnvBadGet);
+    EnvCfg::SetEnv("TEST_NUM_UINT16", "-1");
+    EXPECT_THROW(env.InitEnv(Single("TEST_NUM_UINT16", EnvCfgTypes::uint16_)), EnvBadGet);
+    EnvCfg::SetEnv("TEST_NUM_UINT16", "80.5");
+    EXPECT_THROW(env.InitEnv(Single("TEST_NUM_UINT16", EnvCfgTypes::uint16_)), EnvBadGet);
+    EnvCfg::SetEnv("TEST_NUM_FLOAT", "1e39");
+    EXPECT_THROW(env.InitEnv(Single("TEST_NUM_FLOAT", EnvCfgTypes::float_)), EnvException);
+
+    EXPECT_EQ(EnvCfg::TryGetEnv<std::uint16_t>("TEST_NUM_UINT16").error(), EnvErrc::fractional);
+    EnvCfg::SetEnv("TEST_NUM_UINT64", "18446744073709551616");
+    EXPECT_EQ(EnvCfg::TryGetEnv<std::uint64_t>("TEST_NUM_UINT64").error(), EnvErrc::out_of_range);
+    EXPECT_EQ(EnvCfg::ParseValue<std::uint32_t>("-0").value(), 0u);
+    EXPECT_EQ(EnvCfg::ParseValue<std::uint64_t>("-00000000000000000").value(), 0u);
+    EXPECT_EQ(EnvCfg::ParseValue<std::uint64_t>("-000000000000000001").error(), EnvErrc::out_of_range);
+    EXPECT_EQ(EnvCfg::ParseValue<std::uint64_t>("-12345678901234567890").error(), EnvErrc::out_of_range);
+    EXPECT_EQ(EnvCfg::ParseValue<std::int16_t>("-32768").value(), std::numeric_limits<std::int16_t>::min());
+}
+
+TEST_F(EnvCfgNumericTest, ParsesDurations)
+{
+    EXPECT_EQ(EnvCfg::ParseValue<std::chrono::nanoseconds>("15ns").value(), 15ns);
+    EXPECT_EQ(EnvCfg::ParseValue<std::chrono::nanoseconds>("7us").value(), 7us);
+    EXPECT_EQ(EnvCfg::ParseValue<std::chrono::milliseconds>("1.5s").value(), 1500ms);
+    EXPECT_EQ(EnvCfg::ParseValue<std::chrono::seconds>("1h30m").value(), 5400s);
+    EXPECT_EQ(EnvCfg::ParseValue<std::chrono::seconds>(" 2min ").value(), 120s);
+    EXPECT_EQ(EnvCfg::ParseValue<std::chrono::hours>("7d").value(), std::chrono::hours(168));
+    EXPECT_EQ(EnvCfg::ParseValue<std::chrono::milliseconds>("-250ms").value(), -250ms);
+    EXPECT_EQ(EnvCfg::ParseValue<std::chrono::seconds>("0").value(), 0s);
+
+    EXPECT_EQ(EnvCfg::ParseValue<std::chrono::seconds>("5").error(), EnvErrc::invalid_format);
+    EXPECT_EQ(EnvCfg::ParseValue<std::chrono::seconds>("5 s").error(), EnvErrc::invalid_format);
+    EXPECT_EQ(EnvCfg::ParseValue<std::chrono::seconds>("5sec").error(), EnvErrc::invalid_format);
+    EXPECT_EQ(EnvCfg::ParseValue<std::chrono::seconds>("ms").error(), EnvErrc::invalid_format);
+    EXPECT_EQ(EnvCfg::ParseValue<std::chrono::seconds>("").error(), EnvErrc::empty);
+    EXPECT_EQ(EnvCfg::ParseValue<std::chrono::seconds>("300000d").error(), EnvErrc::out_of_range);
+
+    EnvCfg::SetEnv("TEST_NUM_DURATION", "soon");
+    EXPECT_EQ(EnvCfg::GetW<std::chrono::seconds>("TEST_NUM_DURATION").default_value(30s), 30s);
+    EXPECT_THROW({ std::chrono::seconds value = EnvCfg::GetW<std::chrono::seconds>("TEST_NUM_DURATION"); (void)value; }, EnvBadGet);
+}
+
+TEST_F(EnvCfgNumericTest, ParsesByteSizes)
+{
+    EXPECT_EQ(EnvCfg::ParseValue<EnvBytes>("4096").value().count(), 4096u);
+    EXPECT_EQ(EnvCfg::ParseValue<EnvBytes>("512B").value().count(), 512u);
+    EXPECT_EQ(EnvCfg::ParseValue<EnvBytes>("64KiB").value().count(), 65536u);
+    EXPECT_EQ(EnvCfg::ParseValue<EnvBytes>("64kb").value().count(), 64000u);
+    EXPECT_EQ(EnvCfg::ParseValue<EnvBytes>("2 Gi").value().count(), 2ull << 30);
+    EXPECT_EQ(EnvCfg::ParseValue<EnvBytes>("1.5GB").value().count(), 1500000000u);
+    EXPECT_EQ(EnvCfg::ParseValue<EnvBytes>("15EiB").value().count(), 15ull << 60);
+
+    EXPECT_EQ(EnvCfg::ParseValue<EnvBytes>("16EiB").error(), EnvErrc::out_of_range);
+    EXPECT_EQ(EnvCfg::ParseValue<EnvBytes>("-1KB").error(), EnvErrc::out_of_range);
+    EXPECT_EQ(EnvCfg::ParseValue<EnvBytes>("64XB").error(), EnvErrc::invalid_format);
+    EXPECT_EQ(EnvCfg::ParseValue<EnvBytes>("MiB").error(), EnvErrc::invalid_format);
+}
+
+TEST_F(EnvCfgNumericTest, TypedDefaults)
+{
+    EnvMap map = {
+        {"TEST_NUM_MISSING", EnvCfg::EnvValue::Of<std::uint16_t>(443)},
+        {"TEST_NUM_MISSING_FLOAT", 0.5f},
+        {"TEST_NUM_MISSING_DURATION", 5s},
+        {"TEST_NUM_MISSING_BYTES", EnvBytes(1024)},
+        {"TEST_NUM_MISSING_SIZE", std::numeric_limits<std::uint64_t>::max()},
+        {"TEST_NUM_DURATION", 1min}
+    };
+    env.InitEnv(map);
+
+    EXPECT_EQ(env.Get<std::uint16_t>("TEST_NUM_MISSING"), 443);
+    EXPECT_FLOAT_EQ(env.Get<float>("TEST_NUM_MISSING_FLOAT"), 0.5f);
+    EXPECT_EQ(env.Get<std::chrono::seconds>("TEST_NUM_MISSING_DURATION"), 5s);
+    EXPECT_EQ(env.Get<EnvBytes>("TEST_NUM_MISSING_BYTES"), EnvBytes(1024));
+    EXPECT_EQ(env.Get<std::uint64_t>("TEST_NUM_MISSING_SIZE"), std::numeric_limits<std::uint64_t>::max());
+    EXPECT_EQ(env.Get<std::chrono::milliseconds>("TEST_NUM_DURATION"), 250ms);
+}
+
+TEST_F(EnvCfgNumericTest, FormatsValues)
+{
+    EnvCfg::SetEnv("TEST_NUM_DURATION", "1h30m");
+    EnvCfg::SetEnv("TEST_NUM_BYTES", "1000");
+    EnvMap map = {
+        {"TEST_NUM_INT16", EnvCfgTypes::int16_},
+        {"TEST_NUM_FLOAT", EnvCfgTypes::float_},
+        {"TEST_NUM_DURATION", EnvCfgTypes::duration_},
+        {"TEST_NUM_BYTES", EnvCfgTypes::bytes_},
+        {"TEST_NUM_MISSING", EnvCfgTypes::bytes_}
+    };
+    env.InitEnv(map);
+
+    std::map<std::string, std::string> values = Formatted();
+    EXPECT_EQ(values["TEST_NUM_INT16"], "-1234");
+    EXPECT_EQ(values["TEST_NUM_FLOAT"], "0.25");
+    EXPECT_EQ(values["TEST_NUM_DURATION"], "90m");
+    EXPECT_EQ(values["TEST_NUM_BYTES"], "1000B");
+    EXPECT_EQ(values["TEST_NUM_MISSING"], "nullopt");
+
+    EnvCfg::SetEnv("TEST_NUM_BYTES", "64MiB");
+    EnvCfg::SetEnv("TEST_NUM_DURATION", "0");
+    env.Refresh();
+    values = Formatted();
+    EXPECT_EQ(values["TEST_NUM_BYTES"], "64MiB");
+    EXPECT_EQ(values["TEST_NUM_DURATION"], "0s");
+
+    for (const auto& [key, value] : env.Entries())
+    {
+        if (key == "TEST_NUM_BYTES")
+        {
+            EXPECT_EQ(value.GetN<EnvBytes>(), EnvBytes(64u << 20));
+            EXPECT_TRUE(value.Visit([](auto v) { return std::is_same_v<decltype(v), EnvBytes>; }));
+        }
+    }
+}
+
+TEST_F(EnvCfgNumericTest, SchemaAndBinding)
+{
+    constexpr auto schema = MakeEnvSchema({
+        {"TEST_NUM_UINT16", EnvCfgTypes::uint16_, 80},
+        {"TEST_NUM_MISSING", EnvCfgTypes::duration_, std::chrono::seconds(30)},
+        {"TEST_NUM_MISSING_BYTES", EnvCfgTypes::bytes_, 4096},
+        {"TEST_NUM_MISSING_FLOAT", EnvCfgTypes::float_, 0.75}
+    });
+    constexpr auto port_key = schema.Key<std::uint16_t>("TEST_NUM_UINT16");
+    env.InitEnv(schema);
+    EXPECT_EQ(env.Get(port_key), 8080);
+    EXPECT_EQ(env.Get<std::chrono::seconds>("TEST_NUM_MISSING"), 30s);
+    EXPECT_EQ(env.Get<EnvBytes>("TEST_NUM_MISSING_BYTES").count(), 4096u);
+    EXPECT_FLOAT_EQ(env.Get<float>("TEST_NUM_MISSING_FLOAT"), 0.75f);
+    EXPECT_THROW(MakeEnvSchema({{"TEST_NUM_UINT16", EnvCfgTypes::uint16_, 70000}}), EnvException);
+
+    struct Config
+    {
+        std::uint16_t port = 0;
+        long offset = 0;
+        std::chrono::milliseconds timeout{};
+        EnvBytes cache;
+        std::size_t limit = 0;
+    };
+    EnvCfg::SetEnv("TEST_NUM_OFFSET", "-5");
+    const auto binding = EnvBinding<Config>()
+        .Field("TEST_NUM_UINT16", &Config::port)
+        .Field("TEST_NUM_OFFSET", &Config::offset)
+        .Field("TEST_NUM_DURATION", &Config::timeout)
+        .Field("TEST_NUM_BYTES", &Config::cache)
+        .Field("TEST_NUM_MISSING", &Config::limit, 100);
+    Config config;
+    EnvCfg bound;
+    bound.InitEnv(binding, config);
+    EXPECT_EQ(config.port, 8080);
+    EXPECT_EQ(config.offset, -5);
+    EXPECT_EQ(config.timeout, 250ms);
+    EXPECT_EQ(config.cache, EnvBytes(64u << 20));
+    EXPECT_EQ(config.limit, 100u);
+}
+
+TEST_F(EnvCfgNumericTest, SnapshotRoundTrip)
+{
+    EnvMap map = {
+        {"TEST_NUM_INT16", EnvCfgTypes::int16_},
+        {"TEST_NUM_UINT64", EnvCfgTypes::uint64_},
+        {"TEST_NUM_FLOAT", EnvCfgTypes::float_},
+        {"TEST_NUM_DURATION", EnvCfgTypes::duration_},
+        {"TEST_NUM_BYTES", EnvCfgTypes::bytes_},
+        {"TEST_NUM_MISSING", EnvCfg::EnvValue::Of<std::uint32_t>(7)}
+    };
+    env.InitEnv(map);
+    char path[] = "/tmp/libenv_numeric_testXXXXXX";
+    const int fd = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    close(fd);
+    env.SaveSnapshot(path);
+    EnvCfg loaded = EnvCfg::LoadSnapshot(path);
+    std::remove(path);
+
+    EXPECT_EQ(loaded.Get<std::int16_t>("TEST_NUM_INT16"), -1234);
+    EXPECT_EQ(loaded.Get<std::uint64_t>("TEST_NUM_UINT64"), std::numeric_limits<std::uint64_t>::max());
+    EXPECT_FLOAT_EQ(loaded.Get<float>("TEST_NUM_FLOAT"), 0.25f);
+    EXPECT_EQ(loaded.Get<std::chrono::milliseconds>("TEST_NUM_DURATION"), 250ms);
+    EXPECT_EQ(loaded.Get<EnvBytes>("TEST_NUM_BYTES").count(), 64u << 20);
+    EXPECT_EQ(loaded.Get<std::uint32_t>("TEST_NUM_MISSING"), 7u);
+}
+
+class ExceptionListener : public testing::EmptyTestEventListener {
+    public:
+        void OnTestPartResult(const testing::TestPartResult& result) override
+        {
+            if (result.fatally_failed()) {
+                std::cout << "[Unhandled Exception] "<< result.message() << std::endl;
+            }
+        }
+    };
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    testing::TestEventListeners& listeners =
+        testing::UnitTest::GetInstance()->listeners();
+    listeners.Append(new ExceptionListener);
+
+    return RUN_ALL_TESTS();
+}
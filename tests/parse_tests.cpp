@@ -0,0 +1,288 @@
+#include "../cpp-envlib/libenv.h"
+#include "alloc_counter.h"
+#include <gtest/gtest.h>
+#include <cmath>
+
+using namespace env_cfg;
+
+class EnvCfgParseTest : public ::testing::Test {
+protected:
+    void SetUp() override 
+    {
+        EnvCfg::SetEnvN("TEST_PARSE", "", true);
+    }
+};
+
+template <typename T>
+static std::optional<T> ParseWithStd(const std::string& raw)
+{
+    try
+    {
+        if constexpr (std::is_same_v<T, int>)
+        {
+            return std::stoi(raw);
+        }
+        else if constexpr (std::is_same_v<T, long long>)
+        {
+            return std::stoll(raw);
+        }
+        else
+        {
+            return std::stod(raw);
+        }
+    }
+    catch (const std::exception&)
+    {
+        return std::nullopt;
+    }
+}
+
+TEST_F(EnvCfgParseTest, IntegerMatchesStoi) 
+{
+    const char* inputs[] = {"0", "42", "-42", "+42", "  17", "\t-8", "12abc", "abc", "+-1", "-+1", "+", "-", " ",
+        "2147483647", "-2147483648", "2147483648", "-2147483649", "0012", "1e5"};
+    for (const char* input : inputs)
+    {
+        auto expected = ParseWithStd<int>(input);
+        auto parsed = EnvCfg::ParseValue<int>(input);
+        EXPECT_EQ(parsed.has_value(), expected.has_value()) << input;
+        if (expected && parsed)
+        {
+            EXPECT_EQ(parsed.value(), *expected) << input;
+        }
+    }
+    EXPECT_EQ(EnvCfg::ParseValue<int>("2147483648").error(), EnvErrc::out_of_range);
+    EXPECT_EQ(EnvCfg::ParseValue<int>("3.14").error(), EnvErrc::fractional);
+    EXPECT_EQ(EnvCfg::ParseValue<int>("").error(), EnvErrc::empty);
+}
+
+TEST_F(EnvCfgParseTest, LongLongMatchesStoll) 
+{
+    const char* inputs[] = {"9223372036854775807", "-9223372036854775808", "9223372036854775808", "  +5", "3.5", "x1"};
+    for (const char* input : inputs)
+    {
+        auto expected = ParseWithStd<long long>(input);
+        auto parsed = EnvCfg::ParseValue<long long>(input);
+        EXPECT_EQ(parsed.has_value(), expected.has_value()) << input;
+        if (expected && parsed)
+        {
+            EXPECT_EQ(parsed.value(), *expected) << input;
+        }
+    }
+}
+
+TEST_F(EnvCfgParseTest, DoubleMatchesStod) 
+{
+    const char* inputs[] = {"3.1415", "-2.5", "+1e3", "  .5", "1.", "inf", "-Infinity", "0x1p3", "-0x1.8p1", "0xzz",
+        "1e400", "1e-310", "abc", "+-1", "12.5kg", "0xinf", "0Xnan", "0x-1", "0x+1", "0x", "0x.8", " -0x.p1"};
+    for (const char* input : inputs)
+    {
+        auto expected = ParseWithStd<double>(input);
+        auto parsed = EnvCfg::ParseValue<double>(input);
+        EXPECT_EQ(parsed.has_value(), expected.has_value()) << input;
+        if (expected && parsed)
+        {
+            EXPECT_DOUBLE_EQ(parsed.value(), *expected) << input;
+        }
+    }
+    EXPECT_TRUE(std::isnan(EnvCfg::ParseValue<double>("nan").value()));
+}
+
+TEST_F(EnvCfgParseTest, BoolIsCaseInsensitive) 
+{
+    EXPECT_TRUE(EnvCfg::ParseValue<bool>("TrUe").value());
+    EXPECT_FALSE(EnvCfg::ParseValue<bool>("FALSE").value());
+    EXPECT_TRUE(EnvCfg::ParseValue<bool>("Yes").value());
+    EXPECT_FALSE(EnvCfg::ParseValue<bool>("NO").value());
+    EXPECT_TRUE(EnvCfg::ParseValue<bool>("1").value());
+    EXPECT_FALSE(EnvCfg::ParseValue<bool>("0").value());
+    EXPECT_EQ(EnvCfg::ParseValue<bool>("true ").error(), EnvErrc::invalid_format);
+    EXPECT_EQ(EnvCfg::ParseValue<bool>("\x11").error(), EnvErrc::invalid_format);
+    EXPECT_EQ(EnvCfg::ParseValue<bool>("n0").error(), EnvErrc::invalid_format);
+    EXPECT_EQ(EnvCfg::ParseValue<bool>("truee").error(), EnvErrc::invalid_format);
+    EXPECT_EQ(EnvCfg::ParseValue<bool>("2").error(), EnvErrc::invalid_format);
+}
+
+TEST_F(EnvCfgParseTest, IntegerKernelMatchesStoll) 
+{
+    std::vector<std::string> inputs;
+    std::string digits;
+    for (int length = 1; length <= 20; ++length)
+    {
+        digits += static_cast<char>('0' + (length * 7) % 10);
+        inputs.push_back(digits);
+        inputs.push_back("-" + digits);
+        inputs.push_back(digits + "x");
+        inputs.push_back(" +" + digits + ".5");
+        inputs.push_back(std::string(static_cast<std::size_t>(length), '9'));
+        inputs.push_back("-" + std::string(static_cast<std::size_t>(length), '9'));
+    }
+    inputs.push_back("000000000000000000000000042");
+    inputs.push_back("9999999999999999");
+    inputs.push_back("99999999999999999");
+    for (const std::string& input : inputs)
+    {
+        auto expected = ParseWithStd<long long>(input);
+        auto parsed = EnvCfg::ParseValue<long long>(input);
+        EXPECT_EQ(parsed.has_value(), expected.has_value()) << input;
+        if (expected && parsed)
+        {
+            EXPECT_EQ(parsed.value(), *expected) << input;
+        }
+        if (input.find('.') == std::string::npos)
+        {
+            auto expected_int = ParseWithStd<int>(input);
+            auto parsed_int = EnvCfg::ParseValue<int>(input);
+            EXPECT_EQ(parsed_int.has_value(), expected_int.has_value()) << input;
+            if (expected_int && parsed_int)
+            {
+                EXPECT_EQ(parsed_int.value(), *expected_int) << input;
+            }
+        }
+    }
+}
+
+TEST_F(EnvCfgParseTest, ParseBatchMatchesParseValue) 
+{
+    const std::string_view raw[] = {"1", "-17", "x", "", "2147483648", " 8"};
+    int values[6] = {};
+    EnvErrc errors[6];
+    EnvCfg::ParseBatch<int>(raw, 6, values, errors);
+    for (std::size_t i = 0; i < 6; ++i)
+    {
+        auto expected = EnvCfg::ParseValue<int>(raw[i]);
+        if (expected)
+        {
+            EXPECT_EQ(errors[i], EnvErrc::ok) << raw[i];
+            EXPECT_EQ(values[i], expected.value()) << raw[i];
+        }
+        else
+        {
+            EXPECT_EQ(errors[i], expected.error()) << raw[i];
+        }
+    }
+
+    const std::string_view flags[] = {"TRUE", "no", "maybe"};
+    bool bools[3] = {};
+    EnvCfg::ParseBatch<bool>(flags, 3, bools, errors);
+    EXPECT_TRUE(bools[0]);
+    EXPECT_FALSE(bools[1]);
+    EXPECT_EQ(errors[2], EnvErrc::invalid_format);
+}
+
+TEST_F(EnvCfgParseTest, TryGetEnvReportsErrorCodes) 
+{
+    std::string name = "TEST_PARSE";
+    EXPECT_EQ(EnvCfg::TryGetEnv<int>(name).error(), EnvErrc::empty);
+
+    EnvCfg::SetEnv(name, "not_a_number");
+    EXPECT_EQ(EnvCfg::TryGetEnv<int>(name).error(), EnvErrc::invalid_format);
+
+    EnvCfg::SetEnv(name, "128");
+    auto result = EnvCfg::TryGetEnv<int>(name);
+    ASSERT_TRUE(result);
+    EXPECT_EQ(result.value(), 128);
+}
+
+TEST_F(EnvCfgParseTest, SuccessPathDoesNotAllocate) 
+{
+    std::string name = "TEST_PARSE";
+    EnvCfg::SetEnv(name, "123456");
+
+    const std::size_t before = g_allocations.load();
+    auto as_int = EnvCfg::TryGetEnv<int>(name);
+    auto as_ll = EnvCfg::TryGetEnv<long long>(name);
+    auto as_double = EnvCfg::TryGetEnv<double>(name);
+    const std::size_t after = g_allocations.load();
+
+    EXPECT_EQ(as_int.value(), 123456);
+    EXPECT_EQ(as_ll.value(), 123456LL);
+    EXPECT_DOUBLE_EQ(as_double.value(), 123456.0);
+    EXPECT_EQ(after, before);
+}
+
+TEST_F(EnvCfgParseTest, GetWErrorPathDoesNotAllocate) 
+{
+    std::string name = "TEST_PARSE_WITH_A_NAME_LONGER_THAN_SMALL_STRING_BUFFERS";
+    EnvCfg::SetEnv(name, "not a number at all, and longer than the small string buffer");
+    const std::string missing_name = "TEST_PARSE_MISSING_WITH_A_LONG_NAME_TOO";
+
+    const std::size_t before = g_allocations.load();
+    const int value = EnvCfg::GetW<int>(name).default_value(30);
+    const EnvErrc error = EnvCfg::GetW<int>(name).error();
+    const double missing = EnvCfg::GetW<double>(missing_name).default_value(0.5);
+    const std::size_t after = g_allocations.load();
+    unsetenv(name.c_str());
+
+    EXPECT_EQ(value, 30);
+    EXPECT_EQ(error, EnvErrc::invalid_format);
+    EXPECT_DOUBLE_EQ(missing, 0.5);
+    EXPECT_EQ(after, before);
+}
+
+TEST_F(EnvCfgParseTest, GetWDefersErrorMessage) 
+{
+    std::string name = "TEST_PARSE";
+    EnvCfg::SetEnv(name, "abc");
+    auto wrapper = EnvCfg::GetW<int>(name);
+    EnvCfg::SetEnv(name, "changed later");
+    try
+    {
+        int value = wrapper;
+        FAIL() << value;
+    }
+    catch (const EnvBadGet& e)
+    {
+        EXPECT_NE(std::string(e.what()).find("expected int abc for enviroment TEST_PARSE"), std::string::npos);
+    }
+    EXPECT_THROW(static_cast<double>(EnvCfg::GetW<double>("TEST_PARSE_MISSING")), EnvBadGet);
+    EXPECT_EQ(EnvCfg::GetW<double>("TEST_PARSE_MISSING").error(), EnvErrc::empty);
+
+    const std::string long_value(100, 'z');
+    EnvCfg::SetEnv(name, long_value);
+    try
+    {
+        bool value = EnvCfg::GetW<bool>(name);
+        FAIL() << value;
+    }
+    catch (const EnvBadGet& e)
+    {
+        EXPECT_NE(std::string(e.what()).find("expected bool " + long_value + " for enviroment " + name), std::string::npos);
+    }
+
+    // Long keys keep their full name in the deferred message, like the eagerly created one.
+    const std::string long_name = "TEST_PARSE_" + std::string(80, 'K');
+    EnvCfg::SetEnv(long_name, "abc");
+    try
+    {
+        int value = EnvCfg::GetW<int>(long_name);
+        FAIL() << value;
+    }
+    catch (const EnvBadGet& e)
+    {
+        EXPECT_NE(std::string(e.what()).find("expected int abc for enviroment " + long_name), std::string::npos);
+    }
+    EnvCfg::SetEnvN(long_name, "", true);
+    EXPECT_THROW(static_cast<int>(EnvCfg::GetW<int>(long_name)), EnvBadGet);
+    unsetenv(long_name.c_str());
+}
+
+class ExceptionListener : public testing::EmptyTestEventListener {
+    public:
+        void OnTestPartResult(const testing::TestPartResult& result) override 
+        {
+            if (result.fatally_failed()) {
+                std::cout << "[Unhandled Exception] "<< result.message() << std::endl;
+            }
+        }
+    };
+
+int main(int argc, char **argv) 
+{
+    testing::InitGoogleTest(&argc, argv);
+    testing::TestEventListeners& listeners = 
+        testing::UnitTest::GetInstance()->listeners();
+    listeners.Append(new ExceptionListener);
+    
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,184 @@
+#include "../cpp-envlib/libenv.h"
+#include <gtest/gtest.h>
+#include <fstream>
+#include <map>
+
+using namespace env_cfg;
+
+class EnvCfgPatternTest : public ::testing::Test {
+protected:
+    void SetUp() override
+    {
+        EnvCfg::SetEnv("TEST_PATTERN_A_QUOTA", "10");
+        EnvCfg::SetEnv("TEST_PATTERN_B_QUOTA", "20");
+        EnvCfg::SetEnv("TEST_PATTERN_LONG_ID_QUOTA", "30");
+        EnvCfg::SetEnv("TEST_PATTERN_A_NAME", "alpha");
+        EnvCfg::SetEnv("TEST_PATTERN_VIP_QUOTA", "big");
+        EnvCfg::SetEnv("TEST_PATTERN_QUOTA", "40");
+    }
+
+    void TearDown() override
+    {
+        EnvCfg::DisableSnapshot();
+        EnvCfg::DisableOverlay();
+        EnvCfg::DetachFile();
+    }
+
+    std::map<std::string, int> Quotas() const
+    {
+        std::map<std::string, int> quotas;
+        for (const auto& [key, value] : env.Scope("TEST_PATTERN_"))
+        {
+            if (std::optional<int> quota = value.GetN<int>())
+            {
+                quotas[std::string(key)] = *quota;
+            }
+        }
+        return quotas;
+    }
+
+    EnvCfg env;
+};
+
+TEST_F(EnvCfgPatternTest, DiscoversMatchingKeys)
+{
+    EnvMap map = {
+        {"TEST_PATTERN_*_QUOTA", EnvCfgTypes::int_},
+        {"TEST_PATTERN_*_NAME", EnvCfgTypes::string_},
+        {"TEST_PATTERN_VIP_QUOTA", EnvCfgTypes::string_}
+    };
+    env.InitEnv(map);
+
+    EXPECT_EQ(Quotas(), (std::map<std::string, int>{{"A_QUOTA", 10}, {"B_QUOTA", 20}, {"LONG_ID_QUOTA", 30}}));
+    EXPECT_EQ(env.Get<std::string>("TEST_PATTERN_A_NAME"), "alpha");
+    EXPECT_EQ(env.Get<std::string>("TEST_PATTERN_VIP_QUOTA"), "big");
+    EXPECT_FALSE(env.HasValue("TEST_PATTERN_*_QUOTA"));
+    // "_*_" needs two underscores around the id.
+    EXPECT_FALSE(env.HasValue("TEST_PATTERN_QUOTA"));
+    EXPECT_EQ(env.Scope("TEST_PATTERN_").size(), 5u);
+}
+
+TEST_F(EnvCfgPatternTest, MostSpecificPatternWins)
+{
+    EnvMap map = {
+        {"TEST_PATTERN_*", EnvCfgTypes::string_},
+        {"TEST_PATTERN_*_QUOTA", EnvCfgTypes::int_},
+        {"TEST_PATTERN_LONG_*_QUOTA", 7LL},
+        {"TEST_PATTERN_*QUOTA", EnvCfgTypes::double_}
+    };
+    EnvCfg::SetEnv("TEST_PATTERN_VIP_QUOTA", "50");
+    env.InitEnv(map);
+    EXPECT_EQ(env.Get<int>("TEST_PATTERN_A_QUOTA"), 10);
+    EXPECT_EQ(env.Get<int>("TEST_PATTERN_VIP_QUOTA"), 50);
+    EXPECT_EQ(env.Get<long long>("TEST_PATTERN_LONG_ID_QUOTA"), 30);
+    EXPECT_DOUBLE_EQ(env.Get<double>("TEST_PATTERN_QUOTA"), 40.0);
+    EXPECT_EQ(env.Get<std::string>("TEST_PATTERN_A_NAME"), "alpha");
+}
+
+TEST_F(EnvCfgPatternTest, ErrorsAndModes)
+{
+    EnvMap map = {{"TEST_PATTERN_*_QUOTA", EnvCfgTypes::int_}};
+    EXPECT_THROW(env.InitEnv(map), EnvBadGet);
+
+    EnvInitOptions lazy;
+    lazy.lazy = true;
+    EnvCfg lazy_env;
+    lazy_env.InitEnv(map, lazy);
+    EXPECT_EQ(lazy_env.Get<int>("TEST_PATTERN_B_QUOTA"), 20);
+    EXPECT_THROW(lazy_env.Get<int>("TEST_PATTERN_VIP_QUOTA"), EnvBadGet);
+    EXPECT_FALSE(lazy_env.GetN<int>("TEST_PATTERN_VIP_QUOTA"));
+
+    EnvMap many = {{"TEST_PATTERN_*_QUOTA", 0}, {"TEST_PATTERN_VIP_QUOTA", EnvCfgTypes::string_}};
+    for (int i = 0; i < 64; ++i)
+    {
+        many.emplace("TEST_PATTERN_KEY_" + std::to_string(i), i);
+    }
+    EnvInitOptions threads;
+    threads.threads = 4;
+    threads.min_entries_per_thread = 1;
+    EnvCfg threaded;
+    threaded.InitEnv(many, threads);
+    EXPECT_EQ(threaded.Get<int>("TEST_PATTERN_LONG_ID_QUOTA"), 30);
+    EXPECT_EQ(threaded.Get<int>("TEST_PATTERN_KEY_42"), 42);
+    EXPECT_EQ(threaded.Get<std::string>("TEST_PATTERN_VIP_QUOTA"), "big");
+}
+
+TEST_F(EnvCfgPatternTest, ScansSnapshotOverlayAndFile)
+{
+    EnvMap map = {{"TEST_PATTERN_*_QUOTA", EnvCfgTypes::int_}, {"TEST_PATTERN_VIP_QUOTA", EnvCfgTypes::string_}};
+
+    EnvCfg::EnableSnapshot();
+    unsetenv("TEST_PATTERN_B_QUOTA");
+    env.InitEnv(map);
+    EXPECT_EQ(env.Get<int>("TEST_PATTERN_B_QUOTA"), 20);
+    EnvCfg::DisableSnapshot();
+
+    EnvCfg::EnableOverlay();
+    EnvCfg::SetEnv("TEST_PATTERN_C_QUOTA", "60");
+    EnvCfg::SetEnv("TEST_PATTERN_A_QUOTA", "11");
+    EnvCfg overlay;
+    overlay.InitEnv(map);
+    EXPECT_EQ(overlay.Get<int>("TEST_PATTERN_C_QUOTA"), 60);
+    EXPECT_EQ(overlay.Get<int>("TEST_PATTERN_A_QUOTA"), 11);
+    EXPECT_FALSE(overlay.HasValue("TEST_PATTERN_B_QUOTA"));
+    EnvCfg::DisableOverlay();
+
+    char path[] = "/tmp/libenv_pattern_testXXXXXX";
+    const int fd = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    close(fd);
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << "TEST_PATTERN_A_QUOTA=1\nTEST_PATTERN_FILE_QUOTA=70\n";
+    }
+    EnvCfg::AttachFile(std::make_shared<EnvFileSource>(path));
+    std::remove(path);
+    EnvCfg file;
+    file.InitEnv(map);
+    EXPECT_EQ(file.Get<int>("TEST_PATTERN_A_QUOTA"), 10);
+    EXPECT_EQ(file.Get<int>("TEST_PATTERN_FILE_QUOTA"), 70);
+
+    EnvCfg::AttachFile(std::make_shared<EnvFileSource>("/dev/null"), EnvPrecedence::file_);
+    EnvCfg empty_file;
+    empty_file.InitEnv(map);
+    EXPECT_EQ(empty_file.Get<int>("TEST_PATTERN_A_QUOTA"), 10);
+    EXPECT_FALSE(empty_file.HasValue("TEST_PATTERN_FILE_QUOTA"));
+}
+
+TEST_F(EnvCfgPatternTest, ManyTenants)
+{
+    for (int i = 0; i < 2000; ++i)
+    {
+        EnvCfg::SetEnv("TEST_PATTERN_TENANT_" + std::to_string(i) + "_QUOTA", std::to_string(i * 3));
+    }
+    EnvMap map = {{"TEST_PATTERN_TENANT_*_QUOTA", EnvCfgTypes::int_}, {"TEST_PATTERN_TENANT_7_QUOTA", 1}};
+    env.InitEnv(map);
+    const EnvCfgView tenants = env.Scope("TEST_PATTERN_TENANT_");
+    EXPECT_EQ(tenants.size(), 2000u);
+    EXPECT_EQ(tenants.Get<int>("1999_QUOTA"), 5997);
+    EXPECT_EQ(tenants.Get<int>("7_QUOTA"), 21);
+    for (int i = 0; i < 2000; ++i)
+    {
+        unsetenv(("TEST_PATTERN_TENANT_" + std::to_string(i) + "_QUOTA").c_str());
+    }
+}
+
+class ExceptionListener : public testing::EmptyTestEventListener {
+    public:
+        void OnTestPartResult(const testing::TestPartResult& result) override
+        {
+            if (result.fatally_failed()) {
+                std::cout << "[Unhandled Exception] "<< result.message() << std::endl;
+            }
+        }
+    };
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    testing::TestEventListeners& listeners =
+        testing::UnitTest::GetInstance()->listeners();
+    listeners.Append(new ExceptionListener);
+
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,271 @@
+#include "../cpp-envlib/libenv.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <map>
+#include <thread>
+#include <vector>
+
+using namespace env_cfg;
+
+class EnvCfgReloadTest : public ::testing::Test {
+protected:
+    void SetUp() override 
+    {
+        EnvCfg::SetEnv("TEST_RELOAD_A", "0");
+        EnvCfg::SetEnv("TEST_RELOAD_B", "0");
+    }
+};
+
+TEST_F(EnvCfgReloadTest, ReloadPublishesNewSnapshot) 
+{
+    EnvCfgHolder holder({{"TEST_RELOAD_A", EnvCfgTypes::int_}, {"TEST_RELOAD_DEFAULT", "def"}});
+    EXPECT_EQ(holder.Read()->Get<int>("TEST_RELOAD_A"), 0);
+
+    auto old_guard = holder.Read();
+    EnvCfg::SetEnv("TEST_RELOAD_A", "5");
+    std::thread reloader([&holder] { holder.Reload(); });
+    // The old snapshot stays valid while the guard is alive.
+    EXPECT_EQ(old_guard->Get<int>("TEST_RELOAD_A"), 0);
+    { auto moved = std::move(old_guard); }
+    reloader.join();
+
+    EXPECT_EQ(holder.Read()->Get<int>("TEST_RELOAD_A"), 5);
+    EXPECT_EQ((*holder.Read()).Get<std::string>("TEST_RELOAD_DEFAULT"), "def");
+}
+
+TEST_F(EnvCfgReloadTest, ReloadInsideReadGuard)
+{
+    EnvCfgHolder holder({{"TEST_RELOAD_A", EnvCfgTypes::int_}});
+    EnvCfgHolder other({{"TEST_RELOAD_B", EnvCfgTypes::int_}});
+    auto guard = holder.Read();
+    auto other_guard = other.Read();
+    EnvCfg::SetEnv("TEST_RELOAD_A", "1");
+    EnvCfg::SetEnv("TEST_RELOAD_B", "2");
+    // Neither a guard of the same thread nor one of another holder blocks the reload.
+    holder.Reload();
+    other.Reload();
+    auto cfg = std::make_unique<EnvCfg>();
+    EnvMap map = {{"TEST_RELOAD_A", EnvCfgTypes::int_}};
+    cfg->InitEnv(map);
+    EnvCfg::SetEnv("TEST_RELOAD_A", "3");
+    holder.Publish(std::move(cfg));
+    EXPECT_EQ(guard->Get<int>("TEST_RELOAD_A"), 0);
+    EXPECT_EQ(other_guard->Get<int>("TEST_RELOAD_B"), 0);
+    EXPECT_EQ(holder.Read()->Get<int>("TEST_RELOAD_A"), 1);
+    EXPECT_EQ(other.Read()->Get<int>("TEST_RELOAD_B"), 2);
+    holder.Reload();
+    EXPECT_EQ(holder.Read()->Get<int>("TEST_RELOAD_A"), 3);
+    EXPECT_EQ(guard->Get<int>("TEST_RELOAD_A"), 0);
+}
+
+TEST_F(EnvCfgReloadTest, FailedReloadKeepsCurrent) 
+{
+    EnvCfgHolder holder({{"TEST_RELOAD_A", EnvCfgTypes::int_}});
+    EnvCfg::SetEnv("TEST_RELOAD_A", "broken");
+    EXPECT_THROW(holder.Reload(), EnvBadGet);
+    EXPECT_EQ(holder.Read()->Get<int>("TEST_RELOAD_A"), 0);
+}
+
+TEST_F(EnvCfgReloadTest, ConcurrentReadersSeeConsistentSnapshots) 
+{
+    EnvCfgHolder holder({{"TEST_RELOAD_UNSET_A", 0}, {"TEST_RELOAD_UNSET_B", 0}});
+    std::atomic<bool> stop{false};
+    std::atomic<int> mismatches{0};
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; ++i)
+    {
+        readers.emplace_back([&] {
+            while (!stop.load())
+            {
+                auto cfg = holder.Read();
+                if (cfg->Get<int>("TEST_RELOAD_UNSET_A") != cfg->Get<int>("TEST_RELOAD_UNSET_B"))
+                {
+                    ++mismatches;
+                }
+            }
+        });
+    }
+    for (int i = 1; i <= 50; ++i)
+    {
+        auto cfg = std::make_unique<EnvCfg>();
+        EnvMap map = {{"TEST_RELOAD_UNSET_A", i}, {"TEST_RELOAD_UNSET_B", i}};
+        cfg->InitEnv(map);
+        holder.Publish(std::move(cfg));
+    }
+    stop.store(true);
+    for (std::thread& reader : readers)
+    {
+        reader.join();
+    }
+
+    EXPECT_EQ(mismatches.load(), 0);
+    EXPECT_EQ(holder.Read()->Get<int>("TEST_RELOAD_UNSET_A"), 50);
+}
+
+TEST_F(EnvCfgReloadTest, ReloadWithoutChangesKeepsConfiguration) 
+{
+    EnvCfgHolder holder({{"TEST_RELOAD_A", EnvCfgTypes::int_}});
+    const EnvCfg* before = &*holder.Read();
+    holder.Reload();
+    EXPECT_EQ(&*holder.Read(), before);
+
+    EnvCfg::SetEnv("TEST_RELOAD_A", "1");
+    holder.Reload();
+    EXPECT_NE(&*holder.Read(), before);
+    EXPECT_EQ(holder.Read()->Get<int>("TEST_RELOAD_A"), 1);
+}
+
+TEST_F(EnvCfgReloadTest, SubscribersReceiveOneBatchPerReload) 
+{
+    EnvCfg::SetEnv("TEST_RELOAD_POOL_X", "1");
+    EnvCfg::SetEnv("TEST_RELOAD_POOL_Y", "1");
+    EnvCfgHolder holder({{"TEST_RELOAD_A", EnvCfgTypes::int_}, {"TEST_RELOAD_B", EnvCfgTypes::string_},
+        {"TEST_RELOAD_POOL_X", EnvCfgTypes::int_}, {"TEST_RELOAD_POOL_Y", EnvCfgTypes::int_}});
+    std::vector<std::vector<EnvChange<int>>> pool_batches;
+    std::vector<std::vector<EnvChange<int>>> a_batches;
+    std::vector<std::vector<EnvChange<std::string>>> b_batches;
+    holder.Subscribe<int>("TEST_RELOAD_POOL_", [&](const std::vector<EnvChange<int>>& changes) {
+        pool_batches.push_back(changes);
+    }, EnvMatch::prefix_);
+    const std::size_t a_id = holder.Subscribe<int>("TEST_RELOAD_A", [&](const std::vector<EnvChange<int>>& changes) {
+        a_batches.push_back(changes);
+    });
+    holder.Subscribe<std::string>("TEST_RELOAD_B", [&](const std::vector<EnvChange<std::string>>& changes) {
+        b_batches.push_back(changes);
+    });
+
+    EnvCfg::SetEnv("TEST_RELOAD_POOL_X", "4");
+    EnvCfg::SetEnv("TEST_RELOAD_POOL_Y", "8");
+    EnvCfg::SetEnv("TEST_RELOAD_A", "2");
+    holder.Reload();
+    ASSERT_EQ(pool_batches.size(), 1u);
+    ASSERT_EQ(pool_batches[0].size(), 2u);
+    std::map<std::string, int> pool;
+    for (const auto& change : pool_batches[0])
+    {
+        pool[change.key] = change.value.value();
+    }
+    EXPECT_EQ(pool, (std::map<std::string, int>{{"TEST_RELOAD_POOL_X", 4}, {"TEST_RELOAD_POOL_Y", 8}}));
+    ASSERT_EQ(a_batches.size(), 1u);
+    EXPECT_EQ(a_batches[0][0].value, 2);
+    EXPECT_TRUE(b_batches.empty());
+
+    holder.Unsubscribe(a_id);
+    unsetenv("TEST_RELOAD_B");
+    EnvCfg::SetEnv("TEST_RELOAD_A", "3");
+    holder.Reload();
+    EXPECT_EQ(a_batches.size(), 1u);
+    EXPECT_EQ(pool_batches.size(), 1u);
+    ASSERT_EQ(b_batches.size(), 1u);
+    EXPECT_EQ(b_batches[0][0].key, "TEST_RELOAD_B");
+    EXPECT_FALSE(b_batches[0][0].value);
+}
+
+TEST_F(EnvCfgReloadTest, CallbacksRunOnExecutor) 
+{
+    EnvCfgHolder holder({{"TEST_RELOAD_A", EnvCfgTypes::int_}});
+    std::vector<std::function<void()>> queue;
+    holder.SetExecutor([&queue](std::function<void()> task) {
+        queue.push_back(std::move(task));
+    });
+    int seen = 0;
+    holder.Subscribe<int>("TEST_RELOAD_A", [&seen](const std::vector<EnvChange<int>>& changes) {
+        seen = changes[0].value.value();
+    });
+
+    EnvCfg::SetEnv("TEST_RELOAD_A", "7");
+    holder.Reload();
+    EXPECT_EQ(seen, 0);
+    ASSERT_EQ(queue.size(), 1u);
+    queue[0]();
+    EXPECT_EQ(seen, 7);
+}
+
+TEST_F(EnvCfgReloadTest, ReloadAfterPublishReportsAllKeys) 
+{
+    EnvCfgHolder holder({{"TEST_RELOAD_A", EnvCfgTypes::int_}});
+    auto cfg = std::make_unique<EnvCfg>();
+    EnvMap map = {{"TEST_RELOAD_OTHER", 1}};
+    cfg->InitEnv(map);
+    holder.Publish(std::move(cfg));
+    std::vector<std::string> keys;
+    holder.Subscribe<int>("TEST_RELOAD_", [&keys](const std::vector<EnvChange<int>>& changes) {
+        for (const auto& change : changes)
+        {
+            keys.push_back(change.key);
+        }
+    }, EnvMatch::prefix_);
+
+    holder.Reload();
+    EXPECT_EQ(keys, (std::vector<std::string>{"TEST_RELOAD_A"}));
+    EXPECT_FALSE(holder.Read()->HasValue("TEST_RELOAD_OTHER"));
+}
+
+TEST_F(EnvCfgReloadTest, ReloadDiscoversNewPatternMatches) 
+{
+    unsetenv("TEST_RELOAD_P_B_Q");
+    EnvCfg::SetEnv("TEST_RELOAD_P_A_Q", "1");
+    EnvCfgHolder holder({{"TEST_RELOAD_P_*_Q", EnvCfgTypes::int_}});
+    std::vector<std::string> keys;
+    holder.Subscribe<int>("TEST_RELOAD_P_", [&keys](const std::vector<EnvChange<int>>& changes) {
+        for (const auto& change : changes)
+        {
+            keys.push_back(change.key + "=" + std::to_string(change.value.value_or(-1)));
+        }
+    }, EnvMatch::prefix_);
+    EXPECT_FALSE(holder.Read()->HasValue("TEST_RELOAD_P_B_Q"));
+
+    EnvCfg::SetEnv("TEST_RELOAD_P_B_Q", "2");
+    holder.Reload();
+    EXPECT_EQ(holder.Read()->Get<int>("TEST_RELOAD_P_B_Q"), 2);
+    EXPECT_EQ(holder.Read()->Get<int>("TEST_RELOAD_P_A_Q"), 1);
+    EXPECT_EQ(keys, (std::vector<std::string>{"TEST_RELOAD_P_B_Q=2"}));
+
+    // A match which is set again is only revalidated, not added twice.
+    const EnvCfg* published = &*holder.Read();
+    holder.Reload();
+    EXPECT_EQ(&*holder.Read(), published);
+    EnvCfg::SetEnv("TEST_RELOAD_P_B_Q", "3");
+    holder.Reload();
+    EXPECT_EQ(keys, (std::vector<std::string>{"TEST_RELOAD_P_B_Q=2", "TEST_RELOAD_P_B_Q=3"}));
+    EXPECT_EQ(holder.Read()->Entries().size(), 2u);
+
+    EnvCfg::SetEnv("TEST_RELOAD_P_C_Q", "bad");
+    EXPECT_THROW(holder.Reload(), EnvBadGet);
+    EXPECT_FALSE(holder.Read()->HasValue("TEST_RELOAD_P_C_Q"));
+    unsetenv("TEST_RELOAD_P_A_Q");
+    unsetenv("TEST_RELOAD_P_B_Q");
+    unsetenv("TEST_RELOAD_P_C_Q");
+}
+
+TEST_F(EnvCfgReloadTest, LazyReloadPublishesNewPatternMatches) 
+{
+    unsetenv("TEST_RELOAD_L_B");
+    EnvInitOptions options;
+    options.lazy = true;
+    EnvCfgHolder holder({{"TEST_RELOAD_L_*", EnvCfgTypes::int_}}, options);
+    EnvCfg::SetEnv("TEST_RELOAD_L_B", "4");
+    holder.Reload();
+    EXPECT_EQ(holder.Read()->Get<int>("TEST_RELOAD_L_B"), 4);
+    unsetenv("TEST_RELOAD_L_B");
+}
+
+class ExceptionListener : public testing::EmptyTestEventListener {
+    public:
+        void OnTestPartResult(const testing::TestPartResult& result) override 
+        {
+            if (result.fatally_failed()) {
+                std::cout << "[Unhandled Exception] "<< result.message() << std::endl;
+            }
+        }
+    };
+
+int main(int argc, char **argv) 
+{
+    testing::InitGoogleTest(&argc, argv);
+    testing::TestEventListeners& listeners = 
+        testing::UnitTest::GetInstance()->listeners();
+    listeners.Append(new ExceptionListener);
+    
+    return RUN_ALL_TESTS();
+}
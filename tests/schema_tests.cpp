@@ -0,0 +1,111 @@
+#include "../cpp-envlib/libenv.h"
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace env_cfg;
+
+constexpr auto test_schema = MakeEnvSchema({
+    {"TEST_SCHEMA_PORT", EnvCfgTypes::int_, 8080},
+    {"TEST_SCHEMA_HOST", EnvCfgTypes::string_, "localhost"},
+    {"TEST_SCHEMA_RATIO", EnvCfgTypes::double_, 1},
+    {"TEST_SCHEMA_BIG", EnvCfgTypes::longlong_},
+    {"TEST_SCHEMA_DEBUG", EnvCfgTypes::bool_, false}
+});
+
+constexpr EnvKey<int> port_key = test_schema.Key<int>("TEST_SCHEMA_PORT");
+constexpr EnvKey<std::string> host_key = test_schema.Key<std::string>("TEST_SCHEMA_HOST");
+
+static_assert(test_schema.size() == 5);
+static_assert(test_schema.Find("TEST_SCHEMA_DEBUG") == 4);
+static_assert(test_schema.Find("TEST_SCHEMA_MISSING") == EnvSchema<5>::npos);
+static_assert(port_key.index() == 0);
+
+class EnvCfgSchemaTest : public ::testing::Test {
+protected:
+    void SetUp() override 
+    {
+        EnvCfg::SetEnvN("TEST_SCHEMA_PORT", "", true);
+        EnvCfg::SetEnvN("TEST_SCHEMA_BIG", "", true);
+    }
+
+    EnvCfg env;
+};
+
+TEST_F(EnvCfgSchemaTest, SchemaKeyWithoutSchemaInit)
+{
+    EXPECT_THROW(env.Get(port_key), EnvBadGet);
+    EXPECT_FALSE(env.GetN(host_key).has_value());
+    EXPECT_FALSE(env.HasValue(port_key));
+}
+
+TEST_F(EnvCfgSchemaTest, InitFromSchema) 
+{
+    EnvCfg::SetEnv("TEST_SCHEMA_PORT", "9090");
+    EnvCfg::SetEnv("TEST_SCHEMA_BIG", "10000000000");
+    env.InitEnv(test_schema);
+
+    EXPECT_EQ(env.Get(port_key), 9090);
+    EXPECT_EQ(env.Get(host_key), "localhost");
+    EXPECT_DOUBLE_EQ(env.Get(test_schema.Key<double>("TEST_SCHEMA_RATIO")), 1.0);
+    EXPECT_EQ(env.Get<long long>("TEST_SCHEMA_BIG"), 10000000000LL);
+    EXPECT_FALSE(env.Get<bool>("TEST_SCHEMA_DEBUG"));
+}
+
+TEST_F(EnvCfgSchemaTest, RuntimeLookupErrors) 
+{
+    EXPECT_THROW(test_schema.Index("TEST_SCHEMA_MISSING"), EnvBadGet);
+    EXPECT_THROW(test_schema.Key<bool>("TEST_SCHEMA_PORT"), EnvBadGet);
+}
+
+TEST_F(EnvCfgSchemaTest, RejectsConflictingPositions) 
+{
+    EnvMap map = {{"TEST_SCHEMA_HOST", "other"}};
+    env.InitEnv(map);
+
+    EXPECT_THROW(env.InitEnv(test_schema), EnvException);
+}
+
+TEST_F(EnvCfgSchemaTest, PerfectHashForManyFields) 
+{
+    constexpr std::size_t count = 512;
+    std::vector<std::string> names;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        names.push_back("TEST_SCHEMA_FIELD_" + std::to_string(i));
+    }
+    std::array<EnvField, count> fields{};
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        fields[i] = EnvField{names[i], EnvCfgTypes::int_, static_cast<int>(i)};
+    }
+    EnvSchema<count> schema(fields);
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        EXPECT_EQ(schema.Find(names[i]), i);
+    }
+    EXPECT_EQ(schema.Find("TEST_SCHEMA_FIELD_512"), EnvSchema<count>::npos);
+
+    env.InitEnv(schema);
+    EXPECT_EQ(env.Get(schema.Key<int>("TEST_SCHEMA_FIELD_300")), 300);
+}
+
+class ExceptionListener : public testing::EmptyTestEventListener {
+    public:
+        void OnTestPartResult(const testing::TestPartResult& result) override 
+        {
+            if (result.fatally_failed()) {
+                std::cout << "[Unhandled Exception] "<< result.message() << std::endl;
+            }
+        }
+    };
+
+int main(int argc, char **argv) 
+{
+    testing::InitGoogleTest(&argc, argv);
+    testing::TestEventListeners& listeners = 
+        testing::UnitTest::GetInstance()->listeners();
+    listeners.Append(new ExceptionListener);
+    
+    return RUN_ALL_TESTS();
+}
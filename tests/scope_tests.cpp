@@ -0,0 +1,208 @@
+#include "../cpp-envlib/libenv.h"
+#include <gtest/gtest.h>
+#include <map>
+#include <thread>
+
+using namespace env_cfg;
+
+class EnvCfgScopeTest : public ::testing::Test {
+protected:
+    void SetUp() override
+    {
+        EnvCfg::SetEnv("TEST_SCOPE_DB_HOST", "db.local");
+        EnvCfg::SetEnv("TEST_SCOPE_DB_PORT", "5432");
+        EnvCfg::SetEnv("TEST_SCOPE_CACHE_SIZE", "64");
+        EnvCfg::SetEnv("TEST_SCOPE_CACHE_TTL", "1.5");
+        EnvCfg::SetEnv("TEST_SCOPE_DBX", "other");
+        unsetenv("TEST_SCOPE_DB_USER");
+        map = {
+            {"TEST_SCOPE_DB_HOST", EnvCfgTypes::string_},
+            {"TEST_SCOPE_DB_PORT", EnvCfgTypes::int_},
+            {"TEST_SCOPE_DB_USER", EnvCfgTypes::string_},
+            {"TEST_SCOPE_CACHE_SIZE", EnvCfgTypes::int_},
+            {"TEST_SCOPE_CACHE_TTL", EnvCfgTypes::double_},
+            {"TEST_SCOPE_DBX", EnvCfgTypes::string_}
+        };
+    }
+
+    static std::vector<std::string> Keys(const EnvCfgView& view)
+    {
+        std::vector<std::string> keys;
+        for (const auto& [key, value] : view)
+        {
+            keys.emplace_back(key);
+        }
+        return keys;
+    }
+
+    EnvMap map;
+    EnvCfg env;
+};
+
+TEST_F(EnvCfgScopeTest, LooksUpKeysWithoutPrefix)
+{
+    env.InitEnv(map);
+    const EnvCfgView db = env.Scope("TEST_SCOPE_DB_");
+    EXPECT_EQ(db.size(), 3u);
+    EXPECT_EQ(db.Get<std::string>("HOST"), "db.local");
+    EXPECT_EQ(db.GetView("HOST"), "db.local");
+    EXPECT_EQ(db.Get<int>("PORT"), 5432);
+    EXPECT_EQ(db.GetN<int>("PORT"), 5432);
+    EXPECT_TRUE(db.IsType<int>("PORT"));
+    EXPECT_FALSE(db.IsType<std::string>("PORT"));
+    EXPECT_FALSE(db.HasValue("USER"));
+    EXPECT_FALSE(db.GetN<std::string>("USER"));
+    EXPECT_FALSE(db.GetViewN("USER"));
+    EXPECT_FALSE(db.HasValue("TEST_SCOPE_DB_HOST"));
+    EXPECT_FALSE(db.GetN<std::string>("X"));
+
+    const EnvKey<int> port = db.Key<int>("PORT");
+    EXPECT_EQ(env.Get(port), 5432);
+
+    try
+    {
+        db.Get<int>("MISSING");
+        FAIL() << "no exception thrown";
+    }
+    catch (const EnvBadGet& e)
+    {
+        EXPECT_NE(std::string(e.what()).find("TEST_SCOPE_DB_MISSING"), std::string::npos);
+    }
+    EXPECT_THROW(db.Get<std::string>("PORT"), EnvBadGet);
+    EXPECT_THROW(db.Get<std::string>("USER"), EnvBadGet);
+    EXPECT_THROW(db.GetView("PORT"), EnvBadGet);
+    EXPECT_THROW(db.Key<double>("PORT"), EnvBadGet);
+}
+
+TEST_F(EnvCfgScopeTest, EnumeratesPrefixInOrder)
+{
+    env.InitEnv(map);
+    EXPECT_EQ(Keys(env.Scope("TEST_SCOPE_DB_")), (std::vector<std::string>{"HOST", "PORT", "USER"}));
+    EXPECT_EQ(Keys(env.Scope("TEST_SCOPE_DB")), (std::vector<std::string>{"X", "_HOST", "_PORT", "_USER"}));
+    EXPECT_EQ(Keys(env.Scope("TEST_SCOPE_CACHE_")), (std::vector<std::string>{"SIZE", "TTL"}));
+    EXPECT_TRUE(env.Scope("TEST_SCOPE_NONE_").empty());
+    const std::vector<std::string> all = Keys(env.Scope(""));
+    EXPECT_EQ(all.size(), map.size());
+    EXPECT_TRUE(std::is_sorted(all.begin(), all.end()));
+
+    std::map<std::string, std::string> values;
+    char buffer[64];
+    for (const auto& [key, value] : env.Scope("TEST_SCOPE_CACHE_"))
+    {
+        auto [end, ec] = value.ToChars(buffer, buffer + sizeof(buffer));
+        ASSERT_EQ(ec, std::errc());
+        values[std::string(key)] = std::string(buffer, end);
+    }
+    EXPECT_EQ(values["SIZE"], "64");
+    EXPECT_EQ(values["TTL"], "1.5");
+}
+
+TEST_F(EnvCfgScopeTest, NestedScopes)
+{
+    env.InitEnv(map);
+    const EnvCfgView scope = env.Scope("TEST_SCOPE_");
+    EXPECT_EQ(scope.size(), map.size());
+    const EnvCfgView db = scope.Scope("DB_");
+    EXPECT_EQ(Keys(db), (std::vector<std::string>{"HOST", "PORT", "USER"}));
+    EXPECT_EQ(db.Get<int>("PORT"), 5432);
+    EXPECT_EQ(scope.Scope("CACHE").Scope("_").Get<int>("SIZE"), 64);
+    EXPECT_EQ(db.Scope("HOST").size(), 1u);
+    EXPECT_EQ(db.Scope("HOST").GetView(""), "db.local");
+
+    const EnvCfgView none = scope.Scope("QUEUE_");
+    EXPECT_TRUE(none.empty());
+    EXPECT_EQ(none.begin(), none.end());
+    EXPECT_FALSE(none.HasValue("SIZE"));
+    EXPECT_TRUE(none.Scope("A").empty());
+
+    const EnvCfgView unbound;
+    EXPECT_TRUE(unbound.empty());
+    EXPECT_FALSE(unbound.GetN<int>("PORT"));
+    EXPECT_THROW(unbound.Get<int>("PORT"), EnvBadGet);
+    EXPECT_TRUE(unbound.Scope("A").empty());
+}
+
+TEST_F(EnvCfgScopeTest, OrderFollowsInitEnvAndCopies)
+{
+    env.InitEnv(map);
+    EXPECT_EQ(env.Scope("TEST_SCOPE_DB_").size(), 3u);
+
+    EnvCfg::SetEnv("TEST_SCOPE_DB_NAME", "main");
+    EnvMap more = {{"TEST_SCOPE_DB_NAME", EnvCfgTypes::string_}, {"TEST_SCOPE_DB_PORT", 1}};
+    env.InitEnv(more);
+    const EnvCfgView db = env.Scope("TEST_SCOPE_DB_");
+    EXPECT_EQ(Keys(db), (std::vector<std::string>{"HOST", "NAME", "PORT", "USER"}));
+    EXPECT_EQ(db.Get<std::string>("NAME"), "main");
+    EXPECT_EQ(db.Get<int>("PORT"), 5432);
+
+    EnvCfg copy(env);
+    EnvCfg moved(std::move(env));
+    EXPECT_EQ(Keys(copy.Scope("TEST_SCOPE_DB_")), Keys(moved.Scope("TEST_SCOPE_DB_")));
+    EXPECT_EQ(copy.Scope("TEST_SCOPE_DB_").Get<std::string>("HOST"), "db.local");
+    EXPECT_TRUE(env.Scope("TEST_SCOPE_").empty());
+
+    EnvMap large;
+    for (int i = 0; i < 500; ++i)
+    {
+        large.emplace("TEST_SCOPE_LARGE_" + std::to_string(i), i);
+    }
+    copy.InitEnv(large);
+    const EnvCfgView scope = copy.Scope("TEST_SCOPE_LARGE_");
+    EXPECT_EQ(scope.size(), 500u);
+    for (int i = 0; i < 500; ++i)
+    {
+        ASSERT_EQ(scope.Get<int>(std::to_string(i)), i);
+    }
+    EXPECT_EQ(scope.Scope("49").size(), 11u);
+}
+
+TEST_F(EnvCfgScopeTest, ConcurrentFirstScope)
+{
+    EnvMap large = map;
+    for (int i = 0; i < 1000; ++i)
+    {
+        large.emplace("TEST_SCOPE_KEY_" + std::to_string(i), i);
+    }
+    env.InitEnv(large);
+
+    std::vector<std::thread> workers;
+    std::atomic<int> failures{ 0 };
+    for (int t = 0; t < 8; ++t)
+    {
+        workers.emplace_back([this, &failures, t]() {
+            const EnvCfgView keys = env.Scope("TEST_SCOPE_KEY_");
+            for (int i = t; i < 1000; i += 8)
+            {
+                if (keys.size() != 1000u || keys.Get<int>(std::to_string(i)) != i)
+                {
+                    ++failures;
+                }
+            }
+        });
+    }
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+    EXPECT_EQ(failures.load(), 0);
+}
+
+class ExceptionListener : public testing::EmptyTestEventListener {
+    public:
+        void OnTestPartResult(const testing::TestPartResult& result) override
+        {
+            if (result.fatally_failed()) {
+                std::cout << "[Unhandled Exception] "<< result.message() << std::endl;
+            }
+        }
+    };
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    testing::TestEventListeners& listeners =
+        testing::UnitTest::GetInstance()->listeners();
+    listeners.Append(new ExceptionListener);
+
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,254 @@
+#include "../cpp-envlib/libenv.h"
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+using namespace env_cfg;
+
+class EnvCfgSnapshotTest : public ::testing::Test {
+protected:
+    void SetUp() override
+    {
+        EnvCfg::SetEnv("TEST_SNAP_INT", "42");
+        EnvCfg::SetEnv("TEST_SNAP_DOUBLE", "2.5");
+        EnvCfg::SetEnv("TEST_SNAP_LONG", "9000000000");
+        EnvCfg::SetEnv("TEST_SNAP_BOOL", "yes");
+        EnvCfg::SetEnv("TEST_SNAP_STRING", "hello");
+        unsetenv("TEST_SNAP_DEFAULT");
+        unsetenv("TEST_SNAP_MISSING");
+        char path[] = "/tmp/libenv_snapshot_testXXXXXX";
+        const int fd = mkstemp(path);
+        ASSERT_GE(fd, 0);
+        close(fd);
+        m_path = path;
+        map = {
+            {"TEST_SNAP_INT", EnvCfgTypes::int_},
+            {"TEST_SNAP_DOUBLE", EnvCfgTypes::double_},
+            {"TEST_SNAP_LONG", EnvCfgTypes::longlong_},
+            {"TEST_SNAP_BOOL", EnvCfgTypes::bool_},
+            {"TEST_SNAP_STRING", EnvCfgTypes::string_},
+            {"TEST_SNAP_DEFAULT", std::string("fallback")},
+            {"TEST_SNAP_MISSING", EnvCfgTypes::int_}
+        };
+    }
+
+    void TearDown() override
+    {
+        std::remove(m_path.c_str());
+    }
+
+    std::string Read() const
+    {
+        std::ifstream in(m_path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    void Write(const std::string& content) const
+    {
+        std::ofstream out(m_path, std::ios::binary | std::ios::trunc);
+        out << content;
+    }
+
+    std::string m_path;
+    EnvMap map;
+    EnvCfg env;
+};
+
+TEST_F(EnvCfgSnapshotTest, RoundTripKeepsValuesAndTypes)
+{
+    env.InitEnv(map);
+    env.SaveSnapshot(m_path);
+    EnvCfg loaded = EnvCfg::LoadSnapshot(m_path);
+
+    EXPECT_EQ(loaded.Get<int>("TEST_SNAP_INT"), 42);
+    EXPECT_DOUBLE_EQ(loaded.Get<double>("TEST_SNAP_DOUBLE"), 2.5);
+    EXPECT_EQ(loaded.Get<long long>("TEST_SNAP_LONG"), 9000000000LL);
+    EXPECT_TRUE(loaded.Get<bool>("TEST_SNAP_BOOL"));
+    EXPECT_EQ(loaded.Get<std::string>("TEST_SNAP_STRING"), "hello");
+    EXPECT_EQ(loaded.Get<std::string>("TEST_SNAP_DEFAULT"), "fallback");
+    EXPECT_FALSE(loaded.HasValue("TEST_SNAP_MISSING"));
+    EXPECT_FALSE(loaded.IsType<std::string>("TEST_SNAP_INT"));
+
+    std::vector<std::pair<std::string, std::string>> expected;
+    std::vector<std::pair<std::string, std::string>> actual;
+    for (const auto& entry : env)
+    {
+        expected.push_back(entry);
+    }
+    for (const auto& entry : loaded)
+    {
+        actual.push_back(entry);
+    }
+    EXPECT_EQ(actual, expected);
+}
+
+TEST_F(EnvCfgSnapshotTest, ValidationParsesChangedValues)
+{
+    env.InitEnv(map);
+    env.SaveSnapshot(m_path);
+    EnvCfg::SetEnv("TEST_SNAP_INT", "43");
+    EnvCfg::SetEnv("TEST_SNAP_DEFAULT", "from_env");
+    EnvCfg::SetEnv("TEST_SNAP_MISSING", "7");
+    unsetenv("TEST_SNAP_STRING");
+
+    EnvCfg loaded = EnvCfg::LoadSnapshot(m_path);
+    EXPECT_EQ(loaded.Get<int>("TEST_SNAP_INT"), 43);
+    EXPECT_EQ(loaded.Get<std::string>("TEST_SNAP_DEFAULT"), "from_env");
+    EXPECT_EQ(loaded.Get<int>("TEST_SNAP_MISSING"), 7);
+    EXPECT_FALSE(loaded.HasValue("TEST_SNAP_STRING"));
+    EXPECT_EQ(loaded.Get<long long>("TEST_SNAP_LONG"), 9000000000LL);
+
+    EnvCfg stale = EnvCfg::LoadSnapshot(m_path, false);
+    EXPECT_EQ(stale.Get<int>("TEST_SNAP_INT"), 42);
+    EXPECT_EQ(stale.Get<std::string>("TEST_SNAP_STRING"), "hello");
+}
+
+TEST_F(EnvCfgSnapshotTest, ValidationRestoresDefault)
+{
+    EnvCfg::SetEnv("TEST_SNAP_DEFAULT", "from_env");
+    env.InitEnv(map);
+    env.SaveSnapshot(m_path);
+    unsetenv("TEST_SNAP_DEFAULT");
+
+    EnvCfg loaded = EnvCfg::LoadSnapshot(m_path);
+    EXPECT_EQ(loaded.Get<std::string>("TEST_SNAP_DEFAULT"), "fallback");
+}
+
+TEST_F(EnvCfgSnapshotTest, ValidationReportsParseErrors)
+{
+    env.InitEnv(map);
+    env.SaveSnapshot(m_path);
+    EnvCfg::SetEnv("TEST_SNAP_INT", "not a number");
+
+    EXPECT_THROW(EnvCfg::LoadSnapshot(m_path), EnvBadGet);
+}
+
+TEST_F(EnvCfgSnapshotTest, LazyConfigurationIsResolvedOnSave)
+{
+    EnvInitOptions options;
+    options.lazy = true;
+    env.InitEnv(map, options);
+    env.SaveSnapshot(m_path);
+
+    EnvCfg loaded = EnvCfg::LoadSnapshot(m_path);
+    EXPECT_EQ(loaded.Get<int>("TEST_SNAP_INT"), 42);
+    EXPECT_EQ(loaded.Get<std::string>("TEST_SNAP_STRING"), "hello");
+    EXPECT_EQ(loaded.Get<std::string>("TEST_SNAP_DEFAULT"), "fallback");
+}
+
+TEST_F(EnvCfgSnapshotTest, LargeConfiguration)
+{
+    EnvMap large;
+    for (int i = 0; i < 2000; ++i)
+    {
+        large.emplace("TEST_SNAP_KEY_" + std::to_string(i), i);
+    }
+    env.InitEnv(large);
+    env.SaveSnapshot(m_path);
+
+    EnvCfg loaded = EnvCfg::LoadSnapshot(m_path);
+    for (int i = 0; i < 2000; ++i)
+    {
+        EXPECT_EQ(loaded.Get<int>("TEST_SNAP_KEY_" + std::to_string(i)), i);
+    }
+    EXPECT_FALSE(loaded.HasValue("TEST_SNAP_KEY_2000"));
+}
+
+TEST_F(EnvCfgSnapshotTest, ConcurrentSavesOfOnePath)
+{
+    EnvMap large;
+    for (int i = 0; i < 500; ++i)
+    {
+        large.emplace("TEST_SNAP_KEY_" + std::to_string(i), i);
+    }
+    EnvCfg other;
+    other.InitEnv(large);
+    env.InitEnv(map);
+    env.SaveSnapshot(m_path);
+
+    std::vector<std::thread> savers;
+    for (int t = 0; t < 4; ++t)
+    {
+        savers.emplace_back([this, &other, t] {
+            for (int i = 0; i < 25; ++i)
+            {
+                ((t + i) % 2 ? other : env).SaveSnapshot(m_path);
+            }
+        });
+    }
+    for (int i = 0; i < 50; ++i)
+    {
+        // Every load sees one complete snapshot, never a mix or a partial file.
+        EnvCfg loaded = EnvCfg::LoadSnapshot(m_path);
+        EXPECT_TRUE(loaded.HasValue("TEST_SNAP_INT") ? loaded.Get<int>("TEST_SNAP_INT") == 42 : loaded.Get<int>("TEST_SNAP_KEY_499") == 499);
+    }
+    for (std::thread& saver : savers)
+    {
+        saver.join();
+    }
+
+    const std::filesystem::path path(m_path);
+    for (const auto& entry : std::filesystem::directory_iterator(path.parent_path()))
+    {
+        const std::string name = entry.path().filename().string();
+        EXPECT_FALSE(name != path.filename().string() && name.rfind(path.filename().string(), 0) == 0) << name;
+    }
+}
+
+TEST_F(EnvCfgSnapshotTest, EmptyConfiguration)
+{
+    env.SaveSnapshot(m_path);
+    EnvCfg loaded = EnvCfg::LoadSnapshot(m_path);
+    EXPECT_TRUE(loaded.Empty());
+    EXPECT_FALSE(loaded.HasValue("TEST_SNAP_INT"));
+}
+
+TEST_F(EnvCfgSnapshotTest, RejectsInvalidFiles)
+{
+    env.InitEnv(map);
+    env.SaveSnapshot(m_path);
+    const std::string snapshot = Read();
+
+    EXPECT_THROW(EnvCfg::LoadSnapshot("/nonexistent/libenv.snapshot"), EnvException);
+
+    Write(snapshot.substr(0, snapshot.size() - 1));
+    EXPECT_THROW(EnvCfg::LoadSnapshot(m_path), EnvException);
+
+    std::string corrupt = snapshot;
+    corrupt[corrupt.size() - 1] ^= 1;
+    Write(corrupt);
+    EXPECT_THROW(EnvCfg::LoadSnapshot(m_path), EnvException);
+
+    std::string version = snapshot;
+    version[8] = 2;
+    Write(version);
+    EXPECT_THROW(EnvCfg::LoadSnapshot(m_path), EnvException);
+
+    Write("TEST_SNAP_INT=42\n");
+    EXPECT_THROW(EnvCfg::LoadSnapshot(m_path), EnvException);
+
+    Write("");
+    EXPECT_THROW(EnvCfg::LoadSnapshot(m_path), EnvException);
+}
+
+class ExceptionListener : public testing::EmptyTestEventListener {
+    public:
+        void OnTestPartResult(const testing::TestPartResult& result) override
+        {
+            if (result.fatally_failed()) {
+                std::cout << "[Unhandled Exception] "<< result.message() << std::endl;
+            }
+        }
+    };
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    testing::TestEventListeners& listeners =
+        testing::UnitTest::GetInstance()->listeners();
+    listeners.Append(new ExceptionListener);
+
+    return RUN_ALL_TESTS();
+}
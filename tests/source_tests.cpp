@@ -0,0 +1,262 @@
+#include "../cpp-envlib/libenv.h"
+#include <gtest/gtest.h>
+#include <thread>
+
+using namespace env_cfg;
+
+class EnvCfgSourceTest : public ::testing::Test {
+protected:
+    void SetUp() override 
+    {
+        EnvCfg::SetEnvN("TEST_SOURCE", "", true);
+    }
+
+    void TearDown() override 
+    {
+        EnvCfg::DisableSnapshot();
+        EnvCfg::DisableOverlay();
+    }
+
+    EnvCfg env;
+};
+
+TEST_F(EnvCfgSourceTest, SnapshotResolvesInitEnvAndGetW) 
+{
+    EnvCfg::SetEnv("TEST_SOURCE", "77");
+    EnvCfg::EnableSnapshot();
+    ASSERT_TRUE(EnvCfg::IsSnapshotEnabled());
+
+    EnvMap map = {{"TEST_SOURCE", EnvCfgTypes::int_}, {"TEST_SOURCE_MISSING", 5}};
+    env.InitEnv(map);
+
+    EXPECT_EQ(env.Get<int>("TEST_SOURCE"), 77);
+    EXPECT_EQ(env.Get<int>("TEST_SOURCE_MISSING"), 5);
+    EXPECT_EQ(EnvCfg::GetW<int>("TEST_SOURCE").default_value(0), 77);
+}
+
+TEST_F(EnvCfgSourceTest, SnapshotFollowsSetEnv) 
+{
+    EnvCfg::EnableSnapshot();
+
+    EnvCfg::SetEnv("TEST_SOURCE", "first");
+    EXPECT_EQ(EnvCfg::GetW<std::string>("TEST_SOURCE").default_value(""), "first");
+
+    EXPECT_TRUE(EnvCfg::SetEnvN("TEST_SOURCE_NEW", "second"));
+    EXPECT_EQ(EnvCfg::GetW<std::string>("TEST_SOURCE_NEW").default_value(""), "second");
+
+    EXPECT_TRUE(EnvCfg::SetEnvN("TEST_SOURCE_NEW", "third", false));
+    EXPECT_EQ(EnvCfg::GetW<std::string>("TEST_SOURCE_NEW").default_value(""), "second");
+}
+
+TEST_F(EnvCfgSourceTest, SnapshotIgnoresDirectSetenv) 
+{
+    EnvCfg::SetEnv("TEST_SOURCE", "before");
+    EnvCfg::EnableSnapshot();
+    setenv("TEST_SOURCE", "after", 1);
+
+    EXPECT_EQ(EnvCfg::GetW<std::string>("TEST_SOURCE").default_value(""), "before");
+    EnvCfg::DisableSnapshot();
+    EXPECT_EQ(EnvCfg::GetW<std::string>("TEST_SOURCE").default_value(""), "after");
+}
+
+TEST_F(EnvCfgSourceTest, SnapshotMatchesGetenv) 
+{
+    EnvSnapshot snapshot;
+    std::size_t count = 0;
+    for (char** entry = environ; *entry; ++entry)
+    {
+        std::string line = *entry;
+        const std::string name = line.substr(0, line.find('='));
+        EXPECT_EQ(snapshot.Find(name), std::string_view(std::getenv(name.c_str()))) << name;
+        ++count;
+    }
+    EXPECT_LE(snapshot.size(), count);
+    EXPECT_TRUE(snapshot.Find("TEST_SOURCE_NOT_SET_ANYWHERE").empty());
+}
+
+TEST_F(EnvCfgSourceTest, OverlayDoesNotTouchProcessEnvironment) 
+{
+    EnvCfg::SetEnv("TEST_SOURCE", "base");
+    EnvCfg::EnableOverlay();
+    ASSERT_TRUE(EnvCfg::IsOverlayEnabled());
+    EXPECT_EQ(EnvCfg::GetW<std::string>("TEST_SOURCE").default_value(""), "base");
+
+    EnvCfg::SetEnv("TEST_SOURCE", "12");
+    EnvCfg::SetEnv("TEST_SOURCE_OVERLAY", "on");
+    EXPECT_EQ(EnvCfg::GetW<int>("TEST_SOURCE").default_value(0), 12);
+    EXPECT_EQ(EnvCfg::TryGetEnv<std::string>("TEST_SOURCE_OVERLAY").value(), "on");
+    EXPECT_STREQ(std::getenv("TEST_SOURCE"), "base");
+    EXPECT_EQ(std::getenv("TEST_SOURCE_OVERLAY"), nullptr);
+
+    EnvMap map = {{"TEST_SOURCE", EnvCfgTypes::int_}};
+    env.InitEnv(map);
+    EXPECT_EQ(env.Get<int>("TEST_SOURCE"), 12);
+
+    EnvCfg::DisableOverlay();
+    EXPECT_EQ(EnvCfg::GetW<std::string>("TEST_SOURCE").default_value(""), "base");
+    EXPECT_FALSE(EnvCfg::TryGetEnv<std::string>("TEST_SOURCE_OVERLAY"));
+}
+
+TEST_F(EnvCfgSourceTest, OverlayRespectsOverwriteAndValidation) 
+{
+    EnvCfg::SetEnv("TEST_SOURCE", "base");
+    EnvCfg::EnableOverlay();
+
+    EXPECT_TRUE(EnvCfg::SetEnvN("TEST_SOURCE", "changed", false));
+    EXPECT_EQ(EnvCfg::GetW<std::string>("TEST_SOURCE").default_value(""), "base");
+    EXPECT_TRUE(EnvCfg::SetEnvN("TEST_SOURCE_OVERLAY", "first", false));
+    EXPECT_TRUE(EnvCfg::SetEnvN("TEST_SOURCE_OVERLAY", "second", false));
+    EXPECT_EQ(EnvCfg::GetW<std::string>("TEST_SOURCE_OVERLAY").default_value(""), "first");
+
+    EXPECT_FALSE(EnvCfg::SetEnvN("TEST=SOURCE", "value"));
+    EXPECT_FALSE(EnvCfg::SetEnvN("", "value"));
+    EXPECT_THROW(EnvCfg::SetEnv("TEST=SOURCE", "value"), EnvSetError);
+}
+
+TEST_F(EnvCfgSourceTest, OverlaySetEnvsPublishesBatch) 
+{
+    EnvCfg::SetEnv("TEST_SOURCE", "base");
+    EnvCfg::EnableOverlay();
+
+    std::vector<std::pair<std::string, std::string>> values;
+    for (int i = 0; i < 100; ++i)
+    {
+        values.emplace_back("TEST_SOURCE_BATCH_" + std::to_string(i), std::to_string(i));
+    }
+    values.emplace_back("TEST_SOURCE_BATCH_7", "last");
+    values.emplace_back("TEST_SOURCE", "overlay");
+    EnvCfg::SetEnvs(values);
+    EXPECT_EQ(EnvCfg::GetW<int>("TEST_SOURCE_BATCH_99").default_value(0), 99);
+    EXPECT_EQ(EnvCfg::GetW<std::string>("TEST_SOURCE_BATCH_7").default_value(""), "last");
+    EXPECT_EQ(EnvCfg::GetW<std::string>("TEST_SOURCE").default_value(""), "overlay");
+
+    EXPECT_TRUE(EnvCfg::SetEnvsN({ {"TEST_SOURCE", "kept"}, {"TEST_SOURCE_BATCH_NEW", "first"}, {"TEST_SOURCE_BATCH_NEW", "second"} }, false));
+    EXPECT_EQ(EnvCfg::GetW<std::string>("TEST_SOURCE").default_value(""), "overlay");
+    EXPECT_EQ(EnvCfg::GetW<std::string>("TEST_SOURCE_BATCH_NEW").default_value(""), "first");
+
+    EXPECT_THROW(EnvCfg::SetEnvs({ {"TEST_SOURCE_BATCH_0", "changed"}, {"TEST=SOURCE", "value"} }), EnvSetError);
+    EXPECT_FALSE(EnvCfg::SetEnvsN({ {"TEST_SOURCE_BATCH_0", "changed"}, {"", "value"} }));
+    EXPECT_EQ(EnvCfg::GetW<int>("TEST_SOURCE_BATCH_0").default_value(-1), 0);
+
+    EnvCfg::DisableOverlay();
+    EXPECT_FALSE(EnvCfg::TryGetEnv<std::string>("TEST_SOURCE_BATCH_1"));
+    EnvCfg::SetEnvs({ {"TEST_SOURCE", "process"}, {"TEST_SOURCE_BATCH_1", "1"} });
+    EXPECT_EQ(EnvCfg::GetW<std::string>("TEST_SOURCE").default_value(""), "process");
+    EXPECT_EQ(EnvCfg::GetW<int>("TEST_SOURCE_BATCH_1").default_value(0), 1);
+    EXPECT_THROW(EnvCfg::SetEnvs({ {"TEST=SOURCE", "value"} }), EnvSetError);
+    unsetenv("TEST_SOURCE_BATCH_1");
+}
+
+TEST_F(EnvCfgSourceTest, OverlaySetEnvRacesDisableOverlay) 
+{
+    // EnableOverlay() reads environ, so it only runs while no writer can fall back to setenv.
+    for (int round = 0; round < 200; ++round)
+    {
+        EnvCfg::EnableOverlay();
+        std::atomic<bool> done{ false };
+        std::vector<std::thread> writers;
+        for (int i = 0; i < 2; ++i)
+        {
+            writers.emplace_back([&done, i] {
+                const std::string name = "TEST_SOURCE_RACE_" + std::to_string(i);
+                while (!done.load())
+                {
+                    EnvCfg::SetEnv(name, "value");
+                    EXPECT_TRUE(EnvCfg::SetEnvN(name, "n"));
+                    EnvCfg::SetEnvs({ {name, "batch"}, {name + "_B", "batch"} });
+                }
+            });
+        }
+        std::this_thread::yield();
+        EnvCfg::DisableOverlay();
+        done.store(true);
+        for (std::thread& writer : writers)
+        {
+            writer.join();
+        }
+    }
+    for (const char* name : {"TEST_SOURCE_RACE_0", "TEST_SOURCE_RACE_0_B", "TEST_SOURCE_RACE_1", "TEST_SOURCE_RACE_1_B"})
+    {
+        unsetenv(name);
+    }
+}
+
+TEST_F(EnvCfgSourceTest, MaterializeEnvMergesOverlay) 
+{
+    EnvCfg::SetEnv("TEST_SOURCE", "base");
+    EnvCfg::EnableOverlay();
+    EnvCfg::SetEnv("TEST_SOURCE", "overlay");
+    EnvCfg::SetEnv("TEST_SOURCE_OVERLAY", "new");
+
+    EnvBlock block = EnvCfg::MaterializeEnv();
+    std::size_t count = 0;
+    std::size_t source_count = 0;
+    for (char* const* entry = block.envp(); *entry; ++entry)
+    {
+        const std::string line = *entry;
+        if (line.rfind("TEST_SOURCE=", 0) == 0)
+        {
+            EXPECT_EQ(line, "TEST_SOURCE=overlay");
+            ++source_count;
+        }
+        ++count;
+    }
+    EXPECT_EQ(count, block.size());
+    EXPECT_EQ(source_count, 1u);
+    EXPECT_NE(std::find(block.envp(), block.envp() + block.size(), std::string("TEST_SOURCE_OVERLAY=new")), block.envp() + block.size());
+    EXPECT_EQ(block.envp()[block.size()], nullptr);
+}
+
+TEST_F(EnvCfgSourceTest, OverlayConcurrentSetAndGet) 
+{
+    EnvCfg::EnableOverlay();
+    EnvCfg::SetEnv("TEST_SOURCE", "0");
+    std::atomic<bool> done{ false };
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; ++i)
+    {
+        readers.emplace_back([&done] {
+            int last = 0;
+            while (!done.load())
+            {
+                const int value = EnvCfg::GetW<int>("TEST_SOURCE").default_value(-1);
+                EXPECT_GE(value, last);
+                last = value;
+            }
+        });
+    }
+    std::thread writer([] {
+        for (int i = 1; i <= 2000; ++i)
+        {
+            EnvCfg::SetEnv("TEST_SOURCE", std::to_string(i));
+            EnvCfg::SetEnv("TEST_SOURCE_" + std::to_string(i % 16), "x");
+        }
+    });
+    writer.join();
+    done.store(true);
+    for (std::thread& reader : readers)
+    {
+        reader.join();
+    }
+    EXPECT_EQ(EnvCfg::GetW<int>("TEST_SOURCE").default_value(0), 2000);
+}
+
+class ExceptionListener : public testing::EmptyTestEventListener {
+    public:
+        void OnTestPartResult(const testing::TestPartResult& result) override 
+        {
+            if (result.fatally_failed()) {
+                std::cout << "[Unhandled Exception] "<< result.message() << std::endl;
+            }
+        }
+    };
+
+int main(int argc, char **argv) 
+{
+    testing::InitGoogleTest(&argc, argv);
+    testing::TestEventListeners& listeners = 
+        testing::UnitTest::GetInstance()->listeners();
+    listeners.Append(new ExceptionListener);
+    
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,183 @@
+#define CPPLIBENV_INSTRUMENT
+#include "../cpp-envlib/libenv.h"
+#include <gtest/gtest.h>
+#include <map>
+#include <thread>
+
+using namespace env_cfg;
+
+class EnvCfgStatsTest : public ::testing::Test {
+protected:
+    void SetUp() override
+    {
+        EnvCfg::SetEnv("TEST_STATS_INT", "42");
+        EnvCfg::SetEnv("TEST_STATS_DOUBLE", "2.5");
+        EnvCfg::SetEnv("TEST_STATS_STRING", "hello");
+        map = {
+            {"TEST_STATS_INT", EnvCfgTypes::int_},
+            {"TEST_STATS_DOUBLE", EnvCfgTypes::double_},
+            {"TEST_STATS_STRING", EnvCfgTypes::string_}
+        };
+        EnvCfg::ResetLatency();
+    }
+
+    std::map<std::string, std::uint64_t> Counts() const
+    {
+        std::map<std::string, std::uint64_t> counts;
+        for (const auto& [key, reads] : env.ReadCounts())
+        {
+            counts[key] = reads;
+        }
+        return counts;
+    }
+
+    EnvMap map;
+    EnvCfg env;
+};
+
+TEST_F(EnvCfgStatsTest, CountsReadsByNameAndHandle)
+{
+    env.InitEnv(map);
+    EXPECT_EQ(env.Get<int>("TEST_STATS_INT"), 42);
+    EXPECT_TRUE(env.GetN<int>("TEST_STATS_INT"));
+    EXPECT_TRUE(env.HasValue("TEST_STATS_INT"));
+    EXPECT_EQ(env.GetView("TEST_STATS_STRING"), "hello");
+    EXPECT_FALSE(env.HasValue("TEST_STATS_UNKNOWN"));
+
+    const EnvKey<double> key = env.Key<double>("TEST_STATS_DOUBLE");
+    EXPECT_DOUBLE_EQ(env.Get(key), 2.5);
+    EXPECT_TRUE(env.GetN(key));
+
+    std::map<std::string, std::uint64_t> counts = Counts();
+    ASSERT_EQ(counts.size(), 3u);
+    EXPECT_EQ(counts["TEST_STATS_INT"], 3u);
+    EXPECT_EQ(counts["TEST_STATS_DOUBLE"], 3u);
+    EXPECT_EQ(counts["TEST_STATS_STRING"], 1u);
+
+    env.ResetReadCounts();
+    counts = Counts();
+    EXPECT_EQ(counts["TEST_STATS_INT"], 0u);
+}
+
+TEST_F(EnvCfgStatsTest, CountsAreKeptAcrossInitEnv)
+{
+    env.InitEnv(map);
+    env.Get<int>("TEST_STATS_INT");
+
+    EnvMap more;
+    for (int i = 0; i < 100; ++i)
+    {
+        more.emplace("TEST_STATS_KEY_" + std::to_string(i), i);
+    }
+    env.InitEnv(more);
+    env.Get<int>("TEST_STATS_INT");
+    env.Get<int>("TEST_STATS_KEY_99");
+
+    std::map<std::string, std::uint64_t> counts = Counts();
+    EXPECT_EQ(counts.size(), 103u);
+    EXPECT_EQ(counts["TEST_STATS_INT"], 2u);
+    EXPECT_EQ(counts["TEST_STATS_KEY_99"], 1u);
+    EXPECT_EQ(counts["TEST_STATS_KEY_0"], 0u);
+
+    EnvCfg copy(env);
+    copy.Get<int>("TEST_STATS_INT");
+    for (const auto& [key, reads] : copy.ReadCounts())
+    {
+        EXPECT_EQ(reads, key == "TEST_STATS_INT" ? 1u : 0u) << key;
+    }
+}
+
+TEST_F(EnvCfgStatsTest, CountsReadsOfAllThreads)
+{
+    env.InitEnv(map);
+    const EnvKey<int> key = env.Key<int>("TEST_STATS_INT");
+    env.ResetReadCounts();
+
+    constexpr int threads = 8;
+    constexpr int reads = 10000;
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; ++i)
+    {
+        workers.emplace_back([this, key]() {
+            for (int j = 0; j < reads; ++j)
+            {
+                env.Get(key);
+                env.Get<std::string>("TEST_STATS_STRING");
+            }
+        });
+    }
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+
+    std::map<std::string, std::uint64_t> counts = Counts();
+    EXPECT_EQ(counts["TEST_STATS_INT"], static_cast<std::uint64_t>(threads * reads));
+    EXPECT_EQ(counts["TEST_STATS_STRING"], static_cast<std::uint64_t>(threads * reads));
+}
+
+TEST_F(EnvCfgStatsTest, RecordsParseAndInitLatency)
+{
+    env.InitEnv(map);
+    EXPECT_EQ(EnvCfg::ParseLatency(EnvCfgTypes::int_).count(), 1u);
+    EXPECT_EQ(EnvCfg::ParseLatency(EnvCfgTypes::double_).count(), 1u);
+    EXPECT_EQ(EnvCfg::ParseLatency(EnvCfgTypes::string_).count(), 1u);
+    EXPECT_EQ(EnvCfg::ParseLatency(EnvCfgTypes::bool_).count(), 0u);
+    EXPECT_EQ(EnvCfg::InitLatency().count(), 1u);
+
+    EnvInitOptions options;
+    options.threads = 1;
+    env.InitEnv(map, options);
+    EXPECT_EQ(EnvCfg::InitLatency().count(), 2u);
+    EXPECT_EQ(EnvCfg::ParseLatency(EnvCfgTypes::int_).count(), 2u);
+
+    const EnvLatencyHistogram init = EnvCfg::InitLatency();
+    EXPECT_GT(init.quantile(0.5), 0u);
+    EXPECT_LE(init.quantile(0.5), init.quantile(1.0));
+
+    EnvCfg::ResetLatency();
+    EXPECT_EQ(EnvCfg::InitLatency().count(), 0u);
+    EXPECT_EQ(EnvCfg::InitLatency().quantile(0.5), 0u);
+}
+
+TEST_F(EnvCfgStatsTest, RecordsLazyParses)
+{
+    EnvInitOptions options;
+    options.lazy = true;
+    env.InitEnv(map, options);
+    EXPECT_EQ(EnvCfg::ParseLatency(EnvCfgTypes::int_).count(), 0u);
+    EXPECT_EQ(env.Get<int>("TEST_STATS_INT"), 42);
+    EXPECT_EQ(env.Get<int>("TEST_STATS_INT"), 42);
+    EXPECT_EQ(EnvCfg::ParseLatency(EnvCfgTypes::int_).count(), 1u);
+}
+
+TEST_F(EnvCfgStatsTest, HistogramQuantile)
+{
+    EnvLatencyHistogram histogram;
+    histogram.buckets[3] = 9;
+    histogram.buckets[10] = 1;
+    EXPECT_EQ(histogram.count(), 10u);
+    EXPECT_EQ(histogram.quantile(0.0), 16u);
+    EXPECT_EQ(histogram.quantile(0.9), 16u);
+    EXPECT_EQ(histogram.quantile(0.99), 2048u);
+}
+
+class ExceptionListener : public testing::EmptyTestEventListener {
+    public:
+        void OnTestPartResult(const testing::TestPartResult& result) override
+        {
+            if (result.fatally_failed()) {
+                std::cout << "[Unhandled Exception] "<< result.message() << std::endl;
+            }
+        }
+    };
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    testing::TestEventListeners& listeners =
+        testing::UnitTest::GetInstance()->listeners();
+    listeners.Append(new ExceptionListener);
+
+    return RUN_ALL_TESTS();
+}